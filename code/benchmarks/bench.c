@@ -0,0 +1,150 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "bench.h"
+
+#include <time.h>
+
+static const char *const words[] = {
+    "fish", "model", "chain", "commit", "river", "signal", "token", "ocean", "reef", "current",
+    "shell", "tide", "school", "fin", "coral", "depth", "light", "stone", "wave", "drift",
+    "north", "south", "quick", "slow", "bright", "dark", "small", "large", "early", "late"
+};
+#define WORD_COUNT (sizeof(words) / sizeof(words[0]))
+
+uint64_t bench_rand(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static double rand_unit(uint64_t *state) {
+    return (double)(bench_rand(state) >> 11) / (double)(1ull << 53);
+}
+
+/* ---------------- results ---------------- */
+
+void bench_result_init(bench_result_t *r, ccstring name) {
+    fossil_sys_memory_zero(r, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+}
+
+void bench_record(bench_result_t *r, uint64_t ns, uint64_t rows, uint64_t bytes) {
+    fish_hist_add(&r->latency, ns);
+    r->rows += rows;
+    r->bytes += bytes;
+}
+
+int bench_report(const bench_result_t *r, ccstring out_path) {
+    const fish_hist_t *h = &r->latency;
+    double secs = (double)h->sum / 1e9;
+    char line[1024];
+    int n = snprintf(line, sizeof(line),
+        "{\"bench\":\"%s\",\"version\":\"%s\",\"time\":%lld,\"ops\":%llu,\"rows\":%llu,\"bytes\":%llu,"
+        "\"seconds\":%.6f,\"ops_per_s\":%.1f,\"rows_per_s\":%.1f,\"mb_per_s\":%.3f,"
+        "\"latency_us\":{\"mean\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f}}\n",
+        r->name, FOSSIL_APP_VERSION, (long long)time(NULL), (unsigned long long)h->count,
+        (unsigned long long)r->rows, (unsigned long long)r->bytes, secs,
+        secs > 0 ? (double)h->count / secs : 0.0, secs > 0 ? (double)r->rows / secs : 0.0,
+        secs > 0 ? (double)r->bytes / secs / 1e6 : 0.0,
+        h->count ? (double)h->sum / (double)h->count / 1e3 : 0.0,
+        (double)fish_hist_percentile(h, 0.50) / 1e3, (double)fish_hist_percentile(h, 0.90) / 1e3,
+        (double)fish_hist_percentile(h, 0.99) / 1e3, (double)h->max / 1e3);
+    if (n <= 0 || (size_t)n >= sizeof(line)) return -1;
+
+    fossil_io_printf("%s", line);
+    if (!out_path) return 0;
+
+    fossil_io_file_t out;
+    if (fossil_io_file_open(&out, out_path, "a") != 0) return -1;
+    int rc = fossil_io_file_write(&out, line, 1, (size_t)n) == (size_t)n ? 0 : -1;
+    fossil_io_file_close(&out);
+    return rc;
+}
+
+/* ---------------- generators ---------------- */
+
+static size_t put_words(char *out, size_t cap, uint64_t *state, size_t width) {
+    size_t len = 0;
+    while (len < width && len + 1 < cap) {
+        const char *w = words[bench_rand(state) % WORD_COUNT];
+        if (len) out[len++] = ' ';
+        while (*w && len < width && len + 1 < cap) out[len++] = *w++;
+    }
+    return len;
+}
+
+static size_t csv_row(const bench_csv_t *shape, uint64_t row_seed, uint64_t id, char *out, size_t cap) {
+    uint64_t state = row_seed;
+    int n = snprintf(out, cap, "%llu,%.4f", (unsigned long long)id, rand_unit(&state) * 1000.0);
+    size_t len = n > 0 ? (size_t)n : 0;
+    for (size_t c = 0; c < shape->text_cols && len + 2 < cap; c++) {
+        out[len++] = ',';
+        if (rand_unit(&state) < shape->null_ratio) continue;
+        len += put_words(out + len, cap - len, &state, shape->width);
+    }
+    return len;
+}
+
+int bench_gen_csv(ccstring path, const bench_csv_t *shape) {
+    fish_row_writer_t out;
+    if (fish_row_writer_open(&out, path) != 0) return -1;
+
+    size_t cap = 64 + shape->text_cols * (shape->width + 2);
+    char *row = (char *)fossil_sys_memory_alloc(cap);
+    if (!row) {
+        fish_row_writer_abort(&out);
+        return -1;
+    }
+
+    int n = snprintf(row, cap, "id,value");
+    fish_row_writer_put(&out, row, (size_t)n);
+    for (size_t c = 0; c < shape->text_cols; c++) {
+        n = snprintf(row, cap, ",text%zu", c);
+        fish_row_writer_put(&out, row, (size_t)n);
+    }
+    fish_row_writer_end_row(&out);
+
+    uint64_t state = shape->seed;
+    for (size_t i = 0; i < shape->rows; i++) {
+        /* a duplicate re-derives an earlier row from that row's seed */
+        uint64_t source = i > 0 && rand_unit(&state) < shape->dup_ratio ? bench_rand(&state) % i : i;
+        uint64_t row_seed = shape->seed ^ (source * 0x9e3779b97f4a7c15ull);
+        size_t len = csv_row(shape, row_seed, source, row, cap);
+        fish_row_writer_write(&out, row, len);
+    }
+
+    fossil_sys_memory_free(row);
+    return fish_row_writer_commit(&out);
+}
+
+int bench_gen_text(ccstring path, size_t sentences, uint64_t seed) {
+    fish_row_writer_t out;
+    if (fish_row_writer_open_raw(&out, path) != 0) return -1;
+
+    uint64_t state = seed;
+    char sentence[512];
+    for (size_t s = 0; s < sentences; s++) {
+        size_t count = 5 + bench_rand(&state) % 16, len = 0;
+        for (size_t w = 0; w < count; w++) {
+            int n = snprintf(sentence + len, sizeof(sentence) - len, "%s%s", w ? " " : "",
+                             words[bench_rand(&state) % WORD_COUNT]);
+            if (n > 0) len += (size_t)n;
+        }
+        if (len) sentence[0] = (char)(sentence[0] - 'a' + 'A');
+        len += (size_t)snprintf(sentence + len, sizeof(sentence) - len, s % 6 == 5 ? ".\n\n" : ". ");
+        fish_row_writer_put(&out, sentence, len);
+    }
+    return fish_row_writer_commit(&out);
+}
@@ -0,0 +1,84 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_BENCH_H
+#define FOSSIL_APP_BENCH_H
+
+#include "fossil/code/app.h"
+#include "fossil/code/dataset.h"
+#include "fossil/code/trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Timings collected for one benchmark.
+ *
+ * Each timed operation adds its latency to the histogram and the rows
+ * and bytes it processed to the totals.
+ */
+typedef struct {
+    char name[64];
+    fish_hist_t latency;        /* ns per operation */
+    uint64_t rows;
+    uint64_t bytes;
+} bench_result_t;
+
+void bench_result_init(bench_result_t *r, ccstring name);
+
+void bench_record(bench_result_t *r, uint64_t ns, uint64_t rows, uint64_t bytes);
+
+/**
+ * @brief Print the result as one JSON line and append it to @p out_path (may be NULL).
+ *
+ * Fields: bench, version, ops, rows, bytes, seconds, ops_per_s,
+ * rows_per_s, mb_per_s and latency_us {mean, p50, p90, p99, max}.
+ */
+int bench_report(const bench_result_t *r, ccstring out_path);
+
+/**
+ * @brief Synthetic CSV shape.
+ */
+typedef struct {
+    size_t rows;
+    size_t text_cols;           /* word columns after id and value */
+    size_t width;               /* characters per text column */
+    double dup_ratio;           /* share of rows repeating an earlier row */
+    double null_ratio;          /* share of empty text cells */
+    uint64_t seed;
+} bench_csv_t;
+
+/**
+ * @brief Write a CSV with header "id,value,text0,...".
+ *
+ * Every row is derived from its own seed, so a duplicate is an exact
+ * copy of an earlier row and the same shape always gives the same file.
+ */
+int bench_gen_csv(ccstring path, const bench_csv_t *shape);
+
+/**
+ * @brief Write prose: @p sentences sentences of 5-20 words from a fixed vocabulary.
+ */
+int bench_gen_text(ccstring path, size_t sentences, uint64_t seed);
+
+/**
+ * @brief Next value of a splitmix64 sequence.
+ */
+uint64_t bench_rand(uint64_t *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_BENCH_H */
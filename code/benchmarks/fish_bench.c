@@ -0,0 +1,261 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "bench.h"
+#include "fossil/code/learn.h"
+#include "fossil/code/model.h"
+#include "fossil/code/scan.h"
+#include "fossil/code/zchain.h"
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#  include <direct.h>
+#endif
+
+/*
+ * fish-bench <case> [--rows n] [--iterations n] [--seed n] [--out file]
+ *
+ * Dataset cases regenerate datasets/current.dataset before every
+ * iteration (untimed) and time one full command run. Chain and
+ * reasoning cases time each save, load or answer on their own. Every
+ * case prints one JSON line per result and appends it to --out.
+ */
+
+#define BENCH_MODEL "bench-model"
+#define BENCH_TEXT "bench-text.txt"
+
+typedef struct {
+    size_t rows;
+    size_t iterations;
+    uint64_t seed;
+    ccstring out;
+} bench_opts_t;
+
+typedef int (*bench_command_fn)(void);
+
+static int ensure_datasets_dir(void) {
+#if defined(_WIN32)
+    _mkdir("datasets");
+#else
+    mkdir("datasets", 0755);
+#endif
+    return 0;
+}
+
+static int make_dataset(const bench_opts_t *o, double dup_ratio, double null_ratio, size_t iteration) {
+    bench_csv_t shape = { o->rows, 4, 24, dup_ratio, null_ratio, o->seed + iteration };
+    ensure_datasets_dir();
+    return bench_gen_csv(FISH_DATASET_PATH, &shape);
+}
+
+/* ---------------- dataset commands ---------------- */
+
+static int run_clean(void) { return fish_dataset_clean(1, 0, 1); }
+static int run_dedup(void) { return fish_dataset_clean(0, 1, 0); }
+static int run_preprocess(void) { return fish_dataset_preprocess(1, 1, 1); }
+static int run_augment(void) { return fish_dataset_augment("noise", 2); }
+static int run_split(void) { return fish_dataset_split(0.8f, 0.1f, 0.1f); }
+static int run_stats(void) { return fish_dataset_stats(1, NULL, 0); }
+
+static int bench_dataset(const bench_opts_t *o, ccstring name, bench_command_fn run, double dup_ratio) {
+    bench_result_t r;
+    bench_result_init(&r, name);
+    for (size_t i = 0; i < o->iterations; i++) {
+        if (make_dataset(o, dup_ratio, 0.05, i) != 0) return -1;
+        uint64_t bytes = fish_file_size(FISH_DATASET_PATH);
+        uint64_t start = fish_clock_ns();
+        if (run() != 0) return -1;
+        bench_record(&r, fish_clock_ns() - start, o->rows, bytes);
+    }
+    return bench_report(&r, o->out);
+}
+
+static int bench_summary(const bench_opts_t *o) {
+    bench_result_t r;
+    bench_result_init(&r, "summary");
+    if (bench_gen_text(BENCH_TEXT, o->rows, o->seed) != 0) return -1;
+    uint64_t bytes = fish_file_size(BENCH_TEXT);
+    for (size_t i = 0; i < o->iterations; i++) {
+        uint64_t start = fish_clock_ns();
+        if (fish_summary(BENCH_TEXT, 3, 0) != 0) return -1;
+        bench_record(&r, fish_clock_ns() - start, o->rows, bytes);
+    }
+    fossil_io_file_delete(BENCH_TEXT);
+    return bench_report(&r, o->out);
+}
+
+/* tokenize every line of the bench text with each kernel set the CPU has */
+static int bench_scan(const bench_opts_t *o) {
+    if (bench_gen_text(BENCH_TEXT, o->rows, o->seed) != 0) return -1;
+    fish_scan_isa_t chosen = fish_scan_isa();
+    char out[4096];
+    int rc = 0;
+
+    for (int isa = 0; isa < FISH_SCAN_ISA_COUNT && rc == 0; isa++) {
+        if (fish_scan_select((fish_scan_isa_t)isa) != 0) continue;
+        char name[64];
+        bench_result_t r;
+        snprintf(name, sizeof(name), "scan/%s", fish_scan_isa_name((fish_scan_isa_t)isa));
+        bench_result_init(&r, name);
+        for (size_t i = 0; i < o->iterations && rc == 0; i++) {
+            fish_row_reader_t reader;
+            fish_slice_t line;
+            uint64_t rows = 0, bytes = 0, elapsed = 0;
+            if (fish_row_reader_open(&reader, BENCH_TEXT) != 0) {
+                rc = -1;
+                break;
+            }
+            while (fish_row_reader_next(&reader, &line)) {
+                uint64_t start = fish_clock_ns();
+                fish_scan_tokens(line, out, sizeof(out));
+                elapsed += fish_clock_ns() - start;
+                rows++;
+                bytes += line.len;
+            }
+            fish_row_reader_close(&reader);
+            bench_record(&r, elapsed, rows, bytes);
+        }
+        if (rc == 0) rc = bench_report(&r, o->out);
+    }
+
+    fish_scan_select(chosen);
+    fossil_io_file_delete(BENCH_TEXT);
+    return rc;
+}
+
+/* ---------------- chains ---------------- */
+
+/* a full chain of "question <i>" -> "answer <i>" pairs */
+static fossil_ai_jellyfish_chain_t *make_chain(void) {
+    fossil_ai_jellyfish_chain_t *chain = (fossil_ai_jellyfish_chain_t *)
+        fossil_sys_memory_calloc(1, sizeof(fossil_ai_jellyfish_chain_t));
+    fish_pair_t *pairs = (fish_pair_t *)fossil_sys_memory_alloc(FOSSIL_JELLYFISH_MAX_MEM * sizeof(fish_pair_t));
+    char (*text)[2][32] = (char (*)[2][32])fossil_sys_memory_alloc(FOSSIL_JELLYFISH_MAX_MEM * sizeof(*text));
+    if (!chain || !pairs || !text) {
+        fossil_sys_memory_free(chain);
+        chain = NULL;
+    } else {
+        for (size_t i = 0; i < FOSSIL_JELLYFISH_MAX_MEM; i++) {
+            snprintf(text[i][0], sizeof(text[i][0]), "question %zu", i);
+            snprintf(text[i][1], sizeof(text[i][1]), "answer %zu", i);
+            pairs[i].input = text[i][0];
+            pairs[i].output = text[i][1];
+        }
+        fish_chain_learn_bulk(chain, pairs, FOSSIL_JELLYFISH_MAX_MEM);
+    }
+    fossil_sys_memory_free(pairs);
+    fossil_sys_memory_free(text);
+    return chain;
+}
+
+static int chain_write(const fossil_ai_jellyfish_chain_t *chain, ccstring path, int compressed) {
+    return compressed ? fish_zchain_save(chain, path) : fossil_ai_jellyfish_save(chain, path);
+}
+
+static int bench_chain(const bench_opts_t *o, int load) {
+    static const char *const formats[] = { "bin", "zchain" };
+    fossil_ai_jellyfish_chain_t *chain = make_chain();
+    fossil_ai_jellyfish_chain_t *back = (fossil_ai_jellyfish_chain_t *)
+        fossil_sys_memory_calloc(1, sizeof(fossil_ai_jellyfish_chain_t));
+    int rc = chain && back ? 0 : -1;
+
+    for (int f = 0; f < 2 && rc == 0; f++) {
+        char name[64];
+        bench_result_t r;
+        snprintf(name, sizeof(name), "chain_%s/%s", load ? "load" : "save", formats[f]);
+        bench_result_init(&r, name);
+        if (load) rc = chain_write(chain, BENCH_MODEL ".jfchain", f);
+
+        for (size_t i = 0; i < o->iterations && rc == 0; i++) {
+            uint64_t start = fish_clock_ns();
+            rc = load ? fish_chain_load(back, BENCH_MODEL ".jfchain") : chain_write(chain, BENCH_MODEL ".jfchain", f);
+            uint64_t ns = fish_clock_ns() - start;
+            if (rc == 0) bench_record(&r, ns, chain->count, fish_file_size(BENCH_MODEL ".jfchain"));
+        }
+        if (rc == 0) rc = bench_report(&r, o->out);
+    }
+
+    fossil_io_file_delete(BENCH_MODEL ".jfchain");
+    fossil_sys_memory_free(chain);
+    fossil_sys_memory_free(back);
+    return rc;
+}
+
+/* ---------------- reasoning ---------------- */
+
+static int bench_reason(const bench_opts_t *o, int chat) {
+    fossil_ai_jellyfish_chain_t *chain = make_chain();
+    int rc = chain && fossil_ai_jellyfish_save(chain, BENCH_MODEL ".jfchain") == 0 ? 0 : -1;
+    fossil_sys_memory_free(chain);
+    fish_model_t *model = rc == 0 && fish_models_init() == 0 ? fish_model_acquire(BENCH_MODEL) : NULL;
+    if (!model) rc = -1;
+
+    bench_result_t r;
+    bench_result_init(&r, chat ? "chat" : "ask");
+    uint64_t state = o->seed;
+    char prompt[64], reply[FISH_MODEL_REPLY_MAX];
+    size_t ops = o->rows * o->iterations;
+    for (size_t i = 0; i < ops && rc == 0; i++) {
+        /* three in four prompts were learned, the rest go through reasoning */
+        uint64_t k = bench_rand(&state) % (FOSSIL_JELLYFISH_MAX_MEM + FOSSIL_JELLYFISH_MAX_MEM / 3);
+        int n = snprintf(prompt, sizeof(prompt), "question %llu", (unsigned long long)k);
+        float conf = 0.0f;
+        uint64_t start = fish_clock_ns();
+        if (chat) fish_model_chat(model, prompt, 0, reply, sizeof(reply), &conf);
+        else fish_model_answer(model, prompt, reply, sizeof(reply), &conf, NULL, 0);
+        bench_record(&r, fish_clock_ns() - start, 1, (uint64_t)n);
+    }
+    if (rc == 0) rc = bench_report(&r, o->out);
+
+    if (model) fish_models_release(0);
+    fossil_io_file_delete(BENCH_MODEL ".jfchain");
+    return rc;
+}
+
+/* ---------------- driver ---------------- */
+
+static int run_case(ccstring name, const bench_opts_t *o) {
+    if (strcmp(name, "clean") == 0) return bench_dataset(o, name, run_clean, 0.0);
+    if (strcmp(name, "dedup") == 0) return bench_dataset(o, name, run_dedup, 0.3);
+    if (strcmp(name, "preprocess") == 0) return bench_dataset(o, name, run_preprocess, 0.0);
+    if (strcmp(name, "augment") == 0) return bench_dataset(o, name, run_augment, 0.0);
+    if (strcmp(name, "split") == 0) return bench_dataset(o, name, run_split, 0.0);
+    if (strcmp(name, "stats") == 0) return bench_dataset(o, name, run_stats, 0.0);
+    if (strcmp(name, "summary") == 0) return bench_summary(o);
+    if (strcmp(name, "scan") == 0) return bench_scan(o);
+    if (strcmp(name, "chain_save") == 0) return bench_chain(o, 0);
+    if (strcmp(name, "chain_load") == 0) return bench_chain(o, 1);
+    if (strcmp(name, "ask") == 0) return bench_reason(o, 0);
+    if (strcmp(name, "chat") == 0) return bench_reason(o, 1);
+    fossil_io_printf("{red}fish-bench: unknown case '%s'{normal}\n", name);
+    return -1;
+}
+
+int main(int argc, char **argv) {
+    bench_opts_t o = { 100000, 5, 0x6669736862656e63ull /* "fishbenc" */, NULL };
+    if (argc < 2) {
+        fossil_io_printf("{blue}Usage: {cyan}%s{blue} <case> [--rows n] [--iterations n] [--seed n] [--out file]{normal}\n", argv[0]);
+        fossil_io_printf("{blue}Cases: clean dedup preprocess augment split stats summary scan chain_save chain_load ask chat{normal}\n");
+        return 2;
+    }
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--rows") == 0) o.rows = (size_t)strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--iterations") == 0) o.iterations = (size_t)strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--seed") == 0) o.seed = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--out") == 0) o.out = argv[i + 1];
+    }
+    if (o.rows == 0) o.rows = 1;
+    if (o.iterations == 0) o.iterations = 1;
+    return run_case(argv[1], &o) == 0 ? 0 : 1;
+}
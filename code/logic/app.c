@@ -12,12 +12,14 @@
  * -----------------------------------------------------------------------------
  */
 #include "fossil/code/app.h"
+#include "fossil/code/cli.h"
+#include "fossil/code/trace.h"
 #include <unistd.h>
 
 int FOSSIL_IO_VERBOSE = false; // Verbose output flag
 
 void show_commands(char* app_name) {
-    fossil_io_printf("{blue}Usage: {cyan}%s{blue} <options>{reset}\n", app_name);
+    fossil_io_printf("{blue}Usage: {cyan}%s{blue} <options> <command> [flags]{reset}\n", app_name);
     fossil_io_printf("{blue}Options:{reset}\n");
     fossil_io_printf("{cyan}  --help           Display help information for the Shark tool.{reset}\n");
     fossil_io_printf("{cyan}  --version        Display the current version of the Shark tool.{reset}\n");
@@ -25,6 +27,10 @@ void show_commands(char* app_name) {
     fossil_io_printf("{cyan}  --verbose        Enable verbose output for all commands.{reset}\n");
     fossil_io_printf("{cyan}  --color          Set color output mode: {yellow}enable{cyan}, {yellow}disable{cyan}, or {yellow}auto{cyan}.{reset}\n");
     fossil_io_printf("{cyan}  --clear          Clear terminal or console output.{reset}\n");
+    fossil_io_printf("{cyan}  --trace <file>   Write per-stage timings (load, parse, hash, learn, reason, save) at exit.{reset}\n");
+    fossil_io_printf("{cyan}  --trace-format   Trace file format: {yellow}json{cyan} (summary) or {yellow}chrome{cyan} (trace events).{reset}\n");
+    fossil_io_printf("{blue}Commands:{reset}\n");
+    fish_cli_usage();
     exit(FOSSIL_IO_SUCCESS);
 }
 
@@ -39,7 +45,11 @@ void show_name(void) {
 }
 
 bool app_entry(int argc, char** argv) {
-    for (i32 i = 1; i < argc; ++i) {
+    ccstring trace_path = cnullptr;
+    fish_trace_format_t trace_format = FISH_TRACE_JSON;
+    i32 command = 0;
+
+    for (i32 i = 1; i < argc && !command; ++i) {
         if (argv[i] == cnullptr) continue;
 
         if (fossil_io_cstring_compare(argv[i], "--help") == 0) {
@@ -64,10 +74,33 @@ bool app_entry(int argc, char** argv) {
             }
         } else if (fossil_io_cstring_compare(argv[i], "--clear") == 0) {
             fossil_io_printf("\033[H\033[J"); // ANSI escape sequence to clear screen
+        } else if (fossil_io_cstring_compare(argv[i], "--trace") == 0) {
+            if (i + 1 < argc && argv[i + 1] != cnullptr) {
+                trace_path = argv[i + 1];
+                ++i; // Skip next argument
+            }
+        } else if (fossil_io_cstring_compare(argv[i], "--trace-format") == 0) {
+            if (i + 1 < argc && argv[i + 1] != cnullptr) {
+                if (fossil_io_cstring_compare(argv[i + 1], "chrome") == 0) {
+                    trace_format = FISH_TRACE_CHROME;
+                } else if (fossil_io_cstring_compare(argv[i + 1], "json") == 0) {
+                    trace_format = FISH_TRACE_JSON;
+                }
+                ++i; // Skip next argument
+            }
+        } else if (argv[i][0] != '-') {
+            command = i; // Options end at the subcommand
         } else {
-            fossil_io_printf("{red}Unknown command: %s{reset}\n", argv[i]);
-            return false;
+            fossil_io_printf("{red}Unknown option: %s{reset}\n", argv[i]);
+            return true;
         }
     }
-    return 0;
+
+    if (trace_path && fish_trace_enable(trace_path, trace_format) != 0) {
+        fossil_io_printf("{yellow}Cannot trace to %s (tracing off or compiled out).{reset}\n", trace_path);
+    }
+    if (command) {
+        return fish_cli_dispatch(argc - command, argv + command) != 0;
+    }
+    return false;
 }
@@ -0,0 +1,253 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/arena.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#define ARENA_ALIGN 16
+#define INTERN_SEED 0x696e746eull /* "intn" */
+
+struct fish_arena_block {
+    fish_arena_block_t *next;   /* older block */
+    size_t size;                /* usable bytes after the header */
+};
+
+/* block header rounded up so the payload keeps ARENA_ALIGN alignment */
+#define ARENA_HEADER ((sizeof(fish_arena_block_t) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static char *block_data(fish_arena_block_t *block) {
+    return (char *)block + ARENA_HEADER;
+}
+
+/* ---------------- arena ---------------- */
+
+void fish_arena_init(fish_arena_t *arena, size_t block_size) {
+    fossil_sys_memory_zero(arena, sizeof(*arena));
+    arena->block_size = block_size ? block_size : FISH_ARENA_BLOCK_SIZE;
+}
+
+void *fish_arena_alloc(fish_arena_t *arena, size_t size) {
+    size_t at = (arena->used + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    if (!arena->head || at + size > arena->head->size) {
+        size_t want = size > arena->block_size ? size : arena->block_size;
+        fish_arena_block_t *block = (fish_arena_block_t *)fossil_sys_memory_alloc(ARENA_HEADER + want);
+        if (!block) return NULL;
+        block->size = want;
+        if (want > arena->block_size && arena->head) {
+            /* oversized: keep allocating from the current head afterwards */
+            block->next = arena->head->next;
+            arena->head->next = block;
+            arena->total += size;
+            return block_data(block);
+        }
+        block->next = arena->head;
+        arena->head = block;
+        at = 0;
+    }
+
+    arena->used = at + size;
+    arena->total += size;
+    return block_data(arena->head) + at;
+}
+
+char *fish_arena_strndup(fish_arena_t *arena, fish_slice_t s) {
+    char *out = (char *)fish_arena_alloc(arena, s.len + 1);
+    if (!out) return NULL;
+    if (s.len) fossil_sys_memory_copy(out, s.ptr, s.len);
+    out[s.len] = '\0';
+    return out;
+}
+
+void fish_arena_reset(fish_arena_t *arena) {
+    if (!arena->head) return;
+    /* keep the oldest block: it is a regular one */
+    fish_arena_block_t *keep = arena->head;
+    while (keep->next) {
+        fish_arena_block_t *newer = keep;
+        keep = keep->next;
+        fossil_sys_memory_free(newer);
+    }
+    if (keep->size != arena->block_size) {
+        fossil_sys_memory_free(keep);
+        keep = NULL;
+    }
+    arena->head = keep;
+    arena->used = 0;
+    arena->total = 0;
+}
+
+void fish_arena_free(fish_arena_t *arena) {
+    fish_arena_block_t *block = arena->head;
+    while (block) {
+        fish_arena_block_t *next = block->next;
+        fossil_sys_memory_free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->used = 0;
+    arena->total = 0;
+}
+
+/* ---------------- intern table ---------------- */
+
+static int intern_resolve(void *ctx, uint64_t ref, size_t len, fish_slice_t *out) {
+    const fish_intern_t *table = (const fish_intern_t *)ctx;
+    if (ref >= table->count) return -1;
+    *out = table->str[ref];
+    return 0;
+}
+
+int fish_intern_init(fish_intern_t *table, fish_arena_t *arena, size_t expected) {
+    fossil_sys_memory_zero(table, sizeof(*table));
+    table->arena = arena;
+    return fish_hashset_init(&table->set, expected, intern_resolve, table);
+}
+
+int fish_intern_find(fish_intern_t *table, fish_slice_t s, uint32_t *id) {
+    uint64_t ref = 0;
+    int found = fish_hashset_lookup(&table->set, fish_hash64(s.ptr, s.len, INTERN_SEED), s, &ref);
+    if (found == 1 && id) *id = (uint32_t)ref;
+    return found;
+}
+
+int fish_intern_add(fish_intern_t *table, fish_slice_t s, uint32_t *id) {
+    uint64_t digest = fish_hash64(s.ptr, s.len, INTERN_SEED);
+    uint64_t ref = 0;
+    int found = fish_hashset_lookup(&table->set, digest, s, &ref);
+    if (found != 0) {
+        if (found == 1 && id) *id = (uint32_t)ref;
+        return found < 0 ? -1 : 0;
+    }
+    if (table->count >= UINT32_MAX) return -1;
+
+    if (table->count == table->cap) {
+        size_t cap = table->cap ? table->cap * 2 : 256;
+        fish_slice_t *grown = (fish_slice_t *)fossil_sys_memory_realloc(table->str, cap * sizeof(fish_slice_t));
+        if (!grown) return -1;
+        table->str = grown;
+        table->cap = cap;
+    }
+    char *copy = fish_arena_strndup(table->arena, s);
+    if (!copy) return -1;
+    table->str[table->count].ptr = copy;
+    table->str[table->count].len = s.len;
+    if (fish_hashset_insert(&table->set, digest, table->str[table->count], table->count) < 0) return -1;
+    if (id) *id = (uint32_t)table->count;
+    table->count++;
+    return 1;
+}
+
+void fish_intern_reset(fish_intern_t *table) {
+    fish_hashset_clear(&table->set);
+    table->count = 0;
+}
+
+void fish_intern_free(fish_intern_t *table) {
+    fish_hashset_free(&table->set);
+    fossil_sys_memory_free(table->str);
+    table->str = NULL;
+    table->count = 0;
+    table->cap = 0;
+}
+
+/* ---------------- command scratch ---------------- */
+
+#define SCRATCH_MIN 32
+#define SCRATCH_CLASSES 8       /* SCRATCH_MIN << 7 == FISH_SCRATCH_POOL_MAX */
+
+typedef struct scratch_chunk {
+    struct scratch_chunk *next; /* free list link */
+    size_t size;                /* usable bytes: the class size, or exact when larger */
+} scratch_chunk_t;
+
+#define SCRATCH_HEADER ((sizeof(scratch_chunk_t) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static struct {
+    fish_arena_t arena;
+    scratch_chunk_t *free[SCRATCH_CLASSES];
+    fish_scratch_stats_t stats;
+} scratch;
+
+static size_t scratch_class(size_t size, size_t *class_size) {
+    size_t cls = 0, bytes = SCRATCH_MIN;
+    while (bytes < size) {
+        bytes <<= 1;
+        cls++;
+    }
+    *class_size = bytes;
+    return cls;
+}
+
+void *fish_scratch_alloc(size_t size) {
+    size_t bytes = size;
+    size_t cls = SCRATCH_CLASSES;
+    if (size <= FISH_SCRATCH_POOL_MAX) cls = scratch_class(size, &bytes);
+
+    scratch_chunk_t *chunk = NULL;
+    if (cls < SCRATCH_CLASSES && scratch.free[cls]) {
+        chunk = scratch.free[cls];
+        scratch.free[cls] = chunk->next;
+        scratch.stats.reused++;
+    } else {
+        if (!scratch.arena.block_size) fish_arena_init(&scratch.arena, 0);
+        chunk = (scratch_chunk_t *)fish_arena_alloc(&scratch.arena, SCRATCH_HEADER + bytes);
+        if (!chunk) return NULL;
+        chunk->size = bytes;
+        scratch.stats.reserved += SCRATCH_HEADER + bytes;
+    }
+    chunk->next = NULL;
+    scratch.stats.allocs++;
+    scratch.stats.live += bytes;
+    if (scratch.stats.live > scratch.stats.peak) scratch.stats.peak = scratch.stats.live;
+    return (char *)chunk + SCRATCH_HEADER;
+}
+
+cstring fish_scratch_format(ccstring fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    if (len < 0) return NULL;
+
+    cstring out = (cstring)fish_scratch_alloc((size_t)len + 1);
+    if (!out) return NULL;
+    va_start(args, fmt);
+    vsnprintf(out, (size_t)len + 1, fmt, args);
+    va_end(args);
+    return out;
+}
+
+void fish_scratch_free(void *ptr) {
+    if (!ptr) return;
+    scratch_chunk_t *chunk = (scratch_chunk_t *)((char *)ptr - SCRATCH_HEADER);
+    scratch.stats.live -= chunk->size;
+    /* larger chunks stay in the arena until the release */
+    if (chunk->size > FISH_SCRATCH_POOL_MAX) return;
+    size_t bytes;
+    size_t cls = scratch_class(chunk->size, &bytes);
+    chunk->next = scratch.free[cls];
+    scratch.free[cls] = chunk;
+}
+
+void fish_scratch_stats(fish_scratch_stats_t *stats) {
+    *stats = scratch.stats;
+}
+
+void fish_scratch_release(fish_scratch_stats_t *stats) {
+    if (stats) *stats = scratch.stats;
+    fish_arena_free(&scratch.arena);
+    fossil_sys_memory_zero(&scratch, sizeof(scratch));
+}
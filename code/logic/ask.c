@@ -11,60 +11,488 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
+#include "fossil/code/arena.h"
 #include "fossil/code/commands.h"
+#include "fossil/code/model.h"
+#include "fossil/code/trace.h"
+
+#include <stdarg.h>
 
 /* --------------------------------------------------------------
- * Internal mock backend call.
- * In the real system, this would call Jellyfish AI or Shark AI.
- * For now it generates a deterministic pseudo-answer using Jellyfish chain.
+ * Reason on the resident chain of @p model and format the answer.
+ * The chain is loaded once per process by fish_model_acquire, so
+ * repeated asks (or a fish serve daemon) pay the load cost once.
  * -------------------------------------------------------------- */
-static void backend_generate_reply(ccstring model,
+static void backend_generate_reply(fish_model_t *model,
                                    ccstring prompt,
                                    int explain,
                                    cstring out, size_t out_sz)
 {
-    fossil_ai_jellyfish_chain_t chain;
-    fossil_ai_jellyfish_init(&chain);
-
-    /* Simulate learning the prompt and a canned output */
-    const char *mock_output = "processed.";
-    fossil_ai_jellyfish_learn(&chain, prompt, mock_output);
-
+    char answer[FISH_MODEL_REPLY_MAX];
+    char block_explain[256];
     float confidence = 0.0f;
-    fossil_sys_memory_t reasoned_output = fossil_sys_memory_calloc(1, 256);
-    const fossil_ai_jellyfish_block_t *block = NULL;
-    bool found = fossil_ai_jellyfish_reason_verbose(&chain, prompt, (char *)reasoned_output, &confidence, &block);
-
-    cstring explanation = NULL;
-    if (explain && found && block) {
-        fossil_sys_memory_t block_explain = fossil_sys_memory_calloc(1, 256);
-        fossil_ai_jellyfish_block_explain(block, (char *)block_explain, 256);
-        explanation = fossil_io_cstring_create((char *)block_explain);
-        fossil_sys_memory_free(block_explain);
+    int found = fish_model_ask(model, prompt, answer, sizeof(answer), &confidence,
+                               explain ? block_explain : NULL, sizeof(block_explain));
+
+    ccstring explanation = "";
+    if (explain && found && block_explain[0]) {
+        explanation = block_explain;
     } else if (explain) {
-        explanation = fossil_io_cstring_create("Explanation: (no block found).\n");
-    } else {
-        explanation = fossil_io_cstring_create("");
+        explanation = "Explanation: (no block found).\n";
     }
 
-    cstring formatted = fossil_io_cstring_format_safe(out_sz,
+    snprintf(out, out_sz,
         "[model=%s]\n"
         "Answer: \"%s\" -> %s\n"
         "Confidence: %.2f\n"
         "%s",
-        model,
+        model->name,
         prompt,
-        found ? (char *)reasoned_output : "Unknown",
+        found ? answer : "Unknown",
         confidence,
         explanation
     );
+}
+
+int fish_ask(const char *model_name, const char *prompt,
+             const char *file_path, int explain)
+{
+    if (!model_name || !prompt || !*prompt) {
+        fossil_io_printf("{red,bold}fish_ask: model name and prompt are required.{normal}\n");
+        return -1;
+    }
+
+    fish_model_t *model = fish_model_acquire(model_name);
+    if (!model) {
+        fossil_io_printf("{red,bold}fish_ask: cannot load model '{normal}%s{red,bold}'{normal}\n", model_name);
+        return -1;
+    }
+    if (!model->loaded) {
+        fossil_io_printf("{yellow,bold}fish_ask: '{normal}%s.jfchain{yellow,bold}' not found, using an empty chain.{normal}\n",
+                         model_name);
+    }
+
+    char reply[FISH_MODEL_REPLY_MAX * 2];
+    backend_generate_reply(model, prompt, explain, reply, sizeof(reply));
+    fossil_io_printf("%s", reply);
+    if (reply[0] && reply[strlen(reply) - 1] != '\n') fossil_io_printf("\n");
+
+    if (file_path) {
+        fossil_io_file_t file;
+        if (fossil_io_file_open(&file, file_path, "wb") != 0) {
+            fossil_io_printf("{red,bold}fish_ask: cannot write '{normal}%s{red,bold}'{normal}\n", file_path);
+            return -1;
+        }
+        size_t len = strlen(reply);
+        size_t wrote = fossil_io_file_write(&file, reply, 1, len);
+        fossil_io_file_close(&file);
+        if (wrote != len) {
+            fossil_io_printf("{red,bold}fish_ask: short write to '{normal}%s{red,bold}'{normal}\n", file_path);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* ---------------- batch mode ---------------- */
+
+/*
+ * A batch reads one prompt per line from a file or stdin ("-"): plain
+ * text, or a JSON object whose "prompt" (or "input") member holds it.
+ * The chain is loaded once. Lines are read in windows of ASK_BATCH_ROWS;
+ * the workers claim rows of a window and answer them on the shared
+ * chain under its read lock, then the window is written out in input
+ * order before the next one is read. Memory is bounded by one window
+ * however long the input is. Every non-empty line gets one JSONL result:
+ *
+ *   {"line":N,"prompt":"...","found":true,"confidence":0.9000,"answer":"..."}
+ *   {"line":N,"error":"no prompt"}
+ *
+ * with an "explain" member when asked for.
+ */
+
+#define ASK_BATCH_ROWS 2048
+#define ASK_CLAIM_ROWS 16
+#define ASK_PROMPT_MAX sizeof(((fossil_ai_jellyfish_block_t *)0)->input)
+#define ASK_EXPLAIN_MAX 256
+#define ASK_LINE_MAX ((size_t)1 << 16)
+
+typedef struct {
+    uint64_t line;
+    ccstring prompt;            /* NULL: the line held no prompt */
+    int found;
+    float confidence;
+    char answer[FISH_MODEL_REPLY_MAX];
+    char explain[ASK_EXPLAIN_MAX];
+} ask_row_t;
+
+typedef struct {
+    fish_model_t *model;
+    int explain;
+    int from_stdin;
+    fish_row_reader_t reader;   /* file input */
+    char *line;                 /* stdin line buffer */
+    uint64_t lines;
+    fish_arena_t arena;         /* prompts of the current window */
+    ask_row_t *row;
+    size_t rows;
+    volatile size_t next;
+    char *out;                  /* the window rendered as JSONL */
+    size_t out_len;
+    size_t out_cap;
+    int out_failed;
+} ask_batch_t;
+
+static int batch_next_line(ask_batch_t *b, fish_slice_t *line) {
+    if (!b->from_stdin) return fish_row_reader_next(&b->reader, line);
+    if (!fgets(b->line, (int)ASK_LINE_MAX, stdin)) return 0;
+
+    size_t len = strlen(b->line);
+    if (len > 0 && b->line[len - 1] == '\n') {
+        len--;
+    } else if (len == ASK_LINE_MAX - 1) {
+        /* overlong line: keep its head, drop the rest */
+        int c;
+        while ((c = getc(stdin)) != EOF && c != '\n') {}
+    }
+    if (len > 0 && b->line[len - 1] == '\r') len--;
+    line->ptr = b->line;
+    line->len = len;
+    return 1;
+}
+
+/* Append UTF-8 for code point @p c if it fits; n is the bytes used so far */
+static size_t utf8_put(unsigned long c, char *out, size_t cap, size_t n) {
+    char enc[4];
+    size_t k;
+    if (c < 0x80) {
+        enc[0] = (char)c;
+        k = 1;
+    } else if (c < 0x800) {
+        enc[0] = (char)(0xC0 | (c >> 6));
+        enc[1] = (char)(0x80 | (c & 0x3F));
+        k = 2;
+    } else if (c < 0x10000) {
+        enc[0] = (char)(0xE0 | (c >> 12));
+        enc[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+        enc[2] = (char)(0x80 | (c & 0x3F));
+        k = 3;
+    } else {
+        enc[0] = (char)(0xF0 | (c >> 18));
+        enc[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+        enc[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+        enc[3] = (char)(0x80 | (c & 0x3F));
+        k = 4;
+    }
+    /* never split a character when the buffer runs out */
+    if (!out || n + k >= cap) return n;
+    fossil_sys_memory_copy(out + n, enc, k);
+    return n + k;
+}
+
+static int json_hex4(fish_slice_t s, size_t *at, unsigned long *value) {
+    unsigned long v = 0;
+    if (*at + 4 > s.len) return 0;
+    for (size_t k = 0; k < 4; k++) {
+        char h = s.ptr[*at + k];
+        v <<= 4;
+        if (h >= '0' && h <= '9') v |= (unsigned long)(h - '0');
+        else if (h >= 'a' && h <= 'f') v |= (unsigned long)(h - 'a' + 10);
+        else if (h >= 'A' && h <= 'F') v |= (unsigned long)(h - 'A' + 10);
+        else return 0;
+    }
+    *at += 4;
+    *value = v;
+    return 1;
+}
 
-    fossil_sys_memory_set(out, 0, out_sz);
-    strncpy(out, formatted, out_sz - 1);
-    out[out_sz - 1] = '\0';
+/*
+ * Decode the JSON string opening at s.ptr[*at] into @p out (NULL to skip
+ * it), truncated to @p cap - 1 bytes. Leaves *at past the closing quote.
+ */
+static int json_string(fish_slice_t s, size_t *at, char *out, size_t cap) {
+    size_t i = *at + 1;
+    size_t n = 0;
+    while (i < s.len && s.ptr[i] != '"') {
+        unsigned long c = (unsigned char)s.ptr[i++];
+        if (c == '\\') {
+            if (i >= s.len) return 0;
+            char e = s.ptr[i++];
+            switch (e) {
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u':
+                    if (!json_hex4(s, &i, &c)) return 0;
+                    if (c >= 0xD800 && c < 0xDC00) {
+                        unsigned long low = 0;
+                        size_t j = i + 2;
+                        if (i + 1 < s.len && s.ptr[i] == '\\' && s.ptr[i + 1] == 'u' &&
+                            json_hex4(s, &j, &low) && low >= 0xDC00 && low < 0xE000) {
+                            c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                            i = j;
+                        } else {
+                            c = 0xFFFD;
+                        }
+                    } else if (c >= 0xDC00 && c < 0xE000) {
+                        c = 0xFFFD;
+                    }
+                    n = utf8_put(c, out, cap, n);
+                    continue;
+                default: c = (unsigned char)e; break;
+            }
+        }
+        if (out && n + 1 < cap) out[n++] = (char)c;
+    }
+    if (i >= s.len) return 0;
+    if (out && cap) out[n] = '\0';
+    *at = i + 1;
+    return 1;
+}
+
+static size_t json_space(fish_slice_t s, size_t i) {
+    while (i < s.len && (s.ptr[i] == ' ' || s.ptr[i] == '\t')) i++;
+    return i;
+}
+
+/* Skip the member value at s.ptr[*at], stopping at the ',' or '}' after it */
+static int json_skip(fish_slice_t s, size_t *at) {
+    size_t i = *at;
+    int depth = 0;
+    while (i < s.len) {
+        char c = s.ptr[i];
+        if (c == '"') {
+            if (!json_string(s, &i, NULL, 0)) return 0;
+            continue;
+        }
+        if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (depth == 0) break;
+            depth--;
+        } else if (c == ',' && depth == 0) {
+            break;
+        }
+        i++;
+    }
+    *at = i;
+    return depth == 0 && i < s.len;
+}
+
+/* Pull the "prompt" (or "input") string out of a one-line JSON object */
+static int json_prompt(fish_slice_t s, char *out, size_t cap) {
+    char key[16];
+    size_t i = 1;
+    for (;;) {
+        i = json_space(s, i);
+        if (i >= s.len || s.ptr[i] != '"' || !json_string(s, &i, key, sizeof(key))) return 0;
+        i = json_space(s, i);
+        if (i >= s.len || s.ptr[i] != ':') return 0;
+        i = json_space(s, i + 1);
+        if (i < s.len && s.ptr[i] == '"' && (strcmp(key, "prompt") == 0 || strcmp(key, "input") == 0))
+            return json_string(s, &i, out, cap) && out[0] != '\0';
+        if (!json_skip(s, &i) || s.ptr[i] != ',') return 0;
+        i++;
+    }
+}
+
+/* Read the next window of prompts; returns rows read, or -1 on OOM */
+static int batch_read(ask_batch_t *b) {
+    char prompt[ASK_PROMPT_MAX];
+    fish_slice_t line;
+
+    FISH_TRACE_BEGIN(trace);
+    fish_arena_reset(&b->arena);
+    b->rows = 0;
+    b->next = 0;
+    while (b->rows < ASK_BATCH_ROWS && batch_next_line(b, &line)) {
+        b->lines++;
+        line = fish_slice_trim(line);
+        if (line.len == 0) continue;
+
+        ask_row_t *row = &b->row[b->rows++];
+        row->line = b->lines;
+        row->prompt = NULL;
+        row->found = 0;
+        row->confidence = 0.0f;
+        row->answer[0] = '\0';
+        row->explain[0] = '\0';
+
+        if (line.ptr[0] == '{') {
+            if (!json_prompt(line, prompt, sizeof(prompt))) continue;
+        } else {
+            fish_slice_copy(line, prompt, sizeof(prompt));
+        }
+        fish_slice_t text = { prompt, strlen(prompt) };
+        if (!(row->prompt = fish_arena_strndup(&b->arena, text))) return -1;
+    }
+    FISH_TRACE_END(FISH_STAGE_PARSE, trace, b->rows);
+    return (int)b->rows;
+}
+
+static void batch_worker(void *arg, size_t index) {
+    ask_batch_t *b = (ask_batch_t *)arg;
+    (void)index;
+    for (;;) {
+        size_t begin = fish_thread_claim(&b->next) * ASK_CLAIM_ROWS;
+        if (begin >= b->rows) break;
+        size_t end = begin + ASK_CLAIM_ROWS < b->rows ? begin + ASK_CLAIM_ROWS : b->rows;
+        for (size_t r = begin; r < end; r++) {
+            ask_row_t *row = &b->row[r];
+            if (!row->prompt) continue;
+            row->found = fish_model_ask(b->model, row->prompt, row->answer, sizeof(row->answer),
+                                        &row->confidence, b->explain ? row->explain : NULL,
+                                        sizeof(row->explain));
+        }
+    }
+}
+
+static void out_printf(ask_batch_t *b, const char *fmt, ...) {
+    va_list args;
+    if (b->out_failed) return;
+    for (;;) {
+        size_t room = b->out_cap - b->out_len;
+        va_start(args, fmt);
+        int n = b->out ? vsnprintf(b->out + b->out_len, room, fmt, args) : -1;
+        va_end(args);
+        if (n >= 0 && (size_t)n < room) {
+            b->out_len += (size_t)n;
+            return;
+        }
+        size_t cap = b->out_cap ? b->out_cap * 2 : ((size_t)1 << 16);
+        while (n >= 0 && cap < b->out_len + (size_t)n + 1) cap *= 2;
+        char *grown = (char *)fossil_sys_memory_realloc(b->out, cap);
+        if (!grown) {
+            b->out_failed = 1;
+            return;
+        }
+        b->out = grown;
+        b->out_cap = cap;
+    }
+}
+
+static void out_string(ask_batch_t *b, ccstring s) {
+    cstring escaped = fossil_io_cstring_escape_json(s);
+    if (!escaped) b->out_failed = 1;
+    out_printf(b, "\"%s\"", escaped ? escaped : "");
+    fossil_io_cstring_free(escaped);
+}
+
+static void batch_render(ask_batch_t *b, uint64_t *found) {
+    b->out_len = 0;
+    for (size_t r = 0; r < b->rows; r++) {
+        const ask_row_t *row = &b->row[r];
+        out_printf(b, "{\"line\":%llu,", (unsigned long long)row->line);
+        if (!row->prompt) {
+            out_printf(b, "\"error\":\"no prompt\"}\n");
+            continue;
+        }
+        out_printf(b, "\"prompt\":");
+        out_string(b, row->prompt);
+        out_printf(b, ",\"found\":%s,\"confidence\":%.4f,\"answer\":",
+                   row->found ? "true" : "false", (double)row->confidence);
+        if (row->found) out_string(b, row->answer);
+        else out_printf(b, "null");
+        if (b->explain) {
+            out_printf(b, ",\"explain\":");
+            out_string(b, row->explain);
+        }
+        out_printf(b, "}\n");
+        *found += (uint64_t)(row->found != 0);
+    }
+}
+
+static int batch_write(ask_batch_t *b, fish_row_writer_t *out) {
+    if (b->out_failed) return -1;
+    if (out) return fish_row_writer_put(out, b->out, b->out_len);
+    if (b->out_len && fwrite(b->out, 1, b->out_len, stdout) != b->out_len) return -1;
+    return fflush(stdout) == 0 ? 0 : -1;
+}
+
+int fish_ask_batch(const char *model_name, const char *input_path,
+                   const char *out_path, int explain)
+{
+    if (!model_name || !input_path || !*input_path) {
+        fossil_io_printf("{red,bold}fish_ask: model name and batch input are required.{normal}\n");
+        return -1;
+    }
+    /* with the results on stdout, only errors may be printed */
+    int quiet = !out_path || strcmp(out_path, "-") == 0;
+    ask_batch_t *b = (ask_batch_t *)fossil_sys_memory_calloc(1, sizeof(ask_batch_t));
+    if (!b || !(b->row = (ask_row_t *)fossil_sys_memory_calloc(ASK_BATCH_ROWS, sizeof(ask_row_t)))) {
+        fossil_io_printf("{red,bold}fish_ask: out of memory.{normal}\n");
+        fossil_sys_memory_free(b);
+        return -1;
+    }
+    b->explain = explain;
+    b->from_stdin = strcmp(input_path, "-") == 0;
+    fish_arena_init(&b->arena, 0);
+
+    int rc = -1;
+    int opened = 0;
+    fish_row_writer_t out;
+    if (b->from_stdin) {
+        b->line = (char *)fossil_sys_memory_alloc(ASK_LINE_MAX);
+        opened = b->line != NULL;
+    } else {
+        opened = fish_row_reader_open(&b->reader, input_path) == 0;
+    }
+
+    if (!opened) {
+        fossil_io_printf("{red,bold}fish_ask: cannot read '{normal}%s{red,bold}'{normal}\n", input_path);
+    } else if (!quiet && fish_row_writer_open_raw(&out, out_path) != 0) {
+        fossil_io_printf("{red,bold}fish_ask: cannot write '{normal}%s{red,bold}'{normal}\n", out_path);
+    } else if (fish_models_init() != 0 || !(b->model = fish_model_acquire(model_name))) {
+        fossil_io_printf("{red,bold}fish_ask: cannot load model '{normal}%s{red,bold}'{normal}\n", model_name);
+        if (!quiet) fish_row_writer_abort(&out);
+    } else {
+        size_t workers = fish_thread_count();
+        uint64_t start = fish_clock_ns();
+        uint64_t asked = 0;
+        uint64_t found = 0;
+        int got;
+
+        if (!quiet && !b->model->loaded)
+            fossil_io_printf("{yellow,bold}fish_ask: '{normal}%s.jfchain{yellow,bold}' not found, using an empty chain.{normal}\n",
+                             model_name);
+        rc = 0;
+        while ((got = batch_read(b)) > 0) {
+            fish_thread_run(workers, batch_worker, b);
+            batch_render(b, &found);
+            if (batch_write(b, quiet ? NULL : &out) != 0) {
+                rc = -1;
+                break;
+            }
+            asked += (uint64_t)got;
+        }
+        if (got < 0 || (b->from_stdin ? ferror(stdin) : b->reader.failed)) rc = -1;
+
+        if (quiet) {
+            if (rc != 0) fossil_io_printf("{red,bold}fish_ask: batch failed after %llu prompts.{normal}\n",
+                                          (unsigned long long)asked);
+        } else if (rc != 0) {
+            fish_row_writer_abort(&out);
+            fossil_io_printf("{red,bold}fish_ask: batch failed, '{normal}%s{red,bold}' left untouched.{normal}\n",
+                             out_path);
+        } else if (fish_row_writer_commit(&out) != 0) {
+            fossil_io_printf("{red,bold}fish_ask: cannot write '{normal}%s{red,bold}'{normal}\n", out_path);
+            rc = -1;
+        } else {
+            double secs = (double)(fish_clock_ns() - start) / 1e9;
+            fossil_io_printf("{green,bold}fish_ask: %llu prompts (%llu answered) in %.3fs on %zu threads (%.0f prompts/s){normal}\n",
+                             (unsigned long long)asked, (unsigned long long)found, secs, workers,
+                             secs > 0 ? (double)asked / secs : 0.0);
+        }
+        fish_models_release(0);
+    }
 
-    fossil_io_cstring_free(explanation);
-    fossil_io_cstring_free(formatted);
-    fossil_sys_memory_free(reasoned_output);
-    /* No need to cleanup chain for mock usage */
+    if (!b->from_stdin && opened) fish_row_reader_close(&b->reader);
+    fish_arena_free(&b->arena);
+    fossil_sys_memory_free(b->line);
+    fossil_sys_memory_free(b->out);
+    fossil_sys_memory_free(b->row);
+    fossil_sys_memory_free(b);
+    return rc;
 }
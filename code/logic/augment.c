@@ -11,176 +11,179 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
-#include "fossil/code/commands.h"
+#include "fossil/code/rowmap.h"
+#include "fossil/code/schema.h"
+#include "fossil/code/workspace.h"
 
-/* simple numeric checker */
-static int is_numeric(ccstring s) {
-    char *end;
-    strtod(s, &end);
-    return end != s;
-}
+/* Seed used when the caller passes 0 */
+#define FISH_AUGMENT_DEFAULT_SEED 0x6175676dull /* "augm" */
 
 /* random small noise between -0.05 and +0.05 */
-static double rand_noise(void) {
-    return ((rand() % 10000) / 10000.0 - 0.5) * 0.1;
+static double rand_noise(fish_rng_t *rng) {
+    return (fish_rng_unit(rng) - 0.5) * 0.1;
+}
+
+typedef enum {
+    AUGMENT_NOISE,
+    AUGMENT_FLIP,
+    AUGMENT_SHIFT,
+    AUGMENT_COPY        /* unknown type: plain duplicates */
+} augment_mode_t;
+
+static augment_mode_t augment_mode(ccstring type) {
+    if (fossil_io_cstring_iequals(type, "noise")) return AUGMENT_NOISE;
+    if (fossil_io_cstring_iequals(type, "flip")) return AUGMENT_FLIP;
+    if (fossil_io_cstring_iequals(type, "shift")) return AUGMENT_SHIFT;
+    return AUGMENT_COPY;
 }
 
-static void augment_row_hash(const cstring *fields, size_t fc, uint8_t *hash_out) {
-    // Concatenate all fields into a single string for hashing
-    char buf[4096] = {0};
-    size_t pos = 0;
-    for (size_t i = 0; i < fc; i++) {
-        size_t len = strlen(fields[i]);
-        if (pos + len + 1 < sizeof(buf)) {
-            memcpy(buf + pos, fields[i], len);
-            pos += len;
-            if (i < fc - 1) buf[pos++] = ',';
+/* write one augmented copy of a split record; @p values are its parsed numbers */
+static int augment_row(fish_row_writer_t *writer, const fish_row_fields_t *fields,
+                       const double *values, augment_mode_t mode, fish_rng_t *rng) {
+    size_t fc = fields->count;
+
+    for (size_t c = 0; c < fc; c++) {
+        /* flip reverses the fields, shift rotates the last one to the front */
+        size_t from = c;
+        if (mode == AUGMENT_FLIP) from = fc - 1 - c;
+        else if (mode == AUGMENT_SHIFT) from = (c + fc - 1) % fc;
+
+        if (mode == AUGMENT_NOISE && !isnan(values[from])) {
+            char tmp[64];
+            int n = snprintf(tmp, sizeof(tmp), "%.6f", values[from] + rand_noise(rng));
+            fish_row_writer_put(writer, tmp, (size_t)n);
+        } else {
+            fish_row_writer_put_field(writer, fields->field[from]);
         }
+        if (c + 1 < fc)
+            fish_row_writer_put(writer, ",", 1);
     }
-    buf[pos] = '\0';
-    fossil_ai_jellyfish_hash(buf, "", hash_out);
+    return fish_row_writer_end_row(writer);
 }
 
+typedef struct {
+    augment_mode_t mode;
+    int factor;
+    uint64_t seed;
+    const fish_schema_t *schema;
+} augment_job_t;
+
+/* all augmented copies of one record */
+static int augment_record(void *ctx, fish_row_map_worker_t *worker, fish_slice_t row, uint64_t index) {
+    const augment_job_t *job = (const augment_job_t *)ctx;
+    const double *values = NULL;
+
+    if (job->schema->has_header) {
+        if (index == 0) return 0;
+        index--;
+    }
+
+    row = fish_slice_trim(row);
+    if (fish_row_fields_split(&worker->fields, row) == 0) return -1;
+    if (job->mode == AUGMENT_NOISE) {
+        values = fish_schema_values_at(job->schema, index, &worker->fields, &worker->values, &worker->values_cap);
+        if (!values) return -1;
+    }
+
+    /* noise depends only on the seed and the record, not on which thread draws it */
+    fish_rng_seed(&worker->rng, job->seed ^ (index * 0xD1B54A32D192ED03ull));
+    for (int k = 0; k < job->factor; k++)
+        if (augment_row(&worker->out, &worker->fields, values, job->mode, &worker->rng) != 0) return -1;
+    return 0;
+}
+
+/**
+ * @brief Augment the dataset with the default seed.
+ *
+ * See fish_dataset_augment_seeded().
+ */
 int fish_dataset_augment(ccstring type, int factor)
+{
+    return fish_dataset_augment_seeded(type, factor, 0);
+}
+
+/**
+ * @brief Augment the dataset.
+ *
+ * Output keeps the original rows first, followed by @p factor augmented
+ * copies of each data row; a header row is kept once, at the top. Both
+ * halves are streamed from the source in two passes, so memory does not
+ * grow with dataset size or factor. The first pass infers the schema, and
+ * noise reuses the numbers parsed there instead of parsing every copy
+ * again. The copies are made in parallel by fish_row_map(). Noise is
+ * drawn from a generator seeded by @p seed and the record's position,
+ * so the same seed always gives the same dataset, whatever the thread
+ * count.
+ */
+int fish_dataset_augment_seeded(ccstring type, int factor, uint64_t seed)
 {
     if (!type || factor <= 0) {
         fossil_io_printf("{red,bold}fish_dataset_augment: invalid parameters.{normal}\n");
         return -1;
     }
 
-    ccstring path = "datasets/current.dataset";
-    fossil_io_file_t dataset_file;
-    if (fossil_io_file_open(&dataset_file, path, "r") != 0 || !fossil_io_file_is_open(&dataset_file)) {
+    ccstring path = fish_workspace_path();
+    fish_row_reader_t reader;
+    fish_row_writer_t writer;
+    fish_row_fields_t fields = {0};
+    fish_schema_t schema;
+    fish_slice_t row;
+    int failed = 0;
+    augment_job_t job = { augment_mode(type), factor, seed ? seed : FISH_AUGMENT_DEFAULT_SEED, &schema };
+
+    if (fish_row_reader_open_csv(&reader, path) != 0) {
         fossil_io_printf("{red,bold}fish_dataset_augment: no active dataset.{normal}\n");
         return -1;
     }
 
-    cstring *rows = (cstring *)fossil_sys_memory_alloc(sizeof(cstring) * 200000);
-    if (!rows) {
-        fossil_io_file_close(&dataset_file);
+    if (fish_row_writer_open(&writer, path) != 0) {
+        fish_row_reader_close(&reader);
+        fossil_io_printf("{red,bold}fish_dataset_augment: write error.{normal}\n");
         return -1;
     }
 
-    size_t count = 0;
-    char buf[4096];
-
-    /* LOAD */
-    while (fgets(buf, sizeof(buf), dataset_file.file)) {
-        fossil_io_cstring_trim(buf);
-        rows[count++] = fossil_io_cstring_dup(buf);
+    /* copy originals, inferring the schema on the way */
+    fish_schema_init(&schema, job.mode == AUGMENT_NOISE ? FISH_SCHEMA_CACHE_BUDGET : 0);
+    while (!failed && fish_row_reader_next(&reader, &row)) {
+        row = fish_slice_trim(row);
+        failed = fish_schema_add(&schema, &fields, row) < 0 ||
+                 fish_row_writer_write(&writer, row.ptr, row.len) != 0;
     }
-    fossil_io_file_close(&dataset_file);
-
-    if (count == 0) {
-        fossil_io_printf("{yellow,bold}fish_dataset_augment: dataset empty.{normal}\n");
-        fossil_sys_memory_free(rows);
-        return 0;
+    fish_row_fields_free(&fields);
+    if (reader.failed) failed = 1;
+
+    size_t count = reader.rows;
+    if (failed || count == 0) {
+        fish_row_writer_abort(&writer);
+        fish_row_reader_close(&reader);
+        fish_schema_free(&schema);
+        if (failed) fossil_io_printf("{red,bold}fish_dataset_augment: write error.{normal}\n");
+        else fossil_io_printf("{yellow,bold}fish_dataset_augment: dataset empty.{normal}\n");
+        return failed ? -1 : 0;
     }
 
-    /* determine number of columns */
-    size_t cols = 1;
-    for (char *p = rows[0]; *p; p++)
-        if (*p == ',') cols++;
-
     fossil_io_printf("{green,bold}fish_dataset_augment: type=%s factor=%d columns=%zu{normal}\n",
-           type, factor, cols);
-
-    /* prepare output rows list with room for augmented rows */
-    cstring *out = (cstring *)fossil_sys_memory_alloc(sizeof(cstring) * (count * (factor + 1)));
-    if (!out) {
-        fossil_sys_memory_free(rows);
-        return -1;
-    }
-
-    size_t out_count = 0;
-
-    /* copy originals */
-    for (size_t i = 0; i < count; i++) {
-        out[out_count++] = fossil_io_cstring_dup(rows[i]);
-    }
+           type, factor, schema.columns);
 
     /* AUGMENT */
-    for (size_t i = 0; i < count; i++) {
-        for (int k = 0; k < factor; k++) {
-            cstring temp = fossil_io_cstring_dup(rows[i]);
-            cstring saveptr = NULL;
-            cstring fields[512] = {0};
-            size_t fc = 0;
-            cstring tok = fossil_io_cstring_token(temp, ",", &saveptr);
-
-            while (tok && fc < cols) {
-                fields[fc++] = tok;
-                tok = fossil_io_cstring_token(NULL, ",", &saveptr);
-            }
-
-            /* noise augmentation */
-            if (fossil_io_cstring_iequals(type, "noise")) {
-                for (size_t c = 0; c < fc; c++) {
-                    if (is_numeric(fields[c])) {
-                        double v = atof(fields[c]);
-                        v += rand_noise();
-                        char tmp[64];
-                        snprintf(tmp, sizeof(tmp), "%.6f", v);
-                        fossil_io_cstring_free(fields[c]);
-                        fields[c] = fossil_io_cstring_dup(tmp);
-                    }
-                }
-            }
-
-            /* flip augmentation */
-            else if (fossil_io_cstring_iequals(type, "flip")) {
-                for (size_t c = 0; c < fc / 2; c++) {
-                    cstring tmp = fields[c];
-                    fields[c] = fields[fc - 1 - c];
-                    fields[fc - 1 - c] = tmp;
-                }
-            }
-
-            /* shift augmentation */
-            else if (fossil_io_cstring_iequals(type, "shift")) {
-                cstring last = fields[fc - 1];
-                for (size_t c = fc - 1; c > 0; c--) {
-                    fields[c] = fields[c - 1];
-                }
-                fields[0] = last;
-            }
-
-            /* generate hash for augmented row */
-            uint8_t hash_out[FOSSIL_JELLYFISH_HASH_SIZE] = {0};
-            augment_row_hash(fields, fc, hash_out);
-
-            /* reassemble row */
-            cstring line = fossil_io_cstring_join(fields, fc, ',');
-            cstring newline = fossil_io_cstring_concat(line, "\n");
-            fossil_io_cstring_free(line);
-
-            out[out_count++] = newline;
-
-            for (size_t c = 0; c < fc; c++) {
-                if (fields[c]) fossil_io_cstring_free(fields[c]);
-            }
-            fossil_io_cstring_free(temp);
-        }
-    }
+    fish_schema_rewind(&schema);
+    failed = fish_row_reader_rewind(&reader) != 0 ||
+             fish_row_map(&reader, &writer, augment_record, &job, 0) != 0;
+    fish_row_reader_close(&reader);
+    fish_schema_free(&schema);
 
     /* SAVE */
-    if (fossil_io_file_open(&dataset_file, path, "w") != 0 || !fossil_io_file_is_open(&dataset_file)) {
+    size_t out_count = writer.rows;
+    if (failed) {
+        fish_row_writer_abort(&writer);
         fossil_io_printf("{red,bold}fish_dataset_augment: write error.{normal}\n");
-        fossil_sys_memory_free(out);
-        fossil_sys_memory_free(rows);
         return -1;
     }
-
-    for (size_t i = 0; i < out_count; i++) {
-        fputs(out[i], dataset_file.file);
-        fossil_io_cstring_free(out[i]);
+    if (fish_row_writer_commit(&writer) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_augment: write error.{normal}\n");
+        return -1;
     }
 
-    fossil_io_file_close(&dataset_file);
-    fossil_sys_memory_free(out);
-    for (size_t i = 0; i < count; i++) fossil_io_cstring_free(rows[i]);
-    fossil_sys_memory_free(rows);
-
     fossil_io_printf("{cyan,bold}fish_dataset_augment: wrote %zu rows.{normal}\n", out_count);
     return 0;
 }
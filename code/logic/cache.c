@@ -0,0 +1,365 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/cache.h"
+#include "fossil/code/thread.h"
+#include "fossil/code/trace.h"
+
+#define CACHE_SEED 0x6a666361ull /* "jfca" */
+#define CACHE_TEXT_MAX ((uint32_t)1 << 20) /* longest string a record may hold */
+#define CACHE_COMPACT_MIN 64 /* stale records tolerated before compacting */
+
+/* lookup tallies for serve stats; the trace counters mirror these */
+static volatile uint64_t cache_hits = 0;
+static volatile uint64_t cache_misses = 0;
+
+struct fish_cache_entry {
+    fish_cache_entry_t *newer;
+    fish_cache_entry_t *older;
+    uint64_t digest;
+    uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE];
+    int explain;
+    int found;
+    float confidence;
+    size_t prompt_len;
+    size_t answer_len;
+    size_t explain_len;
+    char data[];                /* prompt, answer, explanation, each NUL-terminated */
+};
+
+typedef struct {
+    uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE];
+    uint8_t explain;
+    uint8_t found;
+    uint8_t pad[2];
+    float confidence;
+    uint32_t prompt_len;
+    uint32_t answer_len;
+    uint32_t explain_len;
+} cache_record_t;
+
+static uint64_t cache_digest(const uint8_t *fingerprint, fish_slice_t prompt, int explain) {
+    uint64_t h = fish_hash64(fingerprint, FOSSIL_JELLYFISH_HASH_SIZE, CACHE_SEED + (uint64_t)(explain != 0));
+    return fish_hash64(prompt.ptr, prompt.len, h);
+}
+
+static int entry_matches(const fish_cache_entry_t *e, uint64_t digest, const uint8_t *fingerprint,
+                         fish_slice_t prompt, int explain) {
+    return e->digest == digest && e->explain == (explain != 0) && e->prompt_len == prompt.len &&
+           memcmp(e->fingerprint, fingerprint, FOSSIL_JELLYFISH_HASH_SIZE) == 0 &&
+           memcmp(e->data, prompt.ptr, prompt.len) == 0;
+}
+
+/* ---------------- LRU list ---------------- */
+
+static void list_unlink(fish_cache_t *cache, fish_cache_entry_t *e) {
+    if (e->newer) e->newer->older = e->older;
+    else cache->newest = e->older;
+    if (e->older) e->older->newer = e->newer;
+    else cache->oldest = e->newer;
+    e->newer = NULL;
+    e->older = NULL;
+}
+
+static void list_push(fish_cache_t *cache, fish_cache_entry_t *e) {
+    e->older = cache->newest;
+    e->newer = NULL;
+    if (cache->newest) cache->newest->newer = e;
+    cache->newest = e;
+    if (!cache->oldest) cache->oldest = e;
+}
+
+/* ---------------- index ---------------- */
+
+static size_t slot_find(const fish_cache_t *cache, uint64_t digest, const uint8_t *fingerprint,
+                        fish_slice_t prompt, int explain) {
+    size_t at = (size_t)digest & cache->slot_mask;
+    while (cache->slot[at]) {
+        if (entry_matches(cache->slot[at], digest, fingerprint, prompt, explain)) return at;
+        at = (at + 1) & cache->slot_mask;
+    }
+    return at; /* empty slot where the key would go */
+}
+
+/* backward-shift delete keeps linear probing free of tombstones */
+static void slot_remove(fish_cache_t *cache, size_t at) {
+    size_t hole = at;
+    cache->slot[hole] = NULL;
+    for (size_t next = (hole + 1) & cache->slot_mask; cache->slot[next]; next = (next + 1) & cache->slot_mask) {
+        size_t home = (size_t)cache->slot[next]->digest & cache->slot_mask;
+        /* move the entry back if the hole lies between its home and where it sits */
+        if (((next - home) & cache->slot_mask) >= ((next - hole) & cache->slot_mask)) {
+            cache->slot[hole] = cache->slot[next];
+            cache->slot[next] = NULL;
+            hole = next;
+        }
+    }
+}
+
+static void entry_drop(fish_cache_t *cache, fish_cache_entry_t *e) {
+    fish_slice_t prompt = { e->data, e->prompt_len };
+    size_t at = slot_find(cache, e->digest, e->fingerprint, prompt, e->explain);
+    if (cache->slot[at] == e) slot_remove(cache, at);
+    list_unlink(cache, e);
+    fossil_sys_memory_free(e);
+    cache->count--;
+}
+
+/* ---------------- cache ---------------- */
+
+int fish_cache_init(fish_cache_t *cache, size_t capacity) {
+    fossil_sys_memory_zero(cache, sizeof(*cache));
+    cache->capacity = capacity ? capacity : FISH_CACHE_ENTRIES;
+    size_t slots = 16;
+    while (slots < cache->capacity * 2) slots *= 2;
+    cache->slot = (fish_cache_entry_t **)fossil_sys_memory_calloc(slots, sizeof(fish_cache_entry_t *));
+    if (!cache->slot) return -1;
+    cache->slot_mask = slots - 1;
+    return 0;
+}
+
+void fish_cache_free(fish_cache_t *cache) {
+    fish_cache_entry_t *e = cache->newest;
+    while (e) {
+        fish_cache_entry_t *older = e->older;
+        fossil_sys_memory_free(e);
+        e = older;
+    }
+    fossil_sys_memory_free(cache->slot);
+    fossil_sys_memory_zero(cache, sizeof(*cache));
+}
+
+int fish_cache_get(fish_cache_t *cache, const uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE],
+                   fish_slice_t prompt, int explain, fish_cache_value_t *value) {
+    fish_cache_entry_t *e = NULL;
+    if (cache->slot) {
+        uint64_t digest = cache_digest(fingerprint, prompt, explain);
+        e = cache->slot[slot_find(cache, digest, fingerprint, prompt, explain)];
+    }
+    if (!e) {
+        fish_thread_add(&cache_misses, 1);
+        fish_trace_count(FISH_COUNTER_CACHE_MISS, 1);
+        return 0;
+    }
+    fish_thread_add(&cache_hits, 1);
+    fish_trace_count(FISH_COUNTER_CACHE_HIT, 1);
+
+    if (cache->newest != e) {
+        list_unlink(cache, e);
+        list_push(cache, e);
+    }
+    value->found = e->found;
+    value->confidence = e->confidence;
+    value->answer = e->data + e->prompt_len + 1;
+    value->explain = e->data + e->prompt_len + 1 + e->answer_len + 1;
+    return 1;
+}
+
+uint64_t fish_cache_hits(void) {
+    return fish_thread_add(&cache_hits, 0);
+}
+
+uint64_t fish_cache_misses(void) {
+    return fish_thread_add(&cache_misses, 0);
+}
+
+int fish_cache_put(fish_cache_t *cache, const uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE],
+                   fish_slice_t prompt, int explain, const fish_cache_value_t *value) {
+    if (!cache->slot) return -1;
+    uint64_t digest = cache_digest(fingerprint, prompt, explain);
+    size_t at = slot_find(cache, digest, fingerprint, prompt, explain);
+    if (cache->slot[at]) {
+        entry_drop(cache, cache->slot[at]);
+    }
+    while (cache->count >= cache->capacity && cache->oldest) entry_drop(cache, cache->oldest);
+
+    size_t answer_len = value->answer ? strlen(value->answer) : 0;
+    size_t explain_len = value->explain ? strlen(value->explain) : 0;
+    fish_cache_entry_t *e = (fish_cache_entry_t *)fossil_sys_memory_alloc(
+        sizeof(fish_cache_entry_t) + prompt.len + answer_len + explain_len + 3);
+    if (!e) return -1;
+    e->digest = digest;
+    fossil_sys_memory_copy(e->fingerprint, fingerprint, FOSSIL_JELLYFISH_HASH_SIZE);
+    e->explain = explain != 0;
+    e->found = value->found;
+    e->confidence = value->confidence;
+    e->prompt_len = prompt.len;
+    e->answer_len = answer_len;
+    e->explain_len = explain_len;
+
+    char *p = e->data;
+    if (prompt.len) fossil_sys_memory_copy(p, prompt.ptr, prompt.len);
+    p[prompt.len] = '\0';
+    p += prompt.len + 1;
+    if (answer_len) fossil_sys_memory_copy(p, value->answer, answer_len);
+    p[answer_len] = '\0';
+    p += answer_len + 1;
+    if (explain_len) fossil_sys_memory_copy(p, value->explain, explain_len);
+    p[explain_len] = '\0';
+
+    /* evictions may have shifted slots: probe again */
+    cache->slot[slot_find(cache, digest, fingerprint, prompt, explain)] = e;
+    list_push(cache, e);
+    cache->count++;
+    return 0;
+}
+
+/* ---------------- persistence ---------------- */
+
+static int record_put(fish_row_writer_t *out, const cache_record_t *rec,
+                      fish_slice_t prompt, ccstring answer, ccstring explain) {
+    if (fish_row_writer_put(out, (const char *)rec, sizeof(*rec)) != 0) return -1;
+    if (fish_row_writer_put(out, prompt.ptr, prompt.len) != 0) return -1;
+    if (fish_row_writer_put(out, answer, rec->answer_len) != 0) return -1;
+    return fish_row_writer_put(out, explain, rec->explain_len);
+}
+
+static void record_fill(cache_record_t *rec, const uint8_t *fingerprint, fish_slice_t prompt,
+                        int explain, const fish_cache_value_t *value) {
+    fossil_sys_memory_zero(rec, sizeof(*rec));
+    fossil_sys_memory_copy(rec->fingerprint, fingerprint, FOSSIL_JELLYFISH_HASH_SIZE);
+    rec->explain = (uint8_t)(explain != 0);
+    rec->found = (uint8_t)(value->found != 0);
+    rec->confidence = value->confidence;
+    rec->prompt_len = (uint32_t)prompt.len;
+    rec->answer_len = (uint32_t)(value->answer ? strlen(value->answer) : 0);
+    rec->explain_len = (uint32_t)(value->explain ? strlen(value->explain) : 0);
+}
+
+/* rewrite the file with just the current version's entries that are still cached */
+static int cache_compact(const fish_cache_t *cache, ccstring path, const uint8_t *fingerprint) {
+    fish_row_writer_t out;
+    if (fish_row_writer_open_raw(&out, path) != 0) return -1;
+    fish_row_writer_put(&out, FISH_CACHE_MAGIC, 8);
+    for (const fish_cache_entry_t *e = cache->oldest; e; e = e->newer) {
+        if (memcmp(e->fingerprint, fingerprint, FOSSIL_JELLYFISH_HASH_SIZE) != 0) continue;
+        fish_slice_t prompt = { e->data, e->prompt_len };
+        fish_cache_value_t value = { e->found, e->confidence, e->data + e->prompt_len + 1,
+                                     e->data + e->prompt_len + 1 + e->answer_len + 1 };
+        cache_record_t rec;
+        record_fill(&rec, fingerprint, prompt, e->explain, &value);
+        if (record_put(&out, &rec, prompt, value.answer, value.explain) != 0) {
+            fish_row_writer_abort(&out);
+            return -1;
+        }
+    }
+    return fish_row_writer_commit(&out);
+}
+
+int fish_cache_load(fish_cache_t *cache, ccstring model_name,
+                    const uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE]) {
+    cstring path = fossil_io_cstring_format("%s%s", model_name, FISH_CACHE_SUFFIX);
+    if (!path) return -1;
+    if (!fossil_io_file_file_exists(path)) {
+        fossil_io_cstring_free(path);
+        return 0;
+    }
+
+    fossil_io_file_t file;
+    char magic[8];
+    if (fossil_io_file_open(&file, path, "rb") != 0) {
+        fossil_io_cstring_free(path);
+        return -1;
+    }
+    int corrupt = fossil_io_file_read(&file, magic, 1, 8) != 8 || memcmp(magic, FISH_CACHE_MAGIC, 8) != 0;
+
+    int loaded = 0;
+    size_t stale = 0;
+    char *buf = NULL;
+    size_t cap = 0;
+    cache_record_t rec;
+    while (!corrupt && fossil_io_file_read(&file, &rec, 1, sizeof(rec)) == sizeof(rec)) {
+        if (rec.prompt_len > CACHE_TEXT_MAX || rec.answer_len > CACHE_TEXT_MAX || rec.explain_len > CACHE_TEXT_MAX) {
+            corrupt = 1;
+            break;
+        }
+        size_t len = (size_t)rec.prompt_len + rec.answer_len + rec.explain_len;
+        if (len + 3 > cap) {
+            size_t grown_cap = cap ? cap : 4096;
+            while (grown_cap < len + 3) grown_cap *= 2;
+            char *grown = (char *)fossil_sys_memory_realloc(buf, grown_cap);
+            if (!grown) {
+                corrupt = 1;
+                break;
+            }
+            buf = grown;
+            cap = grown_cap;
+        }
+        /* prompt, answer and explanation land NUL-separated in buf */
+        char *answer = buf + rec.prompt_len + 1;
+        char *explain = answer + rec.answer_len + 1;
+        if (fossil_io_file_read(&file, buf, 1, rec.prompt_len) != rec.prompt_len ||
+            fossil_io_file_read(&file, answer, 1, rec.answer_len) != rec.answer_len ||
+            fossil_io_file_read(&file, explain, 1, rec.explain_len) != rec.explain_len) {
+            corrupt = 1;
+            break;
+        }
+        if (memcmp(rec.fingerprint, fingerprint, FOSSIL_JELLYFISH_HASH_SIZE) != 0) {
+            stale++;
+            continue;
+        }
+        buf[rec.prompt_len] = '\0';
+        answer[rec.answer_len] = '\0';
+        explain[rec.explain_len] = '\0';
+
+        fish_slice_t prompt = { buf, rec.prompt_len };
+        fish_cache_value_t value = { rec.found, rec.confidence, answer, explain };
+        if (fish_cache_put(cache, fingerprint, prompt, rec.explain, &value) == 0) loaded++;
+    }
+    fossil_io_file_close(&file);
+    fossil_sys_memory_free(buf);
+
+    /* drop superseded model versions (or a torn tail) from the log */
+    if (corrupt || (stale > CACHE_COMPACT_MIN && stale > (size_t)loaded)) cache_compact(cache, path, fingerprint);
+    fossil_io_cstring_free(path);
+    return corrupt && loaded == 0 ? -1 : loaded;
+}
+
+int fish_cache_append(ccstring model_name, const uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE],
+                      fish_slice_t prompt, int explain, const fish_cache_value_t *value) {
+    cache_record_t rec;
+    record_fill(&rec, fingerprint, prompt, explain, value);
+
+    /* one write per record, so appends from other processes never interleave inside it */
+    size_t len = 8 + sizeof(rec) + prompt.len + rec.answer_len + rec.explain_len;
+    char *buf = (char *)fossil_sys_memory_alloc(len);
+    cstring path = fossil_io_cstring_format("%s%s", model_name, FISH_CACHE_SUFFIX);
+    if (!buf || !path) {
+        fossil_sys_memory_free(buf);
+        fossil_io_cstring_free(path);
+        return -1;
+    }
+    size_t at = 0;
+    if (!fossil_io_file_file_exists(path)) {
+        fossil_sys_memory_copy(buf, FISH_CACHE_MAGIC, 8);
+        at = 8;
+    }
+    fossil_sys_memory_copy(buf + at, &rec, sizeof(rec));
+    at += sizeof(rec);
+    if (prompt.len) fossil_sys_memory_copy(buf + at, prompt.ptr, prompt.len);
+    at += prompt.len;
+    if (rec.answer_len) fossil_sys_memory_copy(buf + at, value->answer, rec.answer_len);
+    at += rec.answer_len;
+    if (rec.explain_len) fossil_sys_memory_copy(buf + at, value->explain, rec.explain_len);
+    at += rec.explain_len;
+
+    fossil_io_file_t file;
+    int rc = -1;
+    if (fossil_io_file_open(&file, path, "ab") == 0) {
+        rc = fossil_io_file_write(&file, buf, 1, at) == at ? 0 : -1;
+        fossil_io_file_close(&file);
+    }
+    fossil_sys_memory_free(buf);
+    fossil_io_cstring_free(path);
+    return rc;
+}
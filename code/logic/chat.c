@@ -12,46 +12,79 @@
  * -----------------------------------------------------------------------------
  */
 #include "fossil/code/commands.h"
+#include "fossil/code/scan.h"
+#include "fossil/code/session.h"
 
-#define MAX_HISTORY 32768
 #define MAX_LINE    2048
 
 /* --------------------------------------------------------------
  * Internal Jellyfish model reply generator.
- * Uses fossil_ai_jellyfish_chain_t for reasoning.
+ * Reasons on the resident chain of the model through the session,
+ * which keeps the bounded history and, with keep_context, decides
+ * what the chain learns.
  * -------------------------------------------------------------- */
-static void backend_chat_reply(const char *model,
+static void backend_chat_reply(fish_session_t *session,
                                const char *user_msg,
+                               char *reply, size_t reply_sz,
                                char *out, size_t out_sz)
 {
-    static fossil_ai_jellyfish_chain_t chain;
-    static int initialized = 0;
-
-    if (!initialized) {
-        fossil_ai_jellyfish_init(&chain);
-        initialized = 1;
-    }
-
-    // Allocate output buffer using memory API
-    fossil_sys_memory_t output_mem = fossil_sys_memory_alloc(MAX_LINE * 2);
-    char *output = (char *)output_mem;
     float confidence = 0.0f;
-    const fossil_ai_jellyfish_block_t *block = NULL;
-    bool found = fossil_ai_jellyfish_reason_verbose(&chain, user_msg, output, &confidence, &block);
+    int found = fish_session_turn(session, user_msg, reply, reply_sz, &confidence);
 
     if (found) {
         snprintf(out, out_sz,
             "[{cyan}%s{normal}]: {yellow}%s{normal}\n{dim}(confidence: %.2f){normal}\n",
-            model, output, confidence);
+            session->model->name, reply, confidence);
     } else {
         snprintf(out, out_sz,
             "[{cyan}%s{normal}]: I received: \"{yellow}%s{normal}\"\n",
-            model, user_msg);
+            session->model->name, user_msg);
     }
+}
 
-    // Learn this input/output pair for future context
-    fossil_ai_jellyfish_learn(&chain, user_msg, out);
+int fish_chat(const char *model_name, int keep_context, const char *save_file)
+{
+    fish_model_t *model = fish_model_acquire(model_name);
+    if (!model) {
+        fossil_io_printf("{red,bold}fish_chat: cannot load model '{normal}%s{red,bold}'{normal}\n",
+                         model_name ? model_name : "(null)");
+        return -1;
+    }
 
-    // Free output buffer
-    fossil_sys_memory_free(output_mem);
+    fish_session_t session;
+    if (fish_session_open(&session, model, keep_context, save_file) != 0) {
+        fossil_io_printf("{red,bold}fish_chat: cannot write '{normal}%s{red,bold}'{normal}\n", save_file);
+        return -1;
+    }
+
+    fossil_io_printf("{green,bold}fish_chat: talking to '{normal}%s{green,bold}' (%s); type 'exit' to quit, 'history' to review.{normal}\n",
+                     model->name, model->loaded ? "loaded" : "new model");
+    if (session.count > 0)
+        fossil_io_printf("{cyan}fish_chat: restored %zu turns from '%s'.{normal}\n", session.count, save_file);
+
+    char line[MAX_LINE];
+    char reply[MAX_LINE];
+    char out[MAX_LINE * 2];
+    for (;;) {
+        fossil_io_printf("{bold}> {normal}");
+        if (!fgets(line, sizeof(line), stdin)) break;
+        line[fish_scan_find(line, strlen(line), '\r', '\n', '\n')] = '\0';
+        if (!line[0]) continue;
+        if (strcmp(line, "exit") == 0 || strcmp(line, "quit") == 0) break;
+        if (strcmp(line, "history") == 0) {
+            fish_session_print(&session);
+            continue;
+        }
+
+        backend_chat_reply(&session, line, reply, sizeof(reply), out, sizeof(out));
+        fossil_io_printf("%s", out);
+    }
+
+    int rc = 0;
+    if (fish_session_close(&session) != 0) {
+        fossil_io_printf("{red,bold}fish_chat: cannot write '{normal}%s{red,bold}'{normal}\n", save_file);
+        rc = -1;
+    }
+    if (keep_context && model->dirty && fish_model_save(model) != 0) rc = -1;
+    return rc;
 }
@@ -11,188 +11,182 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
-#include "fossil/code/commands.h"
+#include "fossil/code/dedup.h"
+#include "fossil/code/schema.h"
+#include "fossil/code/workspace.h"
+
+/* ---------------- helpers ---------------- */
+
+/* sink for rows that survive filtering */
+typedef struct {
+    fish_row_writer_t *writer;
+    fish_schema_t *schema;
+    fish_row_fields_t *fields;
+} filter_sink_t;
+
+static int filter_emit(void *ctx, fish_slice_t row) {
+    filter_sink_t *sink = (filter_sink_t *)ctx;
+    if (sink->schema && fish_schema_add(sink->schema, sink->fields, row) < 0) return -1;
+    return fish_row_writer_write(sink->writer, row.ptr, row.len);
+}
 
-#define MAX_LINES 200000
-#define MAX_LINE_LEN 4096
+static int write_normalized(fish_row_writer_t *writer, fish_row_fields_t *fields,
+                            fish_schema_t *schema, fish_slice_t row) {
+    size_t fc = fish_row_fields_split(fields, row);
+    const double *values = fc ? fish_schema_values(schema, fields) : NULL;
+    if (!values) return -1;
+
+    for (size_t c = 0; c < fc; c++) {
+        if (fish_schema_scalable(schema, c) && !isnan(values[c])) {
+            /* numeric -> normalize */
+            const fish_schema_column_t *col = &schema->col[c];
+            char num[64];
+            int n = snprintf(num, sizeof(num), "%.6f", (values[c] - col->min) / (col->max - col->min));
+            fish_row_writer_put(writer, num, (size_t)n);
+        } else {
+            fish_row_writer_put_field(writer, fields->field[c]);
+        }
+        if (c + 1 < fc)
+            fish_row_writer_put(writer, ",", 1);
+    }
+    return fish_row_writer_end_row(writer);
+}
 
-/**
- * @brief Clean the dataset (drop nulls, deduplicate, normalize).
- *
- * The dataset is expected to be located at:
- *     datasets/current.dataset
- *
- * Null rows = rows that are empty or whitespace.
- * Deduplication = remove exact duplicate rows.
- * Normalize = scale numeric values in each column to 0–1 range.
- *
- * @return int Status code.
- */
-int fish_dataset_clean(int drop_null, int dedup, int normalize)
-{
-    const char *path = "datasets/current.dataset";
-    fossil_io_file_t file_stream;
+/* ---------------- passes ---------------- */
 
-    if (fossil_io_file_open(&file_stream, path, "r") != 0 || !file_stream.file) {
-        fossil_io_printf("{red,bold}fish_dataset_clean: no active dataset found.{normal}\n");
-        return -1;
-    }
+/* Drop null / duplicate rows; also infers the schema of the survivors when normalizing. */
+static int clean_filter_pass(ccstring path, int drop_null, int dedup,
+                             fish_schema_t *schema, fish_row_fields_t *fields) {
+    fish_row_writer_t writer;
+    filter_sink_t sink = { &writer, schema, fields };
+    int failed = 0;
 
-    /* storage */
-    cstring *rows = (cstring *)fossil_sys_memory_alloc(sizeof(cstring) * MAX_LINES);
-    if (!rows) {
-        fossil_io_file_close(&file_stream);
-        fossil_io_printf("{red,bold}fish_dataset_clean: memory allocation failed.{normal}\n");
+    if (fish_row_writer_open(&writer, path) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_clean: failed to rewrite dataset.{normal}\n");
         return -1;
     }
-    size_t count = 0;
-
-    /* ---------- Load rows ---------- */
-    char buf[MAX_LINE_LEN];
-    while (fgets(buf, sizeof(buf), file_stream.file)) {
-        if (count >= MAX_LINES) break;
-        rows[count] = fossil_io_cstring_create(buf);
-        count++;
-    }
-    fossil_io_file_close(&file_stream);
-
-    /* ---------- Drop null rows ---------- */
-    if (drop_null) {
-        size_t w = 0;
-        for (size_t i = 0; i < count; i++) {
-            fossil_io_cstring_trim(rows[i]);
-            if (fossil_io_cstring_length(rows[i]) > 0)
-                rows[w++] = rows[i];
-            else
-                fossil_io_cstring_free(rows[i]);
-        }
-        count = w;
-        fossil_io_printf("{green}fish_dataset_clean: dropped null rows.{normal}\n");
-    }
 
-    /* ---------- Deduplicate ---------- */
     if (dedup) {
-        // Use jellyfish hash for deduplication
-        uint8_t *seen_hashes = (uint8_t *)fossil_sys_memory_calloc(count, FOSSIL_JELLYFISH_HASH_SIZE);
-        size_t seen_count = 0;
-
-        size_t w = 0;
-        for (size_t i = 0; i < count; i++) {
-            uint8_t hash[FOSSIL_JELLYFISH_HASH_SIZE];
-            fossil_ai_jellyfish_hash(rows[i], NULL, hash);
-
-            int exists = 0;
-            for (size_t s = 0; s < seen_count; s++) {
-                if (fossil_sys_memory_compare(seen_hashes + s * FOSSIL_JELLYFISH_HASH_SIZE, hash, FOSSIL_JELLYFISH_HASH_SIZE) == 0) {
-                    exists = 1;
-                    break;
-                }
-            }
-            if (!exists) {
-                fossil_sys_memory_copy(seen_hashes + seen_count * FOSSIL_JELLYFISH_HASH_SIZE, hash, FOSSIL_JELLYFISH_HASH_SIZE);
-                seen_count++;
-                rows[w++] = rows[i];
-            } else {
-                fossil_io_cstring_free(rows[i]);
-            }
-        }
-        count = w;
-        fossil_sys_memory_free(seen_hashes);
-
-        fossil_io_printf("{yellow}fish_dataset_clean: removed duplicates.{normal}\n");
-    }
-
-    /* ---------- Normalize numeric columns ---------- */
-    if (normalize && count > 0) {
-        /* determine number of columns */
-        size_t cols = 1;
-        for (char *p = rows[0]; *p; p++)
-            if (*p == ',') cols++;
-
-        double *minv = (double *)fossil_sys_memory_alloc(sizeof(double) * cols);
-        double *maxv = (double *)fossil_sys_memory_alloc(sizeof(double) * cols);
-        if (!minv || !maxv) {
-            fossil_io_printf("{red,bold}fish_dataset_clean: normalize failed (alloc).{normal}\n");
-            fossil_sys_memory_free(minv); fossil_sys_memory_free(maxv);
+        /* hash-set dedup, spilling to disk partitions for very large datasets */
+        failed = fish_dedup_run(path, drop_null, FISH_DEDUP_AUTO, 0, filter_emit, &sink) != 0;
+    } else {
+        fish_row_reader_t reader;
+        fish_slice_t row;
+        if (fish_row_reader_open_csv(&reader, path) != 0) {
+            fish_row_writer_abort(&writer);
+            fossil_io_printf("{red,bold}fish_dataset_clean: no active dataset found.{normal}\n");
             return -1;
         }
-
-        /* init */
-        for (size_t c = 0; c < cols; c++) {
-            minv[c] = 1e300;
-            maxv[c] = -1e300;
+        while (!failed && fish_row_reader_next(&reader, &row)) {
+            row = fish_slice_trim(row);
+            if (row.len == 0) continue;
+            if (filter_emit(&sink, row) != 0) failed = 1;
         }
+        if (reader.failed) failed = 1;
+        fish_row_reader_close(&reader);
+    }
 
-        /* scan numeric ranges */
-        for (size_t i = 0; i < count; i++) {
-            cstring row = fossil_io_cstring_copy(rows[i]);
-            cstring saveptr = NULL;
-            cstring tok = fossil_io_cstring_token(row, ",", &saveptr);
-            size_t c = 0;
-            while (tok && c < cols) {
-                char *end;
-                double v = strtod(tok, &end);
-                if (end != tok) { /* numeric */
-                    if (v < minv[c]) minv[c] = v;
-                    if (v > maxv[c]) maxv[c] = v;
-                }
-                tok = fossil_io_cstring_token(NULL, ",", &saveptr);
-                c++;
-            }
-            fossil_io_cstring_free(row);
-        }
+    if (failed) {
+        fish_row_writer_abort(&writer);
+        fossil_io_printf("{red,bold}fish_dataset_clean: failed to rewrite dataset.{normal}\n");
+        return -1;
+    }
+    if (fish_row_writer_commit(&writer) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_clean: failed to rewrite dataset.{normal}\n");
+        return -1;
+    }
 
-        /* apply normalization */
-        for (size_t i = 0; i < count; i++) {
-            cstring out = fossil_io_cstring_create("");
-            cstring row = fossil_io_cstring_copy(rows[i]);
-            cstring saveptr = NULL;
-            cstring tok = fossil_io_cstring_token(row, ",", &saveptr);
-            size_t c = 0;
-
-            while (tok && c < cols) {
-                char *end;
-                double v = strtod(tok, &end);
-                if (end != tok && maxv[c] > minv[c]) {
-                    /* numeric -> normalize */
-                    double scaled = (v - minv[c]) / (maxv[c] - minv[c]);
-                    cstring num = fossil_io_cstring_format("%.6f", scaled);
-                    fossil_io_cstring_append(&out, num);
-                    fossil_io_cstring_free(num);
-                } else {
-                    fossil_io_cstring_append(&out, tok);
-                }
-                if (c + 1 < cols)
-                    fossil_io_cstring_append(&out, ",");
-                tok = fossil_io_cstring_token(NULL, ",", &saveptr);
-                c++;
-            }
-
-            fossil_io_cstring_free(rows[i]);
-            rows[i] = out;
-            fossil_io_cstring_free(row);
-        }
+    if (drop_null) fossil_io_printf("{green}fish_dataset_clean: dropped null rows.{normal}\n");
+    if (dedup) fossil_io_printf("{yellow}fish_dataset_clean: removed duplicates.{normal}\n");
+    return 0;
+}
 
-        fossil_sys_memory_free(minv);
-        fossil_sys_memory_free(maxv);
+/* Rescale numeric fields to 0-1; infers the schema first unless already known. */
+static int clean_normalize_pass(ccstring path, fish_schema_t *schema,
+                                fish_row_fields_t *fields, int scanned) {
+    fish_row_reader_t reader;
+    fish_row_writer_t writer;
+    fish_slice_t row;
+    int failed = 0;
 
-        fossil_io_printf("{cyan}fish_dataset_clean: normalized numeric values.{normal}\n");
+    if (!scanned && fish_schema_infer(schema, path) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_clean: normalize failed (alloc).{normal}\n");
+        return -1;
+    }
+    fish_schema_rewind(schema);
+
+    if (fish_row_reader_open_csv(&reader, path) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_clean: no active dataset found.{normal}\n");
+        return -1;
+    }
+    if (fish_row_writer_open(&writer, path) != 0) {
+        fish_row_reader_close(&reader);
+        fossil_io_printf("{red,bold}fish_dataset_clean: failed to rewrite dataset.{normal}\n");
+        return -1;
+    }
+    while (!failed && fish_row_reader_next(&reader, &row)) {
+        if (reader.rows == 1 && schema->has_header)
+            failed = fish_row_writer_write(&writer, row.ptr, row.len) != 0;
+        else
+            failed = write_normalized(&writer, fields, schema, row) != 0;
     }
+    if (reader.failed) failed = 1;
+    fish_row_reader_close(&reader);
 
-    /* ---------- Write output back ---------- */
-    if (fossil_io_file_open(&file_stream, path, "w") != 0 || !file_stream.file) {
+    if (failed) {
+        fish_row_writer_abort(&writer);
         fossil_io_printf("{red,bold}fish_dataset_clean: failed to rewrite dataset.{normal}\n");
         return -1;
     }
+    if (fish_row_writer_commit(&writer) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_clean: failed to rewrite dataset.{normal}\n");
+        return -1;
+    }
+    fossil_io_printf("{cyan}fish_dataset_clean: normalized numeric values.{normal}\n");
+    return 0;
+}
+
+/**
+ * @brief Clean the dataset (drop nulls, deduplicate, normalize).
+ *
+ * The dataset is the selected one (fish_workspace_path()), by default:
+ *     datasets/current.dataset
+ *
+ * Null rows = rows that are empty or whitespace.
+ * Deduplication = remove exact duplicate rows.
+ * Normalize = scale numeric values in each column to 0–1 range; a header
+ * row is kept as is.
+ *
+ * Rows are read as CSV records and streamed through fixed-size buffers,
+ * so memory stays flat no matter how large the dataset is. Filtering is
+ * one pass and normalization one more, replaying the values parsed while
+ * filtering; each pass replaces the dataset atomically when it succeeds.
+ *
+ * @return int Status code.
+ */
+int fish_dataset_clean(int drop_null, int dedup, int normalize)
+{
+    const char *path = fish_workspace_path();
+    fish_row_fields_t fields = {0};
+    fish_schema_t schema;
+    int rc = 0;
 
-    for (size_t i = 0; i < count; i++) {
-        fossil_io_fputs(file_stream.file, rows[i]);
-        fossil_io_cstring_free(rows[i]);
+    if (!fossil_io_file_file_exists(path)) {
+        fossil_io_printf("{red,bold}fish_dataset_clean: no active dataset found.{normal}\n");
+        return -1;
     }
-    fossil_io_file_close(&file_stream);
 
-    fossil_sys_memory_free(rows);
+    fish_schema_init(&schema, FISH_SCHEMA_CACHE_BUDGET);
+    if (drop_null || dedup)
+        rc = clean_filter_pass(path, drop_null, dedup, normalize ? &schema : NULL, &fields);
 
-    fossil_io_printf("{green,bold}fish_dataset_clean: completed successfully.{normal}\n");
-    return 0;
+    if (rc == 0 && normalize)
+        rc = clean_normalize_pass(path, &schema, &fields, drop_null || dedup);
+
+    fish_row_fields_free(&fields);
+    fish_schema_free(&schema);
+
+    if (rc == 0)
+        fossil_io_printf("{green,bold}fish_dataset_clean: completed successfully.{normal}\n");
+    return rc;
 }
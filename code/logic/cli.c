@@ -0,0 +1,791 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/cli.h"
+#include "fossil/code/app.h"
+#include "fossil/code/arena.h"
+#include "fossil/code/dataset.h"
+#include "fossil/code/model.h"
+#include "fossil/code/workspace.h"
+#include <stdlib.h>
+
+/* Learning rate used when --lr is not given */
+#define CLI_DEFAULT_LR 0.1f
+
+/* Most stages `fish run` accepts in one pipeline */
+#define CLI_MAX_STAGES 32
+
+typedef int (*cli_fn)(int argc, char **argv);
+
+typedef struct {
+    ccstring name;
+    ccstring usage;
+    ccstring help;
+    cli_fn run;
+    int pipeable;       /* may be a stage of `fish run`; rewrites the dataset */
+    int selects;        /* operates on the dataset chosen with --dataset */
+} cli_command_t;
+
+/* ---------------- argument helpers ---------------- */
+
+static int arg_is(ccstring arg, ccstring flag, ccstring alias) {
+    return fossil_io_cstring_compare(arg, flag) == 0 ||
+           (alias && fossil_io_cstring_compare(arg, alias) == 0);
+}
+
+/* value of the flag at argv[*i], advancing past it */
+static ccstring arg_value(int argc, char **argv, int *i) {
+    if (*i + 1 >= argc || argv[*i + 1] == cnullptr) {
+        fossil_io_printf("{red,bold}%s: %s needs a value.{normal}\n", argv[0], argv[*i]);
+        return cnullptr;
+    }
+    return argv[++*i];
+}
+
+static int arg_int(int argc, char **argv, int *i, int *out) {
+    ccstring text = arg_value(argc, argv, i);
+    if (!text) return -1;
+    char *end = cnullptr;
+    long v = strtol(text, &end, 10);
+    if (end == text || *end != '\0') {
+        fossil_io_printf("{red,bold}%s: %s expects a whole number, got '%s'.{normal}\n", argv[0], argv[*i - 1], text);
+        return -1;
+    }
+    *out = (int)v;
+    return 0;
+}
+
+static int parse_float(ccstring text, float *out) {
+    char *end = cnullptr;
+    double v = strtod(text, &end);
+    if (end == text || *end != '\0') return -1;
+    *out = (float)v;
+    return 0;
+}
+
+static int arg_float(int argc, char **argv, int *i, float *out) {
+    ccstring text = arg_value(argc, argv, i);
+    if (!text) return -1;
+    if (parse_float(text, out) != 0) {
+        fossil_io_printf("{red,bold}%s: %s expects a number, got '%s'.{normal}\n", argv[0], argv[*i - 1], text);
+        return -1;
+    }
+    return 0;
+}
+
+static int arg_positional(ccstring arg) {
+    return arg[0] != '-' || arg[1] == '\0';
+}
+
+/* take one positional argument into *slot, refusing a second one */
+static int arg_take(char **argv, ccstring arg, ccstring *slot) {
+    if (*slot) {
+        fossil_io_printf("{red,bold}%s: unexpected argument '%s'.{normal}\n", argv[0], arg);
+        return -1;
+    }
+    *slot = arg;
+    return 0;
+}
+
+static int arg_unknown(char **argv, ccstring arg) {
+    fossil_io_printf("{red,bold}%s: unknown option '%s' (see --help).{normal}\n", argv[0], arg);
+    return -1;
+}
+
+static int arg_require(char **argv, ccstring value, ccstring what) {
+    if (value) return 0;
+    fossil_io_printf("{red,bold}%s: %s is required.{normal}\n", argv[0], what);
+    return -1;
+}
+
+/* split fractions may be given as percentages (70 15 15) */
+static float as_fraction(float v) {
+    return v > 1.0f ? v / 100.0f : v;
+}
+
+/*
+ * Remove every `--dataset <name>` from argv (past argv[0]) and select that
+ * dataset. *given is set when one was found.
+ */
+static int take_dataset(int *argc, char **argv, int *given) {
+    int kept = 1;
+    for (int i = 1; i < *argc; i++) {
+        if (!arg_is(argv[i], "--dataset", cnullptr)) {
+            argv[kept++] = argv[i];
+            continue;
+        }
+        ccstring name = arg_value(*argc, argv, &i);
+        if (!name) return -1;
+        if (fish_workspace_select(name) != 0) {
+            fossil_io_printf("{red,bold}%s: '%s' is not a dataset name.{normal}\n", argv[0], name);
+            return -1;
+        }
+        *given = 1;
+    }
+    *argc = kept;
+    return 0;
+}
+
+static const cli_command_t *find_command(const cli_command_t *table, size_t count, ccstring name);
+static void print_usage(const cli_command_t *table, size_t count, ccstring prefix);
+static int usage_of(const cli_command_t *cmd, ccstring prefix);
+
+/* ---------------- model commands ---------------- */
+
+static int cmd_create(int argc, char **argv) {
+    ccstring name = cnullptr;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--name", "-n")) {
+            if (!(name = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &name) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, name, "a model name (-n)") != 0) return -1;
+    return fish_create(name);
+}
+
+static int cmd_delete(int argc, char **argv) {
+    ccstring name = cnullptr;
+    int force = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--name", "-n")) {
+            if (!(name = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--force", cnullptr)) {
+            force = 1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &name) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, name, "a model name (-n)") != 0) return -1;
+    return fish_delete_model(name, force);
+}
+
+static int cmd_train(int argc, char **argv) {
+    ccstring model = cnullptr;
+    ccstring dataset = cnullptr;
+    int epochs = 1;
+    int batch = 0;
+    int checkpoint = 0;
+    float lr = CLI_DEFAULT_LR;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--model", "-m")) {
+            if (!(model = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--dataset", "-d")) {
+            if (!(dataset = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--epochs", cnullptr)) {
+            if (arg_int(argc, argv, &i, &epochs) != 0) return -1;
+        } else if (arg_is(argv[i], "--batch", cnullptr)) {
+            if (arg_int(argc, argv, &i, &batch) != 0) return -1;
+        } else if (arg_is(argv[i], "--lr", cnullptr)) {
+            if (arg_float(argc, argv, &i, &lr) != 0) return -1;
+        } else if (arg_is(argv[i], "--checkpoint", cnullptr)) {
+            if (arg_int(argc, argv, &i, &checkpoint) != 0) return -1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &model) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, model, "a model (-m)") != 0) return -1;
+    if (dataset && !(dataset = fish_workspace_resolve(dataset))) return -1;
+    return fish_train(model, dataset, epochs, batch, lr, checkpoint);
+}
+
+static int cmd_test(int argc, char **argv) {
+    ccstring model = cnullptr;
+    ccstring dataset = cnullptr;
+    ccstring metrics = cnullptr;
+    ccstring save = cnullptr;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--model", "-m")) {
+            if (!(model = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--dataset", "-d")) {
+            if (!(dataset = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--metrics", cnullptr)) {
+            if (!(metrics = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--save", cnullptr)) {
+            if (!(save = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &model) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, model, "a model (-m)") != 0) return -1;
+    if (dataset && !(dataset = fish_workspace_resolve(dataset))) return -1;
+    return fish_test(model, dataset, metrics, save);
+}
+
+static int cmd_inspect(int argc, char **argv) {
+    ccstring model = cnullptr;
+    ccstring layer = cnullptr;
+    int weights = 0;
+    int summary = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--model", "-m")) {
+            if (!(model = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--weights", cnullptr)) {
+            weights = 1;
+        } else if (arg_is(argv[i], "--summary", cnullptr)) {
+            summary = 1;
+        } else if (arg_is(argv[i], "--layer", cnullptr)) {
+            if (!(layer = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &model) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, model, "a model (-m)") != 0) return -1;
+    return fish_inspect(model, weights, summary, layer);
+}
+
+static int cmd_save(int argc, char **argv) {
+    ccstring model = cnullptr;
+    ccstring file = cnullptr;
+    ccstring format = "bin";
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--model", "-m")) {
+            if (!(model = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--file", "-f")) {
+            if (!(file = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--format", cnullptr)) {
+            if (!(format = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &model) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, model, "a model (-m)") != 0 ||
+        arg_require(argv, file, "a target file (--file)") != 0) return -1;
+    return fish_save(model, file, format);
+}
+
+static int cmd_load(int argc, char **argv) {
+    ccstring file = cnullptr;
+    int override = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--file", "-f")) {
+            if (!(file = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--override", cnullptr)) {
+            override = 1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &file) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, file, "a source file (--file)") != 0) return -1;
+    return fish_load(file, override);
+}
+
+/* ---------------- dataset commands ---------------- */
+
+static int cmd_import(int argc, char **argv) {
+    ccstring file = cnullptr;
+    ccstring format = "csv";
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--file", "-f")) {
+            if (!(file = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--format", cnullptr)) {
+            if (!(format = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &file) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, file, "a source file (--file)") != 0) return -1;
+    return fish_dataset_import(file, format);
+}
+
+static int cmd_dataset_delete(int argc, char **argv) {
+    ccstring name = cnullptr;
+    int force = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--name", "-n")) {
+            if (!(name = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--force", cnullptr)) {
+            force = 1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &name) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, name, "a dataset name (-n)") != 0) return -1;
+    return fish_delete_dataset(name, force);
+}
+
+static int cmd_dataset_list(int argc, char **argv) {
+    if (argc > 1) return arg_unknown(argv, argv[1]);
+    return fish_dataset_list();
+}
+
+static int cmd_clean(int argc, char **argv) {
+    int drop_null = 0;
+    int dedup = 0;
+    int normalize = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--drop-null", cnullptr)) drop_null = 1;
+        else if (arg_is(argv[i], "--dedup", cnullptr)) dedup = 1;
+        else if (arg_is(argv[i], "--normalize", cnullptr)) normalize = 1;
+        else return arg_unknown(argv, argv[i]);
+    }
+    return fish_dataset_clean(drop_null, dedup, normalize);
+}
+
+static int cmd_preprocess(int argc, char **argv) {
+    int tokenize = 0;
+    int scale = 0;
+    int encode = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--tokenize", cnullptr)) tokenize = 1;
+        else if (arg_is(argv[i], "--scale", cnullptr)) scale = 1;
+        else if (arg_is(argv[i], "--encode", cnullptr)) encode = 1;
+        else return arg_unknown(argv, argv[i]);
+    }
+    return fish_dataset_preprocess(tokenize, scale, encode);
+}
+
+static int cmd_augment(int argc, char **argv) {
+    ccstring type = "noise";
+    int factor = 1;
+    int seed = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--type", cnullptr)) {
+            if (!(type = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--factor", cnullptr)) {
+            if (arg_int(argc, argv, &i, &factor) != 0) return -1;
+        } else if (arg_is(argv[i], "--seed", cnullptr)) {
+            if (arg_int(argc, argv, &i, &seed) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    return fish_dataset_augment_seeded(type, factor, (uint64_t)seed);
+}
+
+static int cmd_export(int argc, char **argv) {
+    ccstring file = cnullptr;
+    ccstring format = "csv";
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--file", "-f")) {
+            if (!(file = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--format", cnullptr)) {
+            if (!(format = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &file) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, file, "a target file (--file)") != 0) return -1;
+    return fish_dataset_export(file, format);
+}
+
+static int cmd_stats(int argc, char **argv) {
+    ccstring columns = cnullptr;
+    int summary = 0;
+    int plot = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--summary", cnullptr)) {
+            summary = 1;
+        } else if (arg_is(argv[i], "--columns", cnullptr)) {
+            if (!(columns = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--plot", cnullptr)) {
+            plot = 1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    return fish_dataset_stats(summary, columns, plot);
+}
+
+static int cmd_split(int argc, char **argv) {
+    float frac[3] = { 0.8f, 0.1f, 0.1f };
+    int given = 0;
+    int seed = 0;
+    int exact = 0;
+    ccstring key = cnullptr;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--train", cnullptr)) {
+            if (arg_float(argc, argv, &i, &frac[0]) != 0) return -1;
+        } else if (arg_is(argv[i], "--val", cnullptr)) {
+            if (arg_float(argc, argv, &i, &frac[1]) != 0) return -1;
+        } else if (arg_is(argv[i], "--test", cnullptr)) {
+            if (arg_float(argc, argv, &i, &frac[2]) != 0) return -1;
+        } else if (arg_is(argv[i], "--seed", cnullptr)) {
+            if (arg_int(argc, argv, &i, &seed) != 0) return -1;
+        } else if (arg_is(argv[i], "--key", cnullptr)) {
+            if (!(key = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--exact", cnullptr)) {
+            exact = 1;
+        } else if (arg_positional(argv[i]) && given < 3) {
+            /* `split 0.8 0.1 0.1` */
+            if (parse_float(argv[i], &frac[given++]) != 0) {
+                fossil_io_printf("{red,bold}%s: '%s' is not a fraction.{normal}\n", argv[0], argv[i]);
+                return -1;
+            }
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    return fish_dataset_split_seeded(as_fraction(frac[0]), as_fraction(frac[1]), as_fraction(frac[2]),
+                                     (uint64_t)seed, key, exact);
+}
+
+static int cmd_shard(int argc, char **argv) {
+    int shards = 0;
+    int kfold = 0;
+    int seed = 0;
+    ccstring key = cnullptr;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--shards", "-k")) {
+            if (arg_int(argc, argv, &i, &shards) != 0) return -1;
+        } else if (arg_is(argv[i], "--kfold", cnullptr)) {
+            kfold = 1;
+        } else if (arg_is(argv[i], "--seed", cnullptr)) {
+            if (arg_int(argc, argv, &i, &seed) != 0) return -1;
+        } else if (arg_is(argv[i], "--key", cnullptr)) {
+            if (!(key = arg_value(argc, argv, &i))) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    return fish_dataset_shard(shards > 0 ? (size_t)shards : 0, kfold, (uint64_t)seed, key);
+}
+
+static const cli_command_t dataset_commands[] = {
+    { "import",     "--file <path|dir|glob> [--format csv|fson|json]", "Import a dataset as the active one", cmd_import, 0, 0 },
+    { "list",       "", "List the datasets in datasets/", cmd_dataset_list, 0, 0 },
+    { "clean",      "[--drop-null] [--dedup] [--normalize]", "Drop nulls and duplicates, normalize values", cmd_clean, 1, 1 },
+    { "preprocess", "[--tokenize] [--scale] [--encode]", "Prepare the dataset for training", cmd_preprocess, 1, 1 },
+    { "augment",    "[--type noise|flip|shift] [--factor <n>] [--seed <n>]", "Add augmented copies of every row", cmd_augment, 1, 1 },
+    { "export",     "--file <path> [--format <f>]", "Export the dataset", cmd_export, 0, 1 },
+    { "stats",      "[--summary] [--columns <list>] [--plot]", "Show dataset statistics", cmd_stats, 0, 1 },
+    { "split",      "[<train> <val> <test>] [--seed <n>] [--key <col>] [--exact]", "Write train/val/test datasets", cmd_split, 1, 1 },
+    { "shard",      "--shards <n> [--kfold] [--seed <n>] [--key <col>]", "Write hash shards or k-fold pairs", cmd_shard, 1, 1 },
+    { "delete",     "-n <name> [--force]", "Delete a dataset", cmd_dataset_delete, 0, 0 }
+};
+#define DATASET_COMMANDS (sizeof(dataset_commands) / sizeof(dataset_commands[0]))
+
+/*
+ * `--dataset <name>` may appear anywhere after "dataset". Commands that
+ * rewrite the dataset hold its workspace lock while they run.
+ */
+static int cmd_dataset(int argc, char **argv) {
+    int named = 0;
+    if (take_dataset(&argc, argv, &named) != 0) return -1;
+    if (argc < 2 || arg_is(argv[1], "--help", cnullptr)) {
+        print_usage(dataset_commands, DATASET_COMMANDS, "dataset ");
+        fossil_io_printf("{blue}  Add --dataset <name> to work on datasets/<name> instead of the active dataset.{normal}\n");
+        return argc < 2 ? -1 : 0;
+    }
+    const cli_command_t *cmd = find_command(dataset_commands, DATASET_COMMANDS, argv[1]);
+    if (!cmd) {
+        fossil_io_printf("{red,bold}dataset: unknown subcommand '%s'.{normal}\n", argv[1]);
+        return -1;
+    }
+    if (argc > 2 && arg_is(argv[2], "--help", cnullptr)) return usage_of(cmd, "dataset ");
+    if (named && !cmd->selects) {
+        fossil_io_printf("{red,bold}dataset %s: --dataset does not apply here.{normal}\n", cmd->name);
+        return -1;
+    }
+    if (!cmd->pipeable) return cmd->run(argc - 1, argv + 1);
+
+    fish_workspace_lock_t lock;
+    if (fish_workspace_lock(&lock) != 0) {
+        fossil_io_printf("{red,bold}dataset %s: cannot lock '%s'.{normal}\n", cmd->name, fish_workspace_path());
+        return -1;
+    }
+    int rc = cmd->run(argc - 1, argv + 1);
+    fish_workspace_unlock(&lock);
+    return rc;
+}
+
+/* ---------------- AI commands ---------------- */
+
+static int cmd_ask(int argc, char **argv) {
+    ccstring model = cnullptr;
+    ccstring file = cnullptr;
+    ccstring prompt = cnullptr;
+    ccstring batch = cnullptr;
+    ccstring out = cnullptr;
+    int explain = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--model", "-m")) {
+            if (!(model = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--file", "-f")) {
+            if (!(file = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--batch", "-b")) {
+            if (!(batch = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--out", "-o")) {
+            if (!(out = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--explain", cnullptr)) {
+            explain = 1;
+        } else if (arg_is(argv[i], "--cache", cnullptr)) {
+            fish_model_cache_persist(1);
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &prompt) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, model, "a model (-m)") != 0) return -1;
+    if (batch) {
+        if (prompt) {
+            fossil_io_printf("{red,bold}%s: --batch takes its prompts from the file, not '%s'.{normal}\n", argv[0], prompt);
+            return -1;
+        }
+        return fish_ask_batch(model, batch, out, explain);
+    }
+    if (arg_require(argv, prompt, "a prompt") != 0) return -1;
+    return fish_ask(model, prompt, file, explain);
+}
+
+static int cmd_chat(int argc, char **argv) {
+    ccstring model = cnullptr;
+    ccstring save = cnullptr;
+    int context = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--model", "-m")) {
+            if (!(model = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--context", cnullptr)) {
+            context = 1;
+        } else if (arg_is(argv[i], "--save", cnullptr)) {
+            if (!(save = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &model) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, model, "a model (-m)") != 0) return -1;
+    return fish_chat(model, context, save);
+}
+
+static int cmd_summary(int argc, char **argv) {
+    ccstring file = cnullptr;
+    ccstring batch = cnullptr;
+    ccstring out = "summaries.jsonl";
+    int depth = 2;
+    int time_flag = 0;
+    int corpus_idf = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--file", "-f")) {
+            if (!(file = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--depth", cnullptr)) {
+            if (arg_int(argc, argv, &i, &depth) != 0) return -1;
+        } else if (arg_is(argv[i], "--time", cnullptr)) {
+            time_flag = 1;
+        } else if (arg_is(argv[i], "--batch", cnullptr)) {
+            if (!(batch = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--out", "-o")) {
+            if (!(out = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--corpus-idf", cnullptr)) {
+            corpus_idf = 1;
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &file) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (batch) return fish_summary_batch(batch, depth, corpus_idf, out);
+    if (arg_require(argv, file, "a file (-f) or --batch <source>") != 0) return -1;
+    return fish_summary(file, depth, time_flag);
+}
+
+static int cmd_serve(int argc, char **argv) {
+    ccstring endpoint = cnullptr;
+    ccstring models = cnullptr;
+    int workers = 0;
+    for (int i = 1; i < argc; i++) {
+        if (arg_is(argv[i], "--endpoint", "-e")) {
+            if (!(endpoint = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--models", "-m")) {
+            if (!(models = arg_value(argc, argv, &i))) return -1;
+        } else if (arg_is(argv[i], "--workers", "-w")) {
+            if (arg_int(argc, argv, &i, &workers) != 0) return -1;
+        } else if (arg_is(argv[i], "--cache", cnullptr)) {
+            fish_model_cache_persist(1);
+        } else if (arg_positional(argv[i])) {
+            if (arg_take(argv, argv[i], &endpoint) != 0) return -1;
+        } else {
+            return arg_unknown(argv, argv[i]);
+        }
+    }
+    if (arg_require(argv, endpoint, "an endpoint (unix:<path> or [host:]port)") != 0) return -1;
+    return fish_serve(endpoint, models, workers > 0 ? (size_t)workers : 0);
+}
+
+/* ---------------- pipeline ---------------- */
+
+typedef struct {
+    const cli_command_t *cmd;
+    int argc;
+    char **argv;
+} cli_stage_t;
+
+/*
+ * `fish run clean --dedup : preprocess --scale : split 0.8 0.1 0.1`
+ *
+ * Every stage is checked before the first one runs. The active dataset is
+ * staged in memory for the whole pipeline, so each stage reads the rows
+ * the previous one committed and only the final result is written back
+ * (split and shard still write their own output files). If a stage fails
+ * the dataset on disk is left as it was. `--dataset <name>` runs the
+ * pipeline on that dataset; its workspace lock is held throughout.
+ */
+static int cmd_run(int argc, char **argv) {
+    cli_stage_t stages[CLI_MAX_STAGES];
+    size_t count = 0;
+    int named = 0;
+    if (take_dataset(&argc, argv, &named) != 0) return -1;
+
+    int i = 1;
+    while (i < argc) {
+        int start = i;
+        while (i < argc && fossil_io_cstring_compare(argv[i], FISH_CLI_STAGE_SEP) != 0) i++;
+        int end = i++;
+
+        /* an optional "dataset" prefix reads like the standalone command */
+        if (start < end && fossil_io_cstring_compare(argv[start], "dataset") == 0) start++;
+        if (start == end) {
+            fossil_io_printf("{red,bold}run: empty stage %zu.{normal}\n", count + 1);
+            return -1;
+        }
+        if (count == CLI_MAX_STAGES) {
+            fossil_io_printf("{red,bold}run: at most %d stages per pipeline.{normal}\n", CLI_MAX_STAGES);
+            return -1;
+        }
+
+        const cli_command_t *cmd = find_command(dataset_commands, DATASET_COMMANDS, argv[start]);
+        if (!cmd || !cmd->pipeable) {
+            fossil_io_printf("{red,bold}run: '%s' cannot be a pipeline stage "
+                             "(use clean, preprocess, augment, split or shard).{normal}\n", argv[start]);
+            return -1;
+        }
+        stages[count].cmd = cmd;
+        stages[count].argc = end - start;
+        stages[count].argv = argv + start;
+        count++;
+    }
+    if (count == 0) {
+        fossil_io_printf("{red,bold}run: no stages given.{normal}\n");
+        return -1;
+    }
+
+    fish_workspace_lock_t lock;
+    if (fish_workspace_lock(&lock) != 0) {
+        fossil_io_printf("{red,bold}run: cannot lock '%s'.{normal}\n", fish_workspace_path());
+        return -1;
+    }
+    if (fish_row_stage_begin(fish_workspace_path()) != 0) {
+        fish_workspace_unlock(&lock);
+        fossil_io_printf("{red,bold}run: cannot stage the active dataset.{normal}\n");
+        return -1;
+    }
+    int rc = 0;
+    for (size_t s = 0; s < count && rc == 0; s++) {
+        fossil_io_printf("{blue}run: [%zu/%zu] %s{normal}\n", s + 1, count, stages[s].cmd->name);
+        if (stages[s].cmd->run(stages[s].argc, stages[s].argv) != 0) {
+            fish_row_stage_end(0);
+            fossil_io_printf("{red,bold}run: stage %zu (%s) failed; the active dataset is unchanged.{normal}\n",
+                             s + 1, stages[s].cmd->name);
+            rc = -1;
+        }
+    }
+    if (rc == 0 && fish_row_stage_end(1) != 0) {
+        fossil_io_printf("{red,bold}run: failed to write the active dataset.{normal}\n");
+        rc = -1;
+    }
+    fish_workspace_unlock(&lock);
+    if (rc == 0) fossil_io_printf("{green,bold}run: %zu stages completed.{normal}\n", count);
+    return rc;
+}
+
+/* ---------------- dispatch ---------------- */
+
+static const cli_command_t commands[] = {
+    { "create",  "-n <name>", "Initialize a new Jellyfish AI model", cmd_create, 0, 0 },
+    { "train",   "-m <model> [-d <dataset>] [--epochs <n>] [--batch <n>] [--lr <rate>] [--checkpoint <n>]",
+                 "Train a model on a dataset", cmd_train, 0, 0 },
+    { "test",    "-m <model> [-d <dataset>] [--metrics <list>] [--save <file>]",
+                 "Evaluate a model on a dataset", cmd_test, 0, 0 },
+    { "inspect", "-m <model> [--weights] [--summary] [--layer <name>]", "Inspect a model", cmd_inspect, 0, 0 },
+    { "save",    "-m <model> --file <path> [--format bin|zchain|ref]", "Save a model to a file", cmd_save, 0, 0 },
+    { "load",    "--file <path> [--override]", "Load a model from a file", cmd_load, 0, 0 },
+    { "delete",  "-n <name> [--force]", "Delete a model", cmd_delete, 0, 0 },
+    { "dataset", "<subcommand> [flags]", "Manage datasets (dataset --help)", cmd_dataset, 0, 0 },
+    { "run",     "[--dataset <name>] <stage> [flags] : <stage> [flags] ...", "Chain dataset stages in memory", cmd_run, 0, 0 },
+    { "ask",     "-m <model> [-f <file>] [--explain] [--cache] <prompt> | --batch <file|-> [-o <file>]", "One-shot prompt", cmd_ask, 0, 0 },
+    { "chat",    "-m <model> [--context] [--save <file>]", "Interactive chat session", cmd_chat, 0, 0 },
+    { "summary", "-f <file> [--depth <n>] [--time] | --batch <source> [-o <file>] [--corpus-idf]",
+                 "Summarize a file or a corpus", cmd_summary, 0, 0 },
+    { "serve",   "<endpoint> [-m <models>] [-w <workers>] [--cache]", "Serve ask/chat requests", cmd_serve, 0, 0 }
+};
+#define COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+static const cli_command_t *find_command(const cli_command_t *table, size_t count, ccstring name) {
+    for (size_t i = 0; i < count; i++) {
+        if (fossil_io_cstring_compare(table[i].name, name) == 0) return &table[i];
+    }
+    return cnullptr;
+}
+
+static void print_usage(const cli_command_t *table, size_t count, ccstring prefix) {
+    for (size_t i = 0; i < count; i++) {
+#ifdef _WIN32
+        if (table[i].run == cmd_serve) continue; /* POSIX only, see serve.c */
+#endif
+        fossil_io_printf("{cyan}  %s%-10s {normal}%s\n", prefix, table[i].name, table[i].help);
+        fossil_io_printf("      {yellow}%s%s %s{normal}\n", prefix, table[i].name, table[i].usage);
+    }
+}
+
+static int usage_of(const cli_command_t *cmd, ccstring prefix) {
+    fossil_io_printf("{blue}Usage: {cyan}fish %s%s{normal} %s\n", prefix, cmd->name, cmd->usage);
+    fossil_io_printf("  %s\n", cmd->help);
+    return 0;
+}
+
+void fish_cli_usage(void) {
+    print_usage(commands, COMMANDS, "");
+}
+
+int fish_cli_dispatch(int argc, char **argv) {
+    if (argc < 1 || !argv[0]) return -1;
+    const cli_command_t *cmd = find_command(commands, COMMANDS, argv[0]);
+    if (!cmd) {
+        fossil_io_printf("{red}Unknown command: %s{reset}\n", argv[0]);
+        return -1;
+    }
+    if (argc > 1 && arg_is(argv[1], "--help", cnullptr) && cmd->run != cmd_dataset)
+        return usage_of(cmd, "");
+
+    int rc = cmd->run(argc, argv);
+    fish_workspace_select(cnullptr);
+    fish_scratch_stats_t stats;
+    fish_scratch_release(&stats);
+    if (FOSSIL_IO_VERBOSE)
+        fossil_io_printf("{blue}scratch: %zu allocations (%zu from pools), peak %zu bytes, %zu reserved{normal}\n",
+                         stats.allocs, stats.reused, stats.peak, stats.reserved);
+    return rc;
+}
@@ -0,0 +1,712 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/columnar.h"
+
+#define COL_DICT_SEED 0x64696374ull /* "dict" */
+#define COL_TRAILER_SIZE 16          /* uint64 footer offset + magic */
+
+/* ---------------- value typing ---------------- */
+
+/* Bitmap bytes for @p rows, padded so the payload stays 8-byte aligned. */
+static size_t bitmap_bytes(size_t rows) {
+    return ((rows + 63) / 64) * 8;
+}
+
+/* Strict integer: optional sign, no leading zeros (keeps "02134" a string). */
+static int parse_int64(fish_slice_t s, int64_t *out) {
+    size_t i = 0;
+    int neg = 0;
+    if (s.len > 0 && (s.ptr[0] == '+' || s.ptr[0] == '-')) neg = s.ptr[i++] == '-';
+    size_t digits = s.len - i;
+    if (digits == 0 || digits > 18) return 0;
+    if (digits > 1 && s.ptr[i] == '0') return 0;
+
+    int64_t v = 0;
+    for (; i < s.len; i++) {
+        if (s.ptr[i] < '0' || s.ptr[i] > '9') return 0;
+        v = v * 10 + (s.ptr[i] - '0');
+    }
+    *out = neg ? -v : v;
+    return 1;
+}
+
+/* ---------------- writer ---------------- */
+
+typedef struct {
+    uint32_t off;           /* into the group text arena */
+    uint32_t len;           /* 0 = null */
+} col_cell_t;
+
+typedef struct {
+    fish_row_writer_t out;
+    uint64_t pos;           /* bytes written so far */
+    int failed;
+
+    cstring *names;
+    size_t columns;
+    size_t names_cap;
+
+    col_cell_t **cells;     /* per column, FISH_COL_GROUP_ROWS cells */
+    size_t rows;            /* rows in the open group */
+    char *text;             /* field bytes of the open group */
+    size_t text_len;
+    size_t text_cap;
+
+    fish_col_chunk_info_t *info; /* per group: `columns` entries, see group_cols */
+    size_t info_len;
+    size_t info_cap;
+    uint64_t *group_rows;
+    uint64_t *group_cols;
+    size_t groups;
+    size_t groups_cap;
+    uint64_t total_rows;
+    uint64_t flags;         /* FISH_COL_* */
+} col_writer_t;
+
+static void wput(col_writer_t *w, const void *data, size_t len) {
+    if (w->failed || len == 0) return;
+    if (fish_row_writer_put(&w->out, (const char *)data, len) != 0) w->failed = 1;
+    w->pos += len;
+}
+
+static void wput_u64(col_writer_t *w, uint64_t v) {
+    wput(w, &v, sizeof(v));
+}
+
+static int grow(void **buf, size_t *cap, size_t need, size_t elem) {
+    if (need <= *cap) return 0;
+    size_t cap2 = *cap ? *cap : 16;
+    while (cap2 < need) cap2 *= 2;
+    void *grown = fossil_sys_memory_realloc(*buf, cap2 * elem);
+    if (!grown) return -1;
+    *buf = grown;
+    *cap = cap2;
+    return 0;
+}
+
+/* Append a column named @p name, or "column<N>" for fields past the header. */
+static int add_column(col_writer_t *w, const fish_slice_t *name) {
+    size_t c = w->columns;
+    if (grow((void **)&w->names, &w->names_cap, c + 1, sizeof(cstring)) != 0) return -1;
+    col_cell_t **cells = (col_cell_t **)fossil_sys_memory_realloc(w->cells, (c + 1) * sizeof(col_cell_t *));
+    if (!cells) return -1;
+    w->cells = cells;
+    w->cells[c] = (col_cell_t *)fossil_sys_memory_calloc(FISH_COL_GROUP_ROWS, sizeof(col_cell_t));
+    if (!w->cells[c]) return -1;
+
+    if (!name) {
+        w->names[c] = fossil_io_cstring_format("column%zu", c + 1);
+    } else {
+        fish_slice_t trimmed = fish_slice_trim(*name);
+        w->names[c] = (cstring)fossil_sys_memory_alloc(trimmed.len + 1);
+        if (w->names[c]) fish_slice_copy(trimmed, w->names[c], trimmed.len + 1);
+    }
+    if (!w->names[c]) return -1;
+    w->columns++;
+    return 0;
+}
+
+typedef struct {
+    const col_writer_t *w;
+    const col_cell_t *dict; /* first cell of each entry */
+} dict_ctx_t;
+
+static int resolve_dict(void *ctx, uint64_t ref, size_t len, fish_slice_t *out) {
+    const dict_ctx_t *d = (const dict_ctx_t *)ctx;
+    out->ptr = d->w->text + d->dict[ref].off;
+    out->len = len;
+    return 0;
+}
+
+static fish_slice_t cell_slice(const col_writer_t *w, col_cell_t cell) {
+    fish_slice_t s = { w->text + cell.off, cell.len };
+    return s;
+}
+
+/* Write strings as a dictionary when it pays off, plain otherwise. */
+static int encode_strings(col_writer_t *w, const col_cell_t *cells, size_t rows,
+                          fish_col_chunk_info_t *info) {
+    fish_hashset_t set;
+    dict_ctx_t ctx = { w, NULL };
+    uint32_t *codes = (uint32_t *)fossil_sys_memory_alloc(rows * sizeof(uint32_t));
+    col_cell_t *dict = (col_cell_t *)fossil_sys_memory_alloc(rows * sizeof(col_cell_t));
+    size_t count = 0;
+    int rc = codes && dict ? 0 : -1;
+
+    ctx.dict = dict;
+    if (rc == 0 && fish_hashset_init(&set, rows / 4, resolve_dict, &ctx) != 0) rc = -1;
+    for (size_t r = 0; rc == 0 && r < rows; r++) {
+        fish_slice_t s = cell_slice(w, cells[r]);
+        uint64_t digest = fish_hash64(s.ptr, s.len, COL_DICT_SEED);
+        uint64_t ref;
+        int found = fish_hashset_lookup(&set, digest, s, &ref);
+        if (found < 0) { rc = -1; break; }
+        if (!found) {
+            ref = count;
+            dict[count++] = cells[r];
+            if (fish_hashset_insert(&set, digest, s, ref) < 0) { rc = -1; break; }
+        }
+        codes[r] = (uint32_t)ref;
+    }
+    if (codes && dict && rc == 0) fish_hashset_free(&set);
+
+    if (rc == 0 && count * 2 <= rows) {
+        uint32_t n = (uint32_t)count;
+        info->type = FISH_COL_DICT;
+        wput(w, &n, sizeof(n));
+        for (size_t i = 0; i < count; i++) wput(w, &dict[i].len, sizeof(uint32_t));
+        wput(w, codes, rows * sizeof(uint32_t));
+        for (size_t i = 0; i < count; i++) wput(w, w->text + dict[i].off, dict[i].len);
+    } else if (rc == 0) {
+        info->type = FISH_COL_STRING;
+        for (size_t r = 0; r < rows; r++) wput(w, &cells[r].len, sizeof(uint32_t));
+        for (size_t r = 0; r < rows; r++) wput(w, w->text + cells[r].off, cells[r].len);
+    }
+
+    fossil_sys_memory_free(codes);
+    fossil_sys_memory_free(dict);
+    return rc;
+}
+
+static int encode_chunk(col_writer_t *w, const col_cell_t *cells, size_t rows,
+                        fish_col_chunk_info_t *info) {
+    size_t nulls = 0;
+    int all_int = 1, all_num = 1;
+    int64_t iv;
+
+    for (size_t r = 0; r < rows; r++) {
+        if (cells[r].len == 0) { nulls++; continue; }
+        fish_slice_t s = cell_slice(w, cells[r]);
+        if (all_int && !parse_int64(s, &iv)) all_int = 0;
+        if (!all_int && all_num && !fish_slice_is_number(s)) all_num = 0;
+    }
+
+    info->offset = w->pos;
+    info->nulls = nulls;
+    info->min = 0.0;
+    info->max = 0.0;
+    if (nulls == rows) {
+        info->type = FISH_COL_NULL;
+        info->bytes = 0;
+        return 0;
+    }
+
+    if (nulls > 0) {
+        size_t bytes = bitmap_bytes(rows);
+        uint8_t *bits = (uint8_t *)fossil_sys_memory_calloc(bytes, 1);
+        if (!bits) return -1;
+        for (size_t r = 0; r < rows; r++)
+            if (cells[r].len) bits[r / 8] |= (uint8_t)(1u << (r % 8));
+        wput(w, bits, bytes);
+        fossil_sys_memory_free(bits);
+    }
+
+    int rc = 0;
+    if (all_int || all_num) {
+        double lo = HUGE_VAL, hi = -HUGE_VAL;
+        info->type = all_int ? FISH_COL_INT64 : FISH_COL_F64;
+        for (size_t r = 0; r < rows; r++) {
+            fish_slice_t s = cell_slice(w, cells[r]);
+            double d = 0.0;
+            if (all_int) {
+                iv = 0;
+                if (cells[r].len) parse_int64(s, &iv);
+                wput(w, &iv, sizeof(iv));
+                d = (double)iv;
+            } else {
+                if (cells[r].len) fish_slice_to_double(s, &d);
+                wput(w, &d, sizeof(d));
+            }
+            if (!cells[r].len) continue;
+            if (d < lo) lo = d;
+            if (d > hi) hi = d;
+        }
+        info->min = lo;
+        info->max = hi;
+    } else {
+        rc = encode_strings(w, cells, rows, info);
+    }
+
+    info->bytes = w->pos - info->offset;
+    return rc != 0 || w->failed ? -1 : 0;
+}
+
+static int flush_group(col_writer_t *w) {
+    if (w->rows == 0) return 0;
+    if (grow((void **)&w->group_rows, &w->groups_cap, w->groups + 1, sizeof(uint64_t)) != 0) return -1;
+    uint64_t *cols = (uint64_t *)fossil_sys_memory_realloc(w->group_cols, w->groups_cap * sizeof(uint64_t));
+    if (!cols) return -1;
+    w->group_cols = cols;
+    if (grow((void **)&w->info, &w->info_cap, w->info_len + w->columns, sizeof(fish_col_chunk_info_t)) != 0)
+        return -1;
+
+    for (size_t c = 0; c < w->columns; c++) {
+        if (encode_chunk(w, w->cells[c], w->rows, &w->info[w->info_len + c]) != 0) return -1;
+        fossil_sys_memory_zero(w->cells[c], w->rows * sizeof(col_cell_t));
+    }
+    w->info_len += w->columns;
+    w->group_rows[w->groups] = w->rows;
+    w->group_cols[w->groups] = w->columns;
+    w->groups++;
+    w->total_rows += w->rows;
+    w->rows = 0;
+    w->text_len = 0;
+    return 0;
+}
+
+static int writer_row(col_writer_t *w, fish_row_fields_t *fields, fish_slice_t row) {
+    size_t fc = fish_row_fields_split(fields, row);
+    if (fc == 0) return -1;
+    while (w->columns < fc)
+        if (add_column(w, NULL) != 0) return -1;
+    if (grow((void **)&w->text, &w->text_cap, w->text_len + row.len, 1) != 0) return -1;
+    if (w->text_len + row.len > UINT32_MAX) return -1;
+
+    for (size_t c = 0; c < fc; c++) {
+        fish_slice_t v = fish_slice_trim(fields->field[c]);
+        w->cells[c][w->rows].off = (uint32_t)w->text_len;
+        w->cells[c][w->rows].len = (uint32_t)v.len;
+        fossil_sys_memory_copy(w->text + w->text_len, v.ptr, v.len);
+        w->text_len += v.len;
+    }
+    w->rows++;
+    return w->rows == FISH_COL_GROUP_ROWS ? flush_group(w) : 0;
+}
+
+static int writer_finish(col_writer_t *w) {
+    if (flush_group(w) != 0) return -1;
+
+    uint64_t footer = w->pos;
+    wput_u64(w, FISH_COL_VERSION);
+    wput_u64(w, w->flags);
+    wput_u64(w, w->columns);
+    for (size_t c = 0; c < w->columns; c++) {
+        uint64_t len = strlen(w->names[c]);
+        wput_u64(w, len);
+        wput(w, w->names[c], (size_t)len);
+    }
+    wput_u64(w, w->total_rows);
+    wput_u64(w, w->groups);
+    size_t at = 0;
+    for (size_t g = 0; g < w->groups; g++) {
+        wput_u64(w, w->group_rows[g]);
+        wput_u64(w, w->group_cols[g]);
+        wput(w, &w->info[at], (size_t)w->group_cols[g] * sizeof(fish_col_chunk_info_t));
+        at += (size_t)w->group_cols[g];
+    }
+    wput_u64(w, footer);
+    wput(w, FISH_COL_MAGIC, 8);
+    return w->failed ? -1 : 0;
+}
+
+static void writer_free(col_writer_t *w) {
+    for (size_t c = 0; c < w->columns; c++) {
+        fossil_sys_memory_free(w->names[c]);
+        fossil_sys_memory_free(w->cells[c]);
+    }
+    fossil_sys_memory_free(w->names);
+    fossil_sys_memory_free(w->cells);
+    fossil_sys_memory_free(w->text);
+    fossil_sys_memory_free(w->info);
+    fossil_sys_memory_free(w->group_rows);
+    fossil_sys_memory_free(w->group_cols);
+}
+
+int64_t fish_col_convert_watched(ccstring text_path, ccstring out_path,
+                                 fish_row_watch_fn watch, void *ctx) {
+    fish_row_reader_t reader;
+    fish_row_fields_t fields = {0};
+    col_writer_t w;
+    fish_slice_t row;
+    int rc = 0;
+
+    fossil_sys_memory_zero(&w, sizeof(w));
+    if (fish_row_reader_open_csv(&reader, text_path) != 0) return -1;
+    if (watch) fish_row_reader_watch(&reader, watch, ctx);
+    if (fish_row_writer_open_raw(&w.out, out_path) != 0) {
+        fish_row_reader_close(&reader);
+        return -1;
+    }
+    wput(&w, FISH_COL_MAGIC, 8);
+    wput_u64(&w, FISH_COL_BYTE_ORDER);
+
+    /* a header row names the columns; without one they are numbered */
+    if (fish_row_reader_header(&reader, &fields, &row) == 1) {
+        w.flags |= FISH_COL_NAMED;
+        for (size_t c = 0; c < fields.count && rc == 0; c++) rc = add_column(&w, &fields.field[c]);
+    }
+    while (rc == 0 && fish_row_reader_next(&reader, &row))
+        rc = writer_row(&w, &fields, row);
+    if (reader.failed) rc = -1;
+    if (rc == 0) rc = writer_finish(&w);
+
+    uint64_t watched = reader.watched;
+    fish_row_reader_close(&reader);
+    fish_row_fields_free(&fields);
+    if (rc == 0 && !w.failed) rc = fish_row_writer_commit(&w.out);
+    else {
+        fish_row_writer_abort(&w.out);
+        rc = -1;
+    }
+    writer_free(&w);
+    return rc == 0 ? (int64_t)watched : -1;
+}
+
+int fish_col_convert(ccstring text_path, ccstring out_path) {
+    return fish_col_convert_watched(text_path, out_path, NULL, NULL) < 0 ? -1 : 0;
+}
+
+/* ---------------- reader ---------------- */
+
+typedef struct {
+    fossil_io_file_t *file;
+    int failed;
+} col_in_t;
+
+static void rget(col_in_t *in, void *data, size_t len) {
+    if (!in->failed && len && fossil_io_file_read(in->file, data, 1, len) != len) in->failed = 1;
+}
+
+static uint64_t rget_u64(col_in_t *in) {
+    uint64_t v = 0;
+    rget(in, &v, sizeof(v));
+    return v;
+}
+
+int fish_col_probe(ccstring path) {
+    fossil_io_file_t file;
+    char magic[8];
+    int yes = 0;
+    if (fish_row_stage_data(path, NULL)) return 0; /* staged rows are text */
+    if (fossil_io_file_open(&file, path, "rb") != 0) return 0;
+    yes = fossil_io_file_read(&file, magic, 1, sizeof(magic)) == sizeof(magic) &&
+          memcmp(magic, FISH_COL_MAGIC, sizeof(magic)) == 0;
+    fossil_io_file_close(&file);
+    return yes;
+}
+
+static int read_footer(fish_col_reader_t *r, uint64_t size) {
+    col_in_t in = { &r->file, 0 };
+    char magic[8];
+
+    if (size < 16 + COL_TRAILER_SIZE) return -1;
+    if (fish_fseek64(r->file.file, 8, SEEK_SET) != 0) return -1;
+    if (rget_u64(&in) != FISH_COL_BYTE_ORDER) {
+        r->foreign = !in.failed;
+        return -1;
+    }
+    if (fish_fseek64(r->file.file, (long long)(size - COL_TRAILER_SIZE), SEEK_SET) != 0) return -1;
+    uint64_t footer = rget_u64(&in);
+    rget(&in, magic, sizeof(magic));
+    if (in.failed || memcmp(magic, FISH_COL_MAGIC, sizeof(magic)) != 0 || footer >= size) return -1;
+    if (fish_fseek64(r->file.file, (long long)footer, SEEK_SET) != 0) return -1;
+
+    if (rget_u64(&in) != FISH_COL_VERSION) return -1;
+    r->flags = rget_u64(&in);
+    uint64_t columns = rget_u64(&in);
+    if (in.failed || columns > size) return -1;
+    r->names = (cstring *)fossil_sys_memory_calloc((size_t)columns + 1, sizeof(cstring));
+    if (!r->names) return -1;
+    r->columns = (size_t)columns;
+    for (size_t c = 0; c < r->columns; c++) {
+        uint64_t len = rget_u64(&in);
+        if (in.failed || len > size) return -1;
+        r->names[c] = (cstring)fossil_sys_memory_alloc((size_t)len + 1);
+        if (!r->names[c]) return -1;
+        rget(&in, r->names[c], (size_t)len);
+        r->names[c][len] = '\0';
+    }
+
+    r->rows = rget_u64(&in);
+    uint64_t groups = rget_u64(&in);
+    if (in.failed || groups > size) return -1;
+    r->groups = (size_t)groups;
+    r->group_rows = (uint64_t *)fossil_sys_memory_calloc(r->groups + 1, sizeof(uint64_t));
+    r->info = (fish_col_chunk_info_t *)fossil_sys_memory_calloc(r->groups * r->columns + 1, sizeof(fish_col_chunk_info_t));
+    if (!r->group_rows || !r->info) return -1;
+
+    for (size_t g = 0; g < r->groups; g++) {
+        r->group_rows[g] = rget_u64(&in);
+        uint64_t cols = rget_u64(&in);
+        if (in.failed || cols > r->columns) return -1;
+        /* columns added by later rows are null in earlier groups (zeroed info) */
+        rget(&in, &r->info[g * r->columns], (size_t)cols * sizeof(fish_col_chunk_info_t));
+    }
+    return in.failed ? -1 : 0;
+}
+
+int fish_col_open(fish_col_reader_t *reader, ccstring path) {
+    fossil_sys_memory_zero(reader, sizeof(*reader));
+    uint64_t size = fish_file_size(path);
+    if (fossil_io_file_open(&reader->file, path, "rb") != 0) return -1;
+    if (read_footer(reader, size) != 0) {
+        if (reader->foreign)
+            fossil_io_printf("{red,bold}fish_col: '{normal}%s{red,bold}' was written on a host with another byte order.{normal}\n", path);
+        fish_col_close(reader);
+        return -1;
+    }
+    return 0;
+}
+
+void fish_col_close(fish_col_reader_t *reader) {
+    if (fossil_io_file_is_open(&reader->file)) fossil_io_file_close(&reader->file);
+    for (size_t c = 0; reader->names && c < reader->columns; c++) fossil_sys_memory_free(reader->names[c]);
+    fossil_sys_memory_free(reader->names);
+    fossil_sys_memory_free(reader->group_rows);
+    fossil_sys_memory_free(reader->info);
+    fossil_sys_memory_zero(reader, sizeof(*reader));
+}
+
+const fish_col_chunk_info_t *fish_col_info(const fish_col_reader_t *reader, size_t group, size_t col) {
+    return &reader->info[group * reader->columns + col];
+}
+
+/* Point the chunk's typed views into its raw bytes. */
+static int decode_chunk(fish_col_chunk_t *chunk, const fish_col_chunk_info_t *info) {
+    size_t rows = chunk->rows;
+    size_t at = 0;
+    size_t bytes = (size_t)info->bytes;
+
+    if (info->nulls > 0) {
+        if (bitmap_bytes(rows) > bytes) return -1;
+        chunk->valid = (const uint8_t *)chunk->data;
+        at = bitmap_bytes(rows);
+    }
+
+    switch (chunk->type) {
+    case FISH_COL_INT64:
+    case FISH_COL_F64:
+        if (at + rows * 8 > bytes) return -1;
+        if (chunk->type == FISH_COL_INT64) chunk->i64 = (const int64_t *)(chunk->data + at);
+        else chunk->f64 = (const double *)(chunk->data + at);
+        return 0;
+
+    case FISH_COL_DICT: {
+        uint32_t count;
+        if (at + 4 > bytes) return -1;
+        fossil_sys_memory_copy(&count, chunk->data + at, 4);
+        at += 4;
+        if (at + ((size_t)count + rows) * 4 > bytes) return -1;
+        const uint32_t *lens = (const uint32_t *)(chunk->data + at);
+        chunk->code = lens + count;
+        at += ((size_t)count + rows) * 4;
+        chunk->dict = (fish_slice_t *)fossil_sys_memory_alloc(((size_t)count + 1) * sizeof(fish_slice_t));
+        if (!chunk->dict) return -1;
+        chunk->dict_count = count;
+        for (uint32_t i = 0; i < count; i++) {
+            if (at + lens[i] > bytes) return -1;
+            chunk->dict[i].ptr = chunk->data + at;
+            chunk->dict[i].len = lens[i];
+            at += lens[i];
+        }
+        for (size_t r = 0; r < rows; r++)
+            if (chunk->code[r] >= count && (!chunk->valid || fish_col_present(chunk, r))) return -1;
+        return 0;
+    }
+
+    case FISH_COL_STRING: {
+        if (at + rows * 4 > bytes) return -1;
+        const uint32_t *lens = (const uint32_t *)(chunk->data + at);
+        at += rows * 4;
+        chunk->dict = (fish_slice_t *)fossil_sys_memory_alloc((rows + 1) * sizeof(fish_slice_t));
+        if (!chunk->dict) return -1;
+        chunk->dict_count = rows;
+        for (size_t r = 0; r < rows; r++) {
+            if (at + lens[r] > bytes) return -1;
+            chunk->dict[r].ptr = chunk->data + at;
+            chunk->dict[r].len = lens[r];
+            at += lens[r];
+        }
+        return 0;
+    }
+
+    default:
+        return -1;
+    }
+}
+
+int fish_col_read(fish_col_reader_t *reader, size_t group, size_t col, fish_col_chunk_t *chunk) {
+    const fish_col_chunk_info_t *info = fish_col_info(reader, group, col);
+    col_in_t in = { &reader->file, 0 };
+
+    fossil_sys_memory_zero(chunk, sizeof(*chunk));
+    chunk->rows = (size_t)reader->group_rows[group];
+    chunk->type = (fish_col_type_t)info->type;
+    if (chunk->type == FISH_COL_NULL) return 0;
+
+    chunk->data = (char *)fossil_sys_memory_alloc(info->bytes ? (size_t)info->bytes : 1);
+    if (!chunk->data) return -1;
+    if (fish_fseek64(reader->file.file, (long long)info->offset, SEEK_SET) != 0) in.failed = 1;
+    rget(&in, chunk->data, (size_t)info->bytes);
+    if (in.failed || decode_chunk(chunk, info) != 0) {
+        fish_col_chunk_free(chunk);
+        return -1;
+    }
+    return 0;
+}
+
+void fish_col_chunk_free(fish_col_chunk_t *chunk) {
+    fossil_sys_memory_free(chunk->data);
+    fossil_sys_memory_free(chunk->dict);
+    fossil_sys_memory_zero(chunk, sizeof(*chunk));
+}
+
+int fish_col_present(const fish_col_chunk_t *chunk, size_t row) {
+    if (chunk->type == FISH_COL_NULL) return 0;
+    if (!chunk->valid) return 1;
+    return (chunk->valid[row / 8] >> (row % 8)) & 1;
+}
+
+size_t fish_col_format(const fish_col_chunk_t *chunk, size_t row, char *out, size_t cap) {
+    int n = 0;
+    if (cap == 0) return 0;
+    out[0] = '\0';
+    if (!fish_col_present(chunk, row)) return 0;
+
+    switch (chunk->type) {
+    case FISH_COL_INT64:
+        n = snprintf(out, cap, "%lld", (long long)chunk->i64[row]);
+        break;
+    case FISH_COL_F64: {
+        /* shortest of %.15g / %.17g that reads back to the same value */
+        double v = chunk->f64[row];
+        n = snprintf(out, cap, "%.15g", v);
+        if (strtod(out, NULL) != v) n = snprintf(out, cap, "%.17g", v);
+        break;
+    }
+    case FISH_COL_DICT:
+        return fish_slice_copy(chunk->dict[chunk->code[row]], out, cap);
+    case FISH_COL_STRING:
+        return fish_slice_copy(chunk->dict[row], out, cap);
+    default:
+        return 0;
+    }
+    if (n < 0) return 0;
+    return (size_t)n < cap ? (size_t)n : cap - 1;
+}
+
+/* ---------------- text-row view ---------------- */
+
+struct fish_col_rows {
+    fish_col_reader_t reader;
+    fish_col_chunk_t *chunk; /* all columns of the current group */
+    size_t group;            /* next group to load */
+    size_t row;              /* next row inside the loaded group */
+    size_t group_len;        /* rows in the loaded group */
+    int header_done;
+    char *line;
+    size_t line_cap;
+};
+
+static int line_put(fish_col_rows_t *rows, size_t *len, const char *data, size_t n) {
+    if (grow((void **)&rows->line, &rows->line_cap, *len + n + 1, 1) != 0) return -1;
+    fossil_sys_memory_copy(rows->line + *len, data, n);
+    *len += n;
+    return 0;
+}
+
+/* Output line being built, as a fish_csv_put_field() sink */
+typedef struct {
+    fish_col_rows_t *rows;
+    size_t *len;
+} line_sink_t;
+
+static int line_sink_put(void *ctx, const char *data, size_t n) {
+    line_sink_t *sink = (line_sink_t *)ctx;
+    return line_put(sink->rows, sink->len, data, n);
+}
+
+static void rows_release_group(fish_col_rows_t *rows) {
+    for (size_t c = 0; c < rows->reader.columns; c++) fish_col_chunk_free(&rows->chunk[c]);
+    rows->group_len = 0;
+    rows->row = 0;
+}
+
+fish_col_rows_t *fish_col_rows_open(ccstring path) {
+    fish_col_rows_t *rows = (fish_col_rows_t *)fossil_sys_memory_calloc(1, sizeof(fish_col_rows_t));
+    if (!rows) return NULL;
+    if (fish_col_open(&rows->reader, path) != 0) {
+        fossil_sys_memory_free(rows);
+        return NULL;
+    }
+    rows->chunk = (fish_col_chunk_t *)fossil_sys_memory_calloc(rows->reader.columns + 1, sizeof(fish_col_chunk_t));
+    if (!rows->chunk) {
+        fish_col_rows_close(rows);
+        return NULL;
+    }
+    return rows;
+}
+
+int fish_col_rows_next(fish_col_rows_t *rows, fish_slice_t *row) {
+    size_t len = 0;
+    size_t cols = rows->reader.columns;
+    line_sink_t sink = { rows, &len };
+
+    if (!rows->header_done && (rows->reader.flags & FISH_COL_NAMED)) {
+        rows->header_done = 1;
+        for (size_t c = 0; c < cols; c++) {
+            if (c && line_put(rows, &len, ",", 1) != 0) return -1;
+            fish_slice_t name = { rows->reader.names[c], strlen(rows->reader.names[c]) };
+            if (fish_csv_put_field(name, line_sink_put, &sink) != 0) return -1;
+        }
+        if (line_put(rows, &len, "", 0) != 0) return -1;
+        row->ptr = rows->line;
+        row->len = len;
+        return 1;
+    }
+
+    while (rows->row >= rows->group_len) {
+        rows_release_group(rows);
+        if (rows->group >= rows->reader.groups) return 0;
+        for (size_t c = 0; c < cols; c++)
+            if (fish_col_read(&rows->reader, rows->group, c, &rows->chunk[c]) != 0) return -1;
+        rows->group_len = (size_t)rows->reader.group_rows[rows->group];
+        rows->group++;
+    }
+
+    char value[64];
+    for (size_t c = 0; c < cols; c++) {
+        const fish_col_chunk_t *chunk = &rows->chunk[c];
+        if (c && line_put(rows, &len, ",", 1) != 0) return -1;
+        if (chunk->type == FISH_COL_DICT && fish_col_present(chunk, rows->row)) {
+            if (fish_csv_put_field(chunk->dict[chunk->code[rows->row]], line_sink_put, &sink) != 0) return -1;
+        } else if (chunk->type == FISH_COL_STRING && fish_col_present(chunk, rows->row)) {
+            if (fish_csv_put_field(chunk->dict[rows->row], line_sink_put, &sink) != 0) return -1;
+        } else {
+            size_t n = fish_col_format(chunk, rows->row, value, sizeof(value));
+            if (line_put(rows, &len, value, n) != 0) return -1;
+        }
+    }
+    if (line_put(rows, &len, "", 0) != 0) return -1;
+    rows->row++;
+    row->ptr = rows->line;
+    row->len = len;
+    return 1;
+}
+
+int fish_col_rows_rewind(fish_col_rows_t *rows) {
+    rows_release_group(rows);
+    rows->group = 0;
+    rows->header_done = 0;
+    return 0;
+}
+
+void fish_col_rows_close(fish_col_rows_t *rows) {
+    if (!rows) return;
+    if (rows->chunk) rows_release_group(rows);
+    fossil_sys_memory_free(rows->chunk);
+    fish_col_close(&rows->reader);
+    fossil_sys_memory_free(rows->line);
+    fossil_sys_memory_free(rows);
+}
@@ -11,7 +11,26 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
+#include "fossil/code/arena.h"
 #include "fossil/code/commands.h"
+#include "fossil/code/page.h"
+#include "fossil/code/store.h"
+#include "fossil/code/trace.h"
+
+/* unique rather than secret: hashes the name, the time, CPU ticks and a stack address */
+static void make_repo_id(uint8_t id[FOSSIL_DEVICE_ID_SIZE], ccstring name, uint64_t now) {
+    fish_sha256_t sha;
+    uint8_t digest[FISH_SHA256_SIZE];
+    clock_t ticks = clock();
+    const void *where = &sha;
+    fish_sha256_init(&sha);
+    fish_sha256_update(&sha, name, strlen(name));
+    fish_sha256_update(&sha, &now, sizeof(now));
+    fish_sha256_update(&sha, &ticks, sizeof(ticks));
+    fish_sha256_update(&sha, &where, sizeof(where));
+    fish_sha256_final(&sha, digest);
+    fossil_sys_memory_copy(id, digest, FOSSIL_DEVICE_ID_SIZE < FISH_SHA256_SIZE ? FOSSIL_DEVICE_ID_SIZE : FISH_SHA256_SIZE);
+}
 
 /**
  * @brief Create a new Jellyfish AI model (chain) and save it to disk.
@@ -34,14 +53,11 @@ int fish_create(ccstring name) {
 
     // Branch info
     chain.branch_count = 1;
-    cstring branch_name = fossil_io_cstring_create_safe("main", sizeof(chain.default_branch));
     fossil_sys_memory_zero(chain.default_branch, sizeof(chain.default_branch));
-    fossil_sys_memory_copy(chain.default_branch, branch_name, sizeof(chain.default_branch) - 1);
-    fossil_io_cstring_free_safe(&branch_name);
+    fossil_sys_memory_copy(chain.default_branch, "main", sizeof("main"));
 
-    // Repo ID placeholder
-    for (size_t i = 0; i < FOSSIL_DEVICE_ID_SIZE; i++)
-        chain.repo_id[i] = (uint8_t)i;
+    // Repo ID, shared by every model later derived from this one
+    make_repo_id(chain.repo_id, name, now);
 
     // Generate first commit using prototype function
     fossil_ai_jellyfish_block_t *init_block = fossil_ai_jellyfish_add_commit(
@@ -53,23 +69,28 @@ int fish_create(ccstring name) {
         0,
         "Initial commit"
     );
+    int rc = -1;
     if (!init_block) {
         fossil_io_printf("{red,bold}Error:{normal} Failed to create initial commit block.\n");
-        return -1;
-    }
-    fossil_sys_memory_copy(init_block->data, &now, sizeof(now));
-    chain.count = 1;
+    } else {
+        fossil_sys_memory_copy(init_block->data, &now, sizeof(now));
+        chain.count = 1;
 
-    cstring filepath = fossil_io_cstring_format_safe(512, "%s.jfchain", name);
+        cstring filepath = fish_scratch_format("%s.jfchain", name);
 
-    // Save chain using prototype function
-    if (fossil_ai_jellyfish_save(&chain, filepath) != 0) {
-        fossil_io_printf("{red,bold}Error:{normal} Could not save chain to file: %s\n", filepath);
-        fossil_io_cstring_free_safe(&filepath);
-        return -1;
+        // Save chain using prototype function
+        FISH_TRACE_BEGIN(trace);
+        int saved = filepath ? fish_store_save(&chain, filepath, NULL) : -1;
+        FISH_TRACE_END(FISH_STAGE_SAVE, trace, chain.count);
+        if (saved != 0) {
+            fossil_io_printf("{red,bold}Error:{normal} Could not save chain to file: %s.jfchain\n", name);
+        } else {
+            fish_page_write(&chain, name);
+            fossil_io_printf("{green,bold}Created new Jellyfish AI model:{normal} %s\n", name);
+            rc = 0;
+        }
     }
 
-    fossil_io_printf("{green,bold}Created new Jellyfish AI model:{normal} %s\n", name);
-    fossil_io_cstring_free_safe(&filepath);
-    return 0;
+    fossil_ai_jellyfish_cleanup(&chain);
+    return rc;
 }
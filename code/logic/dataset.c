@@ -0,0 +1,1141 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/columnar.h"
+#include "fossil/code/meta.h"
+#include "fossil/code/scan.h"
+#include "fossil/code/schema.h"
+#include "fossil/code/trace.h"
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <io.h>
+#else
+#  include <dirent.h>
+#  include <glob.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+/* ---------------- staged path ---------------- */
+
+/* rows of the staged path, once a writer has committed to it */
+static struct {
+    cstring path;
+    char *data;
+    size_t len;
+    int committed;
+} stage;
+
+static int stage_holds(ccstring path) {
+    return stage.path && fossil_io_cstring_compare(stage.path, path) == 0;
+}
+
+/* ---------------- memory-mapped window ---------------- */
+
+static size_t map_granularity(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwAllocationGranularity;
+#else
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? (size_t)page : 4096;
+#endif
+}
+
+static void map_release(fish_row_reader_t *reader) {
+    if (!reader->map) return;
+    if (reader->staged) {
+        reader->map = NULL;
+        reader->map_len = 0;
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(reader->map);
+#else
+    munmap((void *)reader->map, reader->map_len);
+#endif
+    reader->map = NULL;
+    reader->map_len = 0;
+}
+
+/* Pass the part of [off, off + len) the watcher has not seen yet. */
+static void reader_watch(fish_row_reader_t *reader, uint64_t off, const char *data, size_t len) {
+    if (!reader->watch || off > reader->watched || off + len <= reader->watched) return;
+    size_t seen = (size_t)(reader->watched - off);
+    reader->watch(reader->watch_ctx, data + seen, len - seen);
+    reader->watched = off + len;
+}
+
+/* Map a window that starts at or before @p off. */
+static int map_window(fish_row_reader_t *reader, uint64_t off) {
+    size_t gran = map_granularity();
+    uint64_t base = off - (off % gran);
+    uint64_t remaining = reader->file_size - base;
+    size_t len = remaining < reader->map_window ? (size_t)remaining : reader->map_window;
+
+    FISH_TRACE_BEGIN(trace);
+    map_release(reader);
+#ifdef _WIN32
+    const char *view = (const char *)MapViewOfFile((HANDLE)reader->map_handle, FILE_MAP_READ,
+                                                   (DWORD)(base >> 32), (DWORD)(base & 0xffffffffu), len);
+    if (!view) return -1;
+#else
+    void *view = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fileno(reader->stream.file), (off_t)base);
+    if (view == MAP_FAILED) return -1;
+#  ifdef MADV_SEQUENTIAL
+    madvise(view, len, MADV_SEQUENTIAL);
+#  endif
+#endif
+    reader->map = (const char *)view;
+    reader->map_off = base;
+    reader->map_len = len;
+    FISH_TRACE_END(FISH_STAGE_LOAD, trace, len);
+    reader_watch(reader, base, reader->map, len);
+    return 0;
+}
+
+static int map_open(fish_row_reader_t *reader) {
+#ifdef _WIN32
+    HANDLE file = (HANDLE)_get_osfhandle(_fileno(reader->stream.file));
+    LARGE_INTEGER size;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+        return -1;
+    reader->file_size = (uint64_t)size.QuadPart;
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) return -1;
+    reader->map_handle = mapping;
+#else
+    struct stat st;
+    if (fstat(fileno(reader->stream.file), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+        return -1;
+    reader->file_size = (uint64_t)st.st_size;
+#endif
+    reader->map_window = FISH_ROW_MAP_WINDOW;
+    if (map_window(reader, 0) != 0) {
+#ifdef _WIN32
+        CloseHandle((HANDLE)reader->map_handle);
+        reader->map_handle = NULL;
+#endif
+        return -1;
+    }
+    reader->mapped = 1;
+    return 0;
+}
+
+/* ---------------- CSV records ---------------- */
+
+/*
+ * A quote only opens a quoted field at a field start; elsewhere it is
+ * plain text, as in RFC 4180 readers.
+ */
+size_t fish_csv_record_end(const char *p, size_t len, int *state) {
+    size_t i = 0;
+    while (i < len) {
+        if (*state == FISH_CSV_QUOTED) {
+            const char *q = (const char *)memchr(p + i, '"', len - i);
+            if (!q) return len;
+            i = (size_t)(q - p) + 1;
+            *state = FISH_CSV_QUOTE;
+            continue;
+        }
+        if (*state == FISH_CSV_QUOTE) {
+            if (p[i] == '"') {
+                *state = FISH_CSV_QUOTED;
+                i++;
+                continue;
+            }
+            *state = FISH_CSV_PLAIN;
+        }
+
+        /* records are short: find the line end, then any quote before it */
+        const char *nl = (const char *)memchr(p + i, '\n', len - i);
+        size_t stop = nl ? (size_t)(nl - p) : len;
+        const char *q = (const char *)memchr(p + i, '"', stop - i);
+        if (!q) {
+            if (nl) {
+                *state = FISH_CSV_FIELD;
+                return stop;
+            }
+            *state = p[len - 1] == ',' ? FISH_CSV_FIELD : FISH_CSV_PLAIN;
+            return len;
+        }
+        size_t k = (size_t)(q - p);
+        int opens = k == i ? *state == FISH_CSV_FIELD : p[k - 1] == ',';
+        *state = opens ? FISH_CSV_QUOTED : FISH_CSV_PLAIN;
+        i = k + 1;
+    }
+    return len;
+}
+
+static int map_next(fish_row_reader_t *reader, fish_slice_t *row) {
+    for (;;) {
+        if (reader->cursor >= reader->file_size || reader->cursor >= reader->limit) return 0;
+
+        size_t rel = (size_t)(reader->cursor - reader->map_off);
+        const char *start = reader->map + rel;
+        size_t avail = reader->map_len - rel;
+        const char *nl;
+        size_t len;
+
+        if (reader->csv) {
+            int state = FISH_CSV_FIELD;
+            size_t end = fish_csv_record_end(start, avail, &state);
+            nl = end < avail ? start + end : NULL;
+        } else {
+            nl = (const char *)memchr(start, '\n', avail);
+        }
+
+        if (nl) {
+            len = (size_t)(nl - start);
+            reader->cursor += len + 1;
+        } else if (reader->map_off + reader->map_len >= reader->file_size) {
+            /* last row without trailing newline */
+            len = avail;
+            reader->cursor += len;
+        } else {
+            /* row runs past the window: slide it, growing only if the row alone fills it */
+            if (rel < map_granularity()) reader->map_window *= 2;
+            if (map_window(reader, reader->cursor) != 0) {
+                reader->failed = 1;
+                return 0;
+            }
+            continue;
+        }
+
+        if (len > 0 && start[len - 1] == '\r') len--;
+        row->ptr = start;
+        row->len = len;
+        reader->row_offset = reader->map_off + rel;
+        reader->rows++;
+        return 1;
+    }
+}
+
+/* ---------------- buffered fallback ---------------- */
+
+static int reader_fill(fish_row_reader_t *reader) {
+    reader->chunk_base += reader->chunk_len;
+    reader->chunk_pos = 0;
+    FISH_TRACE_BEGIN(trace);
+    reader->chunk_len = fossil_io_file_read(&reader->stream, reader->chunk, 1, FISH_ROW_CHUNK_SIZE);
+    FISH_TRACE_END(FISH_STAGE_LOAD, trace, reader->chunk_len);
+    reader_watch(reader, reader->chunk_base, reader->chunk, reader->chunk_len);
+    /* a short read is the end of the file unless the stream says otherwise */
+    if (reader->chunk_len < FISH_ROW_CHUNK_SIZE && ferror(reader->stream.file)) reader->failed = 1;
+    if (reader->chunk_len == 0) reader->eof = 1;
+    return reader->chunk_len > 0 && !reader->failed;
+}
+
+static int reader_spill(fish_row_reader_t *reader, size_t used, const char *data, size_t len) {
+    if (used + len + 1 > reader->spill_cap) {
+        size_t cap = reader->spill_cap ? reader->spill_cap : 4096;
+        while (cap < used + len + 1) cap *= 2;
+        char *grown = (char *)fossil_sys_memory_realloc(reader->spill, cap);
+        if (!grown) {
+            reader->failed = 1;
+            return -1;
+        }
+        reader->spill = grown;
+        reader->spill_cap = cap;
+    }
+    fossil_sys_memory_copy(reader->spill + used, data, len);
+    return 0;
+}
+
+static int buffered_next(fish_row_reader_t *reader, fish_slice_t *row) {
+    size_t spilled = 0;
+    int spilling = 0;
+    int state = FISH_CSV_FIELD;
+    uint64_t offset = reader->chunk_base + reader->chunk_pos;
+
+    if (offset >= reader->limit) return 0;
+    for (;;) {
+        if (reader->chunk_pos >= reader->chunk_len) {
+            if (reader->eof || !reader_fill(reader)) {
+                if (!spilling || reader->failed) return 0;
+                /* last row without trailing newline */
+                break;
+            }
+        }
+
+        const char *start = reader->chunk + reader->chunk_pos;
+        size_t avail = reader->chunk_len - reader->chunk_pos;
+        const char *nl;
+        if (reader->csv) {
+            /* the quote state carries over when the record crosses chunks */
+            size_t end = fish_csv_record_end(start, avail, &state);
+            nl = end < avail ? start + end : NULL;
+        } else {
+            nl = (const char *)memchr(start, '\n', avail);
+        }
+
+        if (nl) {
+            size_t len = (size_t)(nl - start);
+            reader->chunk_pos += len + 1;
+            if (!spilling) {
+                if (len > 0 && start[len - 1] == '\r') len--;
+                row->ptr = start;
+                row->len = len;
+                reader->row_offset = reader->chunk_base + (uint64_t)(start - reader->chunk);
+                reader->rows++;
+                return 1;
+            }
+            if (reader_spill(reader, spilled, start, len) != 0) return 0;
+            spilled += len;
+            break;
+        }
+
+        /* row continues in the next chunk: keep what we have so far */
+        if (!spilling) offset = reader->chunk_base + reader->chunk_pos;
+        if (reader_spill(reader, spilled, start, avail) != 0) return 0;
+        spilled += avail;
+        spilling = 1;
+        reader->chunk_pos = reader->chunk_len;
+    }
+
+    if (spilled > 0 && reader->spill[spilled - 1] == '\r') spilled--;
+    reader->spill[spilled] = '\0';
+    row->ptr = reader->spill;
+    row->len = spilled;
+    reader->row_offset = offset;
+    reader->rows++;
+    return 1;
+}
+
+/* ---------------- reader ---------------- */
+
+/* Position at the first row starting at or after reader->begin. */
+static int reader_seek_begin(fish_row_reader_t *reader) {
+    uint64_t from = reader->begin > 0 ? reader->begin - 1 : 0;
+    fish_slice_t partial;
+
+    reader->rows = 0;
+    if (reader->staged) {
+        reader->cursor = from;
+    } else if (reader->mapped) {
+        reader->cursor = from;
+        if (from < reader->map_off || from >= reader->map_off + reader->map_len) {
+            if (map_window(reader, from) != 0) return -1;
+        }
+    } else {
+        reader->chunk_len = 0;
+        reader->chunk_pos = 0;
+        reader->chunk_base = from;
+        reader->eof = 0;
+        if (fish_fseek64(reader->stream.file, (long long)from, SEEK_SET) != 0) return -1;
+    }
+
+    /* the byte before begin ends the row owned by the previous range */
+    if (reader->begin > 0) fish_row_reader_next(reader, &partial);
+    reader->rows = 0;
+    return reader->failed ? -1 : 0;
+}
+
+int fish_row_reader_open(fish_row_reader_t *reader, ccstring path) {
+    fossil_sys_memory_zero(reader, sizeof(*reader));
+    reader->limit = UINT64_MAX;
+
+    if (stage_holds(path) && stage.committed) {
+        /* the staged rows stand in for a mapping of the whole file */
+        reader->staged = 1;
+        reader->mapped = 1;
+        reader->map = stage.data;
+        reader->map_len = stage.len;
+        reader->map_window = stage.len;
+        reader->file_size = stage.len;
+        return 0;
+    }
+    if (fossil_io_file_open(&reader->stream, path, "rb") != 0 || !fossil_io_file_is_open(&reader->stream))
+        return -1;
+
+    if (fish_col_probe(path)) {
+        fossil_io_file_close(&reader->stream);
+        reader->columnar = fish_col_rows_open(path);
+        return reader->columnar ? 0 : -1;
+    }
+
+    if (map_open(reader) == 0) return 0;
+
+    reader->chunk = (char *)fossil_sys_memory_alloc(FISH_ROW_CHUNK_SIZE);
+    if (!reader->chunk) {
+        fossil_io_file_close(&reader->stream);
+        return -1;
+    }
+    return 0;
+}
+
+int fish_row_reader_open_csv(fish_row_reader_t *reader, ccstring path) {
+    if (fish_row_reader_open(reader, path) != 0) return -1;
+    reader->csv = 1;
+    return 0;
+}
+
+static int reader_range(fish_row_reader_t *reader, uint64_t begin, uint64_t end) {
+    if (reader->columnar) {
+        /* no byte ranges to split on; callers fall back to one reader */
+        fish_row_reader_close(reader);
+        return -1;
+    }
+    reader->begin = begin;
+    reader->limit = end;
+    if (begin > 0 && reader_seek_begin(reader) != 0) {
+        fish_row_reader_close(reader);
+        return -1;
+    }
+    return 0;
+}
+
+int fish_row_reader_open_range(fish_row_reader_t *reader, ccstring path,
+                               uint64_t begin, uint64_t end) {
+    if (fish_row_reader_open(reader, path) != 0) return -1;
+    return reader_range(reader, begin, end);
+}
+
+int fish_row_reader_open_range_csv(fish_row_reader_t *reader, ccstring path,
+                                   uint64_t begin, uint64_t end) {
+    /* the newline before a record start ends a record, so the seek skips just it */
+    if (fish_row_reader_open_csv(reader, path) != 0) return -1;
+    return reader_range(reader, begin, end);
+}
+
+int fish_row_reader_next(fish_row_reader_t *reader, fish_slice_t *row) {
+    if (reader->failed) return 0;
+    if (reader->columnar) {
+        int got = fish_col_rows_next(reader->columnar, row);
+        if (got < 0) reader->failed = 1;
+        if (got <= 0) return 0;
+        reader->row_offset = reader->rows++;
+        return 1;
+    }
+    return reader->mapped ? map_next(reader, row) : buffered_next(reader, row);
+}
+
+void fish_row_reader_watch(fish_row_reader_t *reader, fish_row_watch_fn watch, void *ctx) {
+    reader->watch = watch;
+    reader->watch_ctx = ctx;
+    reader->watched = 0;
+    /* the first window is already mapped */
+    if (reader->mapped && reader->map) reader_watch(reader, reader->map_off, reader->map, reader->map_len);
+}
+
+int fish_row_reader_rewind(fish_row_reader_t *reader) {
+    if (reader->failed) return -1;
+    if (reader->columnar) {
+        reader->rows = 0;
+        return fish_col_rows_rewind(reader->columnar);
+    }
+    if (reader->begin > 0) return reader_seek_begin(reader);
+    reader->rows = 0;
+    if (reader->mapped) {
+        reader->cursor = 0;
+        return reader->map_off == 0 ? 0 : map_window(reader, 0);
+    }
+    reader->chunk_len = 0;
+    reader->chunk_pos = 0;
+    reader->chunk_base = 0;
+    reader->eof = 0;
+    return fossil_io_file_rewind(&reader->stream);
+}
+
+void fish_row_reader_close(fish_row_reader_t *reader) {
+    fish_col_rows_close(reader->columnar);
+    reader->columnar = NULL;
+    map_release(reader);
+#ifdef _WIN32
+    if (reader->map_handle) CloseHandle((HANDLE)reader->map_handle);
+#endif
+    reader->map_handle = NULL;
+    reader->mapped = 0;
+    if (fossil_io_file_is_open(&reader->stream))
+        fossil_io_file_close(&reader->stream);
+    fossil_sys_memory_free(reader->chunk);
+    fossil_sys_memory_free(reader->spill);
+    reader->chunk = NULL;
+    reader->spill = NULL;
+}
+
+/* ---------------- writer ---------------- */
+
+static int writer_mem_put(fish_row_writer_t *writer, const char *data, size_t len, size_t first_cap) {
+    if (len == 0) return 0;
+    size_t need = writer->mem_len + len;
+    if (need > writer->mem_cap) {
+        size_t cap = writer->mem_cap ? writer->mem_cap : first_cap;
+        while (cap < need) cap *= 2;
+        char *grown = (char *)fossil_sys_memory_realloc(writer->mem, cap);
+        if (!grown) {
+            writer->failed = 1;
+            return -1;
+        }
+        writer->mem = grown;
+        writer->mem_cap = cap;
+    }
+    fossil_sys_memory_copy(writer->mem + writer->mem_len, data, len);
+    writer->mem_len = need;
+    return 0;
+}
+
+static int writer_flush(fish_row_writer_t *writer) {
+    if (writer->chunk_len == 0) return 0;
+    if (writer->staged) {
+        int rc = writer_mem_put(writer, writer->chunk, writer->chunk_len, FISH_ROW_CHUNK_SIZE);
+        writer->chunk_len = 0;
+        return rc;
+    }
+    if (fossil_io_file_write(&writer->stream, writer->chunk, 1, writer->chunk_len) != writer->chunk_len)
+        writer->failed = 1;
+    writer->chunk_len = 0;
+    return writer->failed ? -1 : 0;
+}
+
+static int writer_sync(fish_row_writer_t *writer) {
+    if (fflush(writer->stream.file) != 0) return -1;
+#ifdef _WIN32
+    return _commit(_fileno(writer->stream.file));
+#else
+    return fsync(fileno(writer->stream.file));
+#endif
+}
+
+int fish_file_replace(ccstring from, ccstring to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+#else
+    return rename(from, to);
+#endif
+}
+
+static long process_id(void) {
+#ifdef _WIN32
+    return (long)GetCurrentProcessId();
+#else
+    return (long)getpid();
+#endif
+}
+
+static int writer_open(fish_row_writer_t *writer, ccstring path, int columnar) {
+    fossil_sys_memory_zero(writer, sizeof(*writer));
+    writer->columnar = columnar;
+    writer->path = fossil_io_cstring_create(path);
+    /* private to the process, so jobs writing the same target never share a temp file */
+    writer->tmp_path = fossil_io_cstring_format(columnar ? "%s.%ld.text.tmp" : "%s.%ld.tmp", path, process_id());
+    writer->chunk = (char *)fossil_sys_memory_alloc(FISH_ROW_CHUNK_SIZE);
+
+    if (!writer->path || !writer->tmp_path || !writer->chunk ||
+        fossil_io_file_open(&writer->stream, writer->tmp_path, "wb") != 0) {
+        fossil_io_cstring_free(writer->path);
+        fossil_io_cstring_free(writer->tmp_path);
+        fossil_sys_memory_free(writer->chunk);
+        fossil_sys_memory_zero(writer, sizeof(*writer));
+        return -1;
+    }
+    return 0;
+}
+
+static int writer_open_staged(fish_row_writer_t *writer) {
+    fossil_sys_memory_zero(writer, sizeof(*writer));
+    writer->staged = 1;
+    writer->chunk = (char *)fossil_sys_memory_alloc(FISH_ROW_CHUNK_SIZE);
+    return writer->chunk ? 0 : -1;
+}
+
+int fish_row_writer_open(fish_row_writer_t *writer, ccstring path) {
+    if (stage_holds(path)) return writer_open_staged(writer);
+    size_t len = strlen(path);
+    int columnar = (len > 5 && strcmp(path + len - 5, ".fcol") == 0) || fish_col_probe(path);
+    return writer_open(writer, path, columnar);
+}
+
+int fish_row_writer_open_raw(fish_row_writer_t *writer, ccstring path) {
+    if (stage_holds(path)) return writer_open_staged(writer);
+    return writer_open(writer, path, 0);
+}
+
+int fish_row_writer_open_mem(fish_row_writer_t *writer) {
+    fossil_sys_memory_zero(writer, sizeof(*writer));
+    writer->memory = 1;
+    return 0;
+}
+
+int fish_row_writer_drain(fish_row_writer_t *dst, fish_row_writer_t *src) {
+    if (src->failed) return -1;
+    if (src->mem_len > 0 && fish_row_writer_put(dst, src->mem, src->mem_len) != 0) return -1;
+    dst->rows += src->rows;
+    src->mem_len = 0;
+    src->rows = 0;
+    return 0;
+}
+
+int fish_row_writer_put(fish_row_writer_t *writer, const char *data, size_t len) {
+    if (writer->failed) return -1;
+    if (writer->memory) return writer_mem_put(writer, data, len, 4096);
+
+    while (len > 0) {
+        size_t room = FISH_ROW_CHUNK_SIZE - writer->chunk_len;
+        if (room == 0) {
+            if (writer_flush(writer) != 0) return -1;
+            continue;
+        }
+        size_t n = len < room ? len : room;
+        fossil_sys_memory_copy(writer->chunk + writer->chunk_len, data, n);
+        writer->chunk_len += n;
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int fish_csv_put_field(fish_slice_t field, fish_csv_put_fn put, void *ctx) {
+    /* a bare '\r' would read back as part of a CRLF line end */
+    if (fish_scan_find(field.ptr, field.len, ',', '"', '\n') == field.len &&
+        fish_scan_find(field.ptr, field.len, '\r', '\r', '\r') == field.len)
+        return put(ctx, field.ptr, field.len);
+
+    /* quote it, doubling embedded quotes */
+    const char *p = field.ptr;
+    const char *end = field.ptr + field.len;
+    if (put(ctx, "\"", 1) != 0) return -1;
+    for (;;) {
+        const char *q = (const char *)memchr(p, '"', (size_t)(end - p));
+        const char *stop = q ? q + 1 : end;
+        if (put(ctx, p, (size_t)(stop - p)) != 0) return -1;
+        if (!q) break;
+        if (put(ctx, "\"", 1) != 0) return -1;
+        p = stop;
+    }
+    return put(ctx, "\"", 1);
+}
+
+static int writer_put_bytes(void *ctx, const char *data, size_t len) {
+    return fish_row_writer_put((fish_row_writer_t *)ctx, data, len);
+}
+
+int fish_row_writer_put_field(fish_row_writer_t *writer, fish_slice_t field) {
+    return fish_csv_put_field(field, writer_put_bytes, writer);
+}
+
+int fish_row_writer_put_varint(fish_row_writer_t *writer, uint64_t value) {
+    char buf[FISH_VARINT_MAX];
+    size_t n = 0;
+    do {
+        uint8_t byte = (uint8_t)(value & 0x7f);
+        value >>= 7;
+        buf[n++] = (char)(value ? byte | 0x80 : byte);
+    } while (value);
+    return fish_row_writer_put(writer, buf, n);
+}
+
+size_t fish_varint_read(const char *data, size_t len, uint64_t *value) {
+    uint64_t out = 0;
+    for (size_t i = 0; i < len && i < FISH_VARINT_MAX; i++) {
+        uint8_t byte = (uint8_t)data[i];
+        out |= (uint64_t)(byte & 0x7f) << (7 * i);
+        if (!(byte & 0x80)) {
+            *value = out;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+int fish_row_writer_end_row(fish_row_writer_t *writer) {
+    if (fish_row_writer_put(writer, "\n", 1) != 0) return -1;
+    writer->rows++;
+    return 0;
+}
+
+int fish_row_writer_write(fish_row_writer_t *writer, const char *data, size_t len) {
+    if (fish_row_writer_put(writer, data, len) != 0) return -1;
+    return fish_row_writer_end_row(writer);
+}
+
+static int writer_commit_staged(fish_row_writer_t *writer) {
+    writer_flush(writer);
+    fossil_sys_memory_free(writer->chunk);
+    writer->chunk = NULL;
+    if (writer->failed) {
+        fossil_sys_memory_free(writer->mem);
+        writer->mem = NULL;
+        return -1;
+    }
+    fossil_sys_memory_free(stage.data);
+    stage.data = writer->mem;
+    stage.len = writer->mem_len;
+    stage.committed = 1;
+    writer->mem = NULL;
+    return 0;
+}
+
+static int writer_commit(fish_row_writer_t *writer) {
+    if (writer->staged) return writer_commit_staged(writer);
+    writer_flush(writer);
+    if (FISH_ROW_SYNC && !writer->failed && writer_sync(writer) != 0) writer->failed = 1;
+    fossil_io_file_close(&writer->stream);
+
+    int rc = -1;
+    if (!writer->failed && writer->columnar) {
+        rc = fish_col_convert(writer->tmp_path, writer->path);
+        fossil_io_file_delete(writer->tmp_path);
+    } else if (!writer->failed) {
+        rc = fish_file_replace(writer->tmp_path, writer->path);
+    }
+    if (rc != 0) fossil_io_file_delete(writer->tmp_path);
+    else fish_meta_invalidate(writer->path); /* cached facts describe the old content */
+
+    fossil_io_cstring_free(writer->path);
+    fossil_io_cstring_free(writer->tmp_path);
+    fossil_sys_memory_free(writer->chunk);
+    writer->path = NULL;
+    writer->tmp_path = NULL;
+    writer->chunk = NULL;
+    return rc;
+}
+
+int fish_row_writer_commit(fish_row_writer_t *writer) {
+    FISH_TRACE_BEGIN(trace);
+    int rc = writer_commit(writer);
+    FISH_TRACE_END(FISH_STAGE_SAVE, trace, writer->rows);
+    return rc;
+}
+
+void fish_row_writer_abort(fish_row_writer_t *writer) {
+    if (writer->staged || writer->memory) {
+        fossil_sys_memory_free(writer->chunk);
+        fossil_sys_memory_free(writer->mem);
+        writer->chunk = NULL;
+        writer->mem = NULL;
+        return;
+    }
+    if (fossil_io_file_is_open(&writer->stream))
+        fossil_io_file_close(&writer->stream);
+    if (writer->tmp_path) fossil_io_file_delete(writer->tmp_path);
+
+    fossil_io_cstring_free(writer->path);
+    fossil_io_cstring_free(writer->tmp_path);
+    fossil_sys_memory_free(writer->chunk);
+    writer->path = NULL;
+    writer->tmp_path = NULL;
+    writer->chunk = NULL;
+}
+
+/* ---------------- staging ---------------- */
+
+int fish_row_stage_begin(ccstring path) {
+    if (stage.path) return -1;
+    stage.path = fossil_io_cstring_create(path);
+    stage.data = NULL;
+    stage.len = 0;
+    stage.committed = 0;
+    return stage.path ? 0 : -1;
+}
+
+int fish_row_stage_end(int flush) {
+    if (!stage.path) return 0;
+
+    cstring path = stage.path;
+    stage.path = NULL; /* the write below must reach the file */
+    int rc = 0;
+    if (flush && stage.committed) {
+        fish_row_writer_t writer;
+        if (fish_row_writer_open(&writer, path) != 0) {
+            rc = -1;
+        } else if (stage.len > 0 && fish_row_writer_put(&writer, stage.data, stage.len) != 0) {
+            fish_row_writer_abort(&writer);
+            rc = -1;
+        } else {
+            rc = fish_row_writer_commit(&writer);
+        }
+    }
+
+    fossil_io_cstring_free(path);
+    fossil_sys_memory_free(stage.data);
+    stage.data = NULL;
+    stage.len = 0;
+    stage.committed = 0;
+    return rc;
+}
+
+const char *fish_row_stage_data(ccstring path, size_t *len) {
+    if (!stage_holds(path) || !stage.committed) return NULL;
+    if (len) *len = stage.len;
+    return stage.data ? stage.data : "";
+}
+
+/* ---------------- files ---------------- */
+
+uint64_t fish_file_size(ccstring path) {
+    if (stage_holds(path) && stage.committed) return stage.len;
+#ifdef _WIN32
+    struct __stat64 st;
+    if (_stat64(path, &st) != 0) return 0;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+#endif
+    return (uint64_t)st.st_size;
+}
+
+int64_t fish_file_mtime(ccstring path) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attr)) return 0;
+    uint64_t ticks = ((uint64_t)attr.ftLastWriteTime.dwHighDateTime << 32) | attr.ftLastWriteTime.dwLowDateTime;
+    return (int64_t)(ticks * 100); /* 100 ns units since 1601 */
+#else
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+#  if defined(__APPLE__)
+    return (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#  else
+    return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#  endif
+#endif
+}
+
+int fish_file_is_directory(ccstring path) {
+    struct stat st;
+    return stat(path, &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
+static int file_is_regular(ccstring path) {
+    struct stat st;
+    return stat(path, &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG;
+}
+
+/* ---------------- path lists ---------------- */
+
+int fish_path_list_add(fish_path_list_t *list, cstring path) {
+    if (!path) return -1;
+    if (list->count == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 64;
+        cstring *grown = (cstring *)fossil_sys_memory_realloc(list->path, cap * sizeof(cstring));
+        if (!grown) {
+            fossil_io_cstring_free(path);
+            return -1;
+        }
+        list->path = grown;
+        list->cap = cap;
+    }
+    list->path[list->count++] = path;
+    return 0;
+}
+
+static int path_compare(const void *a, const void *b) {
+    return strcmp(*(const cstring *)a, *(const cstring *)b);
+}
+
+static void path_list_sort(fish_path_list_t *list, size_t from) {
+    if (list->count - from > 1)
+        qsort(list->path + from, list->count - from, sizeof(cstring), path_compare);
+}
+
+int fish_path_list_dir(fish_path_list_t *list, ccstring dir) {
+    size_t from = list->count;
+    int rc = 0;
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    cstring pattern = fossil_io_cstring_format("%s\\*", dir);
+    HANDLE h = pattern ? FindFirstFileA(pattern, &entry) : INVALID_HANDLE_VALUE;
+    fossil_io_cstring_free(pattern);
+    if (h == INVALID_HANDLE_VALUE) return -1;
+    do {
+        if (entry.cFileName[0] == '.' || (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) continue;
+        rc = fish_path_list_add(list, fossil_io_cstring_format("%s\\%s", dir, entry.cFileName));
+    } while (rc == 0 && FindNextFileA(h, &entry));
+    FindClose(h);
+#else
+    DIR *d = opendir(dir);
+    struct dirent *entry;
+    if (!d) return -1;
+    while (rc == 0 && (entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        cstring path = fossil_io_cstring_format("%s/%s", dir, entry->d_name);
+        if (path && !file_is_regular(path)) {
+            fossil_io_cstring_free(path);
+            continue;
+        }
+        rc = fish_path_list_add(list, path);
+    }
+    closedir(d);
+#endif
+    if (rc == 0) path_list_sort(list, from);
+    return rc;
+}
+
+int fish_path_list_glob(fish_path_list_t *list, ccstring pattern) {
+    size_t from = list->count;
+    int rc = 0;
+#ifdef _WIN32
+    /* FindFirstFile matches the last component only; keep the directory part */
+    ccstring slash = strrchr(pattern, '\\');
+    ccstring fwd = strrchr(pattern, '/');
+    if (!slash || (fwd && fwd > slash)) slash = fwd;
+    int dir_len = slash ? (int)(slash - pattern + 1) : 0;
+
+    WIN32_FIND_DATAA entry;
+    HANDLE h = FindFirstFileA(pattern, &entry);
+    if (h == INVALID_HANDLE_VALUE) return 0;
+    do {
+        if (entry.cFileName[0] == '.' || (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) continue;
+        rc = fish_path_list_add(list, fossil_io_cstring_format("%.*s%s", dir_len, pattern, entry.cFileName));
+    } while (rc == 0 && FindNextFileA(h, &entry));
+    FindClose(h);
+#else
+    glob_t matches;
+    int found = glob(pattern, 0, NULL, &matches);
+    if (found == GLOB_NOMATCH) return 0;
+    if (found != 0) return -1;
+    for (size_t i = 0; rc == 0 && i < matches.gl_pathc; i++) {
+        if (!file_is_regular(matches.gl_pathv[i])) continue;
+        rc = fish_path_list_add(list, fossil_io_cstring_create(matches.gl_pathv[i]));
+    }
+    globfree(&matches);
+#endif
+    if (rc == 0) path_list_sort(list, from);
+    return rc;
+}
+
+void fish_path_list_free(fish_path_list_t *list) {
+    for (size_t i = 0; i < list->count; ++i) fossil_io_cstring_free(list->path[i]);
+    fossil_sys_memory_free(list->path);
+    list->path = NULL;
+    list->count = 0;
+    list->cap = 0;
+}
+
+/* ---------------- fields and slices ---------------- */
+
+/* Room for the unescaped fields of a row, reserved once so earlier slices stay valid. */
+static int fields_scratch(fish_row_fields_t *fields, size_t row_len) {
+    if (fields->scratch_len > 0 || row_len <= fields->scratch_cap) return 0;
+    size_t cap = fields->scratch_cap ? fields->scratch_cap : 256;
+    while (cap < row_len) cap *= 2;
+    char *grown = (char *)fossil_sys_memory_realloc(fields->scratch, cap);
+    if (!grown) return -1;
+    fields->scratch = grown;
+    fields->scratch_cap = cap;
+    return 0;
+}
+
+/*
+ * Quoted field whose body starts at @p p. Returns the comma (or end) that
+ * follows it, or NULL on allocation failure. Text between the closing
+ * quote and the comma is kept, and an unterminated field runs to the end
+ * of the row.
+ */
+static const char *split_quoted(fish_row_fields_t *fields, const char *p, const char *end,
+                                size_t row_len, fish_slice_t *out) {
+    const char *q = (const char *)memchr(p, '"', (size_t)(end - p));
+    if (!q || q + 1 == end || q[1] == ',') {
+        /* the common case: no escapes, the slice points into the row */
+        const char *stop = q ? q : end;
+        out->ptr = p;
+        out->len = (size_t)(stop - p);
+        return q ? q + 1 : end;
+    }
+
+    if (fields_scratch(fields, row_len) != 0) return NULL;
+    char *dst = fields->scratch + fields->scratch_len;
+    size_t n = 0;
+    while (q && q + 1 < end && q[1] == '"') {
+        fossil_sys_memory_copy(dst + n, p, (size_t)(q + 1 - p));
+        n += (size_t)(q + 1 - p);
+        p = q + 2;
+        q = (const char *)memchr(p, '"', (size_t)(end - p));
+    }
+    const char *stop = q ? q : end;
+    fossil_sys_memory_copy(dst + n, p, (size_t)(stop - p));
+    n += (size_t)(stop - p);
+
+    if (q) {
+        p = q + 1;
+        const char *comma = (const char *)memchr(p, ',', (size_t)(end - p));
+        stop = comma ? comma : end;
+        fossil_sys_memory_copy(dst + n, p, (size_t)(stop - p));
+        n += (size_t)(stop - p);
+    }
+    out->ptr = dst;
+    out->len = n;
+    fields->scratch_len += n;
+    return stop;
+}
+
+size_t fish_row_fields_split(fish_row_fields_t *fields, fish_slice_t row) {
+    const char *p = row.ptr;
+    const char *end = row.ptr + row.len;
+
+    fields->count = 0;
+    fields->scratch_len = 0;
+    for (;;) {
+        if (fields->count == fields->cap) {
+            size_t cap = fields->cap ? fields->cap * 2 : 16;
+            fish_slice_t *grown = (fish_slice_t *)fossil_sys_memory_realloc(fields->field, cap * sizeof(fish_slice_t));
+            if (!grown) return 0;
+            fields->field = grown;
+            fields->cap = cap;
+        }
+        fish_slice_t *field = &fields->field[fields->count++];
+        const char *stop;
+        if (p < end && *p == '"') {
+            stop = split_quoted(fields, p + 1, end, row.len, field);
+            if (!stop) return 0;
+        } else {
+            const char *comma = (const char *)memchr(p, ',', (size_t)(end - p));
+            stop = comma ? comma : end;
+            field->ptr = p;
+            field->len = (size_t)(stop - p);
+        }
+        if (stop >= end) break;
+        p = stop + 1;
+    }
+    return fields->count;
+}
+
+void fish_row_fields_free(fish_row_fields_t *fields) {
+    fossil_sys_memory_free(fields->field);
+    fossil_sys_memory_free(fields->scratch);
+    fossil_sys_memory_zero(fields, sizeof(*fields));
+}
+
+int fish_row_reader_header(fish_row_reader_t *reader, fish_row_fields_t *fields, fish_slice_t *header) {
+    fish_slice_t first;
+    header->ptr = "";
+    header->len = 0;
+    if (!fish_row_reader_next(reader, &first)) return -1;
+    if (fish_row_fields_split(fields, first) > 0 && fish_schema_is_header(fields)) {
+        *header = first;
+        return 1;
+    }
+    return fish_row_reader_rewind(reader) == 0 ? 0 : -1;
+}
+
+static int column_is(fish_slice_t name, const char *const *options) {
+    name = fish_slice_trim(name);
+    for (; *options; ++options) {
+        size_t len = strlen(*options);
+        if (name.len == len && fossil_io_cstring_iequals_safe(name.ptr, *options, len)) return 1;
+    }
+    return 0;
+}
+
+int fish_pair_cols_pick(fish_pair_cols_t *cols, fish_row_fields_t *fields, fish_slice_t first) {
+    static const char *const inputs[] = { "input", "prompt", "question", NULL };
+    static const char *const outputs[] = { "output", "response", "answer", "label", NULL };
+    size_t n = fish_row_fields_split(fields, first);
+
+    cols->input = 0;
+    cols->output = 1;
+    if (n == 0 || !fish_schema_is_header(fields)) return 0;
+    for (size_t c = 0; c < n; c++) {
+        if (column_is(fields->field[c], inputs)) cols->input = c;
+        else if (column_is(fields->field[c], outputs)) cols->output = c;
+    }
+    return 1;
+}
+
+int fish_pair_split(const fish_pair_cols_t *cols, fish_row_fields_t *fields, fish_slice_t row,
+                    fish_slice_t *input, fish_slice_t *output) {
+    size_t n = fish_row_fields_split(fields, row);
+    if (n == 0) return 0;
+    if (n == 1) {
+        *input = *output = fish_slice_trim(fields->field[0]);
+    } else {
+        *input = fish_slice_trim(fields->field[cols->input < n ? cols->input : 0]);
+        *output = fish_slice_trim(fields->field[cols->output < n ? cols->output : n - 1]);
+    }
+    return input->len > 0 && output->len > 0;
+}
+
+fish_slice_t fish_slice_trim(fish_slice_t s) {
+    while (s.len > 0 && isspace((unsigned char)s.ptr[0])) { s.ptr++; s.len--; }
+    while (s.len > 0 && isspace((unsigned char)s.ptr[s.len - 1])) s.len--;
+    return s;
+}
+
+int fish_slice_to_double(fish_slice_t s, double *out) {
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char *p = s.ptr;
+    const char *end = s.ptr + s.len;
+
+    while (p < end && isspace((unsigned char)*p)) p++;
+
+    int neg = 0;
+    if (p < end && (*p == '+' || *p == '-')) neg = (*p++ == '-');
+
+    uint64_t mant = 0;
+    int digits = 0, scale = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+        if (mant < 1000000000000000000ull) mant = mant * 10 + (uint64_t)(*p - '0');
+        else scale++;
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+            if (mant < 1000000000000000000ull) { mant = mant * 10 + (uint64_t)(*p - '0'); scale--; }
+        }
+    }
+    if (digits == 0) return 0;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int eneg = 0, exp = 0;
+        if (q < end && (*q == '+' || *q == '-')) eneg = (*q++ == '-');
+        if (q < end && *q >= '0' && *q <= '9') {
+            for (; q < end && *q >= '0' && *q <= '9'; q++)
+                if (exp < 100000) exp = exp * 10 + (*q - '0');
+            scale += eneg ? -exp : exp;
+        }
+    }
+
+    double v = (double)mant;
+    if (scale != 0) {
+        if (scale > 0 && scale <= 22) v *= pow10[scale];
+        else if (scale < 0 && scale >= -22) v /= pow10[-scale];
+        else v *= pow(10.0, (double)scale);
+    }
+    if (out) *out = neg ? -v : v;
+    return 1;
+}
+
+int fish_slice_is_number(fish_slice_t s) {
+    size_t i = 0, int_digits = 0, frac_digits = 0;
+    if (i < s.len && (s.ptr[i] == '+' || s.ptr[i] == '-')) i++;
+    size_t int_start = i;
+    while (i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9') { i++; int_digits++; }
+    if (int_digits > 1 && s.ptr[int_start] == '0') return 0;
+    if (i < s.len && s.ptr[i] == '.') {
+        i++;
+        while (i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9') { i++; frac_digits++; }
+    }
+    if (int_digits + frac_digits == 0) return 0;
+    if (i < s.len && (s.ptr[i] == 'e' || s.ptr[i] == 'E')) {
+        size_t exp_digits = 0;
+        i++;
+        if (i < s.len && (s.ptr[i] == '+' || s.ptr[i] == '-')) i++;
+        while (i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9') { i++; exp_digits++; }
+        if (exp_digits == 0) return 0;
+    }
+    return i == s.len;
+}
+
+size_t fish_slice_copy(fish_slice_t s, char *out, size_t out_sz) {
+    if (out_sz == 0) return 0;
+    size_t n = s.len < out_sz - 1 ? s.len : out_sz - 1;
+    fossil_sys_memory_copy(out, s.ptr, n);
+    out[n] = '\0';
+    return n;
+}
@@ -0,0 +1,461 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/dedup.h"
+#include "fossil/code/app.h"
+#include "fossil/code/trace.h"
+
+#define DEDUP_SEED 0x66697368ull /* "fish" */
+#define DEDUP_SAMPLE_ROWS 4096
+#define DEDUP_PART_BUFFER (64u << 10)
+
+/* ---------------- helpers ---------------- */
+
+static int grow_buffer(char **buf, size_t *cap, size_t need) {
+    if (need <= *cap) return 0;
+    size_t grown_cap = *cap ? *cap : 4096;
+    while (grown_cap < need) grown_cap *= 2;
+    char *grown = (char *)fossil_sys_memory_realloc(*buf, grown_cap);
+    if (!grown) return -1;
+    *buf = grown;
+    *cap = grown_cap;
+    return 0;
+}
+
+/* next row as the dedup key: trimmed and non-empty when dropping nulls */
+static int next_key(fish_row_reader_t *reader, int drop_null, fish_slice_t *key, uint64_t *offset) {
+    fish_slice_t row;
+    while (fish_row_reader_next(reader, &row)) {
+        fish_slice_t k = drop_null ? fish_slice_trim(row) : row;
+        if (drop_null && k.len == 0) continue;
+        *key = k;
+        *offset = reader->row_offset + (uint64_t)(k.ptr - row.ptr);
+        return 1;
+    }
+    return 0;
+}
+
+static size_t estimate_rows(fish_row_reader_t *reader, uint64_t file_size) {
+    fish_slice_t row;
+    uint64_t bytes = 0;
+    size_t rows = 0;
+    while (rows < DEDUP_SAMPLE_ROWS && fish_row_reader_next(reader, &row)) {
+        bytes += row.len + 1;
+        rows++;
+    }
+    fish_row_reader_rewind(reader);
+    if (rows == 0 || bytes == 0) return 0;
+    return (size_t)(file_size * rows / bytes) + 1;
+}
+
+/* ---------------- in-memory mode ---------------- */
+
+/* Earlier rows are re-read from the mapping when still in the window, else from disk. */
+typedef struct {
+    fish_row_reader_t *reader;
+    ccstring path;
+    fossil_io_file_t side;
+    int side_open;
+    char *buf;
+    size_t cap;
+} file_resolver_t;
+
+static int resolve_file(void *ctx, uint64_t ref, size_t len, fish_slice_t *out) {
+    file_resolver_t *r = (file_resolver_t *)ctx;
+    fish_row_reader_t *reader = r->reader;
+
+    if (reader->mapped && ref >= reader->map_off && ref + len <= reader->map_off + reader->map_len) {
+        out->ptr = reader->map + (size_t)(ref - reader->map_off);
+        out->len = len;
+        return 0;
+    }
+
+    if (!r->side_open) {
+        if (fossil_io_file_open(&r->side, r->path, "rb") != 0) return -1;
+        r->side_open = 1;
+    }
+    if (grow_buffer(&r->buf, &r->cap, len + 1) != 0) return -1;
+    if (fish_fseek64(r->side.file, (long long)ref, SEEK_SET) != 0) return -1;
+    if (len > 0 && fossil_io_file_read(&r->side, r->buf, 1, len) != len) return -1;
+    out->ptr = r->buf;
+    out->len = len;
+    return 0;
+}
+
+static int dedup_memory(fish_row_reader_t *reader, ccstring path, int drop_null, size_t expected,
+                        fish_row_emit_fn emit, void *ctx) {
+    file_resolver_t resolver = {0};
+    fish_hashset_t set;
+    fish_slice_t key;
+    uint64_t offset;
+    int rc = 0;
+
+    resolver.reader = reader;
+    resolver.path = path;
+    if (fish_hashset_init(&set, expected, resolve_file, &resolver) != 0) return -1;
+
+    /* the scope covers reading too: rows are hashed as they stream in */
+    FISH_TRACE_BEGIN(trace);
+    while (next_key(reader, drop_null, &key, &offset)) {
+        int fresh = fish_hashset_insert(&set, fish_hash64(key.ptr, key.len, DEDUP_SEED), key, offset);
+        if (fresh < 0 || (fresh && emit(ctx, key) != 0)) { rc = -1; break; }
+    }
+    FISH_TRACE_END(FISH_STAGE_HASH, trace, reader->rows);
+
+    fish_hashset_free(&set);
+    if (resolver.side_open) fossil_io_file_close(&resolver.side);
+    fossil_sys_memory_free(resolver.buf);
+    return rc;
+}
+
+/* ---------------- external mode ---------------- */
+
+/* partition record: uint64 seq, uint64 len, len bytes (host order, never leaves this host) */
+#define PART_HEADER 16
+
+/* Levels a partition may be split again before it is finished regardless of the budget */
+#define DEDUP_MAX_DEPTH 8
+
+typedef struct {
+    fossil_io_file_t stream;
+    uint64_t seq;
+    char *row;
+    size_t len;
+    size_t cap;
+} part_cursor_t;
+
+/* receives each record of a merge, in sequence order */
+typedef int (*part_emit_fn)(void *ctx, uint64_t seq, fish_slice_t row);
+
+/* Partition files of @p base: "<base>.dedup.<k>", survivors in "<base>.dedup.<k>.out". */
+static cstring part_path(ccstring base, size_t k, int survivors) {
+    return fossil_io_cstring_format(survivors ? "%s.dedup.%zu.out" : "%s.dedup.%zu", base, k);
+}
+
+static int write_record(fossil_io_file_t *out, uint64_t seq, fish_slice_t row) {
+    uint64_t len = (uint64_t)row.len;
+    if (fossil_io_file_write(out, &seq, sizeof(seq), 1) != 1) return -1;
+    if (fossil_io_file_write(out, &len, sizeof(len), 1) != 1) return -1;
+    if (row.len > 0 && fossil_io_file_write(out, row.ptr, 1, row.len) != row.len) return -1;
+    return 0;
+}
+
+static int read_record(part_cursor_t *cur) {
+    uint64_t len;
+    if (fossil_io_file_read(&cur->stream, &cur->seq, sizeof(cur->seq), 1) != 1) return 0;
+    if (fossil_io_file_read(&cur->stream, &len, sizeof(len), 1) != 1) return -1; /* torn partition */
+    if (len >= SIZE_MAX || grow_buffer(&cur->row, &cur->cap, (size_t)len + 1) != 0) return -1;
+    if (len > 0 && fossil_io_file_read(&cur->stream, cur->row, 1, (size_t)len) != len) return -1;
+    cur->len = (size_t)len;
+    return 1;
+}
+
+static void remove_parts(ccstring base, size_t parts) {
+    for (size_t k = 0; k < parts; k++) {
+        for (int survivors = 0; survivors < 2; survivors++) {
+            cstring p = part_path(base, k, survivors);
+            if (p && fossil_io_file_file_exists(p)) fossil_io_file_delete(p);
+            fossil_io_cstring_free(p);
+        }
+    }
+}
+
+/* Open partition writers; a row goes to the top bits of its digest under @p seed. */
+typedef struct {
+    fossil_io_file_t *outs;
+    size_t parts;
+    int bits;
+    uint64_t seed;
+} part_set_t;
+
+static void parts_close(part_set_t *set) {
+    for (size_t k = 0; set->outs && k < set->parts; k++)
+        if (fossil_io_file_is_open(&set->outs[k])) fossil_io_file_close(&set->outs[k]);
+    fossil_sys_memory_free(set->outs);
+    set->outs = NULL;
+}
+
+static int parts_open(part_set_t *set, ccstring base, size_t parts, int bits, uint64_t seed) {
+    set->outs = (fossil_io_file_t *)fossil_sys_memory_calloc(parts, sizeof(fossil_io_file_t));
+    set->parts = parts;
+    set->bits = bits;
+    set->seed = seed;
+    if (!set->outs) return -1;
+    for (size_t k = 0; k < parts; k++) {
+        cstring p = part_path(base, k, 0);
+        int rc = p ? fossil_io_file_open(&set->outs[k], p, "wb") : -1;
+        fossil_io_cstring_free(p);
+        if (rc != 0) {
+            parts_close(set);
+            return -1;
+        }
+        setvbuf(set->outs[k].file, NULL, _IOFBF, DEDUP_PART_BUFFER);
+    }
+    return 0;
+}
+
+static int parts_put(part_set_t *set, uint64_t seq, fish_slice_t row) {
+    uint64_t digest = fish_hash64(row.ptr, row.len, set->seed);
+    return write_record(&set->outs[(size_t)(digest >> (64 - set->bits))], seq, row);
+}
+
+/* phase 1: scatter rows into digest-prefix partitions */
+static int scatter(fish_row_reader_t *reader, ccstring path, int drop_null, size_t parts, int bits) {
+    part_set_t set;
+    fish_slice_t key;
+    uint64_t offset, seq = 0;
+    int rc = parts_open(&set, path, parts, bits, DEDUP_SEED);
+
+    FISH_TRACE_BEGIN(trace);
+    while (rc == 0 && next_key(reader, drop_null, &key, &offset))
+        if (parts_put(&set, seq++, key) != 0) rc = -1;
+    FISH_TRACE_END(FISH_STAGE_HASH, trace, seq);
+    if (reader->failed) rc = -1; /* nothing is emitted from a partial scatter */
+
+    parts_close(&set);
+    return rc;
+}
+
+/* phase 3: k-way merge of partition survivors back into original order */
+static void heap_sift(part_cursor_t *cur, size_t *heap, size_t n, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        if (l < n && cur[heap[l]].seq < cur[heap[m]].seq) m = l;
+        if (r < n && cur[heap[r]].seq < cur[heap[m]].seq) m = r;
+        if (m == i) return;
+        size_t t = heap[i]; heap[i] = heap[m]; heap[m] = t;
+        i = m;
+    }
+}
+
+static int merge_parts(ccstring base, size_t parts, part_emit_fn emit, void *ctx) {
+    part_cursor_t *cur = (part_cursor_t *)fossil_sys_memory_calloc(parts, sizeof(part_cursor_t));
+    size_t *heap = (size_t *)fossil_sys_memory_calloc(parts, sizeof(size_t));
+    size_t n = 0;
+    int rc = 0;
+
+    if (!cur || !heap) rc = -1;
+    for (size_t k = 0; rc == 0 && k < parts; k++) {
+        cstring p = part_path(base, k, 1);
+        if (!p || fossil_io_file_open(&cur[k].stream, p, "rb") != 0) {
+            rc = -1;
+        } else {
+            setvbuf(cur[k].stream.file, NULL, _IOFBF, DEDUP_PART_BUFFER);
+            int got = read_record(&cur[k]);
+            if (got < 0) rc = -1;
+            else if (got) heap[n++] = k;
+        }
+        fossil_io_cstring_free(p);
+    }
+    for (size_t i = n / 2; rc == 0 && i-- > 0;) heap_sift(cur, heap, n, i);
+
+    while (rc == 0 && n > 0) {
+        part_cursor_t *top = &cur[heap[0]];
+        if (emit(ctx, top->seq, (fish_slice_t){ top->row, top->len }) != 0) { rc = -1; break; }
+        int got = read_record(top);
+        if (got < 0) { rc = -1; break; }
+        if (!got) heap[0] = heap[--n];
+        heap_sift(cur, heap, n, 0);
+    }
+
+    for (size_t k = 0; cur && k < parts; k++) {
+        if (fossil_io_file_is_open(&cur[k].stream)) fossil_io_file_close(&cur[k].stream);
+        fossil_sys_memory_free(cur[k].row);
+    }
+    fossil_sys_memory_free(cur);
+    fossil_sys_memory_free(heap);
+    return rc;
+}
+
+static int emit_record(void *ctx, uint64_t seq, fish_slice_t row) {
+    return write_record((fossil_io_file_t *)ctx, seq, row);
+}
+
+/* Distinct rows of the partition being deduplicated; set refs are offsets into buf. */
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+} part_kept_t;
+
+static int resolve_kept(void *ctx, uint64_t ref, size_t len, fish_slice_t *out) {
+    out->ptr = ((const part_kept_t *)ctx)->buf + ref;
+    out->len = len;
+    return 0;
+}
+
+static int dedup_part(ccstring base, size_t k, int depth, size_t budget);
+
+/*
+ * Split an oversized partition @p in_path into FISH_DEDUP_MIN_PARTS pieces
+ * with a seed of its own, dedup each piece, and merge their survivors, in
+ * order, into @p out_path. Copies of a row share a digest under any seed,
+ * so they still meet in one piece.
+ */
+static int dedup_split(ccstring in_path, ccstring out_path, int depth, size_t budget) {
+    const size_t parts = FISH_DEDUP_MIN_PARTS;
+    part_set_t set;
+    part_cursor_t cur = {0};
+    fossil_io_file_t out;
+    int got = 0;
+    int rc = fossil_io_file_open(&cur.stream, in_path, "rb");
+
+    if (rc == 0) {
+        setvbuf(cur.stream.file, NULL, _IOFBF, DEDUP_PART_BUFFER);
+        rc = parts_open(&set, in_path, parts, 4, DEDUP_SEED + 0x9e3779b97f4a7c15ull * (uint64_t)(depth + 1));
+        while (rc == 0 && (got = read_record(&cur)) > 0)
+            rc = parts_put(&set, cur.seq, (fish_slice_t){ cur.row, cur.len });
+        if (got < 0) rc = -1;
+        parts_close(&set);
+        fossil_io_file_close(&cur.stream);
+    }
+    fossil_sys_memory_free(cur.row);
+    if (rc == 0) fossil_io_file_delete(in_path);
+
+    for (size_t j = 0; rc == 0 && j < parts; j++)
+        rc = dedup_part(in_path, j, depth + 1, budget);
+    if (rc == 0 && fossil_io_file_open(&out, out_path, "wb") != 0) rc = -1;
+    if (rc == 0) {
+        setvbuf(out.file, NULL, _IOFBF, DEDUP_PART_BUFFER);
+        rc = merge_parts(in_path, parts, emit_record, &out);
+        fossil_io_file_close(&out);
+    }
+    remove_parts(in_path, parts);
+    return rc;
+}
+
+/*
+ * phase 2: exact dedup of one partition, streamed. Only its distinct rows
+ * are held in memory, so a partition swollen by copies of a few rows
+ * costs what those rows do. When the distinct rows and their table
+ * outgrow @p budget, the partition is split again (dedup_split()).
+ */
+static int dedup_part(ccstring base, size_t k, int depth, size_t budget) {
+    cstring in_path = part_path(base, k, 0);
+    cstring out_path = part_path(base, k, 1);
+    part_cursor_t cur = {0};
+    part_kept_t kept = {0};
+    fish_hashset_t set;
+    fossil_io_file_t out;
+    uint64_t records = 0;
+    int rc = -1, over = 0, got = 0;
+
+    if (in_path && out_path && fossil_io_file_open(&cur.stream, in_path, "rb") == 0) {
+        setvbuf(cur.stream.file, NULL, _IOFBF, DEDUP_PART_BUFFER);
+        if (fossil_io_file_open(&out, out_path, "wb") == 0) {
+            setvbuf(out.file, NULL, _IOFBF, DEDUP_PART_BUFFER);
+            rc = fish_hashset_init(&set, 0, resolve_kept, &kept);
+
+            FISH_TRACE_BEGIN(trace);
+            while (rc == 0 && !over && (got = read_record(&cur)) > 0) {
+                fish_slice_t row = { cur.row, cur.len };
+                uint64_t digest = fish_hash64(row.ptr, row.len, DEDUP_SEED);
+                int seen = fish_hashset_lookup(&set, digest, row, NULL);
+                records++;
+                if (seen != 0) {
+                    if (seen < 0) rc = -1;
+                    continue;
+                }
+                if (grow_buffer(&kept.buf, &kept.cap, kept.len + row.len + 1) != 0 ||
+                    fish_hashset_insert(&set, digest, row, kept.len) < 0 ||
+                    write_record(&out, cur.seq, row) != 0) {
+                    rc = -1;
+                    break;
+                }
+                fossil_sys_memory_copy(kept.buf + kept.len, row.ptr, row.len);
+                kept.len += row.len;
+                /* past the depth limit the partition is finished whatever it costs */
+                over = depth < DEDUP_MAX_DEPTH &&
+                       kept.len + set.count * fish_hashset_bytes_per_key() > budget;
+            }
+            if (got < 0) rc = -1;
+            FISH_TRACE_END(FISH_STAGE_HASH, trace, records);
+
+            fish_hashset_free(&set);
+            fossil_io_file_close(&out);
+        }
+        fossil_io_file_close(&cur.stream);
+    }
+    fossil_sys_memory_free(kept.buf);
+    fossil_sys_memory_free(cur.row);
+
+    if (rc == 0 && over) rc = dedup_split(in_path, out_path, depth, budget);
+    if (in_path && fossil_io_file_file_exists(in_path)) fossil_io_file_delete(in_path);
+    fossil_io_cstring_free(in_path);
+    fossil_io_cstring_free(out_path);
+    return rc;
+}
+
+typedef struct {
+    fish_row_emit_fn emit;
+    void *ctx;
+} emit_rows_t;
+
+static int emit_row(void *ctx, uint64_t seq, fish_slice_t row) {
+    const emit_rows_t *rows = (const emit_rows_t *)ctx;
+    (void)seq;
+    return rows->emit(rows->ctx, row);
+}
+
+static int dedup_external(fish_row_reader_t *reader, ccstring path, int drop_null,
+                          uint64_t file_size, size_t expected, size_t budget,
+                          fish_row_emit_fn emit, void *ctx) {
+    /* each partition should hold its rows plus its share of the table */
+    uint64_t need = file_size + (uint64_t)expected * fish_hashset_bytes_per_key();
+    size_t parts = FISH_DEDUP_MIN_PARTS;
+    int bits = 4;
+    while (parts < FISH_DEDUP_MAX_PARTS && need / parts > budget) {
+        parts *= 2;
+        bits++;
+    }
+
+    if (FOSSIL_IO_VERBOSE)
+        fossil_io_printf("{blue}dedup: external mode, %zu partitions{normal}\n", parts);
+
+    emit_rows_t rows = { emit, ctx };
+    int rc = scatter(reader, path, drop_null, parts, bits);
+    for (size_t k = 0; rc == 0 && k < parts; k++)
+        rc = dedup_part(path, k, 0, budget);
+    if (rc == 0)
+        rc = merge_parts(path, parts, emit_row, &rows);
+
+    remove_parts(path, parts);
+    return rc;
+}
+
+/* ---------------- entry point ---------------- */
+
+int fish_dedup_run(ccstring path, int drop_null, fish_dedup_mode_t mode, size_t budget,
+                   fish_row_emit_fn emit, void *ctx) {
+    fish_row_reader_t reader;
+    if (fish_row_reader_open_csv(&reader, path) != 0) return -1;
+
+    uint64_t file_size = fish_file_size(path);
+    size_t expected = estimate_rows(&reader, file_size);
+    if (budget == 0) budget = FISH_DEDUP_MEM_BUDGET;
+
+    if (mode == FISH_DEDUP_AUTO) {
+        uint64_t table = (uint64_t)expected * fish_hashset_bytes_per_key();
+        mode = table > budget ? FISH_DEDUP_EXTERNAL : FISH_DEDUP_MEMORY;
+    }
+    /* the in-memory table resolves keys by file offset, which columnar rows lack */
+    if (reader.columnar) mode = FISH_DEDUP_EXTERNAL;
+
+    int rc = mode == FISH_DEDUP_EXTERNAL
+        ? dedup_external(&reader, path, drop_null, file_size, expected, budget, emit, ctx)
+        : dedup_memory(&reader, path, drop_null, expected, emit, ctx);
+    if (reader.failed) rc = -1;
+
+    fish_row_reader_close(&reader);
+    return rc;
+}
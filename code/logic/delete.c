@@ -11,17 +11,42 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
+#include "fossil/code/arena.h"
+#include "fossil/code/cache.h"
 #include "fossil/code/commands.h"
+#include "fossil/code/index.h"
+#include "fossil/code/page.h"
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
+/* Overwrite a file with zeros through one pooled scratch buffer */
+static void overwrite_zero(ccstring path) {
+    fossil_io_file_t file_stream;
+    if (fossil_io_file_open(&file_stream, path, "rb+") != 0) return;
+    int32_t size = fossil_io_file_get_size(&file_stream);
+    fossil_io_file_rewind(&file_stream);
+
+    fossil_sys_memory_t zero_buf = fish_scratch_alloc(FISH_SCRATCH_POOL_MAX);
+    if (zero_buf) {
+        fossil_sys_memory_secure_zero(zero_buf, FISH_SCRATCH_POOL_MAX);
+        for (int32_t left = size; left > 0; ) {
+            size_t n = left < FISH_SCRATCH_POOL_MAX ? (size_t)left : FISH_SCRATCH_POOL_MAX;
+            if (fossil_io_file_write(&file_stream, zero_buf, 1, n) != n) break;
+            left -= (int32_t)n;
+        }
+        fish_scratch_free(zero_buf);
+    }
+    fossil_io_file_close(&file_stream);
+}
+
 /**
  * @brief Delete a model.
  *
  * A Jellyfish AI model is represented by "<model_name>.jfchain".
- * This function loads the chain, securely overwrites the file, and removes it after confirmation.
+ * This function securely overwrites the file and removes it after confirmation,
+ * together with its ".jfpage", ".jfidx" and ".jfcache" sidecars.
  */
 int fish_delete_model(ccstring model_name, int force)
 {
@@ -30,12 +55,12 @@ int fish_delete_model(ccstring model_name, int force)
         return -1;
     }
 
-    cstring path = fossil_io_cstring_format("%s.jfchain", model_name);
+    cstring path = fish_scratch_format("%s.jfchain", model_name);
+    if (!path) return -1;
 
     // Check file existence first
     if (!fossil_io_file_file_exists(path)) {
         fossil_io_printf("{red}fish_delete_model: model not found: %s{normal}\n", path);
-        fossil_io_cstring_free(path);
         return -1;
     }
 
@@ -47,40 +72,28 @@ int fish_delete_model(ccstring model_name, int force)
         char answer = getchar();
         if (answer != 'y' && answer != 'Y') {
             fossil_io_printf("{green}Deletion cancelled.{normal}\n");
-            fossil_io_cstring_free(path);
             return 1;
         }
     }
 
-    // Load the chain for possible cleanup before deletion
-    fossil_ai_jellyfish_chain_t chain;
-    if (fossil_ai_jellyfish_load(&chain, path) == 0) {
-        fossil_ai_jellyfish_cleanup(&chain);
-    }
-
-    // Securely overwrite the file using fossil_sys_memory_secure_zero
-    fossil_io_file_t file_stream;
-    if (fossil_io_file_open(&file_stream, path, "rb+") == 0) {
-        int32_t size = fossil_io_file_get_size(&file_stream);
-        fossil_io_file_rewind(&file_stream);
-
-        fossil_sys_memory_t zero_buf = fossil_sys_memory_alloc(size);
-        fossil_sys_memory_secure_zero(zero_buf, size);
-        fossil_io_file_write(&file_stream, zero_buf, 1, size);
-        fossil_sys_memory_free(zero_buf);
-
-        fossil_io_file_close(&file_stream);
-    }
+    // Securely overwrite the file before removing it
+    overwrite_zero(path);
 
     // Now remove it
     if (fossil_io_file_delete(path) != 0) {
         fossil_io_printf("{red}fish_delete_model: failed to delete file: %s{normal}\n", path);
-        fossil_io_cstring_free(path);
         return -1;
     }
 
+    // Sidecars are derived from the chain; a leftover one would be stale
+    ccstring sidecars[] = { FISH_PAGE_SUFFIX, FISH_INDEX_SUFFIX, FISH_CACHE_SUFFIX };
+    for (size_t i = 0; i < sizeof(sidecars) / sizeof(sidecars[0]); i++) {
+        cstring side = fish_scratch_format("%s%s", model_name, sidecars[i]);
+        if (side && fossil_io_file_file_exists(side)) fossil_io_file_delete(side);
+        fish_scratch_free(side);
+    }
+
     fossil_io_printf("{green,bold}Model '%s' has been deleted.{normal}\n", model_name);
-    fossil_io_cstring_free(path);
     return 0;
 }
 
@@ -98,12 +111,12 @@ int fish_delete_dataset(ccstring dataset_name, int force)
     }
 
     /* Construct dataset path */
-    cstring path = fossil_io_cstring_format("datasets/%s", dataset_name);
+    cstring path = fish_scratch_format("datasets/%s", dataset_name);
+    if (!path) return -1;
 
     /* Check if file exists */
     if (!fossil_io_file_file_exists(path)) {
         fossil_io_printf("{red}fish_delete_dataset: dataset '{bold}%s{normal}{red}' not found.{normal}\n", dataset_name);
-        fossil_io_cstring_free(path);
         return -1;
     }
 
@@ -115,39 +128,24 @@ int fish_delete_dataset(ccstring dataset_name, int force)
         char response[8] = {0};
         if (!fgets(response, sizeof(response), stdin)) {
             fossil_io_printf("{green}fish_delete_dataset: cancelled.{normal}\n");
-            fossil_io_cstring_free(path);
             return -1;
         }
 
         if (response[0] != 'y' && response[0] != 'Y') {
             fossil_io_printf("{green}fish_delete_dataset: cancelled.{normal}\n");
-            fossil_io_cstring_free(path);
             return -1;
         }
     }
 
     /* Securely overwrite the dataset file before deletion */
-    fossil_io_file_t file_stream;
-    if (fossil_io_file_open(&file_stream, path, "rb+") == 0) {
-        int32_t size = fossil_io_file_get_size(&file_stream);
-        fossil_io_file_rewind(&file_stream);
-
-        fossil_sys_memory_t zero_buf = fossil_sys_memory_alloc(size);
-        fossil_sys_memory_secure_zero(zero_buf, size);
-        fossil_io_file_write(&file_stream, zero_buf, 1, size);
-        fossil_sys_memory_free(zero_buf);
-
-        fossil_io_file_close(&file_stream);
-    }
+    overwrite_zero(path);
 
     /* Delete file */
     if (fossil_io_file_delete(path) != 0) {
         fossil_io_printf("{red}fish_delete_dataset: failed to remove '{bold}%s{normal}{red}'.{normal}\n", path);
-        fossil_io_cstring_free(path);
         return -1;
     }
 
     fossil_io_printf("{green,bold}fish_delete_dataset: removed '{bold}%s{normal}{green}'.{normal}\n", path);
-    fossil_io_cstring_free(path);
     return 0;
 }
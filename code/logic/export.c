@@ -11,13 +11,82 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
-#include "fossil/code/commands.h"
+#include "fossil/code/columnar.h"
+#include "fossil/code/learn.h"
+#include "fossil/code/trace.h"
+#include "fossil/code/workspace.h"
+
+/* NUL-terminated copy of a row in a reusable buffer, for C-string APIs */
+static char *row_cstr(fish_slice_t row, char **buf, size_t *cap) {
+    if (row.len + 1 > *cap) {
+        size_t grown_cap = *cap ? *cap : 4096;
+        while (grown_cap < row.len + 1) grown_cap *= 2;
+        char *grown = (char *)fossil_sys_memory_realloc(*buf, grown_cap);
+        if (!grown) return NULL;
+        *buf = grown;
+        *cap = grown_cap;
+    }
+    fish_slice_copy(row, *buf, *cap);
+    return *buf;
+}
+
+/* fish_pair_next_fn over dataset lines: each line is its own input and output */
+static int jelly_next_pair(void *ctx, char *input, size_t input_cap, char *output, size_t output_cap) {
+    fish_slice_t row;
+    if (!fish_row_reader_next((fish_row_reader_t *)ctx, &row)) return 0;
+    fish_slice_copy(row, input, input_cap);
+    fish_slice_copy(row, output, output_cap);
+    return 1;
+}
+
+typedef enum { EXPORT_CSV, EXPORT_JSON, EXPORT_FSON, EXPORT_JELLY } export_format_t;
+
+/* one ["<escaped row>"] element; a row that cannot be escaped is written empty */
+static int put_json_row(fish_row_writer_t *out, ccstring escaped) {
+    if (fish_row_writer_put(out, "  [\"", 4) != 0) return -1;
+    if (escaped && fish_row_writer_put(out, escaped, strlen(escaped)) != 0) return -1;
+    return fish_row_writer_put(out, "\"]", 2);
+}
+
+/*
+ * Every row goes through the writer's chunk, so the target sees one write
+ * per FISH_ROW_CHUNK_SIZE bytes and is only replaced once complete.
+ */
+static int export_rows(fish_row_reader_t *reader, fish_row_writer_t *out, export_format_t kind) {
+    char *buf = NULL;
+    size_t buf_cap = 0;
+    fish_slice_t row;
+    int rc = 0;
+
+    if (kind == EXPORT_JSON) rc = fish_row_writer_put(out, "[\n", 2);
+    int first = 1;
+    while (rc == 0 && fish_row_reader_next(reader, &row)) {
+        if (kind == EXPORT_CSV) {
+            rc = fish_row_writer_write(out, row.ptr, row.len);
+        } else if (kind == EXPORT_FSON) {
+            // binary dump: varint length prefix, then the row bytes
+            rc = fish_row_writer_put_varint(out, row.len);
+            if (rc == 0) rc = fish_row_writer_put(out, row.ptr, row.len);
+        } else {
+            if (!first) rc = fish_row_writer_put(out, ",\n", 2);
+            first = 0;
+            char *line_str = row_cstr(row, &buf, &buf_cap);
+            cstring escaped = line_str ? fossil_io_cstring_escape_json(line_str) : NULL;
+            if (rc == 0) rc = put_json_row(out, escaped);
+            fossil_io_cstring_free(escaped);
+        }
+    }
+    if (reader->failed) rc = -1;
+    if (rc == 0 && kind == EXPORT_JSON) rc = fish_row_writer_put(out, "\n]\n", 3);
+    fossil_sys_memory_free(buf);
+    return rc;
+}
 
 /**
  * @brief Export the dataset to a file.
  * 
  * @param file_path Path to export file.
- * @param format Export format: "csv", "json", "fson", "jelly".
+ * @param format Export format: "csv", "json", "fson", "jelly", "fcol" (columnar).
  * @return int Status code.
  */
 int fish_dataset_export(ccstring file_path, ccstring format)
@@ -27,72 +96,66 @@ int fish_dataset_export(ccstring file_path, ccstring format)
         return -1;
     }
 
-    ccstring src_path = "datasets/current.dataset";
-    fossil_io_file_t src_stream = {0};
-    fossil_io_file_t dst_stream = {0};
+    ccstring src_path = fish_workspace_path();
+    fish_row_reader_t src_stream;
 
-    if (fossil_io_file_open(&src_stream, src_path, "r") != 0) {
-        fossil_io_printf("{red,bold}fish_dataset_export: no active dataset found.{normal}\n", "");
-        return -1;
+    if (fossil_io_cstring_iequals(format, "fcol")) {
+        if (!fossil_io_file_file_exists(src_path)) {
+            fossil_io_printf("{red,bold}fish_dataset_export: no active dataset found.{normal}\n", "");
+            return -1;
+        }
+        if (fish_col_convert(src_path, file_path) != 0) {
+            fossil_io_printf("{red,bold}fish_dataset_export: cannot open output file.{normal}\n", "");
+            return -1;
+        }
+        fossil_io_printf("{green,bold}fish_dataset_export: dataset exported to '%s' as %s.{normal}\n", file_path, format);
+        return 0;
     }
 
-    if (fossil_io_file_open(&dst_stream, file_path, "w+b") != 0) {
-        fossil_io_file_close(&src_stream);
-        fossil_io_printf("{red,bold}fish_dataset_export: cannot open output file.{normal}\n", "");
+    export_format_t kind;
+    if (fossil_io_cstring_iequals(format, "csv")) kind = EXPORT_CSV;
+    else if (fossil_io_cstring_iequals(format, "json")) kind = EXPORT_JSON;
+    else if (fossil_io_cstring_iequals(format, "fson")) kind = EXPORT_FSON;
+    else if (fossil_io_cstring_iequals(format, "jelly")) kind = EXPORT_JELLY;
+    else {
+        fossil_io_printf("{yellow,bold}fish_dataset_export: unsupported format '%s'.{normal}\n", format, "");
         return -1;
     }
 
-    fossil_sys_memory_t buf = fossil_sys_memory_alloc(4096);
-
-    if (fossil_io_cstring_iequals(format, "csv")) {
-        // simple copy for CSV
-        while (fgets((char *)buf, 4096, src_stream.file)) {
-            fossil_io_file_write(&dst_stream, buf, 1, strlen((char *)buf));
-        }
-    }
-    else if (fossil_io_cstring_iequals(format, "json")) {
-        fossil_io_file_write(&dst_stream, "[\n", 1, 2);
-        int first = 1;
-        while (fgets((char *)buf, 4096, src_stream.file)) {
-            if (!first) fossil_io_file_write(&dst_stream, ",\n", 1, 2);
-            first = 0;
-            ((char *)buf)[strcspn((char *)buf, "\r\n")] = 0; // strip newline
-            cstring escaped = fossil_io_cstring_escape_json((char *)buf);
-            if (escaped) {
-                fossil_sys_memory_t line = fossil_sys_memory_alloc(4096);
-                snprintf((char *)line, 4096, "  [\"%s\"]", escaped);
-                fossil_io_file_write(&dst_stream, line, 1, strlen((char *)line));
-                fossil_sys_memory_free(line);
-                fossil_io_cstring_free(escaped);
-            } else {
-                fossil_io_file_write(&dst_stream, "  [\"\"]", 1, 7);
-            }
-        }
-        fossil_io_file_write(&dst_stream, "\n]\n", 1, 3);
+    if (fish_row_reader_open(&src_stream, src_path) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_export: no active dataset found.{normal}\n", "");
+        return -1;
     }
-    else if (fossil_io_cstring_iequals(format, "fson")) {
-        // minimal binary dump: length-prefixed lines
-        while (fgets((char *)buf, 4096, src_stream.file)) {
-            size_t len = strcspn((char *)buf, "\r\n");
-            fossil_io_file_write(&dst_stream, &len, sizeof(size_t), 1);
-            fossil_io_file_write(&dst_stream, buf, 1, len);
+
+    if (kind == EXPORT_JELLY) {
+        // Export using jellyfish chain serialization, learning every line in bulk
+        fossil_ai_jellyfish_chain_t *chain = (fossil_ai_jellyfish_chain_t *)
+            fossil_sys_memory_calloc(1, sizeof(fossil_ai_jellyfish_chain_t));
+        if (!chain) {
+            fish_row_reader_close(&src_stream);
+            fossil_io_printf("{red,bold}fish_dataset_export: out of memory.{normal}\n", "");
+            return -1;
         }
-    }
-    else if (fossil_io_cstring_iequals(format, "jelly")) {
-        // Export using jellyfish chain serialization
-        fossil_ai_jellyfish_chain_t chain;
-        fossil_ai_jellyfish_init(&chain);
-        // Load dataset lines as input/output pairs into chain
-        while (fgets((char *)buf, 4096, src_stream.file)) {
-            ((char *)buf)[strcspn((char *)buf, "\r\n")] = 0; // strip newline
-            // For demo: treat line as both input and output
-            fossil_ai_jellyfish_learn(&chain, (char *)buf, (char *)buf);
+        fossil_ai_jellyfish_init(chain);
+        // For demo: treat each line as both input and output
+        size_t learned = 0, dropped = 0;
+        int full = fish_chain_learn_iter(chain, jelly_next_pair, &src_stream, &learned, &dropped);
+        if (src_stream.failed) {
+            fossil_ai_jellyfish_cleanup(chain);
+            fossil_sys_memory_free(chain);
+            fish_row_reader_close(&src_stream);
+            fossil_io_printf("{red,bold}fish_dataset_export: cannot read dataset.{normal}\n", "");
+            return -1;
         }
-        int rc = fossil_ai_jellyfish_save(&chain, file_path);
-        fossil_ai_jellyfish_cleanup(&chain);
-        fossil_io_file_close(&src_stream);
-        fossil_io_file_close(&dst_stream);
-        fossil_sys_memory_free(buf);
+        if (full > 0)
+            fossil_io_printf("{yellow,bold}fish_dataset_export: chain full after %zu lines; %zu more were skipped.{normal}\n",
+                             learned, dropped);
+        FISH_TRACE_BEGIN(trace);
+        int rc = fossil_ai_jellyfish_save(chain, file_path);
+        FISH_TRACE_END(FISH_STAGE_SAVE, trace, chain->count);
+        fossil_ai_jellyfish_cleanup(chain);
+        fossil_sys_memory_free(chain);
+        fish_row_reader_close(&src_stream);
         if (rc != 0) {
             fossil_io_printf("{red,bold}fish_dataset_export: jellyfish export failed.{normal}\n", "");
             return -1;
@@ -100,17 +163,22 @@ int fish_dataset_export(ccstring file_path, ccstring format)
         fossil_io_printf("{green,bold}fish_dataset_export: dataset exported to '%s' as jellyfish chain.{normal}\n", file_path, "");
         return 0;
     }
-    else {
-        fossil_io_file_close(&src_stream);
-        fossil_io_file_close(&dst_stream);
-        fossil_sys_memory_free(buf);
-        fossil_io_printf("{yellow,bold}fish_dataset_export: unsupported format '%s'.{normal}\n", format, "");
+
+    fish_row_writer_t dst_stream;
+    if (fish_row_writer_open_raw(&dst_stream, file_path) != 0) {
+        fish_row_reader_close(&src_stream);
+        fossil_io_printf("{red,bold}fish_dataset_export: cannot open output file.{normal}\n", "");
         return -1;
     }
 
-    fossil_io_file_close(&src_stream);
-    fossil_io_file_close(&dst_stream);
-    fossil_sys_memory_free(buf);
+    int rc = export_rows(&src_stream, &dst_stream, kind);
+    fish_row_reader_close(&src_stream);
+    if (rc != 0) fish_row_writer_abort(&dst_stream);
+    else rc = fish_row_writer_commit(&dst_stream);
+    if (rc != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_export: cannot write '%s'.{normal}\n", file_path);
+        return -1;
+    }
     fossil_io_printf("{green,bold}fish_dataset_export: dataset exported to '%s' as %s.{normal}\n", file_path, format);
     return 0;
 }
@@ -0,0 +1,168 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_ARENA_H
+#define FOSSIL_APP_ARENA_H
+
+#include "hash.h"
+
+/* Default block size; larger requests get a block of their own */
+#ifndef FISH_ARENA_BLOCK_SIZE
+#define FISH_ARENA_BLOCK_SIZE ((size_t)64 << 10)
+#endif
+
+/* Scratch pools hold size classes 32, 64, ... up to this many bytes */
+#define FISH_SCRATCH_POOL_MAX 4096
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fish_arena_block fish_arena_block_t;
+
+/**
+ * @brief Bump allocator over a chain of blocks.
+ *
+ * Allocations are never freed one by one; the whole arena is released
+ * (or reset for reuse) in one call.
+ */
+typedef struct {
+    fish_arena_block_t *head;   /* block currently allocated from */
+    size_t used;                /* bytes used in head */
+    size_t block_size;
+    size_t total;               /* bytes handed out */
+} fish_arena_t;
+
+/**
+ * @brief Prepare an empty arena; no memory is taken until the first allocation.
+ *
+ * @param block_size Block size, 0 for FISH_ARENA_BLOCK_SIZE.
+ */
+void fish_arena_init(fish_arena_t *arena, size_t block_size);
+
+/**
+ * @brief Allocate @p size bytes aligned for any object type.
+ *
+ * @return void* Memory valid until the arena is reset or freed, NULL on OOM.
+ */
+void *fish_arena_alloc(fish_arena_t *arena, size_t size);
+
+/**
+ * @brief Copy a slice into the arena as a NUL-terminated string.
+ */
+char *fish_arena_strndup(fish_arena_t *arena, fish_slice_t s);
+
+/**
+ * @brief Drop every allocation but keep the first block for reuse.
+ */
+void fish_arena_reset(fish_arena_t *arena);
+
+/**
+ * @brief Release every block.
+ */
+void fish_arena_free(fish_arena_t *arena);
+
+/**
+ * @brief String interning table.
+ *
+ * Each distinct string is copied once into the arena and given a dense
+ * id (0, 1, 2, ...), so callers can index per-string arrays by id.
+ */
+typedef struct {
+    fish_arena_t *arena;
+    fish_hashset_t set;
+    fish_slice_t *str;          /* id -> interned bytes */
+    size_t count;
+    size_t cap;
+} fish_intern_t;
+
+/**
+ * @brief Create a table that copies strings into @p arena.
+ */
+int fish_intern_init(fish_intern_t *table, fish_arena_t *arena, size_t expected);
+
+/**
+ * @brief Intern @p s, returning its id through @p id.
+ *
+ * @return int 1 if newly added, 0 if already present, -1 on error.
+ */
+int fish_intern_add(fish_intern_t *table, fish_slice_t s, uint32_t *id);
+
+/**
+ * @brief Look @p s up without adding it.
+ *
+ * @return int 1 if found, 0 if absent, -1 on error.
+ */
+int fish_intern_find(fish_intern_t *table, fish_slice_t s, uint32_t *id);
+
+/**
+ * @brief Forget every string; pair with fish_arena_reset() on the arena.
+ */
+void fish_intern_reset(fish_intern_t *table);
+
+/**
+ * @brief Release the table (the strings live on in the arena).
+ */
+void fish_intern_free(fish_intern_t *table);
+
+/**
+ * @brief Allocation counters of the command scratch.
+ */
+typedef struct {
+    size_t allocs;          /* fish_scratch_alloc() calls */
+    size_t reused;          /* of those, served from a pool free list */
+    size_t live;            /* bytes currently handed out */
+    size_t peak;            /* high-water mark of live */
+    size_t reserved;        /* bytes taken from the system */
+} fish_scratch_stats_t;
+
+/**
+ * @brief Allocate from the command scratch.
+ *
+ * The scratch is a process-wide arena that lives for one command: the
+ * CLI releases it after each dispatch, so callers may skip
+ * fish_scratch_free() on error paths. Requests up to
+ * FISH_SCRATCH_POOL_MAX bytes come from size-class pools and are
+ * recycled when freed. Not thread-safe; keep it off worker threads.
+ *
+ * @return void* Memory aligned for any object type, NULL on OOM.
+ */
+void *fish_scratch_alloc(size_t size);
+
+/**
+ * @brief printf into a NUL-terminated scratch string.
+ */
+cstring fish_scratch_format(ccstring fmt, ...);
+
+/**
+ * @brief Return a scratch allocation to its pool early (NULL is ignored).
+ */
+void fish_scratch_free(void *ptr);
+
+/**
+ * @brief Current counters.
+ */
+void fish_scratch_stats(fish_scratch_stats_t *stats);
+
+/**
+ * @brief Drop every scratch allocation and reset the counters.
+ *
+ * @param stats Receives the counters as they were, NULL to skip.
+ */
+void fish_scratch_release(fish_scratch_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_ARENA_H */
@@ -0,0 +1,123 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_CACHE_H
+#define FOSSIL_APP_CACHE_H
+
+#include "hash.h"
+
+/*
+ * Answer cache.
+ *
+ * Results of fish_model_ask() keyed on (chain fingerprint, normalized
+ * prompt, explain flag). A learned commit changes the fingerprint, so
+ * entries of an older model version simply stop matching and age out of
+ * the LRU. The optional on-disk copy, "<model>.jfcache", is an append-only
+ * log of records:
+ *
+ *   "FISHCAC1"
+ *   record: fingerprint[32] explain found pad[2] confidence(float)
+ *           prompt_len answer_len explain_len (uint32) prompt answer explanation
+ *
+ * in host byte order like the other sidecars. Loading keeps only records
+ * of the current fingerprint and compacts the file once stale ones
+ * dominate.
+ */
+#define FISH_CACHE_SUFFIX ".jfcache"
+#define FISH_CACHE_MAGIC "FISHCAC1"
+
+/* Entries kept in memory */
+#ifndef FISH_CACHE_ENTRIES
+#define FISH_CACHE_ENTRIES 4096
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fish_cache_entry fish_cache_entry_t;
+
+/**
+ * @brief LRU of answers with a hashed index; not thread-safe on its own.
+ */
+typedef struct {
+    fish_cache_entry_t **slot;  /* open addressing, NULL = empty */
+    size_t slot_mask;
+    fish_cache_entry_t *newest;
+    fish_cache_entry_t *oldest;
+    size_t count;
+    size_t capacity;
+} fish_cache_t;
+
+/**
+ * @brief A cached answer; strings point into the entry until it is evicted.
+ */
+typedef struct {
+    int found;
+    float confidence;
+    ccstring answer;
+    ccstring explain;
+} fish_cache_value_t;
+
+/**
+ * @brief Prepare a cache for @p capacity entries (0 for FISH_CACHE_ENTRIES).
+ */
+int fish_cache_init(fish_cache_t *cache, size_t capacity);
+
+void fish_cache_free(fish_cache_t *cache);
+
+/**
+ * @brief Look an answer up and mark it most recently used.
+ *
+ * @p prompt must already be normalized (see fish_chain_index_normalize()).
+ *
+ * @return int 1 on a hit, 0 on a miss.
+ */
+int fish_cache_get(fish_cache_t *cache, const uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE],
+                   fish_slice_t prompt, int explain, fish_cache_value_t *value);
+
+/**
+ * @brief fish_cache_get() hits and misses so far, over every cache in the
+ *        process.
+ *
+ * These are plain atomic counters, kept whether or not tracing is built
+ * in; FISH_COUNTER_CACHE_HIT / FISH_COUNTER_CACHE_MISS only mirror them.
+ */
+uint64_t fish_cache_hits(void);
+uint64_t fish_cache_misses(void);
+
+/**
+ * @brief Insert or replace an answer, evicting the least recently used one when full.
+ */
+int fish_cache_put(fish_cache_t *cache, const uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE],
+                   fish_slice_t prompt, int explain, const fish_cache_value_t *value);
+
+/**
+ * @brief Load the records of "<model_name>.jfcache" that match @p fingerprint.
+ *
+ * @return int Records loaded, 0 when the file is missing, -1 if it is corrupt.
+ */
+int fish_cache_load(fish_cache_t *cache, ccstring model_name,
+                    const uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE]);
+
+/**
+ * @brief Append one answer to "<model_name>.jfcache".
+ */
+int fish_cache_append(ccstring model_name, const uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE],
+                      fish_slice_t prompt, int explain, const fish_cache_value_t *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_CACHE_H */
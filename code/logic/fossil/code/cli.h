@@ -0,0 +1,49 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_CLI_H
+#define FOSSIL_APP_CLI_H
+
+#include "commands.h"
+
+/* Token separating the stages of `fish run` */
+#define FISH_CLI_STAGE_SEP ":"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Run one subcommand.
+ *
+ * @p argv[0] is the command name ("train", "dataset", "run", ...) and the
+ * rest are its flags, parsed as listed in the README command tables.
+ * The command scratch is released when it returns; with --verbose its
+ * allocation counters are printed.
+ *
+ * @param argc Number of arguments, including the command name.
+ * @param argv Command name followed by its arguments.
+ * @return int 0 on success, -1 on a usage error or a failed command.
+ */
+int fish_cli_dispatch(int argc, char **argv);
+
+/**
+ * @brief Print the list of subcommands with their usage lines.
+ */
+void fish_cli_usage(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_CLI_H */
@@ -0,0 +1,190 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_COLUMNAR_H
+#define FOSSIL_APP_COLUMNAR_H
+
+#include "hash.h"
+
+/*
+ * Fish columnar dataset (".fcol")
+ *
+ *   "FISHCOL1" uint64 FISH_COL_BYTE_ORDER
+ *   row group 0: chunk(col 0) chunk(col 1) ...
+ *   row group 1: ...
+ *   footer: flags, column names, per group row count and per chunk
+ *           {type, offset, bytes, nulls, min, max}
+ *   uint64 footer offset, "FISHCOL1"
+ *
+ * Every chunk is typed on its own (int64, f64, dictionary or plain
+ * strings) and starts with a validity bitmap when it has nulls. Values
+ * are stored in host byte order, like the .meta sidecar, so chunks map
+ * straight into typed arrays; a file only opens on hosts with the byte
+ * order that wrote it, which the marker after the magic tells. The
+ * footer's min/max act as zone maps, and reading one column touches
+ * only that column's chunks.
+ */
+#define FISH_COL_MAGIC "FISHCOL1"
+#define FISH_COL_VERSION 3
+
+/* Reads back as itself only on a host with the writer's byte order */
+#define FISH_COL_BYTE_ORDER 0x0102030405060708ull
+
+/* Footer flags */
+#define FISH_COL_NAMED 1u      /* column names came from a header row */
+
+/* Rows buffered per row group by the writer */
+#ifndef FISH_COL_GROUP_ROWS
+#define FISH_COL_GROUP_ROWS 65536
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    FISH_COL_NULL = 0,      /* every value in the chunk is null */
+    FISH_COL_INT64,
+    FISH_COL_F64,
+    FISH_COL_DICT,          /* uint32 codes into a per-chunk dictionary */
+    FISH_COL_STRING         /* plain length-prefixed strings */
+} fish_col_type_t;
+
+/**
+ * @brief Footer entry (zone map) for one column chunk.
+ */
+typedef struct {
+    uint64_t type;
+    uint64_t offset;
+    uint64_t bytes;
+    uint64_t nulls;
+    double min;             /* numeric chunks only */
+    double max;
+} fish_col_chunk_info_t;
+
+/**
+ * @brief One decoded column chunk.
+ *
+ * Strings are slices into @c data and stay valid until the chunk is freed.
+ */
+typedef struct {
+    fish_col_type_t type;
+    size_t rows;
+    const uint8_t *valid;   /* bit i set = row i present; NULL = no nulls */
+    const int64_t *i64;
+    const double *f64;
+    const uint32_t *code;   /* DICT: index into dict */
+    fish_slice_t *dict;     /* DICT entries, or one per row for STRING */
+    size_t dict_count;
+    char *data;             /* raw chunk bytes backing everything above */
+} fish_col_chunk_t;
+
+typedef struct {
+    fossil_io_file_t file;
+    size_t columns;
+    uint64_t rows;
+    size_t groups;
+    uint64_t flags;         /* FISH_COL_* footer flags */
+    cstring *names;
+    uint64_t *group_rows;
+    fish_col_chunk_info_t *info; /* groups x columns */
+    int foreign;            /* written on a host with another byte order */
+} fish_col_reader_t;
+
+/**
+ * @brief Check whether @p path holds a columnar dataset.
+ *
+ * A staged path that a stage has committed to holds text rows.
+ */
+int fish_col_probe(ccstring path);
+
+/**
+ * @brief Open a columnar dataset and load its footer.
+ */
+int fish_col_open(fish_col_reader_t *reader, ccstring path);
+
+void fish_col_close(fish_col_reader_t *reader);
+
+/**
+ * @brief Zone map for a chunk.
+ */
+const fish_col_chunk_info_t *fish_col_info(const fish_col_reader_t *reader, size_t group, size_t col);
+
+/**
+ * @brief Decode one column of one row group (column projection).
+ *
+ * @return int 0 on success, -1 on I/O or format error.
+ */
+int fish_col_read(fish_col_reader_t *reader, size_t group, size_t col, fish_col_chunk_t *chunk);
+
+void fish_col_chunk_free(fish_col_chunk_t *chunk);
+
+/**
+ * @brief Whether row @p row of the chunk is non-null.
+ */
+int fish_col_present(const fish_col_chunk_t *chunk, size_t row);
+
+/**
+ * @brief Render one value as text (empty for null).
+ *
+ * @return size_t Characters written (up to @p cap - 1, NUL-terminated).
+ */
+size_t fish_col_format(const fish_col_chunk_t *chunk, size_t row, char *out, size_t cap);
+
+/**
+ * @brief Convert a text dataset to columnar form.
+ *
+ * A header row (see fish_row_reader_header()) names the columns; without
+ * one the first record is data and every column is named "column<N>", as
+ * are columns added by rows longer than the header. The output replaces
+ * @p out_path atomically.
+ *
+ * @return int 0 on success, -1 on failure.
+ */
+int fish_col_convert(ccstring text_path, ccstring out_path);
+
+/**
+ * @brief fish_col_convert() that also shows the source bytes to @p watch
+ *        as it reads them (see fish_row_reader_watch()).
+ *
+ * @return int Bytes of @p text_path passed to @p watch, -1 on failure.
+ */
+int64_t fish_col_convert_watched(ccstring text_path, ccstring out_path,
+                                 fish_row_watch_fn watch, void *ctx);
+
+/**
+ * @brief Sequential text-row view of a columnar dataset.
+ *
+ * Lets every row-based command read columnar datasets unchanged: the
+ * header row comes first if the source had one, then each row rebuilt as
+ * comma-separated text.
+ */
+typedef struct fish_col_rows fish_col_rows_t;
+
+fish_col_rows_t *fish_col_rows_open(ccstring path);
+
+/**
+ * @brief Fetch the next row, valid until the next call.
+ *
+ * @return int 1 if a row was produced, 0 at the end, -1 if a chunk could
+ *         not be read or the line not built.
+ */
+int fish_col_rows_next(fish_col_rows_t *rows, fish_slice_t *row);
+int fish_col_rows_rewind(fish_col_rows_t *rows);
+void fish_col_rows_close(fish_col_rows_t *rows);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_COLUMNAR_H */
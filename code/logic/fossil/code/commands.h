@@ -53,24 +53,33 @@ int fish_delete_model(const char *model_name, int force);
 
 /**
  * @brief Train an AI model with a dataset.
+ *
+ * Streams the dataset in batches, turns rows into input/output pairs and
+ * learns them into "<model_name>.jfchain". Later epochs reinforce pairs
+ * the chain already knows.
  * 
  * @param model_name Name of the model to train.
- * @param dataset_path Path to the training dataset.
+ * @param dataset_path Path to the training dataset (NULL: active dataset).
  * @param epochs Number of training epochs.
- * @param batch_size Size of each training batch.
- * @param lr Learning rate.
+ * @param batch_size Rows per batch.
+ * @param lr Learning rate: how far a repeated pair's confidence moves towards 1.
+ * @param checkpoint_every Save the chain every N batches (0: only at the end).
  * @return int Status code.
  */
 int fish_train(const char *model_name, const char *dataset_path,
-               int epochs, int batch_size, float lr);
+               int epochs, int batch_size, float lr, int checkpoint_every);
 
 /**
  * @brief Test an AI model using a dataset and metrics.
- * 
+ *
+ * Every row of the dataset is asked of the model on all threads and the
+ * answer compared with the expected output.
+ *
  * @param model_name Name of the model to test.
- * @param dataset_path Path to the test dataset.
- * @param metrics_list Comma-separated list of metrics.
- * @param save_file File to save test results.
+ * @param dataset_path Path to the test dataset (NULL: the active dataset).
+ * @param metrics_list Comma-separated list of accuracy, coverage, confidence,
+ *                     loss and latency (NULL: all of them).
+ * @param save_file File to save the results to as JSON, may be NULL.
  * @return int Status code.
  */
 int fish_test(const char *model_name, const char *dataset_path,
@@ -93,7 +102,7 @@ int fish_inspect(const char *model_name, int show_weights,
  * 
  * @param model_name Name of the model.
  * @param file_path Path to save the model.
- * @param format File format (e.g., "bin", "json").
+ * @param format File format: "bin", or "zchain" for the block-compressed layout.
  * @return int Status code.
  */
 int fish_save(const char *model_name, const char *file_path,
@@ -111,7 +120,8 @@ int fish_load(const char *file_path, int override_session);
 /**
  * @brief Import a dataset from a file.
  * 
- * @param file_path Path to the dataset file.
+ * @param file_path Path to the dataset file, a directory of them or a
+ *        wildcard pattern; several files are imported concurrently.
  * @param format File format (e.g., "csv", "json").
  * @return int Status code.
  */
@@ -155,6 +165,16 @@ int fish_dataset_preprocess(int tokenize, int scale, int encode);
  */
 int fish_dataset_augment(const char *type, int factor);
 
+/**
+ * @brief Augment the dataset reproducibly.
+ *
+ * @param type Type of augmentation.
+ * @param factor Augmentation factor.
+ * @param seed Noise seed (0 = default); equal seeds give equal datasets.
+ * @return int Status code.
+ */
+int fish_dataset_augment_seeded(const char *type, int factor, uint64_t seed);
+
 /**
  * @brief Export the dataset to a file.
  * 
@@ -184,6 +204,39 @@ int fish_dataset_stats(int summary, const char *columns, int plot);
  */
 int fish_dataset_split(float train_frac, float val_frac, float test_frac);
 
+/**
+ * @brief Split the dataset reproducibly in one streaming pass.
+ * 
+ * @param train_frac Fraction for training set.
+ * @param val_frac Fraction for validation set.
+ * @param test_frac Fraction for test set.
+ * @param seed Hash seed (0 = default).
+ * @param key_column Column whose value decides the bucket (NULL = whole row).
+ * @param exact Match the fractions exactly (1) or in expectation (0);
+ *              exact mode takes no @p key_column.
+ * @return int Status code.
+ */
+int fish_dataset_split_seeded(float train_frac, float val_frac, float test_frac,
+                              uint64_t seed, const char *key_column, int exact);
+
+/**
+ * @brief Shard the dataset N ways or into k train/val folds.
+ * 
+ * @param shards Number of shards or folds.
+ * @param kfold Write k-fold train/val pairs (1) or plain shards (0).
+ * @param seed Hash seed (0 = default).
+ * @param key_column Column whose value decides the shard (NULL = whole row).
+ * @return int Status code.
+ */
+int fish_dataset_shard(size_t shards, int kfold, uint64_t seed, const char *key_column);
+
+/**
+ * @brief List the datasets of the workspace with their sizes.
+ * 
+ * @return int Status code.
+ */
+int fish_dataset_list(void);
+
 /**
  * @brief Ask a model a question using a prompt.
  * 
@@ -196,6 +249,21 @@ int fish_dataset_split(float train_frac, float val_frac, float test_frac);
 int fish_ask(const char *model_name, const char *prompt,
              const char *file_path, int explain);
 
+/**
+ * @brief Ask a model every prompt of a file, loading the chain once.
+ *
+ * Each line is a prompt, or a JSON object with a "prompt" (or "input")
+ * string. Answers are written as JSONL in input order.
+ *
+ * @param model_name Name of the model.
+ * @param input_path Prompt file, or "-" for stdin.
+ * @param out_path Output file, or NULL / "-" for stdout.
+ * @param explain Flag to explain answers (1: yes, 0: no).
+ * @return int Status code.
+ */
+int fish_ask_batch(const char *model_name, const char *input_path,
+                   const char *out_path, int explain);
+
 /**
  * @brief Start a chat session with a model.
  * 
@@ -206,6 +274,16 @@ int fish_ask(const char *model_name, const char *prompt,
  */
 int fish_chat(const char *model_name, int keep_context, const char *save_file);
 
+/**
+ * @brief Serve ask/chat requests from resident models until SIGINT/SIGTERM.
+ *
+ * @param endpoint "unix:<path>" for the line protocol, or "[host:]port" for HTTP.
+ * @param models Comma-separated models to load before listening (may be NULL).
+ * @param workers Worker threads, 0 for one per hardware thread.
+ * @return int Status code.
+ */
+int fish_serve(const char *endpoint, const char *models, size_t workers);
+
 /**
  * @brief Summarize a file using a model.
  * 
@@ -216,6 +294,20 @@ int fish_chat(const char *model_name, int keep_context, const char *save_file);
  */
 int fish_summary(const char *file_path, int depth, int time_flag);
 
+/**
+ * @brief Summarize many documents in parallel.
+ *
+ * Writes one JSON line per document (summary sentences plus per-stage
+ * wall-clock timings) and prints overall throughput.
+ *
+ * @param source Directory of documents, or a file listing one path per line.
+ * @param depth Summary depth, as for fish_summary().
+ * @param corpus_idf Compute IDF over the whole corpus instead of per document (1: yes, 0: no).
+ * @param out_path JSONL output file.
+ * @return int Status code.
+ */
+int fish_summary_batch(const char *source, int depth, int corpus_idf, const char *out_path);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,542 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_DATASET_H
+#define FOSSIL_APP_DATASET_H
+
+#include "commands.h"
+
+/* Dataset the commands operate on until another is selected (workspace.h) */
+#define FISH_DATASET_PATH "datasets/current.dataset"
+
+/* Size of the fixed read/write chunk used by the row pipeline */
+#ifndef FISH_ROW_CHUNK_SIZE
+#define FISH_ROW_CHUNK_SIZE (1u << 20)
+#endif
+
+/* 1 = writers fsync the temp file before renaming it over the target */
+#ifndef FISH_ROW_SYNC
+#define FISH_ROW_SYNC 0
+#endif
+
+/* Longest LEB128 encoding of a uint64_t */
+#define FISH_VARINT_MAX 10
+
+/* Bytes of the dataset kept mapped at once by the reader */
+#ifndef FISH_ROW_MAP_WINDOW
+#define FISH_ROW_MAP_WINDOW (64u << 20)
+#endif
+
+/* 64-bit seek on a FILE * */
+#ifdef _WIN32
+#  define fish_fseek64 _fseeki64
+#else
+#  define fish_fseek64 fseeko
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Non-owning view of a byte range (row or field).
+ */
+typedef struct {
+    const char *ptr;
+    size_t len;
+} fish_slice_t;
+
+struct fish_col_rows;
+
+/* Quote state of a CSV scan, carried across buffers */
+enum {
+    FISH_CSV_FIELD = 0,     /* at the start of a field (and of a record) */
+    FISH_CSV_PLAIN,         /* inside an unquoted field */
+    FISH_CSV_QUOTED,        /* inside a quoted field */
+    FISH_CSV_QUOTE          /* quote seen in a quoted field: escape or close */
+};
+
+/**
+ * @brief Find the newline that ends the CSV record running through p[0, len).
+ *
+ * @param state In: quote state at p[0]; out: state at the returned offset
+ *        (FISH_CSV_FIELD after a record end). Pass FISH_CSV_FIELD at the
+ *        start of a record and keep it across buffers of one record.
+ * @return size_t Offset of the newline, or @p len when the record goes on
+ *         past the buffer.
+ */
+size_t fish_csv_record_end(const char *p, size_t len, int *state);
+
+/* Sink for fish_csv_put_field(): append @p len bytes, 0 on success */
+typedef int (*fish_csv_put_fn)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Write @p field as one CSV field through @p put, quoting it when it
+ *        holds a comma, quote, newline or carriage return.
+ *
+ * Embedded quotes are doubled. Every CSV writer goes through this, so
+ * fields always split back the way they were written.
+ *
+ * @return int 0 on success, -1 if @p put failed.
+ */
+int fish_csv_put_field(fish_slice_t field, fish_csv_put_fn put, void *ctx);
+
+/* Observer of the raw bytes a reader loads (see fish_row_reader_watch()) */
+typedef void (*fish_row_watch_fn)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Streaming row reader.
+ *
+ * Regular files are memory-mapped through a sliding FISH_ROW_MAP_WINDOW
+ * window and rows are returned as slices pointing straight into the
+ * mapping, so no bytes are copied. Anything that cannot be mapped is read
+ * in FISH_ROW_CHUNK_SIZE chunks instead. Either way memory use is bounded
+ * by the window/chunk plus the longest row, independent of file size.
+ * Columnar datasets are detected by their magic and read through their
+ * text-row view.
+ */
+typedef struct {
+    fossil_io_file_t stream;
+
+    /* memory-mapped window */
+    int mapped;
+    const char *map;
+    uint64_t map_off;   /* file offset of the window */
+    size_t map_len;
+    size_t map_window;  /* grows only for rows longer than the window */
+    uint64_t file_size;
+    uint64_t cursor;    /* file offset of the next row */
+    void *map_handle;   /* Windows mapping object */
+
+    /* buffered fallback */
+    char *chunk;        /* fixed read buffer */
+    size_t chunk_len;   /* valid bytes in chunk */
+    size_t chunk_pos;   /* read cursor inside chunk */
+    char *spill;        /* row that crosses a chunk boundary */
+    size_t spill_cap;
+    uint64_t chunk_base; /* file offset of chunk[0] */
+
+    size_t rows;        /* rows returned so far */
+    uint64_t row_offset; /* file offset of the last row returned */
+    uint64_t begin;     /* first byte of the range being read */
+    uint64_t limit;     /* rows must start before this offset */
+    int eof;
+    int failed;         /* a read or allocation failed; no more rows until closed */
+
+    struct fish_col_rows *columnar; /* set for columnar datasets */
+    int staged;         /* window is the staged buffer, nothing to unmap */
+    int csv;            /* records may span lines inside quoted fields */
+
+    fish_row_watch_fn watch; /* sees each loaded byte once, in file order */
+    void *watch_ctx;
+    uint64_t watched;   /* bytes passed to watch so far */
+} fish_row_reader_t;
+
+/**
+ * @brief Streaming row writer.
+ *
+ * Rows are buffered in a FISH_ROW_CHUNK_SIZE chunk and written to
+ * "<path>.<pid>.tmp". The target is only replaced on commit, via an atomic
+ * rename, so a failed or interrupted command never leaves a torn dataset.
+ * A columnar target keeps its format: rows are staged as text and
+ * converted on commit.
+ */
+typedef struct {
+    fossil_io_file_t stream;
+    cstring path;
+    cstring tmp_path;
+    char *chunk;
+    size_t chunk_len;
+    size_t rows;        /* rows written so far */
+    int failed;
+    int columnar;       /* convert the staged text on commit */
+
+    /* target is staged: rows collect here and are swapped in on commit */
+    int staged;
+    char *mem;
+    size_t mem_len;
+    size_t mem_cap;
+
+    int memory;         /* no target: rows stay in mem until drained */
+} fish_row_writer_t;
+
+/**
+ * @brief Reusable field splitter.
+ *
+ * Fields are slices into the row itself, nothing is copied, except for
+ * quoted fields holding escaped quotes ("") which are unescaped into
+ * @c scratch. Both buffers grow to the widest row seen and are reused, so
+ * splitting does not allocate in steady state.
+ */
+typedef struct {
+    fish_slice_t *field;
+    size_t count;
+    size_t cap;
+    char *scratch;      /* unescaped quoted fields of the current row */
+    size_t scratch_len;
+    size_t scratch_cap;
+} fish_row_fields_t;
+
+/**
+ * @brief Open a dataset for streaming reads.
+ *
+ * @param reader Reader to initialize.
+ * @param path Dataset path.
+ * @return int 0 on success, -1 if the file cannot be opened.
+ */
+int fish_row_reader_open(fish_row_reader_t *reader, ccstring path);
+
+/**
+ * @brief Open a dataset for streaming reads of CSV records.
+ *
+ * Like fish_row_reader_open(), but a newline inside a quoted field does
+ * not end the row, so every RFC 4180 record comes back whole.
+ */
+int fish_row_reader_open_csv(fish_row_reader_t *reader, ccstring path);
+
+/**
+ * @brief Open a reader over the rows that start inside [begin, end).
+ *
+ * A row that straddles @p begin belongs to the previous range, so splitting
+ * a file at arbitrary byte offsets gives every row to exactly one reader.
+ * Used to fan a dataset out across worker threads.
+ *
+ * @param reader Reader to initialize.
+ * @param path Dataset path.
+ * @param begin First byte of the range.
+ * @param end Byte offset rows must start before.
+ * @return int 0 on success, -1 if the file cannot be opened or is columnar.
+ */
+int fish_row_reader_open_range(fish_row_reader_t *reader, ccstring path,
+                               uint64_t begin, uint64_t end);
+
+/**
+ * @brief Like fish_row_reader_open_range(), but for CSV records.
+ *
+ * A newline inside a quoted field cannot be told from a record end by
+ * looking at the bytes around it, so @p begin must be 0 or the start of
+ * a record, e.g. from fish_meta_record_start().
+ */
+int fish_row_reader_open_range_csv(fish_row_reader_t *reader, ccstring path,
+                                   uint64_t begin, uint64_t end);
+
+/**
+ * @brief Fetch the next row.
+ *
+ * The returned slice is valid until the next call on the same reader.
+ *
+ * @param reader Open reader.
+ * @param row Receives the row contents without "\n" / "\r\n".
+ * @return int 1 if a row was produced, 0 at end of file or on failure.
+ *         A failure sets reader->failed and stays set, so callers check it
+ *         once after their loop, as they check a writer's commit.
+ */
+int fish_row_reader_next(fish_row_reader_t *reader, fish_slice_t *row);
+
+/**
+ * @brief Restart reading from the first row (of the range, if any).
+ *
+ * @return int 0 on success, -1 if the reader has failed or cannot seek.
+ */
+int fish_row_reader_rewind(fish_row_reader_t *reader);
+
+/**
+ * @brief Pass every byte the reader loads to @p watch, once and in file order.
+ *
+ * Lets a caller hash a file during the pass it already makes instead of
+ * reading it a second time; rewinding does not repeat bytes. Call right
+ * after opening a whole file. A columnar source is read through its row
+ * view and never reaches @p watch, so check reader->watched against the
+ * file size before relying on it.
+ */
+void fish_row_reader_watch(fish_row_reader_t *reader, fish_row_watch_fn watch, void *ctx);
+
+/**
+ * @brief Close the reader and release its buffers.
+ */
+void fish_row_reader_close(fish_row_reader_t *reader);
+
+/**
+ * @brief Open a writer that will atomically replace @p path on commit.
+ *
+ * @param writer Writer to initialize.
+ * @param path Final dataset path.
+ * @return int 0 on success, -1 on failure.
+ */
+int fish_row_writer_open(fish_row_writer_t *writer, ccstring path);
+
+/**
+ * @brief Like fish_row_writer_open(), but never converts to columnar form.
+ */
+int fish_row_writer_open_raw(fish_row_writer_t *writer, ccstring path);
+
+/**
+ * @brief Open a writer that keeps rows in memory, e.g. one per worker.
+ *
+ * Move the rows into a real writer with fish_row_writer_drain() and
+ * release the buffer with fish_row_writer_abort().
+ */
+int fish_row_writer_open_mem(fish_row_writer_t *writer);
+
+/**
+ * @brief Append every row held by the memory writer @p src to @p dst and
+ *        empty @p src for reuse.
+ */
+int fish_row_writer_drain(fish_row_writer_t *dst, fish_row_writer_t *src);
+
+/**
+ * @brief Append raw bytes to the row currently being written.
+ */
+int fish_row_writer_put(fish_row_writer_t *writer, const char *data, size_t len);
+
+/**
+ * @brief Append one field to the current row, quoting it when it holds a
+ *        comma, quote, newline or carriage return.
+ */
+int fish_row_writer_put_field(fish_row_writer_t *writer, fish_slice_t field);
+
+/**
+ * @brief Append @p value as an unsigned LEB128 varint, the portable
+ *        length prefix of the binary formats.
+ */
+int fish_row_writer_put_varint(fish_row_writer_t *writer, uint64_t value);
+
+/**
+ * @brief Decode an unsigned LEB128 varint from @p data.
+ *
+ * @return size_t Bytes consumed, 0 if the varint is truncated or longer
+ *         than FISH_VARINT_MAX bytes.
+ */
+size_t fish_varint_read(const char *data, size_t len, uint64_t *value);
+
+/**
+ * @brief Terminate the current row with a newline.
+ */
+int fish_row_writer_end_row(fish_row_writer_t *writer);
+
+/**
+ * @brief Write a complete row (bytes plus newline).
+ */
+int fish_row_writer_write(fish_row_writer_t *writer, const char *data, size_t len);
+
+/**
+ * @brief Flush, close and rename the temp file over the target.
+ *
+ * With FISH_ROW_SYNC the data reaches the disk before the rename, so a
+ * crash leaves either the old or the new content.
+ *
+ * @return int 0 on success, -1 if any write failed (the target is untouched).
+ */
+int fish_row_writer_commit(fish_row_writer_t *writer);
+
+/**
+ * @brief Discard everything written and remove the temp file.
+ */
+void fish_row_writer_abort(fish_row_writer_t *writer);
+
+/**
+ * @brief Keep the rows of @p path in memory until fish_row_stage_end().
+ *
+ * While a path is staged, committing a writer to it swaps the rows into
+ * memory instead of rewriting the file, and readers opened on it see the
+ * last committed rows (the file itself until the first commit). This lets
+ * a pipeline chain rewriting stages without a disk round trip between
+ * them. One path can be staged at a time, and as with files, readers on
+ * the path must be closed before a writer commits to it.
+ *
+ * @return int 0 on success, -1 if another path is already staged.
+ */
+int fish_row_stage_begin(ccstring path);
+
+/**
+ * @brief Stop staging, writing the rows back if @p flush is set.
+ *
+ * Nothing is written when no stage committed. The file is replaced
+ * atomically and keeps its format (a columnar dataset stays columnar).
+ *
+ * @return int 0 on success, -1 if the write failed (the file is untouched).
+ */
+int fish_row_stage_end(int flush);
+
+/**
+ * @brief Rows committed to a staged @p path, for code that reads the
+ *        dataset bytes without a row reader.
+ *
+ * @param len Receives the byte count (may be NULL).
+ * @return const char * The staged bytes, or NULL when @p path is not
+ *         staged or no stage has committed yet (the file is current).
+ */
+const char *fish_row_stage_data(ccstring path, size_t *len);
+
+/**
+ * @brief Size of a file in bytes (0 if it does not exist).
+ *
+ * 64-bit on every platform, unlike fossil_io_file_get_size. A staged
+ * path reports the size of its staged rows.
+ */
+uint64_t fish_file_size(ccstring path);
+
+/**
+ * @brief Last modification time of a file in nanoseconds (0 if it does not exist).
+ *
+ * Only meaningful for comparing against other values from this function;
+ * the epoch and real resolution depend on the platform and file system.
+ */
+int64_t fish_file_mtime(ccstring path);
+
+/**
+ * @brief Atomically move @p from over @p to, replacing it if it exists.
+ *
+ * @return int 0 on success, -1 on failure.
+ */
+int fish_file_replace(ccstring from, ccstring to);
+
+/**
+ * @brief Whether @p path names an existing directory.
+ */
+int fish_file_is_directory(ccstring path);
+
+/**
+ * @brief Growable list of owned path strings.
+ */
+typedef struct {
+    cstring *path;
+    size_t count;
+    size_t cap;
+} fish_path_list_t;
+
+/**
+ * @brief Append @p path, taking ownership (it is freed on failure too).
+ *
+ * @return int 0 on success, -1 if @p path is NULL or on OOM.
+ */
+int fish_path_list_add(fish_path_list_t *list, cstring path);
+
+/**
+ * @brief Append the regular, non-hidden files directly inside @p dir,
+ *        sorted by name.
+ *
+ * @return int 0 on success, -1 if the directory cannot be read.
+ */
+int fish_path_list_dir(fish_path_list_t *list, ccstring dir);
+
+/**
+ * @brief Append the regular files matching the wildcard @p pattern
+ *        ("*", "?", "[...]"), sorted by name. No match is not an error.
+ */
+int fish_path_list_glob(fish_path_list_t *list, ccstring pattern);
+
+void fish_path_list_free(fish_path_list_t *list);
+
+/**
+ * @brief Split a row into comma separated fields.
+ *
+ * Fields follow RFC 4180: a field starting with a quote runs to the
+ * matching closing quote, may hold commas and newlines, and "" inside it
+ * stands for one quote. The quotes themselves are not part of the slice.
+ * Slices stay valid as long as the row does and until the next split.
+ *
+ * @param fields Splitter state (zero-initialize before first use).
+ * @param row Row to split; empty fields are preserved.
+ * @return size_t Number of fields, or 0 on allocation failure.
+ */
+size_t fish_row_fields_split(fish_row_fields_t *fields, fish_slice_t row);
+
+/**
+ * @brief Release splitter buffers.
+ */
+void fish_row_fields_free(fish_row_fields_t *fields);
+
+/**
+ * @brief Read the first record and decide whether it is a header.
+ *
+ * The decision is fish_schema_is_header(), the one train and test use.
+ * A header is left consumed and returned in @p header; otherwise the
+ * reader is rewound so the first record is read again as data, and
+ * @p header is empty.
+ *
+ * @param fields Splitter used to judge the record.
+ * @return int 1 for a header, 0 for a headerless dataset, -1 if the
+ *         dataset is empty or cannot be rewound.
+ */
+int fish_row_reader_header(fish_row_reader_t *reader, fish_row_fields_t *fields, fish_slice_t *header);
+
+/**
+ * @brief Input and output columns of a dataset read as pairs.
+ */
+typedef struct {
+    size_t input;
+    size_t output;
+} fish_pair_cols_t;
+
+/**
+ * @brief Pick the pair columns from the first record.
+ *
+ * When the record is a header (fish_schema_is_header()), columns named
+ * input/prompt/question and output/response/answer/label win; otherwise
+ * the first two columns are used.
+ *
+ * @return int 1 if @p first is a header, 0 if it is the first data record.
+ */
+int fish_pair_cols_pick(fish_pair_cols_t *cols, fish_row_fields_t *fields, fish_slice_t first);
+
+/**
+ * @brief Split @p row and return its trimmed input and output fields.
+ *
+ * A single-column row is its own input and output.
+ *
+ * @return int 1 if both fields are non-empty, 0 otherwise.
+ */
+int fish_pair_split(const fish_pair_cols_t *cols, fish_row_fields_t *fields, fish_slice_t row,
+                    fish_slice_t *input, fish_slice_t *output);
+
+/**
+ * @brief Strip leading and trailing whitespace from a slice.
+ */
+fish_slice_t fish_slice_trim(fish_slice_t s);
+
+/**
+ * @brief Parse a leading number from a slice without copying it.
+ *
+ * Follows strtod's prefix rule: leading whitespace is skipped and the
+ * slice counts as numeric if at least one digit was consumed, so "3.5kg"
+ * yields 3.5. Hex, inf and nan are not recognized.
+ *
+ * @param s Slice to parse.
+ * @param out Receives the value (may be NULL).
+ * @return int 1 if a number was parsed, 0 otherwise.
+ */
+int fish_slice_to_double(fish_slice_t s, double *out);
+
+/**
+ * @brief Whether the whole slice is one decimal or scientific number.
+ *
+ * Nothing may follow the number, so "3.5kg", "12px" and "2024-01-05"
+ * are not numbers, and neither are codes with a leading zero such as
+ * "02134". Whitespace is not skipped; trim first where it is allowed.
+ * A slice that passes reads in full with fish_slice_to_double().
+ */
+int fish_slice_is_number(fish_slice_t s);
+
+/**
+ * @brief Copy a slice into a NUL-terminated buffer, truncating if needed.
+ *
+ * @return size_t Number of bytes copied (excluding the terminator).
+ */
+size_t fish_slice_copy(fish_slice_t s, char *out, size_t out_sz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_DATASET_H */
@@ -0,0 +1,72 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_DEDUP_H
+#define FOSSIL_APP_DEDUP_H
+
+#include "hash.h"
+
+/* Default memory budget: for the in-memory table, then for each external partition */
+#ifndef FISH_DEDUP_MEM_BUDGET
+#define FISH_DEDUP_MEM_BUDGET ((size_t)512 << 20)
+#endif
+
+/* Bounds on the number of on-disk partitions in external mode */
+#define FISH_DEDUP_MIN_PARTS 16
+#define FISH_DEDUP_MAX_PARTS 256
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Callback receiving each surviving row, in original order.
+ *
+ * @return int 0 to continue, non-zero to abort the run.
+ */
+typedef int (*fish_row_emit_fn)(void *ctx, fish_slice_t row);
+
+typedef enum {
+    FISH_DEDUP_AUTO = 0,     /* pick from the row-count estimate */
+    FISH_DEDUP_MEMORY,       /* single in-memory hash set */
+    FISH_DEDUP_EXTERNAL      /* partition by digest prefix on disk */
+} fish_dedup_mode_t;
+
+/**
+ * @brief Remove exact duplicate rows from a dataset.
+ *
+ * Rows are keyed on fish_hash64 and confirmed with a byte compare on
+ * digest match, so results are exact. In memory mode the set holds only
+ * digests and file offsets; external mode splits rows into digest-prefix
+ * partitions next to @p path, deduplicates each on its own and merges
+ * survivors back in original order, so datasets larger than RAM work.
+ * A partition is streamed and keeps only its distinct rows in memory;
+ * one whose distinct rows still outgrow @p budget is split again with
+ * another seed. A row is a whole CSV record, quoted newlines included.
+ *
+ * @param path Dataset to read.
+ * @param drop_null Also drop empty/whitespace rows (rows are trimmed).
+ * @param mode Memory strategy.
+ * @param budget Bytes the table and kept rows may use (0 = FISH_DEDUP_MEM_BUDGET).
+ * @param emit Receives surviving rows.
+ * @param ctx Passed to @p emit.
+ * @return int 0 on success, -1 on failure.
+ */
+int fish_dedup_run(ccstring path, int drop_null, fish_dedup_mode_t mode, size_t budget,
+                   fish_row_emit_fn emit, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_DEDUP_H */
@@ -0,0 +1,163 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_HASH_H
+#define FOSSIL_APP_HASH_H
+
+#include "dataset.h"
+
+/* Maximum fill ratio before the set doubles (percent) */
+#define FISH_HASHSET_LOAD 70
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fast non-cryptographic 64-bit digest (XXH64).
+ *
+ * Used where Jellyfish hashes are stronger than needed, e.g. row
+ * deduplication and partitioning. Not suitable for content addressing;
+ * use fish_sha256_t for that.
+ *
+ * @param data Bytes to hash.
+ * @param len Number of bytes.
+ * @param seed Seed value; different seeds give independent digests.
+ * @return uint64_t Digest.
+ */
+uint64_t fish_hash64(const void *data, size_t len, uint64_t seed);
+
+/* Bytes in a SHA-256 digest */
+#define FISH_SHA256_SIZE 32
+
+/**
+ * @brief Streaming SHA-256 (FIPS 180-4) for content hashes.
+ *
+ * Feed bytes in any number of fish_sha256_update() calls of any size;
+ * the digest is the same as hashing them in one piece.
+ */
+typedef struct {
+    uint32_t h[8];
+    uint64_t bytes;         /* total fed so far */
+    uint8_t block[64];      /* pending partial block */
+    size_t used;
+} fish_sha256_t;
+
+void fish_sha256_init(fish_sha256_t *sha);
+void fish_sha256_update(fish_sha256_t *sha, const void *data, size_t len);
+
+/**
+ * @brief Finish the hash; @p sha must be re-initialized before reuse.
+ */
+void fish_sha256_final(fish_sha256_t *sha, uint8_t digest[FISH_SHA256_SIZE]);
+
+/**
+ * @brief xoshiro256** pseudo-random generator.
+ *
+ * Small and fast, and fully determined by its seed, so streams are the
+ * same on every run and machine. Not for anything security related.
+ */
+typedef struct {
+    uint64_t s[4];
+} fish_rng_t;
+
+/**
+ * @brief Seed @p rng; the state is expanded from @p seed with SplitMix64.
+ */
+void fish_rng_seed(fish_rng_t *rng, uint64_t seed);
+
+/**
+ * @brief Next 64 random bits.
+ */
+uint64_t fish_rng_next(fish_rng_t *rng);
+
+/**
+ * @brief Uniform double in [0, 1).
+ */
+double fish_rng_unit(fish_rng_t *rng);
+
+/**
+ * @brief Resolve a stored reference back to the key bytes it names.
+ *
+ * Lets the set confirm a digest match with a full byte compare without
+ * keeping a copy of every key.
+ *
+ * @return int 0 on success, -1 if the key cannot be read.
+ */
+typedef int (*fish_hashset_resolve_fn)(void *ctx, uint64_t ref, size_t len, fish_slice_t *out);
+
+typedef struct {
+    uint64_t digest;    /* 0 marks an empty slot */
+    uint64_t ref;       /* caller-defined key location */
+    uint64_t len;       /* key length, checked before resolving */
+} fish_hashset_entry_t;
+
+/**
+ * @brief Open-addressing (linear probing) set of key digests.
+ */
+typedef struct {
+    fish_hashset_entry_t *slots;
+    size_t cap;         /* power of two */
+    size_t count;
+    fish_hashset_resolve_fn resolve;
+    void *ctx;
+} fish_hashset_t;
+
+/**
+ * @brief Create a set sized for @p expected keys without rehashing.
+ */
+int fish_hashset_init(fish_hashset_t *set, size_t expected,
+                      fish_hashset_resolve_fn resolve, void *ctx);
+
+/**
+ * @brief Insert a key unless an equal key is already present.
+ *
+ * @param set Target set.
+ * @param digest fish_hash64 of @p key.
+ * @param key Key bytes, compared against resolved keys on digest match.
+ * @param ref Reference stored for later resolution of this key.
+ * @return int 1 if inserted, 0 if already present, -1 on error.
+ */
+int fish_hashset_insert(fish_hashset_t *set, uint64_t digest, fish_slice_t key, uint64_t ref);
+
+/**
+ * @brief Look a key up without inserting it.
+ *
+ * @param set Set to search.
+ * @param digest fish_hash64 of @p key.
+ * @param key Key bytes.
+ * @param ref Receives the stored reference when found (may be NULL).
+ * @return int 1 if present, 0 if absent, -1 on error.
+ */
+int fish_hashset_lookup(fish_hashset_t *set, uint64_t digest, fish_slice_t key, uint64_t *ref);
+
+/**
+ * @brief Remove every key but keep the table for reuse.
+ */
+void fish_hashset_clear(fish_hashset_t *set);
+
+/**
+ * @brief Release the set.
+ */
+void fish_hashset_free(fish_hashset_t *set);
+
+/**
+ * @brief Bytes needed per key at the target load factor.
+ */
+size_t fish_hashset_bytes_per_key(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_HASH_H */
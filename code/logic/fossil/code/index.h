@@ -0,0 +1,139 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_INDEX_H
+#define FOSSIL_APP_INDEX_H
+
+#include "arena.h"
+
+/* Sidecar stored next to every model: "<model>.jfidx" */
+#define FISH_INDEX_SUFFIX ".jfidx"
+#define FISH_INDEX_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t pos;               /* position in chain->commits */
+    uint8_t hash[FOSSIL_JELLYFISH_HASH_SIZE]; /* re-binds the tag after a rebuild */
+    cstring name;
+} fish_index_tag_t;
+
+/**
+ * @brief Lookup structures over one Jellyfish chain.
+ *
+ * - commit hashes, kept sorted so any hex prefix is a binary search;
+ * - commit_index -> position (hash set);
+ * - normalized input -> most confident commit with that input;
+ * - tags, which the chain API can set but not list.
+ *
+ * Build it once after loading the chain and call fish_chain_index_sync()
+ * after learning; appended commits are indexed incrementally.
+ */
+typedef struct {
+    fossil_ai_jellyfish_chain_t *chain;
+    size_t count;               /* commits indexed so far */
+    size_t cap;
+    uint32_t *by_hash;          /* positions ordered by commit hash */
+    fish_hashset_t commits;     /* commit_index -> position */
+    fish_arena_t arena;         /* normalized inputs */
+    fish_intern_t inputs;       /* normalized input -> key id */
+    uint32_t *best;             /* key id -> position */
+    size_t best_cap;
+    fish_index_tag_t *tags;
+    size_t tag_count;
+    size_t tag_cap;
+} fish_chain_index_t;
+
+/**
+ * @brief Index every commit of @p chain.
+ */
+int fish_chain_index_build(fish_chain_index_t *index, fossil_ai_jellyfish_chain_t *chain);
+
+/**
+ * @brief Index the sidecar of @p model_name if it still matches @p chain,
+ *        otherwise rebuild (keeping the tags of commits that still exist).
+ *
+ * @return int 0 on success, -1 on failure.
+ */
+int fish_chain_index_open(fish_chain_index_t *index, fossil_ai_jellyfish_chain_t *chain, ccstring model_name);
+
+/**
+ * @brief Index commits appended since the last build or sync.
+ *
+ * A chain that shrank is rebuilt from scratch.
+ */
+int fish_chain_index_sync(fish_chain_index_t *index);
+
+/**
+ * @brief Persist the index as "<model_name>.jfidx" (atomic replace).
+ */
+int fish_chain_index_save(const fish_chain_index_t *index, ccstring model_name);
+
+/**
+ * @brief Commit with the given commit_index, or NULL.
+ */
+fossil_ai_jellyfish_block_t *fish_chain_index_commit(const fish_chain_index_t *index, uint32_t commit_index);
+
+/**
+ * @brief Commit with exactly this hash, or NULL.
+ */
+fossil_ai_jellyfish_block_t *fish_chain_index_hash(const fish_chain_index_t *index,
+                                                    const uint8_t hash[FOSSIL_JELLYFISH_HASH_SIZE]);
+
+/**
+ * @brief Commits whose hash starts with the hex digits in @p hex.
+ *
+ * @param out Receives up to @p cap positions, in hash order.
+ * @return size_t Number of matching commits (0 also for a non-hex prefix).
+ */
+size_t fish_chain_index_prefix(const fish_chain_index_t *index, ccstring hex, uint32_t *out, size_t cap);
+
+/**
+ * @brief Normalize a prompt the way inputs are matched: trim, lowercase
+ *        ASCII and collapse whitespace runs to one space.
+ *
+ * @param out Receives at least @p len bytes (not NUL-terminated).
+ * @return size_t Normalized length.
+ */
+size_t fish_chain_index_normalize(const char *in, size_t len, char *out);
+
+/**
+ * @brief Valid commit whose normalized input equals @p text's, or NULL.
+ *
+ * Inputs are compared case-insensitively with surrounding whitespace
+ * trimmed and inner runs collapsed to one space. When several commits
+ * match, the most confident (then the newest) wins.
+ */
+fossil_ai_jellyfish_block_t *fish_chain_index_input(const fish_chain_index_t *index, ccstring text);
+
+/**
+ * @brief Tag the commit at @p pos, recording the tag in the index too.
+ */
+int fish_chain_index_tag(fish_chain_index_t *index, uint32_t pos, ccstring tag);
+
+/**
+ * @brief Positions of commits tagged @p tag (up to @p cap).
+ *
+ * @return size_t Number of tagged commits.
+ */
+size_t fish_chain_index_tagged(const fish_chain_index_t *index, ccstring tag, uint32_t *out, size_t cap);
+
+void fish_chain_index_free(fish_chain_index_t *index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_INDEX_H */
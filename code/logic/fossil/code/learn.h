@@ -0,0 +1,77 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_LEARN_H
+#define FOSSIL_APP_LEARN_H
+
+#include "thread.h"
+
+/* Pairs hashed per claimed chunk, and the smallest run worth threading */
+#ifndef FISH_LEARN_CHUNK
+#define FISH_LEARN_CHUNK 256
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    ccstring input;
+    ccstring output;
+} fish_pair_t;
+
+/**
+ * @brief Produce the next pair for fish_chain_learn_iter().
+ *
+ * Writes NUL-terminated strings straight into the commit being filled.
+ *
+ * @return int 1 if a pair was produced, 0 at the end, -1 on error.
+ */
+typedef int (*fish_pair_next_fn)(void *ctx, char *input, size_t input_cap,
+                                 char *output, size_t output_cap);
+
+/**
+ * @brief Append many pairs to a chain at once.
+ *
+ * Each new commit is zeroed, then gets its input and output (truncated
+ * to the field size), commit_hash from fossil_ai_jellyfish_hash(),
+ * commit_index, block_type FOSSIL_JELLYFISH_COMMIT_INIT, valid = 1,
+ * confidence = 1.0, the current time as timestamp and, past the first
+ * commit of the chain, parent_hashes[0] = the previous commit's hash with
+ * parent_count = 1. The chain's count, created_at (when still 0) and
+ * updated_at are set once. Capacity is checked once and the hashes are
+ * computed on worker threads.
+ *
+ * @return size_t Pairs learned; fewer than @p count when the chain fills up.
+ */
+size_t fish_chain_learn_bulk(fossil_ai_jellyfish_chain_t *chain, const fish_pair_t *pairs, size_t count);
+
+/**
+ * @brief Learn pairs pulled from @p next until it runs dry.
+ *
+ * Commits are set up as in fish_chain_learn_bulk(). Once the chain is full
+ * the remaining pairs are still pulled, so the caller learns how many
+ * were left out.
+ *
+ * @param learned Receives the number of pairs learned (may be NULL).
+ * @param dropped Receives the number of pairs pulled after the chain filled up (may be NULL).
+ * @return int 0 when every pair was learned, 1 when some were dropped, -1 on error.
+ */
+int fish_chain_learn_iter(fossil_ai_jellyfish_chain_t *chain, fish_pair_next_fn next, void *ctx,
+                          size_t *learned, size_t *dropped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_LEARN_H */
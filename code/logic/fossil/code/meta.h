@@ -0,0 +1,158 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_META_H
+#define FOSSIL_APP_META_H
+
+#include "hash.h"
+#include "sketch.h"
+
+/* Sidecar stored next to every dataset: "<dataset>.meta" */
+#define FISH_META_SUFFIX ".meta"
+#define FISH_META_VERSION 4
+
+/* Fingerprint block size; only blocks whose digest changed are rescanned */
+#ifndef FISH_META_BLOCK_SIZE
+#define FISH_META_BLOCK_SIZE (4u << 20)
+#endif
+
+/* Histogram shape cached for stats --plot */
+#define FISH_STATS_BINS 20
+
+/* fish_column_stats_t.flags */
+#define FISH_STATS_READY  1u    /* sketches cover the dataset */
+#define FISH_STATS_BINNED 2u    /* bins match the current min/max */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Mergeable statistics for one column.
+ */
+typedef struct {
+    uint64_t present;       /* non-null values */
+    uint64_t nulls;         /* empty or missing fields */
+    fish_moments_t moments; /* numeric values only */
+    fish_hll_t distinct;
+    fish_kll_t quantiles;
+    uint64_t bins[FISH_STATS_BINS];
+    uint32_t flags;         /* FISH_STATS_* */
+} fish_column_stats_t;
+
+typedef struct {
+    uint64_t digest;        /* fish_hash64 of the block bytes */
+    uint64_t records;       /* CSV records ending in the block */
+    uint64_t state;         /* FISH_CSV_* quote state at the block start */
+} fish_meta_block_t;
+
+/**
+ * @brief Cached facts about a dataset file.
+ *
+ * The fingerprint is a Merkle tree over FISH_META_BLOCK_SIZE blocks: the
+ * leaves tell which blocks changed, the root identifies the whole content.
+ * Whether the first record is a header is decided once, the way train and
+ * test decide it (fish_row_reader_header()), and every count follows it.
+ * Stats cover the data rows before byte stats_end; a dataset that only
+ * grew keeps them, and the caller folds in rows from stats_end onwards.
+ * Columnar datasets are summarised column by column, so each slot records
+ * which of its parts are filled in.
+ */
+typedef struct {
+    uint64_t file_size;
+    int64_t mtime;
+    fish_meta_block_t *block;
+    size_t blocks;
+    uint64_t root;
+    uint64_t rows;          /* data rows, header excluded */
+    int ends_on_record;     /* last byte ends a CSV record */
+    int has_header;         /* first record is a header */
+    cstring header;         /* first record: column names if has_header, else
+                               the first data row, giving only the column count */
+
+    int has_stats;
+    uint64_t stats_end;
+    uint64_t stats_rows;
+    size_t columns;
+    fish_column_stats_t *stats;
+} fish_meta_t;
+
+typedef enum {
+    FISH_META_UNCHANGED = 0, /* sidecar matched the file as is */
+    FISH_META_APPENDED,      /* rows were appended; cached stats still valid as a prefix */
+    FISH_META_REBUILT        /* content changed; stats dropped */
+} fish_meta_state_t;
+
+/**
+ * @brief Bring the sidecar for @p path up to date.
+ *
+ * Loads "<path>.meta" when present. If size, mtime and the final block
+ * still match (and the file is older than its sidecar), nothing else is
+ * read. If the file grew and the old final block still matches, the
+ * blocks before it keep their digests and counts and only the rest is
+ * read. Otherwise every block is rehashed, and only blocks whose digest
+ * changed are rescanned for record counts. The refreshed sidecar is
+ * written back.
+ *
+ * @param meta Receives the metadata; release with fish_meta_free().
+ * @param path Dataset path.
+ * @return int fish_meta_state_t on success, -1 on failure.
+ */
+int fish_meta_sync(fish_meta_t *meta, ccstring path);
+
+/**
+ * @brief Offset of the first CSV record that starts at or after @p offset.
+ *
+ * Rescans from the start of the block holding @p offset, using the quote
+ * state recorded there, so a newline inside a quoted field is never taken
+ * for a record end.
+ *
+ * @param meta Synced metadata for @p path.
+ * @return uint64_t The record start, or the file size if none follows.
+ */
+uint64_t fish_meta_record_start(const fish_meta_t *meta, ccstring path, uint64_t offset);
+
+/**
+ * @brief Persist @p meta as the sidecar for @p path (atomic replace).
+ */
+int fish_meta_save(const fish_meta_t *meta, ccstring path);
+
+/**
+ * @brief Remove the sidecar for @p path, e.g. after rewriting the dataset.
+ */
+void fish_meta_invalidate(ccstring path);
+
+/**
+ * @brief Allocate @p columns fresh stat slots, dropping any cached stats.
+ */
+int fish_meta_stats_reset(fish_meta_t *meta, size_t columns);
+
+/**
+ * @brief Prepare a column stat slot for accumulation.
+ */
+int fish_column_stats_init(fish_column_stats_t *col);
+
+/**
+ * @brief Fold @p src into @p dst (bins included).
+ */
+int fish_column_stats_merge(fish_column_stats_t *dst, const fish_column_stats_t *src);
+
+void fish_column_stats_free(fish_column_stats_t *col);
+
+void fish_meta_free(fish_meta_t *meta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_META_H */
@@ -0,0 +1,161 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_MODEL_H
+#define FOSSIL_APP_MODEL_H
+
+#include "index.h"
+#include "thread.h"
+
+/* Longest reasoned answer or block explanation kept per request */
+#ifndef FISH_MODEL_REPLY_MAX
+#define FISH_MODEL_REPLY_MAX 1024
+#endif
+
+/* Most models kept resident at once; acquiring another one fails */
+#ifndef FISH_MODEL_RESIDENT_MAX
+#define FISH_MODEL_RESIDENT_MAX 64
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A model kept resident in memory.
+ *
+ * The chain is loaded from "<name>.jfchain" the first time the model is
+ * acquired, together with its lookup index, and stays loaded until
+ * fish_models_release(). Reasoning runs
+ * under the read lock, so any number of requests can share one model;
+ * learning and saving take the write lock.
+ */
+typedef struct fish_model {
+    cstring name;
+    fossil_ai_jellyfish_chain_t *chain;
+    fish_chain_index_t index;
+    fish_rwlock_t *lock;
+    int loaded;                 /* chain came from disk (0: started empty) */
+    int dirty;                  /* learned since load or last save */
+    uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE];
+    int fingerprint_ok;         /* fingerprint matches the chain */
+    int cache_loaded;           /* .jfcache read for this fingerprint */
+    struct fish_model *next;
+} fish_model_t;
+
+/**
+ * @brief Whether @p name is usable as a model name (no path separators or "..").
+ */
+int fish_model_valid_name(ccstring name);
+
+/**
+ * @brief Prepare the registry; call before models are acquired from several threads.
+ */
+int fish_models_init(void);
+
+/**
+ * @brief Find a resident model, loading it on first use.
+ *
+ * A missing model file gives an empty chain, so a new model can be
+ * taught through chat and saved later.
+ *
+ * @return fish_model_t* Shared model, NULL on invalid name, out of memory
+ *         or FISH_MODEL_RESIDENT_MAX models already resident.
+ */
+fish_model_t *fish_model_acquire(ccstring name);
+
+/**
+ * @brief fish_model_acquire() for models that already exist.
+ *
+ * Only a resident model or one with a "<name>.jfchain" on disk is
+ * returned; an unknown name never creates an empty chain. Use this
+ * for names that come from clients.
+ *
+ * @return fish_model_t* Shared model, NULL if unknown or not loadable.
+ */
+fish_model_t *fish_model_acquire_existing(ccstring name);
+
+/**
+ * @brief Whether @p name is resident or has a chain file on disk.
+ */
+int fish_model_exists(ccstring name);
+
+/**
+ * @brief Reason on the model's chain.
+ *
+ * A prompt matching a learned input (see fish_chain_index_input) is
+ * answered from the index; anything else goes through Jellyfish reasoning.
+ *
+ * @param answer Receives the reasoned output (empty when not found).
+ * @param confidence Receives the confidence, may be NULL.
+ * @param explain Receives the block explanation when found, may be NULL.
+ * @return int 1 if an answer was found, 0 if not.
+ */
+int fish_model_answer(fish_model_t *model, ccstring prompt,
+                      char *answer, size_t answer_cap, float *confidence,
+                      char *explain, size_t explain_cap);
+
+/**
+ * @brief fish_model_answer() through the answer cache.
+ *
+ * Results are cached per (chain fingerprint, normalized prompt, explain
+ * flag), so repeating a question against an unchanged model is a hash
+ * lookup; learning changes the fingerprint and with it the key. Hits and
+ * misses are counted by fish_cache_hits() / fish_cache_misses().
+ */
+int fish_model_ask(fish_model_t *model, ccstring prompt,
+                   char *answer, size_t answer_cap, float *confidence,
+                   char *explain, size_t explain_cap);
+
+/**
+ * @brief Also keep answers in "<model>.jfcache", so later processes start warm.
+ */
+void fish_model_cache_persist(int on);
+
+/**
+ * @brief Fingerprint of the model's chain, recomputed only after learning.
+ */
+void fish_model_fingerprint(fish_model_t *model, uint8_t out[FOSSIL_JELLYFISH_HASH_SIZE]);
+
+/**
+ * @brief Teach the model one input/output pair.
+ */
+void fish_model_learn(fish_model_t *model, ccstring input, ccstring output);
+
+/**
+ * @brief One chat turn: answer @p message, or echo it back when the chain
+ *        has nothing on it.
+ *
+ * @param learn Teach the chain the echoed reply so later turns recall it.
+ * @return int 1 if the chain answered, 0 if the reply is the echo.
+ */
+int fish_model_chat(fish_model_t *model, ccstring message, int learn,
+                    char *reply, size_t reply_cap, float *confidence);
+
+/**
+ * @brief Write the chain back to "<name>.jfchain" and its index to "<name>.jfidx".
+ *
+ * @return int 0 on success, -1 on failure.
+ */
+int fish_model_save(fish_model_t *model);
+
+/**
+ * @brief Unload every model, saving the dirty ones first when @p save_dirty is set.
+ */
+void fish_models_release(int save_dirty);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_MODEL_H */
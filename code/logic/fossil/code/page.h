@@ -0,0 +1,104 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_PAGE_H
+#define FOSSIL_APP_PAGE_H
+
+#include "dataset.h"
+
+/*
+ * Paged model layout ("<model>.jfpage"), written next to each .jfchain
+ * the fish layer saves:
+ *
+ *   fish_page_header_t      chain fields, scores, source .jfchain size/mtime
+ *   fish_page_entry_t[n]    commit directory: offset, commit_index, valid
+ *   block[n]                commits, fossil_ai_jellyfish_block_t as in memory
+ *
+ * Opening reads only the header and directory and maps the rest, so a
+ * commit costs a page fault when touched. Values are in host byte order,
+ * like the .meta and .jfidx sidecars; a page file whose source .jfchain
+ * changed is rebuilt from a full load.
+ */
+#define FISH_PAGE_SUFFIX ".jfpage"
+#define FISH_PAGE_MAGIC "FISHPAG1"
+#define FISH_PAGE_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t block_size;            /* sizeof(fossil_ai_jellyfish_block_t) */
+    uint64_t source_size;           /* .jfchain this file mirrors */
+    int64_t source_mtime;
+    uint64_t count;
+    uint64_t created_at;
+    uint64_t updated_at;
+    uint32_t branch_count;
+    float trust_score;
+    float coverage;
+    uint32_t reserved;
+    char default_branch[sizeof(((fossil_ai_jellyfish_chain_t *)0)->default_branch)];
+    uint8_t repo_id[FOSSIL_DEVICE_ID_SIZE];
+    uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE];
+} fish_page_header_t;
+
+typedef struct {
+    uint64_t offset;                /* of the block, from the start of the file */
+    uint32_t commit_index;
+    uint32_t valid;
+} fish_page_entry_t;
+
+/**
+ * @brief Lazily opened model.
+ */
+typedef struct {
+    fish_page_header_t header;
+    fish_page_entry_t *dir;         /* header.count entries */
+    fossil_io_file_t file;
+    const char *map;                /* whole file, when mapping worked */
+    size_t map_len;
+    void *map_handle;
+    fossil_ai_jellyfish_block_t **cache; /* read-on-demand fallback */
+    fossil_ai_jellyfish_chain_t *chain;  /* set when the page file could not be written */
+} fish_page_t;
+
+/**
+ * @brief Write "<model_name>.jfpage" for @p chain (atomic replace).
+ *
+ * Call right after saving "<model_name>.jfchain" so the page file
+ * records the saved file's size and mtime.
+ */
+int fish_page_write(const fossil_ai_jellyfish_chain_t *chain, ccstring model_name);
+
+/**
+ * @brief Open a model through its page file, rebuilding a missing or stale one.
+ *
+ * @return int 0 on success, -1 if the model cannot be read.
+ */
+int fish_page_open(fish_page_t *page, ccstring model_name);
+
+/**
+ * @brief Commit at @p pos, faulted in on first use (NULL if out of range).
+ */
+const fossil_ai_jellyfish_block_t *fish_page_commit(fish_page_t *page, size_t pos);
+
+void fish_page_close(fish_page_t *page);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_PAGE_H */
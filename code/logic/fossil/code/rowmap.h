@@ -0,0 +1,74 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_ROWMAP_H
+#define FOSSIL_APP_ROWMAP_H
+
+#include "arena.h"
+
+/* Records read per window; a window is transformed in parallel, then written in order */
+#ifndef FISH_ROW_MAP_WINDOW_ROWS
+#define FISH_ROW_MAP_WINDOW_ROWS 4096
+#endif
+
+/* Fewest records worth a worker of their own */
+#ifndef FISH_ROW_MAP_MIN_ROWS
+#define FISH_ROW_MAP_MIN_ROWS 256
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Per-worker state handed to a fish_row_map_fn.
+ *
+ * Everything here belongs to one worker, so the callback may use it
+ * without locking.
+ */
+typedef struct {
+    fish_row_writer_t out;      /* rows produced for the current window */
+    fish_row_fields_t fields;
+    fish_rng_t rng;
+    double *values;             /* numeric scratch, e.g. for fish_schema_values_at() */
+    size_t values_cap;
+    int failed;
+} fish_row_map_worker_t;
+
+/**
+ * @brief Transform one record, writing any output rows to @c worker->out.
+ *
+ * @param index Position of the record in the input, 0 for the first.
+ * @return int 0 on success, -1 to stop the map.
+ */
+typedef int (*fish_row_map_fn)(void *ctx, fish_row_map_worker_t *worker, fish_slice_t row, uint64_t index);
+
+/**
+ * @brief Run @p fn over every remaining record of @p reader on several
+ *        threads, writing the results to @p writer in input order.
+ *
+ * Records are copied in windows of FISH_ROW_MAP_WINDOW_ROWS and each
+ * worker takes one contiguous run of a window, so memory stays bounded
+ * by the window and its output, whatever the dataset size.
+ *
+ * @param threads Worker count, 0 for fish_thread_count().
+ * @return int 0 on success, -1 if @p fn or a write failed.
+ */
+int fish_row_map(fish_row_reader_t *reader, fish_row_writer_t *writer,
+                 fish_row_map_fn fn, void *ctx, size_t threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_ROWMAP_H */
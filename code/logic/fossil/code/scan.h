@@ -0,0 +1,124 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_SCAN_H
+#define FOSSIL_APP_SCAN_H
+
+#include "dataset.h"
+
+/*
+ * Byte scanning kernels for the text passes: finding delimiters,
+ * counting them, splitting text into runs of one byte class and
+ * lowercasing. Each kernel has SSE2 and AVX2 (x86), NEON (aarch64) and
+ * portable versions; the widest one the CPU supports is picked at
+ * first use. Class runs come from 64-byte bitmaps walked with
+ * count-trailing-zeros, so short words share one vector pass.
+ * Classes and case are ASCII only, like isalnum()/isspace()/tolower()
+ * in the C locale the tool runs in, so bytes >= 0x80 are in no class.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    FISH_SCAN_SCALAR = 0,
+    FISH_SCAN_SSE2,
+    FISH_SCAN_AVX2,
+    FISH_SCAN_NEON,
+    FISH_SCAN_ISA_COUNT
+} fish_scan_isa_t;
+
+typedef enum {
+    FISH_SCAN_ALNUM = 0,        /* [0-9A-Za-z] */
+    FISH_SCAN_SPACE             /* ' ', \t \n \v \f \r */
+} fish_scan_class_t;
+
+/**
+ * @brief Walks the runs of bytes in (or not in) one class.
+ */
+typedef struct {
+    const char *ptr;
+    size_t len;
+    size_t pos;                 /* next byte to look at */
+    size_t base;                /* block covered by bits */
+    uint64_t bits;              /* bit i: byte base + i belongs to a run */
+    fish_scan_class_t cls;
+    int in;
+} fish_scan_cursor_t;
+
+/**
+ * @brief Offset of the first byte equal to @p a, @p b or @p c (repeat
+ *        one to look for fewer), or @p len when there is none.
+ */
+size_t fish_scan_find(const char *p, size_t len, char a, char b, char c);
+
+/**
+ * @brief Number of bytes equal to @p c.
+ */
+size_t fish_scan_count(const char *p, size_t len, char c);
+
+/**
+ * @brief Length of the leading run of bytes in @p cls.
+ */
+size_t fish_scan_span(const char *p, size_t len, fish_scan_class_t cls);
+
+/**
+ * @brief Length of the leading run of bytes not in @p cls.
+ */
+size_t fish_scan_cspan(const char *p, size_t len, fish_scan_class_t cls);
+
+/**
+ * @brief Start walking @p s for runs of bytes in @p cls (@p in = 1) or
+ *        outside it (@p in = 0).
+ */
+void fish_scan_cursor_init(fish_scan_cursor_t *cursor, fish_slice_t s, fish_scan_class_t cls, int in);
+
+/**
+ * @brief Next maximal run.
+ *
+ * @return int 1 with @p run set, 0 at the end of the text.
+ */
+int fish_scan_cursor_next(fish_scan_cursor_t *cursor, fish_slice_t *run);
+
+/**
+ * @brief Copy @p len bytes to @p out with ASCII letters lowercased.
+ */
+void fish_scan_lower(char *out, const char *p, size_t len);
+
+/**
+ * @brief Lowercased alnum runs of @p in joined by single spaces.
+ *
+ * @return size_t Bytes written (up to @p cap - 1, NUL-terminated).
+ */
+size_t fish_scan_tokens(fish_slice_t in, char *out, size_t cap);
+
+/**
+ * @brief Kernel set in use.
+ */
+fish_scan_isa_t fish_scan_isa(void);
+
+/**
+ * @brief Switch to another kernel set, e.g. to compare them.
+ *
+ * @return int 0 on success, -1 if this build or CPU lacks it.
+ */
+int fish_scan_select(fish_scan_isa_t isa);
+
+ccstring fish_scan_isa_name(fish_scan_isa_t isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_SCAN_H */
@@ -0,0 +1,147 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_SCHEMA_H
+#define FOSSIL_APP_SCHEMA_H
+
+#include "dataset.h"
+
+/* Memory the numeric cache may use before later rows are parsed again */
+#ifndef FISH_SCHEMA_CACHE_BUDGET
+#define FISH_SCHEMA_CACHE_BUDGET ((size_t)64 << 20)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Column types, ordered so a column takes the widest type of its values */
+typedef enum {
+    FISH_SCHEMA_EMPTY = 0,  /* only empty or missing values */
+    FISH_SCHEMA_INT,
+    FISH_SCHEMA_FLOAT,
+    FISH_SCHEMA_TEXT        /* at least one value is not a number */
+} fish_schema_type_t;
+
+typedef struct {
+    cstring name;           /* header label, or "column<N>" */
+    fish_schema_type_t type;
+    uint64_t numeric;       /* values that parse as numbers */
+    double min;             /* over numeric values */
+    double max;
+} fish_schema_column_t;
+
+/**
+ * @brief Shape of a CSV dataset, inferred in one pass.
+ *
+ * The first record is taken as a header when every field is non-empty,
+ * non-numeric and distinct. Every data record is parsed once while the
+ * schema is built: column types and numeric ranges come out of that pass,
+ * and the parsed values are cached (up to a memory budget) so a second
+ * pass over the same records replays them instead of parsing again.
+ */
+typedef struct {
+    fish_schema_column_t *col;
+    size_t columns;
+    size_t cap;
+    int seen;               /* first record handled */
+    int has_header;
+    uint64_t rows;          /* data records, header excluded */
+    int complete;           /* every record was added; column types are final */
+
+    /* per record: field count, then one value per field (NaN = not numeric) */
+    double *cache;
+    size_t cache_len;
+    size_t cache_cap;
+    size_t *cache_at;       /* where each cached record starts */
+    size_t cache_at_cap;
+    uint64_t cache_rows;    /* leading data records that are cached */
+    size_t cache_limit;     /* 8-byte slots the budget allows, 0 = no cache */
+    int cache_full;
+
+    /* sequential replay */
+    uint64_t replay;        /* next data record */
+    double *values;         /* parsed values of a record past the cache */
+    size_t values_cap;
+} fish_schema_t;
+
+/**
+ * @brief Prepare an empty schema.
+ *
+ * @param cache_budget Bytes for cached values; 0 disables the cache.
+ */
+void fish_schema_init(fish_schema_t *schema, size_t cache_budget);
+
+/**
+ * @brief Whether a split record reads as a header: every field non-empty,
+ *        non-numeric and distinct.
+ */
+int fish_schema_is_header(const fish_row_fields_t *fields);
+
+/**
+ * @brief Fold one record into the schema.
+ *
+ * @param fields Splitter used for @p row.
+ * @return int 1 if the record is the header, 0 for a data record, -1 on
+ *         allocation failure.
+ */
+int fish_schema_add(fish_schema_t *schema, fish_row_fields_t *fields, fish_slice_t row);
+
+/**
+ * @brief Infer the schema of @p path, reading it once as CSV records.
+ *
+ * @return int 0 on success, -1 if the dataset cannot be read.
+ */
+int fish_schema_infer(fish_schema_t *schema, ccstring path);
+
+/**
+ * @brief Mark the schema complete and restart replay at the first data record.
+ */
+void fish_schema_rewind(fish_schema_t *schema);
+
+/**
+ * @brief Numeric values of data record @p row (0 = first after any
+ *        header), already split into @p fields.
+ *
+ * Cached records cost no parsing; later ones are parsed into @p scratch,
+ * skipping columns known to hold no numbers once the schema is complete.
+ * Safe to call from several threads, each with its own scratch buffer.
+ *
+ * @param scratch Growable buffer owned by the caller (free it when done).
+ * @return const double* One value per field, NaN where the field is not a
+ *         number; valid until the next call. NULL on allocation failure.
+ */
+const double *fish_schema_values_at(const fish_schema_t *schema, uint64_t row,
+                                    const fish_row_fields_t *fields,
+                                    double **scratch, size_t *scratch_cap);
+
+/**
+ * @brief fish_schema_values_at() for the next record, replaying records in
+ *        the order they were added.
+ */
+const double *fish_schema_values(fish_schema_t *schema, const fish_row_fields_t *fields);
+
+/**
+ * @brief Whether column @p col has a range to scale numeric values into 0-1.
+ */
+int fish_schema_scalable(const fish_schema_t *schema, size_t col);
+
+ccstring fish_schema_type_name(fish_schema_type_t type);
+
+void fish_schema_free(fish_schema_t *schema);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_SCHEMA_H */
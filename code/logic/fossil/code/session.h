@@ -0,0 +1,116 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_SESSION_H
+#define FOSSIL_APP_SESSION_H
+
+#include "model.h"
+
+/* Turns kept in the history ring */
+#ifndef FISH_SESSION_TURNS
+#define FISH_SESSION_TURNS 64
+#endif
+
+/* Text kept in the ring; older turns are evicted past this */
+#ifndef FISH_SESSION_BYTES
+#define FISH_SESSION_BYTES (16u << 10)
+#endif
+
+/* Turns learned as one commit each per session; later ones are compacted */
+#ifndef FISH_SESSION_COMMITS
+#define FISH_SESSION_COMMITS 256
+#endif
+
+/* Evicted text folded into one summary commit */
+#ifndef FISH_SESSION_SUMMARY
+#define FISH_SESSION_SUMMARY 1024
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief One exchange, stored as plain text.
+ */
+typedef struct {
+    cstring user;
+    cstring reply;
+    int learned;        /* already in the chain (or restored from the log) */
+} fish_turn_t;
+
+/**
+ * @brief Chat context with bounded memory.
+ *
+ * The most recent turns are kept in a fixed ring of FISH_SESSION_TURNS
+ * slots holding at most FISH_SESSION_BYTES of text. With learning on, the
+ * first FISH_SESSION_COMMITS unknown messages are learned one commit each;
+ * after that, turns are folded into a summary as they leave the ring and
+ * each full summary becomes a single commit, so a long session grows the
+ * chain by one commit per FISH_SESSION_SUMMARY bytes rather than per turn.
+ * The transcript file is appended to after every turn and read back into
+ * the ring when the session is reopened.
+ */
+typedef struct {
+    fish_model_t *model;
+    int learn;
+    fish_turn_t turn[FISH_SESSION_TURNS];
+    size_t head;        /* slot of the oldest turn */
+    size_t count;
+    size_t bytes;       /* text held by the ring */
+    size_t turns;       /* turns seen, restored ones included */
+    size_t commits;     /* per-turn commits learned this session */
+    char summary[FISH_SESSION_SUMMARY];
+    size_t summary_len;
+    size_t summary_first; /* turn number the pending summary starts at */
+    size_t summaries;   /* summary commits learned this session */
+    fossil_io_file_t log;
+    int logging;
+    int log_failed;
+} fish_session_t;
+
+/**
+ * @brief Start a session, restoring the last turns of @p save_file if it exists.
+ *
+ * @param learn Learn new turns into the model (keep_context).
+ * @param save_file Transcript to restore from and append to, may be NULL.
+ * @return int 0 on success, -1 if the transcript cannot be opened.
+ */
+int fish_session_open(fish_session_t *session, fish_model_t *model, int learn, ccstring save_file);
+
+/**
+ * @brief Answer @p message and record the turn.
+ *
+ * @param reply Receives the plain-text reply.
+ * @return int 1 if the model knew an answer, 0 if it fell back to an echo.
+ */
+int fish_session_turn(fish_session_t *session, ccstring message,
+                      char *reply, size_t reply_cap, float *confidence);
+
+/**
+ * @brief Print the turns currently held in the ring, oldest first.
+ */
+void fish_session_print(const fish_session_t *session);
+
+/**
+ * @brief Compact unlearned turns, close the transcript and free the ring.
+ *
+ * @return int 0 on success, -1 if the transcript could not be written.
+ */
+int fish_session_close(fish_session_t *session);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_SESSION_H */
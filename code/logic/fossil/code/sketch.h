@@ -0,0 +1,107 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_SKETCH_H
+#define FOSSIL_APP_SKETCH_H
+
+#include "commands.h"
+
+/* HyperLogLog precision: 2^bits one-byte registers, ~1.04/sqrt(2^bits) error */
+#ifndef FISH_HLL_BITS
+#define FISH_HLL_BITS 12
+#endif
+#define FISH_HLL_REGS (1u << FISH_HLL_BITS)
+
+/* KLL accuracy parameter; rank error is roughly 1.7/k */
+#ifndef FISH_KLL_K
+#define FISH_KLL_K 200
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* All sketches below are mergeable: per-thread partials combine exactly
+ * (moments) or with the same error bound (HLL, KLL) as a single pass. */
+
+/**
+ * @brief Running count/min/max/mean/variance (Welford).
+ */
+typedef struct {
+    uint64_t n;
+    double mean;
+    double m2;          /* sum of squared deviations from the mean */
+    double min;
+    double max;
+} fish_moments_t;
+
+void fish_moments_init(fish_moments_t *m);
+void fish_moments_add(fish_moments_t *m, double x);
+void fish_moments_merge(fish_moments_t *dst, const fish_moments_t *src);
+
+/**
+ * @brief Sample variance (0 for fewer than two values).
+ */
+double fish_moments_variance(const fish_moments_t *m);
+
+/**
+ * @brief HyperLogLog distinct-count sketch over 64-bit digests.
+ */
+typedef struct {
+    uint8_t reg[FISH_HLL_REGS];
+} fish_hll_t;
+
+void fish_hll_init(fish_hll_t *h);
+void fish_hll_add(fish_hll_t *h, uint64_t digest);
+void fish_hll_merge(fish_hll_t *dst, const fish_hll_t *src);
+double fish_hll_estimate(const fish_hll_t *h);
+
+typedef struct {
+    double *item;
+    size_t n;
+    size_t cap;
+} fish_kll_level_t;
+
+/**
+ * @brief KLL quantile sketch.
+ *
+ * Level h holds items of weight 2^h; a full level is sorted and every
+ * other item promoted, so memory stays O(k) for any stream length.
+ */
+typedef struct {
+    fish_kll_level_t *level;
+    size_t levels;
+    size_t k;
+    size_t size;        /* items held across all levels */
+    uint64_t n;         /* values seen */
+    unsigned toggle;    /* alternates the kept half on compaction */
+} fish_kll_t;
+
+int fish_kll_init(fish_kll_t *s, size_t k);
+int fish_kll_add(fish_kll_t *s, double x);
+int fish_kll_merge(fish_kll_t *dst, const fish_kll_t *src);
+
+/**
+ * @brief Approximate value at quantile @p q (0..1).
+ *
+ * @return int 0 on success, -1 if the sketch is empty or out of memory.
+ */
+int fish_kll_quantile(const fish_kll_t *s, double q, double *out);
+
+void fish_kll_free(fish_kll_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_SKETCH_H */
@@ -0,0 +1,84 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_STORE_H
+#define FOSSIL_APP_STORE_H
+
+#include "hash.h"
+
+/*
+ * Content-addressed commit store
+ *
+ *   .jfstore/objects/<2 hex>/<62 hex>   one commit block, named by the
+ *                                       SHA-256 of its bytes
+ *
+ * A model file ("<model>.jfchain") saved by the fish layer is a ref
+ * into the store of its own directory rather than a full chain:
+ *
+ *   "FISHREF1" version block_size count chain_len head
+ *   chain record            chain fields outside the commit array
+ *   uint8 id[count][32]     object of each commit, in chain order
+ *
+ * head is the id of the newest commit (zero for an empty chain), the tip
+ * of default_branch. Models that share commits, such as variants trained
+ * from one base, share their objects, so a copy of a model is a copy of
+ * its ids and a save writes only commits the store does not hold yet.
+ * Objects never change once written; writers race harmlessly because
+ * every writer produces the same bytes for the same name. Values are in
+ * host byte order, like the .jfpage and .jfidx sidecars.
+ */
+#define FISH_STORE_DIR ".jfstore"
+#define FISH_REF_MAGIC "FISHREF1"
+#define FISH_REF_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief What a fish_store_save() call wrote.
+ */
+typedef struct {
+    size_t written;         /* objects new to the store */
+    size_t shared;          /* objects the store already held */
+} fish_store_stats_t;
+
+/**
+ * @brief Check whether @p path holds a ref.
+ */
+int fish_ref_probe(ccstring path);
+
+/**
+ * @brief Store the commits of @p chain and write the ref @p path (atomic replace).
+ *
+ * Commits that the previous ref at @p path already pointed to are not
+ * looked up again; the rest are written only when missing.
+ *
+ * @param stats Receives the object counts, may be NULL.
+ * @return int 0 on success, -1 on failure (the old ref stays in place).
+ */
+int fish_store_save(const fossil_ai_jellyfish_chain_t *chain, ccstring path, fish_store_stats_t *stats);
+
+/**
+ * @brief Load the chain a ref points to, verifying every object's hash.
+ *
+ * @return int 0 on success, -1 if the ref or one of its objects is
+ *         missing or corrupt.
+ */
+int fish_ref_load(fossil_ai_jellyfish_chain_t *chain, ccstring path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_STORE_H */
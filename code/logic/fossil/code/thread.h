@@ -0,0 +1,108 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_THREAD_H
+#define FOSSIL_APP_THREAD_H
+
+#include "commands.h"
+
+/* Upper bound on worker threads used by any single command */
+#ifndef FISH_THREAD_MAX
+#define FISH_THREAD_MAX 64
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Work item run by fish_thread_run on each worker.
+ *
+ * @param ctx Shared context.
+ * @param index Worker index, 0 .. count-1.
+ */
+typedef void (*fish_thread_fn)(void *ctx, size_t index);
+
+/**
+ * @brief Number of hardware threads, clamped to 1 .. FISH_THREAD_MAX.
+ */
+size_t fish_thread_count(void);
+
+/**
+ * @brief Run @p fn on @p count workers and wait for all of them.
+ *
+ * Worker 0 runs on the calling thread. If a thread cannot be started its
+ * index is run inline instead, so every index always runs exactly once.
+ *
+ * @param count Number of workers.
+ * @param fn Work item.
+ * @param ctx Passed to every call of @p fn.
+ * @return int 0 on success, -1 if @p count is zero.
+ */
+int fish_thread_run(size_t count, fish_thread_fn fn, void *ctx);
+
+/**
+ * @brief Atomically take the next item from a shared counter.
+ *
+ * Workers of a fish_thread_run() loop on this to pull items one at a
+ * time, which balances uneven work (e.g. files of very different sizes).
+ *
+ * @param next Counter shared by all workers, starting at 0.
+ * @return size_t The claimed index; callers stop once it reaches their total.
+ */
+size_t fish_thread_claim(volatile size_t *next);
+
+/**
+ * @brief Atomically add @p n to a shared counter.
+ *
+ * @return uint64_t The value before the addition.
+ */
+uint64_t fish_thread_add(volatile uint64_t *counter, uint64_t n);
+
+/**
+ * @brief Atomically raise @p value to @p candidate if it is larger.
+ */
+void fish_thread_max(volatile uint64_t *value, uint64_t candidate);
+
+/**
+ * @brief Small id of the calling thread, 1 for the first thread that asks.
+ */
+size_t fish_thread_self(void);
+
+/**
+ * @brief Monotonic wall-clock time in nanoseconds (for timing, not dates).
+ */
+uint64_t fish_clock_ns(void);
+
+/**
+ * @brief Reader/writer lock: many concurrent readers or one writer.
+ */
+typedef struct fish_rwlock fish_rwlock_t;
+
+/**
+ * @brief Create a lock; NULL on failure.
+ */
+fish_rwlock_t *fish_rwlock_create(void);
+
+void fish_rwlock_read_lock(fish_rwlock_t *lock);
+void fish_rwlock_read_unlock(fish_rwlock_t *lock);
+void fish_rwlock_write_lock(fish_rwlock_t *lock);
+void fish_rwlock_write_unlock(fish_rwlock_t *lock);
+
+void fish_rwlock_destroy(fish_rwlock_t *lock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_THREAD_H */
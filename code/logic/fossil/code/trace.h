@@ -0,0 +1,174 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_TRACE_H
+#define FOSSIL_APP_TRACE_H
+
+#include "thread.h"
+
+/*
+ * Stage tracing.
+ *
+ *   FISH_TRACE_BEGIN(t);
+ *   ... load the chain ...
+ *   FISH_TRACE_END(FISH_STAGE_LOAD, t, commits);
+ *
+ * Each finished scope is added to its stage's histogram: call count,
+ * items (rows, commits or bytes, as the call site counts them), total
+ * time and latency percentiles, aggregated over every thread of the
+ * process. Tracing stays off until fish_trace_enable() (the --trace
+ * flag); while off, a scope costs one branch. Building with
+ * -Dwith_trace=disabled defines FISH_TRACE to 0 and the macros expand
+ * to nothing.
+ *
+ * Dataset reads are traced per FISH_ROW_CHUNK_SIZE read or mmap window
+ * (LOAD, bytes), dedup per pass (HASH, rows) and writer commits (SAVE,
+ * rows). Splitting a row into fields is not: a scope per row would
+ * cost more than the split, so that time stays in the callers' scopes.
+ */
+#ifndef FISH_TRACE
+#define FISH_TRACE 1
+#endif
+
+/* Events kept for the Chrome trace; later ones only reach the histograms */
+#ifndef FISH_TRACE_EVENTS_MAX
+#define FISH_TRACE_EVENTS_MAX ((size_t)1 << 16)
+#endif
+
+/* 16 exact buckets, then 8 sub-buckets per power of two: within 12.5% */
+#define FISH_HIST_BUCKETS (16 + 60 * 8)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    FISH_STAGE_LOAD = 0,
+    FISH_STAGE_PARSE,
+    FISH_STAGE_HASH,
+    FISH_STAGE_LEARN,
+    FISH_STAGE_REASON,
+    FISH_STAGE_SAVE,
+    FISH_STAGE_COUNT
+} fish_stage_t;
+
+/* Event counters reported next to the stages */
+typedef enum {
+    FISH_COUNTER_CACHE_HIT = 0,
+    FISH_COUNTER_CACHE_MISS,
+    FISH_COUNTER_COUNT
+} fish_counter_t;
+
+typedef enum {
+    FISH_TRACE_JSON = 0,        /* per-stage summary */
+    FISH_TRACE_CHROME           /* trace-event format (chrome://tracing, Perfetto) */
+} fish_trace_format_t;
+
+/**
+ * @brief Log-bucketed histogram of nanosecond values.
+ */
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t bucket[FISH_HIST_BUCKETS];
+} fish_hist_t;
+
+void fish_hist_add(fish_hist_t *hist, uint64_t value);
+
+void fish_hist_merge(fish_hist_t *into, const fish_hist_t *from);
+
+/**
+ * @brief Value below which a share @p p (0..1) of the samples fall.
+ *
+ * Exact below 16, otherwise the top of the matching bucket (capped at max).
+ */
+uint64_t fish_hist_percentile(const fish_hist_t *hist, double p);
+
+ccstring fish_stage_name(fish_stage_t stage);
+
+ccstring fish_counter_name(fish_counter_t counter);
+
+#if FISH_TRACE
+
+/**
+ * @brief Start collecting; the report is written to @p path at exit.
+ *
+ * @return int 0 on success, -1 if tracing is already on or out of memory.
+ */
+int fish_trace_enable(ccstring path, fish_trace_format_t format);
+
+/**
+ * @brief Whether tracing is on.
+ */
+int fish_trace_on(void);
+
+/**
+ * @brief Start time of a scope, 0 while tracing is off.
+ */
+uint64_t fish_trace_begin(void);
+
+/**
+ * @brief Close a scope opened with fish_trace_begin().
+ */
+void fish_trace_end(fish_stage_t stage, uint64_t start, uint64_t items);
+
+/**
+ * @brief Add @p n to a counter; counted whether or not tracing is on.
+ */
+void fish_trace_count(fish_counter_t counter, uint64_t n);
+
+/**
+ * @brief Current value of a counter.
+ */
+uint64_t fish_trace_counter(fish_counter_t counter);
+
+/**
+ * @brief Write the report now (also done at exit).
+ *
+ * @return int 0 on success or when tracing is off, -1 on I/O error.
+ */
+int fish_trace_write(void);
+
+#define FISH_TRACE_BEGIN(name) uint64_t name = fish_trace_begin()
+#define FISH_TRACE_END(stage, name, items) \
+    do { if (name) fish_trace_end((stage), (name), (uint64_t)(items)); } while (0)
+
+#else
+
+static inline int fish_trace_enable(ccstring path, fish_trace_format_t format) {
+    (void)path;
+    (void)format;
+    return -1;
+}
+static inline int fish_trace_on(void) { return 0; }
+static inline void fish_trace_count(fish_counter_t counter, uint64_t n) {
+    (void)counter;
+    (void)n;
+}
+static inline uint64_t fish_trace_counter(fish_counter_t counter) {
+    (void)counter;
+    return 0;
+}
+static inline int fish_trace_write(void) { return 0; }
+
+#define FISH_TRACE_BEGIN(name) ((void)0)
+#define FISH_TRACE_END(stage, name, items) ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_TRACE_H */
@@ -0,0 +1,100 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_WORKSPACE_H
+#define FOSSIL_APP_WORKSPACE_H
+
+#include "dataset.h"
+
+/* Directory holding every named dataset */
+#define FISH_DATASET_DIR "datasets"
+
+/*
+ * Dataset workspace
+ *
+ * Every regular file in datasets/ is a dataset, named by its file name
+ * with or without the extension: `--dataset s3` finds datasets/s3, then
+ * datasets/s3.fcol, then datasets/s3.dataset, which is where import puts
+ * the files it registers. Commands use datasets/current.dataset until a
+ * dataset is selected.
+ *
+ * Writers never modify a file in place. They write a temp file private
+ * to the process and rename it over the target, so a reader keeps the
+ * snapshot it opened. Commands that rewrite a dataset, or write files
+ * derived from it, hold an exclusive lock on it (datasets/.<file>.lock)
+ * while they run. Jobs on different datasets run side by side; jobs on
+ * the same one take turns.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Whether @p name can name a dataset: non-empty, no path
+ *        separators and not starting with '.'.
+ */
+int fish_workspace_valid_name(ccstring name);
+
+/**
+ * @brief Select the dataset later commands operate on.
+ *
+ * @param name Dataset name, NULL for datasets/current.dataset.
+ * @return int 0 on success, -1 if the name is invalid.
+ */
+int fish_workspace_select(ccstring name);
+
+/**
+ * @brief Path of the selected dataset.
+ */
+ccstring fish_workspace_path(void);
+
+/**
+ * @brief Path for a dataset given on the command line: an existing file
+ *        as is, otherwise the dataset of that name.
+ *
+ * @return ccstring Valid until the command ends (scratch), NULL on OOM.
+ */
+ccstring fish_workspace_resolve(ccstring name_or_path);
+
+/**
+ * @brief Path of a file derived from the selected dataset.
+ *
+ * "datasets/<role>.dataset" while datasets/current.dataset is selected,
+ * as before, and "datasets/<name>.<role>.dataset" for a named dataset, so
+ * splits of different datasets do not overwrite each other.
+ *
+ * @return cstring Free with fossil_io_cstring_free(); NULL on OOM.
+ */
+cstring fish_workspace_output(ccstring role);
+
+typedef struct {
+    intptr_t handle;    /* file descriptor or HANDLE, -1 when not held */
+} fish_workspace_lock_t;
+
+/**
+ * @brief Take the exclusive lock of the selected dataset, waiting for
+ *        other jobs holding it.
+ *
+ * @return int 0 on success (also when datasets/ does not exist yet), -1
+ *         if the lock file cannot be opened or locked.
+ */
+int fish_workspace_lock(fish_workspace_lock_t *lock);
+
+void fish_workspace_unlock(fish_workspace_lock_t *lock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_WORKSPACE_H */
@@ -0,0 +1,105 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_APP_ZCHAIN_H
+#define FOSSIL_APP_ZCHAIN_H
+
+#include "dataset.h"
+
+#include <stddef.h>
+
+/*
+ * Compressed chain (".jfchain" written with format "zchain")
+ *
+ *   "FISHZCH1" version block_size keyframe count
+ *   chain record            chain fields outside the commit array
+ *   block record[count]
+ *   uint64 offset[count], uint64 directory offset, "FISHZCH1"
+ *
+ * Every block is XORed against a prediction, then the result is stored
+ * as (zero run, literal run) pairs with varint lengths. A keyframe
+ * (every FISH_ZCHAIN_KEYFRAME blocks) is predicted as all zeros, so its
+ * fixed-size text fields shrink to their used bytes. The other blocks
+ * are predicted from the previous block, with commit_index + 1 and the
+ * previous commit hash as the first parent. Repeated text, tree hashes
+ * and linear parent links therefore cost almost nothing. Random access
+ * decodes at most one keyframe interval.
+ */
+#define FISH_ZCHAIN_MAGIC "FISHZCH1"
+#define FISH_ZCHAIN_VERSION 1
+
+#ifndef FISH_ZCHAIN_KEYFRAME
+#define FISH_ZCHAIN_KEYFRAME 64
+#endif
+
+/* Chain fields around the commit array, which every format stores apart */
+#define FISH_CHAIN_HEAD offsetof(fossil_ai_jellyfish_chain_t, commits)
+#define FISH_CHAIN_TAIL (FISH_CHAIN_HEAD + sizeof(((fossil_ai_jellyfish_chain_t *)0)->commits))
+#define FISH_CHAIN_FIELDS (sizeof(fossil_ai_jellyfish_chain_t) - (FISH_CHAIN_TAIL - FISH_CHAIN_HEAD))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Random-access reader over a compressed chain.
+ */
+typedef struct {
+    fossil_io_file_t file;
+    uint64_t count;
+    uint32_t keyframe;
+    uint64_t *offset;               /* count + 1 entries; the last one ends the blocks */
+    uint8_t *record;                /* scratch for one encoded record */
+    size_t record_cap;
+    fossil_ai_jellyfish_block_t last;   /* most recently decoded block */
+    uint64_t last_pos;              /* UINT64_MAX when none */
+} fish_zchain_t;
+
+/**
+ * @brief Check whether @p path holds a compressed chain.
+ */
+int fish_zchain_probe(ccstring path);
+
+/**
+ * @brief Write @p chain to @p path in compressed form (atomic replace).
+ */
+int fish_zchain_save(const fossil_ai_jellyfish_chain_t *chain, ccstring path);
+
+/**
+ * @brief Open a compressed chain and read its directory.
+ *
+ * @param chain If non-NULL, receives the chain fields (commits untouched).
+ */
+int fish_zchain_open(fish_zchain_t *z, ccstring path, fossil_ai_jellyfish_chain_t *chain);
+
+/**
+ * @brief Decode the block at @p pos; reading in order decodes each block once.
+ */
+int fish_zchain_read(fish_zchain_t *z, uint64_t pos, fossil_ai_jellyfish_block_t *out);
+
+void fish_zchain_close(fish_zchain_t *z);
+
+/**
+ * @brief Load a chain saved in any format.
+ *
+ * Refs are resolved through the commit store (store.h) and compressed
+ * files are decoded here; anything else goes to
+ * fossil_ai_jellyfish_load().
+ */
+int fish_chain_load(fossil_ai_jellyfish_chain_t *chain, ccstring path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOSSIL_APP_ZCHAIN_H */
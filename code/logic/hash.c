@@ -0,0 +1,317 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/hash.h"
+
+/* ---------------- XXH64 ---------------- */
+
+#define P1 0x9E3779B185EBCA87ull
+#define P2 0xC2B2AE3D27D4EB4Full
+#define P3 0x165667B19E3779F9ull
+#define P4 0x85EBCA77C2B2AE63ull
+#define P5 0x27D4EB2F165667C5ull
+
+static uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t read64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+static uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * P2;
+    acc = rotl64(acc, 31);
+    return acc * P1;
+}
+
+static uint64_t merge64(uint64_t acc, uint64_t val) {
+    acc ^= round64(0, val);
+    return acc * P1 + P4;
+}
+
+uint64_t fish_hash64(const void *data, size_t len, uint64_t seed) {
+    const uint8_t *p = (const uint8_t *)data;
+    const uint8_t *end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        uint64_t v1 = seed + P1 + P2;
+        uint64_t v2 = seed + P2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - P1;
+        const uint8_t *limit = end - 32;
+        do {
+            v1 = round64(v1, read64(p));      p += 8;
+            v2 = round64(v2, read64(p));      p += 8;
+            v3 = round64(v3, read64(p));      p += 8;
+            v4 = round64(v4, read64(p));      p += 8;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = merge64(h, v1);
+        h = merge64(h, v2);
+        h = merge64(h, v3);
+        h = merge64(h, v4);
+    } else {
+        h = seed + P5;
+    }
+
+    h += (uint64_t)len;
+
+    while (p + 8 <= end) {
+        h ^= round64(0, read64(p));
+        h = rotl64(h, 27) * P1 + P4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * P1;
+        h = rotl64(h, 23) * P2 + P3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * P5;
+        h = rotl64(h, 11) * P1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+/* ---------------- SHA-256 ---------------- */
+
+static const uint32_t SHA_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint32_t rotr32(uint32_t x, int r) {
+    return (x >> r) | (x << (32 - r));
+}
+
+static void sha256_block(uint32_t h[8], const uint8_t *p) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++)
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = k + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + SHA_K[i] + w[i];
+        uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+void fish_sha256_init(fish_sha256_t *sha) {
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(sha->h, iv, sizeof(iv));
+    sha->bytes = 0;
+    sha->used = 0;
+}
+
+void fish_sha256_update(fish_sha256_t *sha, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    sha->bytes += len;
+    if (sha->used) {
+        size_t n = 64 - sha->used < len ? 64 - sha->used : len;
+        memcpy(sha->block + sha->used, p, n);
+        sha->used += n;
+        p += n;
+        len -= n;
+        if (sha->used < 64) return;
+        sha256_block(sha->h, sha->block);
+        sha->used = 0;
+    }
+    for (; len >= 64; p += 64, len -= 64) sha256_block(sha->h, p);
+    if (len) memcpy(sha->block, p, len);
+    sha->used = len;
+}
+
+void fish_sha256_final(fish_sha256_t *sha, uint8_t digest[FISH_SHA256_SIZE]) {
+    uint64_t bits = sha->bytes * 8;
+    uint8_t pad[72] = { 0x80 };
+    /* pad to 56 mod 64, then the big-endian bit count */
+    size_t n = (sha->used < 56 ? 56 : 120) - sha->used;
+    for (int i = 0; i < 8; i++) pad[n + i] = (uint8_t)(bits >> (56 - 8 * i));
+    fish_sha256_update(sha, pad, n + 8);
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = (uint8_t)(sha->h[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(sha->h[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(sha->h[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)sha->h[i];
+    }
+}
+
+/* ---------------- xoshiro256** ---------------- */
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void fish_rng_seed(fish_rng_t *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(&seed);
+}
+
+uint64_t fish_rng_next(fish_rng_t *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+double fish_rng_unit(fish_rng_t *rng) {
+    return (double)(fish_rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* ---------------- hash set ---------------- */
+
+static int hashset_alloc(fish_hashset_t *set, size_t cap) {
+    set->slots = (fish_hashset_entry_t *)fossil_sys_memory_calloc(cap, sizeof(fish_hashset_entry_t));
+    if (!set->slots) return -1;
+    set->cap = cap;
+    return 0;
+}
+
+static int hashset_grow(fish_hashset_t *set) {
+    fish_hashset_entry_t *old = set->slots;
+    size_t old_cap = set->cap;
+
+    if (hashset_alloc(set, old_cap * 2) != 0) {
+        set->slots = old;
+        set->cap = old_cap;
+        return -1;
+    }
+    for (size_t i = 0; i < old_cap; i++) {
+        if (!old[i].digest) continue;
+        size_t idx = (size_t)old[i].digest & (set->cap - 1);
+        while (set->slots[idx].digest) idx = (idx + 1) & (set->cap - 1);
+        set->slots[idx] = old[i];
+    }
+    fossil_sys_memory_free(old);
+    return 0;
+}
+
+int fish_hashset_init(fish_hashset_t *set, size_t expected,
+                      fish_hashset_resolve_fn resolve, void *ctx) {
+    fossil_sys_memory_zero(set, sizeof(*set));
+    set->resolve = resolve;
+    set->ctx = ctx;
+
+    size_t want = expected * 100 / FISH_HASHSET_LOAD + 1;
+    size_t cap = 1024;
+    while (cap < want) cap *= 2;
+    return hashset_alloc(set, cap);
+}
+
+/* Find @p key's slot: 1 = present at *idx, 0 = absent (*idx is the free slot), -1 = error. */
+static int hashset_probe(fish_hashset_t *set, uint64_t digest, fish_slice_t key, size_t *idx) {
+    size_t i = (size_t)digest & (set->cap - 1);
+    while (set->slots[i].digest) {
+        fish_hashset_entry_t *e = &set->slots[i];
+        if (e->digest == digest && e->len == key.len) {
+            fish_slice_t seen;
+            if (!set->resolve) { *idx = i; return 1; } /* digest-only mode */
+            if (set->resolve(set->ctx, e->ref, (size_t)e->len, &seen) != 0) return -1;
+            if (key.len == 0 || fossil_sys_memory_compare(seen.ptr, key.ptr, key.len) == 0) {
+                *idx = i;
+                return 1;
+            }
+        }
+        i = (i + 1) & (set->cap - 1);
+    }
+    *idx = i;
+    return 0;
+}
+
+int fish_hashset_insert(fish_hashset_t *set, uint64_t digest, fish_slice_t key, uint64_t ref) {
+    size_t idx;
+    if (digest == 0) digest = 1; /* 0 is the empty marker */
+
+    if ((set->count + 1) * 100 > set->cap * FISH_HASHSET_LOAD && hashset_grow(set) != 0)
+        return -1;
+
+    int found = hashset_probe(set, digest, key, &idx);
+    if (found != 0) return found < 0 ? -1 : 0;
+
+    set->slots[idx].digest = digest;
+    set->slots[idx].ref = ref;
+    set->slots[idx].len = key.len;
+    set->count++;
+    return 1;
+}
+
+int fish_hashset_lookup(fish_hashset_t *set, uint64_t digest, fish_slice_t key, uint64_t *ref) {
+    size_t idx;
+    if (digest == 0) digest = 1;
+
+    int found = hashset_probe(set, digest, key, &idx);
+    if (found == 1 && ref) *ref = set->slots[idx].ref;
+    return found;
+}
+
+void fish_hashset_clear(fish_hashset_t *set) {
+    if (set->slots) fossil_sys_memory_zero(set->slots, set->cap * sizeof(fish_hashset_entry_t));
+    set->count = 0;
+}
+
+void fish_hashset_free(fish_hashset_t *set) {
+    fossil_sys_memory_free(set->slots);
+    fossil_sys_memory_zero(set, sizeof(*set));
+}
+
+size_t fish_hashset_bytes_per_key(void) {
+    return sizeof(fish_hashset_entry_t) * 100 / FISH_HASHSET_LOAD;
+}
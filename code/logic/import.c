@@ -11,18 +11,221 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
-#include "fossil/code/commands.h"
+#include "fossil/code/arena.h"
+#include "fossil/code/columnar.h"
+#include "fossil/code/meta.h"
+#include "fossil/code/thread.h"
 
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
 
+typedef enum { IMPORT_COPY, IMPORT_FSON, IMPORT_COLUMNAR } import_kind_t;
+
+/* One source file; workers fill in everything below dst. */
+typedef struct {
+    ccstring src;
+    cstring dst;
+    ccstring error;             /* why the import failed, NULL on success */
+    uint64_t bytes;             /* source bytes hashed */
+    uint8_t hash[FISH_SHA256_SIZE];
+} import_job_t;
+
+typedef struct {
+    import_job_t *job;
+    size_t jobs;
+    import_kind_t kind;
+    volatile size_t next;
+} import_ctx_t;
+
+/* Buffered read that also feeds the content hash. */
+static size_t read_hashed(fossil_io_file_t *in, import_job_t *job, fish_sha256_t *sha, char *buf, size_t cap) {
+    size_t n = fossil_io_file_read(in, buf, 1, cap);
+    fish_sha256_update(sha, buf, n);
+    job->bytes += n;
+    return n;
+}
+
+/* Byte copy for formats that are stored as is. */
+static int import_copy(import_job_t *job, fossil_io_file_t *in, fish_sha256_t *sha, fish_row_writer_t *out) {
+    fossil_sys_memory_t buffer = fossil_sys_memory_alloc(FISH_ROW_CHUNK_SIZE);
+    int rc = buffer ? 0 : -1;
+    size_t n;
+    while (rc == 0 && (n = read_hashed(in, job, sha, (char *)buffer, FISH_ROW_CHUNK_SIZE)) > 0)
+        rc = fish_row_writer_put(out, (const char *)buffer, n);
+    fossil_sys_memory_free(buffer);
+    return rc;
+}
+
+/* FSON holds varint length-prefixed rows (see export); store them as text rows. */
+static int import_fson(import_job_t *job, fossil_io_file_t *in, fish_sha256_t *sha, fish_row_writer_t *out) {
+    /* records are decoded from a window that grows to the longest row */
+    size_t cap = FISH_ROW_CHUNK_SIZE;
+    char *buf = (char *)fossil_sys_memory_alloc(cap);
+    size_t have = 0;
+    int rc = buf ? 0 : -1;
+    int eof = 0;
+    while (rc == 0 && !(eof && have == 0)) {
+        if (!eof && have < cap) {
+            size_t n = read_hashed(in, job, sha, buf + have, cap - have);
+            if (n == 0) eof = 1;
+            have += n;
+        }
+        size_t pos = 0;
+        uint64_t len = 0;
+        size_t head;
+        while (rc == 0 && (head = fish_varint_read(buf + pos, have - pos, &len)) > 0 &&
+               len <= have - pos - head) {
+            rc = fish_row_writer_write(out, buf + pos + head, (size_t)len);
+            pos += head + (size_t)len;
+        }
+        if (rc != 0) break;
+        if (eof && pos < have) {
+            job->error = "truncated FSON record";
+            rc = -1;
+            break;
+        }
+        memmove(buf, buf + pos, have - pos);
+        have -= pos;
+        if (pos == 0 && have == cap) {
+            /* one record longer than the window */
+            size_t need = cap * 2;
+            if (head > 0 && len + head > need) need = (size_t)len + head;
+            char *grown = (char *)fossil_sys_memory_realloc(buf, need);
+            if (!grown) rc = -1;
+            else {
+                buf = grown;
+                cap = need;
+            }
+        }
+    }
+    fossil_sys_memory_free(buf);
+    return rc;
+}
+
+typedef struct {
+    import_job_t *job;
+    fish_sha256_t *sha;
+} import_hash_t;
+
+static void import_watch(void *ctx, const char *data, size_t len) {
+    import_hash_t *hash = (import_hash_t *)ctx;
+    fish_sha256_update(hash->sha, data, len);
+    hash->job->bytes += len;
+}
+
+/*
+ * CSV is parsed once here and stored typed, so later commands skip strtod.
+ * The converter hashes the pages it maps as it parses them; only what it
+ * did not read as text (a columnar source) is hashed from the stream.
+ */
+static int import_columnar(import_job_t *job, fossil_io_file_t *in, fish_sha256_t *sha) {
+    import_hash_t hash = { job, sha };
+    int64_t watched = fish_col_convert_watched(job->src, job->dst, import_watch, &hash);
+    if (watched < 0) return -1;
+    if (fish_fseek64(in->file, (long long)watched, SEEK_SET) != 0) return -1;
+
+    char *buf = (char *)fossil_sys_memory_alloc(FISH_ROW_CHUNK_SIZE);
+    if (!buf) return -1;
+    while (read_hashed(in, job, sha, buf, FISH_ROW_CHUNK_SIZE) > 0) {}
+    fossil_sys_memory_free(buf);
+    return 0;
+}
+
+static void import_one(import_job_t *job, import_kind_t kind) {
+    fossil_io_file_t in = {0};
+    fish_row_writer_t out;
+    fish_sha256_t sha;
+    int rc;
+
+    if (fossil_io_file_open(&in, job->src, "rb") != 0) {
+        job->error = "cannot open input file";
+        return;
+    }
+    fish_sha256_init(&sha);
+    if (kind == IMPORT_COLUMNAR) {
+        rc = import_columnar(job, &in, &sha);
+    } else if (fish_row_writer_open_raw(&out, job->dst) != 0) {
+        rc = -1;
+    } else {
+        /* the target is only replaced once the whole file made it */
+        rc = kind == IMPORT_FSON ? import_fson(job, &in, &sha, &out) : import_copy(job, &in, &sha, &out);
+        if (rc != 0) fish_row_writer_abort(&out);
+        else rc = fish_row_writer_commit(&out);
+    }
+    fossil_io_file_close(&in);
+
+    if (rc != 0 && !job->error) job->error = "cannot write the output";
+    if (rc == 0) fish_sha256_final(&sha, job->hash);
+}
+
+static void import_worker(void *arg, size_t index) {
+    import_ctx_t *ctx = (import_ctx_t *)arg;
+    (void)index;
+    for (;;) {
+        size_t i = fish_thread_claim(&ctx->next);
+        if (i >= ctx->jobs) break;
+        if (!ctx->job[i].error) import_one(&ctx->job[i], ctx->kind); /* duplicates are skipped */
+    }
+}
+
+/* Directory, wildcard pattern or plain file; a plain path is kept even if missing. */
+static int collect_sources(fish_path_list_t *list, ccstring file_path) {
+    if (fish_file_is_directory(file_path)) return fish_path_list_dir(list, file_path);
+    if (strpbrk(file_path, "*?[")) return fish_path_list_glob(list, file_path);
+    return fish_path_list_add(list, fossil_io_cstring_create(file_path));
+}
+
+/* "datasets/<name>" for @p src, named after its base file name. */
+static cstring import_target(ccstring src, import_kind_t kind) {
+    ccstring base = strrchr(src, '/');
+#ifdef _WIN32
+    ccstring back = strrchr(src, '\\');
+    if (back && (!base || back > base)) base = back;
+#endif
+    base = base ? base + 1 : src;
+    ccstring dot = strrchr(base, '.');
+    int stem = dot && dot != base ? (int)(dot - base) : (int)strlen(base);
+
+    if (kind == IMPORT_COLUMNAR) return fish_scratch_format("datasets/%.*s.fcol", stem, base);
+    if (kind == IMPORT_FSON) return fish_scratch_format("datasets/%.*s.dataset", stem, base);
+    return fish_scratch_format("datasets/%s", base);
+}
+
+/* Two sources with the same base name would race for one target. */
+static int mark_duplicates(import_job_t *job, size_t jobs) {
+    fish_arena_t arena;
+    fish_intern_t names;
+    int rc = 0;
+
+    fish_arena_init(&arena, 0);
+    if (fish_intern_init(&names, &arena, jobs) != 0) {
+        fish_arena_free(&arena);
+        return -1;
+    }
+    for (size_t i = 0; rc == 0 && i < jobs; i++) {
+        fish_slice_t dst = { job[i].dst, strlen(job[i].dst) };
+        int added = fish_intern_add(&names, dst, NULL);
+        if (added < 0) rc = -1;
+        else if (added == 0) job[i].error = "another source has the same name";
+    }
+    fish_intern_free(&names);
+    fish_arena_free(&arena);
+    return rc;
+}
+
 /**
  * @brief Import a dataset from a file.
  *
- * This function validates the file and format, then copies the dataset
- * into the local "datasets/" directory under a canonical name derived
- * from the input filename. No parsing is performed.
+ * This function validates the file and format, then stores the dataset
+ * in the local "datasets/" directory under a canonical name derived from
+ * the input filename. CSV is converted into the columnar format
+ * ("<stem>.fcol"), FSON is decoded into text rows ("<stem>.dataset") and
+ * JSON is copied without parsing.
+ *
+ * @p file_path may also be a directory (its regular files) or a wildcard
+ * pattern; the files are then imported concurrently, one per worker.
+ * Each file's SHA-256 is computed while it is read.
  */
 int fish_dataset_import(const char *file_path, const char *format)
 {
@@ -32,18 +235,45 @@ int fish_dataset_import(const char *file_path, const char *format)
     }
 
     /* Validate format (case-insensitive) */
-    if (!fossil_io_cstring_iequals_safe(format, "csv", 16) &&
-        !fossil_io_cstring_iequals_safe(format, "json", 16)) {
+    import_kind_t kind;
+    if (fossil_io_cstring_iequals_safe(format, "csv", 16)) kind = IMPORT_COLUMNAR;
+    else if (fossil_io_cstring_iequals_safe(format, "fson", 16)) kind = IMPORT_FSON;
+    else if (fossil_io_cstring_iequals_safe(format, "json", 16)) kind = IMPORT_COPY;
+    else {
         fossil_io_printf("{red,bold}fish_dataset_import: unsupported format '{yellow}%s{red}'.{normal}\n", format);
         return -1;
     }
 
-    /* Extract base filename using safe substring */
-    const char *base = strrchr(file_path, '/');
-    base = base ? base + 1 : file_path;
+    fish_path_list_t sources = { NULL, 0, 0 };
+    if (collect_sources(&sources, file_path) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_import: cannot list '{yellow}%s{red}'.{normal}\n", file_path);
+        fish_path_list_free(&sources);
+        return -1;
+    }
+    if (sources.count == 0) {
+        fossil_io_printf("{red,bold}fish_dataset_import: no files match '{yellow}%s{red}'.{normal}\n", file_path);
+        fish_path_list_free(&sources);
+        return -1;
+    }
 
-    /* Build output path using Fossil IO cstring */
-    cstring out_path = fossil_io_cstring_format_safe(512, "datasets/%s", base);
+    import_ctx_t ctx;
+    fossil_sys_memory_zero(&ctx, sizeof(ctx));
+    ctx.job = (import_job_t *)fossil_sys_memory_calloc(sources.count, sizeof(import_job_t));
+    ctx.jobs = sources.count;
+    ctx.kind = kind;
+    int rc = ctx.job ? 0 : -1;
+    for (size_t i = 0; rc == 0 && i < ctx.jobs; i++) {
+        ctx.job[i].src = sources.path[i];
+        ctx.job[i].dst = import_target(sources.path[i], kind);
+        if (!ctx.job[i].dst) rc = -1;
+    }
+    if (rc == 0) rc = mark_duplicates(ctx.job, ctx.jobs);
+    if (rc != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_import: out of memory.{normal}\n");
+        fossil_sys_memory_free(ctx.job);
+        fish_path_list_free(&sources);
+        return -1;
+    }
 
     /* Ensure datasets directory exists (best-effort) */
 #if defined(_WIN32)
@@ -52,49 +282,34 @@ int fish_dataset_import(const char *file_path, const char *format)
     mkdir("datasets", 0755);
 #endif
 
-    fossil_io_file_t src_stream = {0};
-    fossil_io_file_t dst_stream = {0};
-
-    /* Open source file */
-    if (fossil_io_file_open(&src_stream, file_path, "rb") != 0) {
-        fossil_io_printf("{red,bold}fish_dataset_import: cannot open input file '{yellow}%s{red}'.{normal}\n", file_path);
-        fossil_io_cstring_free(out_path);
-        return -1;
-    }
+    size_t workers = fish_thread_count();
+    if (workers > ctx.jobs) workers = ctx.jobs;
+    uint64_t start = fish_clock_ns();
+    fish_thread_run(workers, import_worker, &ctx);
+    double secs = (double)(fish_clock_ns() - start) / 1e9;
 
-    /* Open destination file */
-    if (fossil_io_file_open(&dst_stream, out_path, "wb") != 0) {
-        fossil_io_file_close(&src_stream);
-        fossil_io_printf("{red,bold}fish_dataset_import: cannot write '{yellow}%s{red}'.{normal}\n", out_path);
-        fossil_io_cstring_free(out_path);
-        return -1;
+    size_t imported = 0;
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < ctx.jobs; i++) {
+        import_job_t *job = &ctx.job[i];
+        if (job->error) {
+            fossil_io_printf("{red,bold}fish_dataset_import: '{yellow}%s{red}': %s.{normal}\n", job->src, job->error);
+            continue;
+        }
+        char hash_hex[2 * FISH_SHA256_SIZE + 1];
+        for (size_t b = 0; b < FISH_SHA256_SIZE; ++b)
+            sprintf(hash_hex + 2 * b, "%02x", job->hash[b]);
+        fossil_io_printf("{green,bold}fish_dataset_import: imported '{yellow}%s{green}' as '{yellow}%s{green}' ({cyan}%s{green} format).{normal}\n",
+               job->src, job->dst, format);
+        fossil_io_printf("{blue}Content hash (sha256): {yellow}%s{normal}\n", hash_hex);
+        imported++;
+        bytes += job->bytes;
     }
+    if (ctx.jobs > 1)
+        fossil_io_printf("{blue}fish_dataset_import: %zu of %zu files, %.1f MiB in %.3fs on %zu workers{normal}\n",
+                         imported, ctx.jobs, (double)bytes / (1024.0 * 1024.0), secs, workers);
 
-    /* Copy contents using fossil_sys_memory_t and memory API */
-    size_t buffer_size = 4096;
-    fossil_sys_memory_t buffer = fossil_sys_memory_alloc(buffer_size);
-    size_t n;
-    while ((n = fossil_io_file_read(&src_stream, buffer, 1, buffer_size)) > 0) {
-        fossil_io_file_write(&dst_stream, buffer, 1, n);
-    }
-    fossil_sys_memory_free(buffer);
-
-    fossil_io_file_close(&src_stream);
-    fossil_io_file_close(&dst_stream);
-
-    /* Generate hash for imported file (content addressing) */
-    uint8_t hash_out[FOSSIL_JELLYFISH_HASH_SIZE] = {0};
-    fossil_ai_jellyfish_hash(file_path, out_path, hash_out);
-
-    /* Print hash as hex string for diagnostics */
-    char hash_hex[2 * FOSSIL_JELLYFISH_HASH_SIZE + 1] = {0};
-    for (size_t i = 0; i < FOSSIL_JELLYFISH_HASH_SIZE; ++i)
-        sprintf(hash_hex + 2 * i, "%02x", hash_out[i]);
-
-    fossil_io_printf("{green,bold}fish_dataset_import: imported '{yellow}%s{green}' as '{yellow}%s{green}' ({cyan}%s{green} format).{normal}\n",
-           file_path, out_path, format);
-    fossil_io_printf("{blue}Content hash: {yellow}%s{normal}\n", hash_hex);
-
-    fossil_io_cstring_free(out_path);
-    return 0;
+    fossil_sys_memory_free(ctx.job);
+    fish_path_list_free(&sources);
+    return imported == ctx.jobs ? 0 : -1;
 }
@@ -0,0 +1,483 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/index.h"
+#include "fossil/code/scan.h"
+#include "fossil/code/trace.h"
+
+#define INDEX_MAGIC "FISHIDX1"
+#define INDEX_SEED 0x6a666964ull /* "jfid" */
+#define INDEX_KEY_STACK 512
+#define INDEX_INPUT_MAX sizeof(((fossil_ai_jellyfish_block_t *)0)->input)
+
+static fossil_ai_jellyfish_block_t *block_at(const fish_chain_index_t *index, uint32_t pos) {
+    return &index->chain->commits[pos];
+}
+
+static int hash_compare(const fish_chain_index_t *index, uint32_t a, uint32_t b) {
+    return memcmp(block_at(index, a)->identity.commit_hash, block_at(index, b)->identity.commit_hash,
+                  FOSSIL_JELLYFISH_HASH_SIZE);
+}
+
+size_t fish_chain_index_normalize(const char *in, size_t len, char *out) {
+    fish_scan_cursor_t words;
+    fish_slice_t text = { in, len }, word;
+    size_t n = 0;
+    fish_scan_cursor_init(&words, text, FISH_SCAN_SPACE, 0);
+    while (fish_scan_cursor_next(&words, &word)) {
+        if (n > 0) out[n++] = ' ';
+        fish_scan_lower(out + n, word.ptr, word.len);
+        n += word.len;
+    }
+    return n;
+}
+
+static int commit_resolve(void *ctx, uint64_t ref, size_t len, fish_slice_t *out) {
+    const fish_chain_index_t *index = (const fish_chain_index_t *)ctx;
+    if (ref >= index->count) return -1;
+    out->ptr = (const char *)&block_at(index, (uint32_t)ref)->identity.commit_index;
+    out->len = sizeof(uint32_t);
+    return 0;
+}
+
+static uint64_t chain_digest(const fossil_ai_jellyfish_chain_t *chain) {
+    uint64_t h = fish_hash64(&chain->count, sizeof(chain->count), INDEX_SEED);
+    for (size_t i = 0; i < chain->count; ++i)
+        h = fish_hash64(chain->commits[i].identity.commit_hash, FOSSIL_JELLYFISH_HASH_SIZE, h);
+    return h;
+}
+
+/* ---------------- building ---------------- */
+
+static void lookups_free(fish_chain_index_t *index) {
+    fish_hashset_free(&index->commits);
+    fish_intern_free(&index->inputs);
+    fish_arena_free(&index->arena);
+    fossil_sys_memory_free(index->by_hash);
+    fossil_sys_memory_free(index->best);
+    index->by_hash = NULL;
+    index->best = NULL;
+    index->count = 0;
+    index->cap = 0;
+    index->best_cap = 0;
+}
+
+static int lookups_init(fish_chain_index_t *index, fossil_ai_jellyfish_chain_t *chain) {
+    size_t expected = chain->count ? chain->count : 16;
+    index->chain = chain;
+    fish_arena_init(&index->arena, 0);
+    if (fish_intern_init(&index->inputs, &index->arena, expected) != 0) return -1;
+    return fish_hashset_init(&index->commits, expected, commit_resolve, index);
+}
+
+static int reserve(fish_chain_index_t *index, size_t need) {
+    if (need <= index->cap) return 0;
+    size_t cap = index->cap ? index->cap : 64;
+    while (cap < need) cap *= 2;
+    uint32_t *grown = (uint32_t *)fossil_sys_memory_realloc(index->by_hash, cap * sizeof(uint32_t));
+    if (!grown) return -1;
+    index->by_hash = grown;
+    index->cap = cap;
+    return 0;
+}
+
+/* index everything about one commit except its place in by_hash */
+static int index_keys(fish_chain_index_t *index, uint32_t pos) {
+    const fossil_ai_jellyfish_block_t *b = block_at(index, pos);
+
+    uint32_t ci = b->identity.commit_index;
+    fish_slice_t key = { (const char *)&ci, sizeof(ci) };
+    if (fish_hashset_insert(&index->commits, fish_hash64(&ci, sizeof(ci), INDEX_SEED), key, pos) < 0)
+        return -1;
+    if (!b->attributes.valid) return 0;
+
+    char stack[INDEX_KEY_STACK];
+    size_t len = strnlen(b->input, sizeof(b->input));
+    char *buf = len <= sizeof(stack) ? stack : (char *)fossil_sys_memory_alloc(len);
+    if (!buf) return -1;
+    fish_slice_t norm = { buf, fish_chain_index_normalize(b->input, len, buf) };
+    uint32_t id = 0;
+    int added = fish_intern_add(&index->inputs, norm, &id);
+    if (buf != stack) fossil_sys_memory_free(buf);
+    if (added < 0) return -1;
+
+    if (id >= index->best_cap) {
+        size_t cap = index->best_cap ? index->best_cap * 2 : 64;
+        while (cap <= id) cap *= 2;
+        uint32_t *grown = (uint32_t *)fossil_sys_memory_realloc(index->best, cap * sizeof(uint32_t));
+        if (!grown) return -1;
+        index->best = grown;
+        index->best_cap = cap;
+    }
+    if (added || b->attributes.confidence >= block_at(index, index->best[id])->attributes.confidence)
+        index->best[id] = pos;
+    return 0;
+}
+
+/* bottom-up merge sort of by_hash[0..n) by commit hash */
+static int sort_by_hash(fish_chain_index_t *index, size_t n) {
+    if (n < 2) return 0;
+    uint32_t *tmp = (uint32_t *)fossil_sys_memory_alloc(n * sizeof(uint32_t));
+    if (!tmp) return -1;
+    uint32_t *src = index->by_hash, *dst = tmp;
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t a = lo, b = mid, o = lo;
+            while (a < mid && b < hi) dst[o++] = hash_compare(index, src[b], src[a]) < 0 ? src[b++] : src[a++];
+            while (a < mid) dst[o++] = src[a++];
+            while (b < hi) dst[o++] = src[b++];
+        }
+        uint32_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != index->by_hash) fossil_sys_memory_copy(index->by_hash, src, n * sizeof(uint32_t));
+    fossil_sys_memory_free(tmp);
+    return 0;
+}
+
+/* first by_hash slot whose hash is not below @p hash */
+static size_t hash_lower_bound(const fish_chain_index_t *index, const uint8_t *hash) {
+    size_t lo = 0, hi = index->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (memcmp(block_at(index, index->by_hash[mid])->identity.commit_hash, hash, FOSSIL_JELLYFISH_HASH_SIZE) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void tags_rebind(fish_chain_index_t *index) {
+    size_t kept = 0;
+    for (size_t i = 0; i < index->tag_count; ++i) {
+        fish_index_tag_t *tag = &index->tags[i];
+        const fossil_ai_jellyfish_block_t *b = fish_chain_index_hash(index, tag->hash);
+        if (!b) {
+            fossil_io_cstring_free(tag->name);
+            continue;
+        }
+        tag->pos = (uint32_t)(b - index->chain->commits);
+        index->tags[kept++] = *tag;
+    }
+    index->tag_count = kept;
+}
+
+static int index_rebuild(fish_chain_index_t *index, fossil_ai_jellyfish_chain_t *chain) {
+    FISH_TRACE_BEGIN(trace);
+    lookups_free(index);
+    if (lookups_init(index, chain) != 0 || reserve(index, chain->count) != 0) return -1;
+    for (size_t pos = 0; pos < chain->count; ++pos) {
+        index->by_hash[pos] = (uint32_t)pos;
+        index->count = pos + 1;
+        if (index_keys(index, (uint32_t)pos) != 0) return -1;
+    }
+    if (sort_by_hash(index, index->count) != 0) return -1;
+    tags_rebind(index);
+    FISH_TRACE_END(FISH_STAGE_HASH, trace, chain->count);
+    return 0;
+}
+
+int fish_chain_index_build(fish_chain_index_t *index, fossil_ai_jellyfish_chain_t *chain) {
+    fossil_sys_memory_zero(index, sizeof(*index));
+    return index_rebuild(index, chain);
+}
+
+int fish_chain_index_sync(fish_chain_index_t *index) {
+    if (index->chain->count < index->count) return index_rebuild(index, index->chain);
+    if (reserve(index, index->chain->count) != 0) return -1;
+
+    while (index->count < index->chain->count) {
+        uint32_t pos = (uint32_t)index->count;
+        size_t at = hash_lower_bound(index, block_at(index, pos)->identity.commit_hash);
+        memmove(index->by_hash + at + 1, index->by_hash + at, (index->count - at) * sizeof(uint32_t));
+        index->by_hash[at] = pos;
+        index->count++;
+        if (index_keys(index, pos) != 0) return -1;
+    }
+    return 0;
+}
+
+/* ---------------- lookups ---------------- */
+
+fossil_ai_jellyfish_block_t *fish_chain_index_commit(const fish_chain_index_t *index, uint32_t commit_index) {
+    fish_slice_t key = { (const char *)&commit_index, sizeof(commit_index) };
+    uint64_t pos = 0;
+    int found = fish_hashset_lookup((fish_hashset_t *)&index->commits,
+                                    fish_hash64(&commit_index, sizeof(commit_index), INDEX_SEED), key, &pos);
+    return found == 1 ? block_at(index, (uint32_t)pos) : NULL;
+}
+
+fossil_ai_jellyfish_block_t *fish_chain_index_hash(const fish_chain_index_t *index,
+                                                    const uint8_t hash[FOSSIL_JELLYFISH_HASH_SIZE]) {
+    size_t at = hash_lower_bound(index, hash);
+    if (at == index->count) return NULL;
+    fossil_ai_jellyfish_block_t *b = block_at(index, index->by_hash[at]);
+    return memcmp(b->identity.commit_hash, hash, FOSSIL_JELLYFISH_HASH_SIZE) == 0 ? b : NULL;
+}
+
+static int hex_nibble(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+static int prefix_compare(const uint8_t *hash, const uint8_t *nib, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        int h = (i & 1) ? (hash[i / 2] & 0x0f) : (hash[i / 2] >> 4);
+        if (h != nib[i]) return h < nib[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+size_t fish_chain_index_prefix(const fish_chain_index_t *index, ccstring hex, uint32_t *out, size_t cap) {
+    uint8_t nib[FOSSIL_JELLYFISH_HASH_SIZE * 2];
+    size_t n = 0;
+    if (!hex || !*hex) return 0;
+    for (; hex[n]; ++n) {
+        int v = hex_nibble(hex[n]);
+        if (v < 0 || n == sizeof(nib)) return 0;
+        nib[n] = (uint8_t)v;
+    }
+
+    size_t lo = 0, hi = index->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (prefix_compare(block_at(index, index->by_hash[mid])->identity.commit_hash, nib, n) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    size_t matches = 0;
+    for (size_t at = lo; at < index->count; ++at) {
+        if (prefix_compare(block_at(index, index->by_hash[at])->identity.commit_hash, nib, n) != 0) break;
+        if (matches < cap) out[matches] = index->by_hash[at];
+        matches++;
+    }
+    return matches;
+}
+
+fossil_ai_jellyfish_block_t *fish_chain_index_input(const fish_chain_index_t *index, ccstring text) {
+    char stack[INDEX_KEY_STACK];
+    size_t len = strlen(text);
+    char *buf = len <= sizeof(stack) ? stack : (char *)fossil_sys_memory_alloc(len);
+    if (!buf) return NULL;
+    fish_slice_t norm = { buf, fish_chain_index_normalize(text, len, buf) };
+    uint32_t id = 0;
+    int found = fish_intern_find((fish_intern_t *)&index->inputs, norm, &id);
+    if (buf != stack) fossil_sys_memory_free(buf);
+    return found == 1 ? block_at(index, index->best[id]) : NULL;
+}
+
+int fish_chain_index_tag(fish_chain_index_t *index, uint32_t pos, ccstring tag) {
+    if (pos >= index->count || !tag || !*tag) return -1;
+    for (size_t i = 0; i < index->tag_count; ++i) {
+        if (index->tags[i].pos == pos && strcmp(index->tags[i].name, tag) == 0) return 0;
+    }
+    if (index->tag_count == index->tag_cap) {
+        size_t cap = index->tag_cap ? index->tag_cap * 2 : 16;
+        fish_index_tag_t *grown = (fish_index_tag_t *)fossil_sys_memory_realloc(index->tags, cap * sizeof(fish_index_tag_t));
+        if (!grown) return -1;
+        index->tags = grown;
+        index->tag_cap = cap;
+    }
+    fossil_ai_jellyfish_block_t *b = block_at(index, pos);
+    fish_index_tag_t *entry = &index->tags[index->tag_count];
+    entry->name = fossil_io_cstring_create(tag);
+    if (!entry->name) return -1;
+    entry->pos = pos;
+    fossil_sys_memory_copy(entry->hash, b->identity.commit_hash, FOSSIL_JELLYFISH_HASH_SIZE);
+    index->tag_count++;
+    fossil_ai_jellyfish_tag_block(b, tag);
+    return 0;
+}
+
+size_t fish_chain_index_tagged(const fish_chain_index_t *index, ccstring tag, uint32_t *out, size_t cap) {
+    size_t matches = 0;
+    for (size_t i = 0; i < index->tag_count; ++i) {
+        if (strcmp(index->tags[i].name, tag) != 0) continue;
+        if (matches < cap) out[matches] = index->tags[i].pos;
+        matches++;
+    }
+    return matches;
+}
+
+void fish_chain_index_free(fish_chain_index_t *index) {
+    lookups_free(index);
+    for (size_t i = 0; i < index->tag_count; ++i) fossil_io_cstring_free(index->tags[i].name);
+    fossil_sys_memory_free(index->tags);
+    fossil_sys_memory_zero(index, sizeof(*index));
+}
+
+/* ---------------- sidecar ---------------- */
+
+static cstring index_path(ccstring model_name) {
+    return fossil_io_cstring_format("%s" FISH_INDEX_SUFFIX, model_name);
+}
+
+typedef struct {
+    fossil_io_file_t file;
+    int failed;
+} index_in_t;
+
+static void get(index_in_t *in, void *data, size_t len) {
+    if (!in->failed && len && fossil_io_file_read(&in->file, data, 1, len) != len) in->failed = 1;
+}
+
+static uint64_t get_u64(index_in_t *in) {
+    uint64_t v = 0;
+    get(in, &v, sizeof(v));
+    return v;
+}
+
+static void put(fish_row_writer_t *out, const void *data, size_t len) {
+    fish_row_writer_put(out, (const char *)data, len);
+}
+
+static void put_u64(fish_row_writer_t *out, uint64_t v) {
+    put(out, &v, sizeof(v));
+}
+
+int fish_chain_index_save(const fish_chain_index_t *index, ccstring model_name) {
+    fish_row_writer_t out;
+    cstring file = index_path(model_name);
+    if (!file || fish_row_writer_open_raw(&out, file) != 0) {
+        fossil_io_cstring_free(file);
+        return -1;
+    }
+
+    put(&out, INDEX_MAGIC, 8);
+    put_u64(&out, FISH_INDEX_VERSION);
+    put_u64(&out, index->count);
+    put_u64(&out, chain_digest(index->chain));
+
+    /* tags first: a stale sidecar still hands them over to the rebuild */
+    put_u64(&out, index->tag_count);
+    for (size_t i = 0; i < index->tag_count; ++i) {
+        size_t len = strlen(index->tags[i].name);
+        put(&out, index->tags[i].hash, FOSSIL_JELLYFISH_HASH_SIZE);
+        put_u64(&out, len);
+        put(&out, index->tags[i].name, len);
+    }
+
+    put(&out, index->by_hash, index->count * sizeof(uint32_t));
+    put_u64(&out, index->inputs.count);
+    for (size_t id = 0; id < index->inputs.count; ++id) {
+        put_u64(&out, index->inputs.str[id].len);
+        put(&out, index->inputs.str[id].ptr, index->inputs.str[id].len);
+        put(&out, &index->best[id], sizeof(uint32_t));
+    }
+
+    int rc = fish_row_writer_commit(&out);
+    fossil_io_cstring_free(file);
+    return rc;
+}
+
+static int read_tags(index_in_t *in, fish_chain_index_t *index) {
+    uint64_t tags = get_u64(in);
+    if (in->failed || tags > ((uint64_t)1 << 24)) return -1;
+    for (uint64_t i = 0; i < tags; ++i) {
+        uint8_t hash[FOSSIL_JELLYFISH_HASH_SIZE];
+        char name[256];
+        get(in, hash, sizeof(hash));
+        uint64_t len = get_u64(in);
+        if (in->failed || len >= sizeof(name)) return -1;
+        get(in, name, (size_t)len);
+        if (in->failed) return -1;
+        name[len] = '\0';
+
+        if (index->tag_count == index->tag_cap) {
+            size_t cap = index->tag_cap ? index->tag_cap * 2 : 16;
+            fish_index_tag_t *grown = (fish_index_tag_t *)fossil_sys_memory_realloc(index->tags, cap * sizeof(fish_index_tag_t));
+            if (!grown) return -1;
+            index->tags = grown;
+            index->tag_cap = cap;
+        }
+        fish_index_tag_t *entry = &index->tags[index->tag_count];
+        entry->name = fossil_io_cstring_create(name);
+        if (!entry->name) return -1;
+        entry->pos = 0;
+        fossil_sys_memory_copy(entry->hash, hash, sizeof(hash));
+        index->tag_count++;
+    }
+    return 0;
+}
+
+/* adopt the stored lookups; the commit_index set is cheap and rebuilt */
+static int read_lookups(index_in_t *in, fish_chain_index_t *index, size_t count) {
+    if (reserve(index, count) != 0) return -1;
+    get(in, index->by_hash, count * sizeof(uint32_t));
+    for (size_t i = 0; i < count; ++i) {
+        if (in->failed || index->by_hash[i] >= count) return -1;
+    }
+    index->count = count;
+
+    uint64_t keys = get_u64(in);
+    if (in->failed || keys > count) return -1;
+    index->best = (uint32_t *)fossil_sys_memory_alloc((size_t)(keys ? keys : 1) * sizeof(uint32_t));
+    if (!index->best) return -1;
+    index->best_cap = (size_t)(keys ? keys : 1);
+
+    char key[INDEX_INPUT_MAX];
+    for (uint64_t id = 0; id < keys; ++id) {
+        uint64_t len = get_u64(in);
+        if (in->failed || len > INDEX_INPUT_MAX) return -1;
+        get(in, key, (size_t)len);
+        get(in, &index->best[id], sizeof(uint32_t));
+        fish_slice_t norm = { key, (size_t)len };
+        if (in->failed || index->best[id] >= count || fish_intern_add(&index->inputs, norm, NULL) != 1) return -1;
+    }
+
+    for (size_t pos = 0; pos < count; ++pos) {
+        uint32_t ci = block_at(index, (uint32_t)pos)->identity.commit_index;
+        fish_slice_t k = { (const char *)&ci, sizeof(ci) };
+        if (fish_hashset_insert(&index->commits, fish_hash64(&ci, sizeof(ci), INDEX_SEED), k, pos) < 0) return -1;
+    }
+    return 0;
+}
+
+int fish_chain_index_open(fish_chain_index_t *index, fossil_ai_jellyfish_chain_t *chain, ccstring model_name) {
+    index_in_t in;
+    cstring file = index_path(model_name);
+
+    fossil_sys_memory_zero(index, sizeof(*index));
+    fossil_sys_memory_zero(&in, sizeof(in));
+    if (!file || !fossil_io_file_file_exists(file) || fossil_io_file_open(&in.file, file, "rb") != 0) {
+        fossil_io_cstring_free(file);
+        return index_rebuild(index, chain);
+    }
+    fossil_io_cstring_free(file);
+
+    char magic[8];
+    get(&in, magic, sizeof(magic));
+    int fresh = !in.failed && memcmp(magic, INDEX_MAGIC, sizeof(magic)) == 0 &&
+                get_u64(&in) == FISH_INDEX_VERSION;
+    uint64_t count = get_u64(&in);
+    uint64_t digest = get_u64(&in);
+    if (fresh && read_tags(&in, index) != 0) fresh = 0;
+    fresh = fresh && !in.failed && count == chain->count && digest == chain_digest(chain);
+
+    int rc = -1;
+    if (fresh && lookups_init(index, chain) == 0 && read_lookups(&in, index, (size_t)count) == 0) {
+        tags_rebind(index);
+        rc = 0;
+    }
+    fossil_io_file_close(&in.file);
+    /* stale or foreign sidecar: rebuild, keeping whatever tags were read */
+    return rc == 0 ? 0 : index_rebuild(index, chain);
+}
@@ -12,14 +12,91 @@
  * -----------------------------------------------------------------------------
  */
 #include "fossil/code/commands.h"
+#include "fossil/code/index.h"
+#include "fossil/code/page.h"
+#include "fossil/code/zchain.h"
+
+static void print_commit(const fossil_ai_jellyfish_block_t *b)
+{
+    fossil_io_printf("{yellow}Commit [{bold}%u{normal}{yellow}]{normal}\n", b->identity.commit_index);
+
+    fossil_io_printf("  Type     : {bold}%u{normal} (%s)\n", 
+        (unsigned)b->block_type, fossil_ai_jellyfish_commit_type_name(b->block_type));
+    fossil_io_printf("  Parents  : {bold}%u{normal}\n", (unsigned)b->identity.parent_count);
+
+    fossil_io_printf("  Hash     : ");
+    for (int h = 0; h < FOSSIL_JELLYFISH_HASH_SIZE; h++)
+        fossil_io_printf("{magenta}%02X{normal}", b->identity.commit_hash[h]);
+    fossil_io_printf("\n");
+
+    fossil_io_printf("  Tree     : ");
+    for (int h = 0; h < FOSSIL_JELLYFISH_HASH_SIZE; h++)
+        fossil_io_printf("{blue}%02X{normal}", b->identity.tree_hash[h]);
+    fossil_io_printf("\n");
+
+    fossil_io_printf("  Message  : {bold}%s{normal}\n", b->identity.commit_message);
+    fossil_io_printf("  Timestamp: {bold}%llu{normal}\n",
+           (unsigned long long)b->time.timestamp);
+    fossil_io_printf("  Confidence: {bold}%.2f{normal}\n", b->attributes.confidence);
+
+    // Print block trust score
+    bool valid_block = fossil_ai_jellyfish_verify_block(b);
+    fossil_io_printf("  Valid     : {bold}%s{normal}\n", valid_block ? "yes" : "no");
+
+    // Print block age
+    uint64_t now = fossil_io_time_now();
+    uint64_t age = fossil_ai_jellyfish_block_age(b, now);
+    fossil_io_printf("  Age (us)  : {bold}%llu{normal}\n", (unsigned long long)age);
+
+    // Print block explanation
+    char explain[128];
+    fossil_sys_memory_zero(explain, sizeof(explain));
+    fossil_ai_jellyfish_block_explain(b, explain, sizeof(explain));
+    fossil_io_printf("  Explain   : {bold}%s{normal}\n", explain);
+
+    if (b->identity.parent_count > 0) {
+        fossil_io_printf("  Parent hashes:\n");
+        for (uint32_t p = 0; p < b->identity.parent_count; ++p) {
+            fossil_io_printf("    - ");
+            for (int h = 0; h < FOSSIL_JELLYFISH_HASH_SIZE; h++)
+                fossil_io_printf("{magenta}%02X{normal}", b->identity.parent_hashes[p][h]);
+            fossil_io_printf("\n");
+        }
+    }
+
+    fossil_io_printf("\n");
+}
+
+/* Resolve --layer: "tag:<name>", a commit index, or a commit hash prefix */
+static size_t resolve_layer(const fish_chain_index_t *index, ccstring layer,
+                            uint32_t *out, size_t cap)
+{
+    if (strncmp(layer, "tag:", 4) == 0)
+        return fish_chain_index_tagged(index, layer + 4, out, cap);
+
+    char *end = NULL;
+    unsigned long commit_index = strtoul(layer, &end, 10);
+    if (end && *end == '\0' && end != layer) {
+        const fossil_ai_jellyfish_block_t *b = fish_chain_index_commit(index, (uint32_t)commit_index);
+        if (b) {
+            if (cap) out[0] = (uint32_t)(b - index->chain->commits);
+            return 1;
+        }
+    }
+    return fish_chain_index_prefix(index, layer, out, cap);
+}
 
 /**
  * @brief Inspect an AI model's details.
  *
- * Loads <model_name>.jfchain and prints structural info:
+ * Opens <model_name>.jfchain through its page file and prints structural info:
  * - Summary: commit counts, branch counts, timestamps
  * - Weights: in Jellyfish AI this means commit hashes + relationships
- * - Layer: maps to commit index or specific commit ID filter
+ * - Layer: a commit index, a commit hash prefix, or "tag:<name>",
+ *   resolved through the chain index
+ *
+ * Summary and weights read only the commits they print; a layer lookup
+ * still loads the full chain for the index.
  */
 int fish_inspect(ccstring model_name, int show_weights,
                  int summary, ccstring layer_name)
@@ -29,24 +106,12 @@ int fish_inspect(ccstring model_name, int show_weights,
         return -1;
     }
 
-    cstring path = fossil_io_cstring_format("%s.jfchain", model_name);
-
-    fossil_ai_jellyfish_chain_t chain;
-    fossil_sys_memory_zero(&chain, sizeof(chain));
-
-    fossil_io_file_t model_file;
-    if (fossil_io_file_open(&model_file, path, "rb") != 0) {
-        fossil_io_printf("{red,bold}fish_inspect: failed to open model file '%s'{normal}\n", path);
-        fossil_io_cstring_free(path);
-        return -1;
-    }
-
-    if (fossil_ai_jellyfish_load(&chain, path) != 0) {
+    fish_page_t page;
+    if (fish_page_open(&page, model_name) != 0) {
         fossil_io_printf("{red,bold}fish_inspect: failed to load model '%s'{normal}\n", model_name);
-        fossil_io_file_close(&model_file);
-        fossil_io_cstring_free(path);
         return -1;
     }
+    const fish_page_header_t *h = &page.header;
 
     fossil_io_printf("{green,bold}Inspecting AI model: %s{normal}\n", model_name);
     fossil_io_printf("{yellow}--------------------------------------{normal}\n");
@@ -54,112 +119,70 @@ int fish_inspect(ccstring model_name, int show_weights,
     /* SUMMARY SECTION */
     if (summary) {
         fossil_io_printf("{cyan,bold}Summary:{normal}\n");
-        fossil_io_printf("  Branch count : {bold}%u{normal}\n", (unsigned)chain.branch_count);
-        fossil_io_printf("  Commit count : {bold}%u{normal}\n", (unsigned)chain.count);
+        fossil_io_printf("  Branch count : {bold}%u{normal}\n", (unsigned)h->branch_count);
+        fossil_io_printf("  Commit count : {bold}%u{normal}\n", (unsigned)h->count);
         fossil_io_printf("  Created at   : {bold}%llu{normal}\n",
-               (unsigned long long)chain.created_at);
+               (unsigned long long)h->created_at);
         fossil_io_printf("  Updated at   : {bold}%llu{normal}\n",
-               (unsigned long long)chain.updated_at);
-        fossil_io_printf("  Default branch: {bold}%s{normal}\n", chain.default_branch);
+               (unsigned long long)h->updated_at);
+        fossil_io_printf("  Default branch: {bold}%s{normal}\n", h->default_branch);
         fossil_io_printf("  Repo ID      : ");
         for (int i = 0; i < FOSSIL_DEVICE_ID_SIZE; i++)
-            fossil_io_printf("{magenta}%02X{normal}", chain.repo_id[i]);
+            fossil_io_printf("{magenta}%02X{normal}", h->repo_id[i]);
         fossil_io_printf("\n");
 
-        // Print chain trust score
-        float trust_score = fossil_ai_jellyfish_chain_trust_score(&chain);
-        fossil_io_printf("  Trust score  : {bold}%.2f{normal}\n", trust_score);
-
-        // Print knowledge coverage
-        float coverage = fossil_ai_jellyfish_knowledge_coverage(&chain);
-        fossil_io_printf("  Knowledge coverage: {bold}%.2f{normal}\n", coverage);
-
-        // Print fingerprint
-        uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE];
-        fossil_sys_memory_zero(fingerprint, sizeof(fingerprint));
-        fossil_ai_jellyfish_chain_fingerprint(&chain, fingerprint);
+        // Scores are computed when the page file is written
+        fossil_io_printf("  Trust score  : {bold}%.2f{normal}\n", h->trust_score);
+        fossil_io_printf("  Knowledge coverage: {bold}%.2f{normal}\n", h->coverage);
         fossil_io_printf("  Fingerprint  : ");
         for (int i = 0; i < FOSSIL_JELLYFISH_HASH_SIZE; i++)
-            fossil_io_printf("{magenta}%02X{normal}", fingerprint[i]);
+            fossil_io_printf("{magenta}%02X{normal}", h->fingerprint[i]);
         fossil_io_printf("\n\n");
     }
 
-    /* If user wants a specific "layer" → treat as commit index or hash prefix */
-    int filter_specific_commit = 0;
-    unsigned target_index = 0;
-
-    if (layer_name && layer_name[0] != '\0') {
-        filter_specific_commit = 1;
-        target_index = (unsigned)atoi(layer_name);
-    }
-
     /* COMMIT / WEIGHT INSPECTION SECTION */
-    if (show_weights || filter_specific_commit) {
-        fossil_io_printf("{cyan,bold}Model Structure:{normal}\n");
-
-        for (size_t i = 0; i < chain.count; i++) {
-            fossil_ai_jellyfish_block_t *b = &chain.commits[i];
-            if (!b->attributes.valid)
-                continue;
-
-            if (filter_specific_commit && b->identity.commit_index != target_index)
-                continue;
-
-            fossil_io_printf("{yellow}Commit [{bold}%u{normal}{yellow}]{normal}\n", b->identity.commit_index);
-
-            fossil_io_printf("  Type     : {bold}%u{normal} (%s)\n", 
-                (unsigned)b->block_type, fossil_ai_jellyfish_commit_type_name(b->block_type));
-            fossil_io_printf("  Parents  : {bold}%u{normal}\n", (unsigned)b->identity.parent_count);
-
-            fossil_io_printf("  Hash     : ");
-            for (int h = 0; h < FOSSIL_JELLYFISH_HASH_SIZE; h++)
-                fossil_io_printf("{magenta}%02X{normal}", b->identity.commit_hash[h]);
-            fossil_io_printf("\n");
-
-            fossil_io_printf("  Tree     : ");
-            for (int h = 0; h < FOSSIL_JELLYFISH_HASH_SIZE; h++)
-                fossil_io_printf("{blue}%02X{normal}", b->identity.tree_hash[h]);
-            fossil_io_printf("\n");
+    if (layer_name && layer_name[0] != '\0') {
+        cstring path = fossil_io_cstring_format("%s.jfchain", model_name);
+        fossil_ai_jellyfish_chain_t chain;
+        fossil_sys_memory_zero(&chain, sizeof(chain));
+
+        fish_chain_index_t index;
+        if (fish_chain_load(&chain, path) != 0 ||
+            fish_chain_index_open(&index, &chain, model_name) != 0) {
+            fossil_io_printf("{red,bold}fish_inspect: failed to index model '%s'{normal}\n", model_name);
+            fossil_io_cstring_free(path);
+            fish_page_close(&page);
+            return -1;
+        }
+        fossil_io_cstring_free(path);
 
-            fossil_io_printf("  Message  : {bold}%s{normal}\n", b->identity.commit_message);
-            fossil_io_printf("  Timestamp: {bold}%llu{normal}\n",
-                   (unsigned long long)b->time.timestamp);
-            fossil_io_printf("  Confidence: {bold}%.2f{normal}\n", b->attributes.confidence);
-
-            // Print block trust score
-            bool valid_block = fossil_ai_jellyfish_verify_block(b);
-            fossil_io_printf("  Valid     : {bold}%s{normal}\n", valid_block ? "yes" : "no");
-
-            // Print block age
-            uint64_t now = fossil_io_time_now();
-            uint64_t age = fossil_ai_jellyfish_block_age(b, now);
-            fossil_io_printf("  Age (us)  : {bold}%llu{normal}\n", (unsigned long long)age);
-
-            // Print block explanation
-            char explain[128];
-            fossil_sys_memory_zero(explain, sizeof(explain));
-            fossil_ai_jellyfish_block_explain(b, explain, sizeof(explain));
-            fossil_io_printf("  Explain   : {bold}%s{normal}\n", explain);
-
-            if (b->identity.parent_count > 0) {
-                fossil_io_printf("  Parent hashes:\n");
-                for (int p = 0; p < b->identity.parent_count; ++p) {
-                    fossil_io_printf("    - ");
-                    for (int h = 0; h < FOSSIL_JELLYFISH_HASH_SIZE; h++)
-                        fossil_io_printf("{magenta}%02X{normal}", b->identity.parent_hashes[p][h]);
-                    fossil_io_printf("\n");
-                }
+        uint32_t *match = (uint32_t *)fossil_sys_memory_alloc((chain.count ? chain.count : 1) * sizeof(uint32_t));
+        size_t matches = match ? resolve_layer(&index, layer_name, match, chain.count) : 0;
+        if (matches == 0) {
+            fossil_io_printf("{yellow}No commit matches '%s'.{normal}\n", layer_name);
+        } else {
+            fossil_io_printf("{cyan,bold}Model Structure:{normal}\n");
+            if (matches > 1)
+                fossil_io_printf("{yellow}%zu commits match '%s'.{normal}\n\n", matches, layer_name);
+            for (size_t i = 0; i < matches && i < chain.count; i++) {
+                const fossil_ai_jellyfish_block_t *b = &chain.commits[match[i]];
+                if (b->attributes.valid) print_commit(b);
             }
+        }
+        fossil_sys_memory_free(match);
+        fish_chain_index_free(&index);
+    } else if (show_weights) {
+        fossil_io_printf("{cyan,bold}Model Structure:{normal}\n");
 
-            fossil_io_printf("\n");
-
-            if (filter_specific_commit)
-                break;  // only show one
+        for (size_t i = 0; i < h->count; i++) {
+            if (page.dir && !page.dir[i].valid) continue;
+            const fossil_ai_jellyfish_block_t *b = fish_page_commit(&page, i);
+            if (b && b->attributes.valid)
+                print_commit(b);
         }
     }
 
     fossil_io_printf("{green}Inspection complete.{normal}\n");
-    fossil_io_file_close(&model_file);
-    fossil_io_cstring_free(path);
+    fish_page_close(&page);
     return 0;
 }
@@ -0,0 +1,119 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/learn.h"
+#include "fossil/code/trace.h"
+
+typedef struct {
+    fossil_ai_jellyfish_block_t *block;
+    size_t count;
+    uint64_t now;
+    volatile size_t next;
+} learn_job_t;
+
+/* everything per commit except the parent link, which depends on the previous commit */
+static void learn_worker(void *arg, size_t index) {
+    learn_job_t *job = (learn_job_t *)arg;
+    (void)index;
+    for (;;) {
+        size_t begin = fish_thread_claim(&job->next) * FISH_LEARN_CHUNK;
+        if (begin >= job->count) break;
+        size_t end = begin + FISH_LEARN_CHUNK < job->count ? begin + FISH_LEARN_CHUNK : job->count;
+        FISH_TRACE_BEGIN(trace);
+        for (size_t i = begin; i < end; i++) {
+            fossil_ai_jellyfish_block_t *b = &job->block[i];
+            fossil_ai_jellyfish_hash(b->input, b->output, b->identity.commit_hash);
+            b->attributes.valid = 1;
+            b->attributes.confidence = 1.0f;
+            b->time.timestamp = job->now;
+        }
+        FISH_TRACE_END(FISH_STAGE_HASH, trace, end - begin);
+    }
+}
+
+/* hash, stamp and link commits [first, first + count) whose input/output are filled in */
+static void learn_finish(fossil_ai_jellyfish_chain_t *chain, size_t first, size_t count) {
+    if (count == 0) return;
+
+    FISH_TRACE_BEGIN(trace);
+    learn_job_t job;
+    job.block = &chain->commits[first];
+    job.count = count;
+    job.now = (uint64_t)time(NULL);
+    job.next = 0;
+
+    size_t workers = (count + FISH_LEARN_CHUNK - 1) / FISH_LEARN_CHUNK;
+    size_t hw = fish_thread_count();
+    fish_thread_run(workers < hw ? workers : hw, learn_worker, &job);
+
+    for (size_t pos = first; pos < first + count; pos++) {
+        fossil_ai_jellyfish_block_t *b = &chain->commits[pos];
+        b->identity.commit_index = (uint32_t)pos;
+        b->block_type = FOSSIL_JELLYFISH_COMMIT_INIT;
+        if (pos > 0) {
+            fossil_sys_memory_copy(b->identity.parent_hashes[0], chain->commits[pos - 1].identity.commit_hash,
+                                   FOSSIL_JELLYFISH_HASH_SIZE);
+            b->identity.parent_count = 1;
+        }
+    }
+
+    chain->count = first + count;
+    if (chain->created_at == 0) chain->created_at = job.now;
+    chain->updated_at = job.now;
+    FISH_TRACE_END(FISH_STAGE_LEARN, trace, count);
+}
+
+size_t fish_chain_learn_bulk(fossil_ai_jellyfish_chain_t *chain, const fish_pair_t *pairs, size_t count) {
+    size_t first = chain->count;
+    size_t room = first < FOSSIL_JELLYFISH_MAX_MEM ? FOSSIL_JELLYFISH_MAX_MEM - first : 0;
+    if (count > room) count = room;
+
+    for (size_t i = 0; i < count; i++) {
+        fossil_ai_jellyfish_block_t *b = &chain->commits[first + i];
+        fossil_sys_memory_zero(b, sizeof(*b));
+        snprintf(b->input, sizeof(b->input), "%s", pairs[i].input ? pairs[i].input : "");
+        snprintf(b->output, sizeof(b->output), "%s", pairs[i].output ? pairs[i].output : "");
+    }
+    learn_finish(chain, first, count);
+    return count;
+}
+
+int fish_chain_learn_iter(fossil_ai_jellyfish_chain_t *chain, fish_pair_next_fn next, void *ctx,
+                          size_t *learned, size_t *dropped) {
+    size_t first = chain->count;
+    size_t pos = first;
+    size_t over = 0;
+    int got;
+
+    /* fill commits in place, then hash and link them in one go */
+    for (;;) {
+        if (pos >= FOSSIL_JELLYFISH_MAX_MEM) {
+            /* full: drain the rest into scratch space so each one is counted */
+            char scratch_in[sizeof(chain->commits[0].input)], scratch_out[sizeof(chain->commits[0].output)];
+            while ((got = next(ctx, scratch_in, sizeof(scratch_in), scratch_out, sizeof(scratch_out))) > 0)
+                over++;
+            break;
+        }
+        fossil_ai_jellyfish_block_t *b = &chain->commits[pos];
+        fossil_sys_memory_zero(b, sizeof(*b));
+        got = next(ctx, b->input, sizeof(b->input), b->output, sizeof(b->output));
+        if (got <= 0) break;
+        pos++;
+    }
+
+    learn_finish(chain, first, pos - first);
+    if (learned) *learned = pos - first;
+    if (dropped) *dropped = over;
+    if (got < 0) return -1;
+    return over > 0 ? 1 : 0;
+}
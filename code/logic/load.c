@@ -11,13 +11,19 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
+#include "fossil/code/arena.h"
 #include "fossil/code/commands.h"
+#include "fossil/code/page.h"
+#include "fossil/code/store.h"
+#include "fossil/code/trace.h"
+#include "fossil/code/zchain.h"
 
 /**
  * @brief Load an AI model from a file using fossil_io_file_t.
  *
  * This loads the .jfchain file and, if override_session=1,
- * writes it into "<model_name>.jfchain".
+ * writes it into "<model_name>.jfchain" as a ref into the commit store
+ * (store.h), adding only the commits the store does not hold yet.
  *
  * If override_session=0, the model is only validated/loaded but not persisted.
  * After loading, verifies chain integrity and prints fingerprint.
@@ -49,7 +55,7 @@ int fish_load(ccstring file_path, int override_session)
     }
 
     /* Load the model into memory */
-    if (fossil_ai_jellyfish_load(chain, file_path) != 0) {
+    if (fish_chain_load(chain, file_path) != 0) {
         fossil_io_printf("{red,bold}fish_load: failed to load model file '{normal}%s{red,bold}'\n", file_path);
         fossil_sys_memory_free(chain);
         fossil_io_file_close(&model_file);
@@ -83,36 +89,34 @@ int fish_load(ccstring file_path, int override_session)
     ccstring base = strrchr(file_path, '/');
     base = base ? base + 1 : file_path;
 
-    char *model_name = fossil_sys_memory_strdup(base);
-    char *dot = strrchr(model_name, '.');
-    if (dot) *dot = '\0'; /* remove extension */
-
-    cstring out_path = fossil_io_cstring_format("%s.jfchain", model_name);
-
-    fossil_io_file_t out_file;
-    if (fossil_io_file_open(&out_file, out_path, "wb") != 0) {
-        fossil_io_printf("{red,bold}fish_load: failed to open output file '{normal}%s{red,bold}'\n", out_path);
-        fossil_sys_memory_free(model_name);
-        fossil_io_cstring_free(out_path);
+    char *model_name = fish_scratch_format("%s", base);
+    cstring out_path = NULL;
+    if (model_name) {
+        char *dot = strrchr(model_name, '.');
+        if (dot) *dot = '\0'; /* remove extension */
+        out_path = fish_scratch_format("%s.jfchain", model_name);
+    }
+    if (!out_path) {
+        fossil_io_printf("{red,bold}fish_load: out of memory.{normal}\n");
         fossil_sys_memory_free(chain);
         return -1;
     }
 
-    if (fossil_ai_jellyfish_save(chain, out_path) != 0) {
+    /* the ref is replaced atomically, so the old model survives a failed save */
+    fish_store_stats_t stored;
+    FISH_TRACE_BEGIN(trace);
+    int saved = fish_store_save(chain, out_path, &stored);
+    FISH_TRACE_END(FISH_STAGE_SAVE, trace, chain->count);
+    if (saved != 0) {
         fossil_io_printf("{red,bold}fish_load: failed to save loaded model to '{normal}%s{red,bold}'\n", out_path);
-        fossil_io_file_close(&out_file);
-        fossil_sys_memory_free(model_name);
-        fossil_io_cstring_free(out_path);
         fossil_sys_memory_free(chain);
         return -1;
     }
 
-    fossil_io_file_close(&out_file);
-
-    fossil_io_printf("{green,bold}fish_load: model persisted as '{normal}%s{green,bold}'\n", out_path);
+    fish_page_write(chain, model_name);
 
-    fossil_sys_memory_free(model_name);
-    fossil_io_cstring_free(out_path);
+    fossil_io_printf("{green,bold}fish_load: model persisted as '{normal}%s{green,bold}' "
+                     "(%zu new commits, %zu already stored){normal}\n", out_path, stored.written, stored.shared);
     fossil_sys_memory_free(chain);
     return 0;
 }
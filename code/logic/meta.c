@@ -0,0 +1,555 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/columnar.h"
+#include "fossil/code/meta.h"
+
+#define META_MAGIC "FISHMETA"
+#define META_SEED 0x6d657461ull /* "meta" */
+
+/* ---------------- column stats ---------------- */
+
+int fish_column_stats_init(fish_column_stats_t *col) {
+    fossil_sys_memory_zero(col, sizeof(*col));
+    fish_moments_init(&col->moments);
+    fish_hll_init(&col->distinct);
+    return fish_kll_init(&col->quantiles, FISH_KLL_K);
+}
+
+int fish_column_stats_merge(fish_column_stats_t *dst, const fish_column_stats_t *src) {
+    dst->present += src->present;
+    dst->nulls += src->nulls;
+    fish_moments_merge(&dst->moments, &src->moments);
+    fish_hll_merge(&dst->distinct, &src->distinct);
+    for (size_t b = 0; b < FISH_STATS_BINS; b++) dst->bins[b] += src->bins[b];
+    return fish_kll_merge(&dst->quantiles, &src->quantiles);
+}
+
+void fish_column_stats_free(fish_column_stats_t *col) {
+    fish_kll_free(&col->quantiles);
+}
+
+static void meta_stats_free(fish_meta_t *meta) {
+    for (size_t c = 0; c < meta->columns && meta->stats; c++)
+        fish_column_stats_free(&meta->stats[c]);
+    fossil_sys_memory_free(meta->stats);
+    meta->stats = NULL;
+    meta->columns = 0;
+    meta->has_stats = 0;
+    meta->stats_end = 0;
+    meta->stats_rows = 0;
+}
+
+int fish_meta_stats_reset(fish_meta_t *meta, size_t columns) {
+    meta_stats_free(meta);
+    meta->stats = (fish_column_stats_t *)fossil_sys_memory_calloc(columns ? columns : 1,
+                                                                  sizeof(fish_column_stats_t));
+    if (!meta->stats) return -1;
+    meta->columns = columns;
+    for (size_t c = 0; c < columns; c++)
+        if (fish_column_stats_init(&meta->stats[c]) != 0) return -1;
+    return 0;
+}
+
+void fish_meta_free(fish_meta_t *meta) {
+    meta_stats_free(meta);
+    fossil_sys_memory_free(meta->block);
+    fossil_sys_memory_free(meta->header);
+    fossil_sys_memory_zero(meta, sizeof(*meta));
+}
+
+/* ---------------- serialization ---------------- */
+
+static cstring meta_path(ccstring path) {
+    return fossil_io_cstring_format("%s" FISH_META_SUFFIX, path);
+}
+
+typedef struct {
+    fossil_io_file_t file;
+    int failed;
+} meta_in_t;
+
+static void get(meta_in_t *in, void *data, size_t len) {
+    if (!in->failed && fossil_io_file_read(&in->file, data, 1, len) != len) in->failed = 1;
+}
+
+static uint64_t get_u64(meta_in_t *in) {
+    uint64_t v = 0;
+    get(in, &v, sizeof(v));
+    return v;
+}
+
+static void put(fish_row_writer_t *out, const void *data, size_t len) {
+    fish_row_writer_put(out, (const char *)data, len);
+}
+
+static void put_u64(fish_row_writer_t *out, uint64_t v) {
+    put(out, &v, sizeof(v));
+}
+
+static void put_column(fish_row_writer_t *out, const fish_column_stats_t *col) {
+    const fish_kll_t *q = &col->quantiles;
+
+    put_u64(out, col->present);
+    put_u64(out, col->nulls);
+    put(out, &col->moments, sizeof(col->moments));
+    put(out, col->distinct.reg, sizeof(col->distinct.reg));
+    put_u64(out, q->k);
+    put_u64(out, q->n);
+    put_u64(out, q->toggle);
+    put_u64(out, q->levels);
+    for (size_t h = 0; h < q->levels; h++) {
+        put_u64(out, q->level[h].n);
+        put(out, q->level[h].item, q->level[h].n * sizeof(double));
+    }
+    put(out, col->bins, sizeof(col->bins));
+    put_u64(out, col->flags);
+}
+
+static int get_column(meta_in_t *in, fish_column_stats_t *col) {
+    fish_kll_t *q = &col->quantiles;
+
+    col->present = get_u64(in);
+    col->nulls = get_u64(in);
+    get(in, &col->moments, sizeof(col->moments));
+    get(in, col->distinct.reg, sizeof(col->distinct.reg));
+    q->k = (size_t)get_u64(in);
+    q->n = get_u64(in);
+    q->toggle = (unsigned)get_u64(in) & 1u;
+    uint64_t levels = get_u64(in);
+    if (in->failed || levels == 0 || levels > 64) return -1;
+
+    /* init left one empty level; add the rest with their items */
+    for (uint64_t h = 0; h < levels; h++) {
+        if (h >= q->levels) {
+            fish_kll_level_t *grown = (fish_kll_level_t *)fossil_sys_memory_realloc(
+                q->level, (size_t)(h + 1) * sizeof(fish_kll_level_t));
+            if (!grown) return -1;
+            q->level = grown;
+            fossil_sys_memory_zero(&q->level[h], sizeof(fish_kll_level_t));
+            q->levels = (size_t)(h + 1);
+        }
+        fish_kll_level_t *lv = &q->level[h];
+        uint64_t n = get_u64(in);
+        if (in->failed || n > ((uint64_t)1 << 32)) return -1;
+        if (n > lv->cap) {
+            double *items = (double *)fossil_sys_memory_realloc(lv->item, (size_t)n * sizeof(double));
+            if (!items) return -1;
+            lv->item = items;
+            lv->cap = (size_t)n;
+        }
+        get(in, lv->item, (size_t)n * sizeof(double));
+        lv->n = (size_t)n;
+        q->size += (size_t)n;
+    }
+    get(in, col->bins, sizeof(col->bins));
+    col->flags = (uint32_t)get_u64(in);
+    return in->failed ? -1 : 0;
+}
+
+int fish_meta_save(const fish_meta_t *meta, ccstring path) {
+    /* staged rows are not on disk yet; the write-back drops the sidecar anyway */
+    if (fish_row_stage_data(path, NULL)) return 0;
+
+    fish_row_writer_t out;
+    cstring file = meta_path(path);
+    if (!file || fish_row_writer_open_raw(&out, file) != 0) {
+        fossil_io_cstring_free(file);
+        return -1;
+    }
+
+    size_t header_len = meta->header ? strlen(meta->header) : 0;
+    put(&out, META_MAGIC, 8);
+    put_u64(&out, FISH_META_VERSION);
+    put_u64(&out, FISH_META_BLOCK_SIZE);
+    put_u64(&out, FISH_HLL_BITS);
+    put_u64(&out, FISH_STATS_BINS);
+    put_u64(&out, meta->file_size);
+    put_u64(&out, (uint64_t)meta->mtime);
+    put_u64(&out, meta->rows);
+    put_u64(&out, (uint64_t)meta->ends_on_record);
+    put_u64(&out, (uint64_t)meta->has_header);
+    put_u64(&out, meta->root);
+    put_u64(&out, meta->blocks);
+    put(&out, meta->block, meta->blocks * sizeof(fish_meta_block_t));
+    put_u64(&out, header_len);
+    put(&out, meta->header, header_len);
+
+    put_u64(&out, (uint64_t)meta->has_stats);
+    if (meta->has_stats) {
+        put_u64(&out, meta->stats_end);
+        put_u64(&out, meta->stats_rows);
+        put_u64(&out, meta->columns);
+        for (size_t c = 0; c < meta->columns; c++) put_column(&out, &meta->stats[c]);
+    }
+
+    int rc = fish_row_writer_commit(&out);
+    fossil_io_cstring_free(file);
+    return rc;
+}
+
+static int meta_read(meta_in_t *in, fish_meta_t *meta) {
+    char magic[8];
+    get(in, magic, sizeof(magic));
+    if (in->failed || memcmp(magic, META_MAGIC, sizeof(magic)) != 0) return -1;
+    if (get_u64(in) != FISH_META_VERSION || get_u64(in) != FISH_META_BLOCK_SIZE ||
+        get_u64(in) != FISH_HLL_BITS || get_u64(in) != FISH_STATS_BINS)
+        return -1;
+
+    meta->file_size = get_u64(in);
+    meta->mtime = (int64_t)get_u64(in);
+    meta->rows = get_u64(in);
+    meta->ends_on_record = (int)get_u64(in);
+    meta->has_header = (int)get_u64(in);
+    meta->root = get_u64(in);
+    uint64_t blocks = get_u64(in);
+    if (in->failed || blocks != (meta->file_size + FISH_META_BLOCK_SIZE - 1) / FISH_META_BLOCK_SIZE)
+        return -1;
+    meta->block = (fish_meta_block_t *)fossil_sys_memory_alloc((size_t)(blocks ? blocks : 1) * sizeof(fish_meta_block_t));
+    if (!meta->block) return -1;
+    meta->blocks = (size_t)blocks;
+    get(in, meta->block, meta->blocks * sizeof(fish_meta_block_t));
+
+    uint64_t header_len = get_u64(in);
+    if (in->failed || header_len > meta->file_size) return -1;
+    meta->header = (cstring)fossil_sys_memory_alloc((size_t)header_len + 1);
+    if (!meta->header) return -1;
+    get(in, meta->header, (size_t)header_len);
+    meta->header[header_len] = '\0';
+
+    if (get_u64(in) == 0) return in->failed ? -1 : 0;
+    uint64_t stats_end = get_u64(in);
+    uint64_t stats_rows = get_u64(in);
+    uint64_t columns = get_u64(in);
+    if (in->failed || columns > meta->file_size || fish_meta_stats_reset(meta, (size_t)columns) != 0)
+        return -1;
+    for (size_t c = 0; c < meta->columns; c++)
+        if (get_column(in, &meta->stats[c]) != 0) return -1;
+    meta->has_stats = 1;
+    meta->stats_end = stats_end;
+    meta->stats_rows = stats_rows;
+    return 0;
+}
+
+static int meta_load(fish_meta_t *meta, ccstring path) {
+    meta_in_t in;
+    cstring file = meta_path(path);
+
+    fossil_sys_memory_zero(meta, sizeof(*meta));
+    fossil_sys_memory_zero(&in, sizeof(in));
+    if (!file || !fossil_io_file_file_exists(file) || fossil_io_file_open(&in.file, file, "rb") != 0) {
+        fossil_io_cstring_free(file);
+        return -1;
+    }
+    int rc = meta_read(&in, meta);
+    fossil_io_file_close(&in.file);
+    fossil_io_cstring_free(file);
+    if (rc != 0) fish_meta_free(meta); /* stale or foreign sidecar: rebuild */
+    return rc;
+}
+
+void fish_meta_invalidate(ccstring path) {
+    cstring file = meta_path(path);
+    if (file && fossil_io_file_file_exists(file)) fossil_io_file_delete(file);
+    fossil_io_cstring_free(file);
+}
+
+/* ---------------- fingerprint ---------------- */
+
+/* CSV records ending in buf[0, len); @p state carries the quote state across blocks */
+static uint64_t count_records(const char *buf, size_t len, int *state) {
+    uint64_t n = 0;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t end = fish_csv_record_end(buf + pos, len - pos, state);
+        if (end == len - pos) break;
+        n++;
+        pos += end + 1;
+    }
+    return n;
+}
+
+static size_t block_length(uint64_t file_size, size_t index) {
+    uint64_t start = (uint64_t)index * FISH_META_BLOCK_SIZE;
+    uint64_t left = file_size > start ? file_size - start : 0;
+    return left < FISH_META_BLOCK_SIZE ? (size_t)left : FISH_META_BLOCK_SIZE;
+}
+
+/* Dataset bytes block by block: the staged rows of a pipeline, else the file. */
+typedef struct {
+    const char *staged;
+    fossil_io_file_t file;
+    char *buf;
+    uint64_t file_size;
+} meta_src_t;
+
+static int src_open(meta_src_t *src, ccstring path, uint64_t file_size) {
+    fossil_sys_memory_zero(src, sizeof(*src));
+    src->file_size = file_size;
+    src->staged = fish_row_stage_data(path, NULL);
+    if (src->staged) return 0;
+    src->buf = (char *)fossil_sys_memory_alloc(FISH_META_BLOCK_SIZE);
+    if (!src->buf || fossil_io_file_open(&src->file, path, "rb") != 0) {
+        fossil_sys_memory_free(src->buf);
+        src->buf = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Bytes of block @p index, valid until the next call; NULL on a short read. */
+static const char *src_block(meta_src_t *src, size_t index, size_t *len) {
+    *len = block_length(src->file_size, index);
+    if (src->staged) return src->staged + (size_t)index * FISH_META_BLOCK_SIZE;
+    if (fish_fseek64(src->file.file, (long long)index * FISH_META_BLOCK_SIZE, SEEK_SET) != 0 ||
+        fossil_io_file_read(&src->file, src->buf, 1, *len) != *len)
+        return NULL;
+    return src->buf;
+}
+
+static void src_close(meta_src_t *src) {
+    if (src->buf) fossil_io_file_close(&src->file);
+    fossil_sys_memory_free(src->buf);
+    src->buf = NULL;
+}
+
+static uint64_t merkle_root(const fish_meta_block_t *block, size_t blocks) {
+    if (blocks == 0) return fish_hash64(NULL, 0, META_SEED);
+
+    uint64_t *level = (uint64_t *)fossil_sys_memory_alloc(blocks * sizeof(uint64_t));
+    if (!level) return 0;
+    for (size_t i = 0; i < blocks; i++) level[i] = block[i].digest;
+
+    size_t n = blocks;
+    while (n > 1) {
+        size_t up = 0;
+        for (size_t i = 0; i < n; i += 2) {
+            if (i + 1 < n) {
+                uint64_t pair[2] = { level[i], level[i + 1] };
+                level[up++] = fish_hash64(pair, sizeof(pair), META_SEED);
+            } else {
+                level[up++] = level[i]; /* odd node is carried up */
+            }
+        }
+        n = up;
+    }
+    uint64_t root = level[0];
+    fossil_sys_memory_free(level);
+    return root;
+}
+
+/* Cheap staleness check: re-digest only the final block. */
+static int tail_matches(const fish_meta_t *meta, ccstring path) {
+    if (meta->blocks == 0) return 1;
+    size_t last = meta->blocks - 1;
+    size_t len = block_length(meta->file_size, last);
+    fossil_io_file_t file;
+    int ok = 0;
+
+    char *buf = (char *)fossil_sys_memory_alloc(len ? len : 1);
+    if (!buf) return 0;
+    if (fossil_io_file_open(&file, path, "rb") == 0) {
+        if (fish_fseek64(file.file, (long long)last * FISH_META_BLOCK_SIZE, SEEK_SET) == 0 &&
+            fossil_io_file_read(&file, buf, 1, len) == len)
+            ok = fish_hash64(buf, len, META_SEED) == meta->block[last].digest;
+        fossil_io_file_close(&file);
+    }
+    fossil_sys_memory_free(buf);
+    return ok;
+}
+
+static int read_header(fish_meta_t *meta, ccstring path) {
+    fish_row_reader_t reader;
+    fish_row_fields_t fields = {0};
+    fish_slice_t row;
+
+    if (fish_row_reader_open_csv(&reader, path) != 0) return -1;
+    meta->has_header = fish_row_reader_header(&reader, &fields, &row) == 1;
+    /* without a header the first data record still gives the column count */
+    if (meta->has_header || fish_row_reader_next(&reader, &row)) {
+        meta->header = (cstring)fossil_sys_memory_alloc(row.len + 1);
+        if (meta->header) fish_slice_copy(row, meta->header, row.len + 1);
+    }
+    int failed = reader.failed;
+    fish_row_reader_close(&reader);
+    fish_row_fields_free(&fields);
+    return failed || (meta->file_size > 0 && !meta->header) ? -1 : 0;
+}
+
+/*
+ * Digest the blocks of @p path into @p meta, reusing record counts from
+ * @p old for blocks whose digest and starting quote state are unchanged.
+ * After an append only the old final block onwards is read. Sets *prefix
+ * if @p old's content is still an exact prefix of the file.
+ */
+static int meta_scan(fish_meta_t *meta, const fish_meta_t *old, ccstring path, int *prefix) {
+    meta_src_t src;
+    size_t blocks = (size_t)((meta->file_size + FISH_META_BLOCK_SIZE - 1) / FISH_META_BLOCK_SIZE);
+    int failed = 0;
+
+    *prefix = old && old->file_size <= meta->file_size;
+    meta->block = (fish_meta_block_t *)fossil_sys_memory_calloc(blocks ? blocks : 1, sizeof(fish_meta_block_t));
+    if (!meta->block || src_open(&src, path, meta->file_size) != 0) return -1;
+    meta->blocks = blocks;
+
+    uint64_t records = 0;
+    int state = FISH_CSV_FIELD;
+
+    /* appending only touches the old final block onwards: once that block's
+     * old bytes still match, the blocks before it keep their digests unread */
+    size_t keep = 0;
+    if (old && old->blocks > 0 && old->file_size < meta->file_size && tail_matches(old, path)) {
+        keep = old->blocks - 1;
+        for (size_t i = 0; i < keep; i++) {
+            meta->block[i] = old->block[i];
+            records += old->block[i].records;
+        }
+        state = (int)old->block[keep].state;
+    }
+
+    for (size_t i = keep; i < blocks; i++) {
+        size_t len;
+        const char *data = src_block(&src, i, &len);
+        if (!data) {
+            failed = 1;
+            break;
+        }
+        fish_meta_block_t *b = &meta->block[i];
+        b->digest = fish_hash64(data, len, META_SEED);
+        b->state = (uint64_t)state;
+
+        size_t old_len = old && i < old->blocks ? block_length(old->file_size, i) : 0;
+        if (old_len == len && old->block[i].digest == b->digest && old->block[i].state == b->state &&
+            i + 1 < old->blocks) {
+            /* the next block's starting state says where this one left off */
+            b->records = old->block[i].records;
+            state = (int)old->block[i + 1].state;
+        } else {
+            b->records = count_records(data, len, &state);
+            /* a grown final block still counts as unchanged if its old bytes match */
+            if (old_len && (old_len > len || fish_hash64(data, old_len, META_SEED) != old->block[i].digest))
+                *prefix = 0;
+        }
+        records += b->records;
+        if (i + 1 == blocks) meta->ends_on_record = data[len - 1] == '\n' && state == FISH_CSV_FIELD;
+    }
+    src_close(&src);
+    if (failed) return -1;
+
+    /* an unterminated last record still counts; read_header() ran first */
+    uint64_t total = records + (meta->file_size > 0 && !meta->ends_on_record ? 1 : 0);
+    meta->rows = total > 0 && meta->has_header ? total - 1 : total;
+
+    /* columnar files carry their row count, and rewrite their footer on any change */
+    fish_col_reader_t col;
+    if (fish_col_probe(path)) {
+        if (fish_col_open(&col, path) != 0) return -1;
+        meta->rows = col.rows;
+        meta->ends_on_record = 0;
+        fish_col_close(&col);
+    }
+    meta->root = merkle_root(meta->block, meta->blocks);
+    return 0;
+}
+
+uint64_t fish_meta_record_start(const fish_meta_t *meta, ccstring path, uint64_t offset) {
+    if (offset == 0) return 0;
+    if (offset >= meta->file_size) return meta->file_size;
+
+    /* rescan from the start of the block holding the byte before @p offset */
+    uint64_t from = offset - 1;
+    size_t i = (size_t)(from / FISH_META_BLOCK_SIZE);
+    int state = (int)meta->block[i].state;
+    meta_src_t src;
+    if (src_open(&src, path, meta->file_size) != 0) return meta->file_size;
+
+    uint64_t found = meta->file_size;
+    size_t skip = (size_t)(from - (uint64_t)i * FISH_META_BLOCK_SIZE);
+    for (; i < meta->blocks && found == meta->file_size; i++) {
+        size_t len;
+        const char *data = src_block(&src, i, &len);
+        if (!data) break;
+        size_t pos = 0;
+        while (pos < len) {
+            size_t end = fish_csv_record_end(data + pos, len - pos, &state);
+            if (end == len - pos) break;
+            pos += end + 1;
+            if (pos > skip) {
+                found = (uint64_t)i * FISH_META_BLOCK_SIZE + pos;
+                break;
+            }
+        }
+        skip = 0;
+    }
+    src_close(&src);
+    return found;
+}
+
+int fish_meta_sync(fish_meta_t *meta, ccstring path) {
+    fish_meta_t old;
+    int prefix = 0;
+    int state;
+
+    fossil_sys_memory_zero(meta, sizeof(*meta));
+    if (!fossil_io_file_file_exists(path)) return -1;
+
+    /* the sidecar describes the file, not rows staged by a pipeline */
+    int staged = fish_row_stage_data(path, NULL) != NULL;
+    int have = !staged && meta_load(&old, path) == 0;
+    uint64_t size = fish_file_size(path);
+    int64_t mtime = fish_file_mtime(path);
+
+    /* a file modified in the same clock tick as the sidecar was written could
+     * still look unchanged, so the fast path needs it strictly older */
+    cstring file = meta_path(path);
+    int settled = file && mtime < fish_file_mtime(file);
+    fossil_io_cstring_free(file);
+
+    if (have && settled && old.file_size == size && old.mtime == mtime && tail_matches(&old, path)) {
+        *meta = old;
+        return FISH_META_UNCHANGED;
+    }
+
+    meta->file_size = size;
+    meta->mtime = mtime;
+    if (read_header(meta, path) != 0 || meta_scan(meta, have ? &old : NULL, path, &prefix) != 0) {
+        if (have) fish_meta_free(&old);
+        fish_meta_free(meta);
+        return -1;
+    }
+
+    if (have && prefix && size == old.file_size) {
+        state = FISH_META_UNCHANGED;        /* touched, not modified */
+    } else if (have && prefix && old.ends_on_record) {
+        state = FISH_META_APPENDED;
+    } else {
+        state = FISH_META_REBUILT;
+    }
+
+    if (have && state != FISH_META_REBUILT && old.has_stats) {
+        /* hand the cached stats over; appended rows are folded in by the caller */
+        meta->has_stats = 1;
+        meta->stats_end = old.stats_end;
+        meta->stats_rows = old.stats_rows;
+        meta->columns = old.columns;
+        meta->stats = old.stats;
+        old.stats = NULL;
+        old.columns = 0;
+        for (size_t c = 0; state == FISH_META_APPENDED && c < meta->columns; c++)
+            meta->stats[c].flags &= ~FISH_STATS_BINNED;
+    }
+    if (have) fish_meta_free(&old);
+
+    fish_meta_save(meta, path);
+    return state;
+}
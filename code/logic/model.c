@@ -0,0 +1,325 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/cache.h"
+#include "fossil/code/learn.h"
+#include "fossil/code/model.h"
+#include "fossil/code/page.h"
+#include "fossil/code/store.h"
+#include "fossil/code/trace.h"
+#include "fossil/code/zchain.h"
+
+#define MODEL_NAME_MAX 200
+#define MODEL_PROMPT_STACK 512
+
+static fish_rwlock_t *registry_lock = NULL;
+static fish_model_t *registry = NULL;
+static size_t registry_count = 0;
+
+/* answers of every resident model; the LRU order changes on reads too */
+static fish_rwlock_t *cache_lock = NULL;
+static fish_cache_t answer_cache;
+static int cache_ready = 0;
+static int cache_persist = 0;
+
+int fish_model_valid_name(ccstring name) {
+    if (!name || !*name) return 0;
+    if (strlen(name) > MODEL_NAME_MAX) return 0;
+    if (strstr(name, "..")) return 0;
+    for (const char *p = name; *p; ++p) {
+        if (*p == '/' || *p == '\\' || *p == ':' || (unsigned char)*p < 0x20) return 0;
+    }
+    return 1;
+}
+
+int fish_models_init(void) {
+    if (registry_lock) return 0;
+    registry_lock = fish_rwlock_create();
+    cache_lock = fish_rwlock_create();
+    if (!registry_lock || !cache_lock) return -1;
+    cache_ready = fish_cache_init(&answer_cache, 0) == 0;
+    return 0;
+}
+
+static fish_model_t *registry_find(ccstring name) {
+    for (fish_model_t *m = registry; m; m = m->next) {
+        if (strcmp(m->name, name) == 0) return m;
+    }
+    return NULL;
+}
+
+static void model_free(fish_model_t *model) {
+    fish_chain_index_free(&model->index);
+    fossil_io_cstring_free(model->name);
+    fossil_sys_memory_free(model->chain);
+    fish_rwlock_destroy(model->lock);
+    fossil_sys_memory_free(model);
+}
+
+static fish_model_t *model_load(ccstring name) {
+    fish_model_t *model = (fish_model_t *)fossil_sys_memory_calloc(1, sizeof(fish_model_t));
+    if (!model) return NULL;
+    model->name = fossil_io_cstring_create(name);
+    model->chain = (fossil_ai_jellyfish_chain_t *)
+        fossil_sys_memory_calloc(1, sizeof(fossil_ai_jellyfish_chain_t));
+    model->lock = fish_rwlock_create();
+    if (!model->name || !model->chain || !model->lock) {
+        model_free(model);
+        return NULL;
+    }
+
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s.jfchain", name);
+    fossil_ai_jellyfish_init(model->chain);
+    if (fossil_io_file_file_exists(path)) {
+        if (fish_chain_load(model->chain, path) != 0) {
+            fossil_io_printf("{red,bold}fish_model: failed to load '{normal}%s{red,bold}'{normal}\n", path);
+            model_free(model);
+            return NULL;
+        }
+        model->loaded = 1;
+    }
+    if (fish_chain_index_open(&model->index, model->chain, name) != 0) {
+        model_free(model);
+        return NULL;
+    }
+    return model;
+}
+
+static int chain_on_disk(ccstring name) {
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s.jfchain", name);
+    return fossil_io_file_file_exists(path);
+}
+
+static fish_model_t *model_acquire(ccstring name, int create) {
+    if (!fish_model_valid_name(name)) return NULL;
+    if (fish_models_init() != 0) return NULL;
+
+    fish_rwlock_read_lock(registry_lock);
+    fish_model_t *model = registry_find(name);
+    fish_rwlock_read_unlock(registry_lock);
+    if (model) return model;
+    if (!create && !chain_on_disk(name)) return NULL;
+
+    /* load under the write lock so concurrent first requests load it once */
+    fish_rwlock_write_lock(registry_lock);
+    model = registry_find(name);
+    if (!model && registry_count >= FISH_MODEL_RESIDENT_MAX) {
+        fossil_io_printf("{red,bold}fish_model: %d models resident, not loading '{normal}%s{red,bold}'{normal}\n",
+                         FISH_MODEL_RESIDENT_MAX, name);
+    } else if (!model) {
+        model = model_load(name);
+        if (model) {
+            model->next = registry;
+            registry = model;
+            registry_count++;
+        }
+    }
+    fish_rwlock_write_unlock(registry_lock);
+    return model;
+}
+
+fish_model_t *fish_model_acquire(ccstring name) {
+    return model_acquire(name, 1);
+}
+
+fish_model_t *fish_model_acquire_existing(ccstring name) {
+    return model_acquire(name, 0);
+}
+
+int fish_model_exists(ccstring name) {
+    if (!fish_model_valid_name(name)) return 0;
+    if (chain_on_disk(name)) return 1;
+    if (fish_models_init() != 0) return 0;
+    fish_rwlock_read_lock(registry_lock);
+    int resident = registry_find(name) != NULL;
+    fish_rwlock_read_unlock(registry_lock);
+    return resident;
+}
+
+int fish_model_answer(fish_model_t *model, ccstring prompt,
+                      char *answer, size_t answer_cap, float *confidence,
+                      char *explain, size_t explain_cap) {
+    char reasoned[FISH_MODEL_REPLY_MAX];
+    const fossil_ai_jellyfish_block_t *block = NULL;
+    float conf = 0.0f;
+
+    reasoned[0] = '\0';
+    if (explain && explain_cap) explain[0] = '\0';
+
+    FISH_TRACE_BEGIN(trace);
+    fish_rwlock_read_lock(model->lock);
+    bool found = false;
+    block = fish_chain_index_input(&model->index, prompt);
+    if (block) {
+        snprintf(reasoned, sizeof(reasoned), "%.*s", (int)sizeof(block->output), block->output);
+        conf = block->attributes.confidence;
+        found = true;
+    } else {
+        found = fossil_ai_jellyfish_reason_verbose(model->chain, prompt, reasoned, &conf, &block);
+    }
+    /* the block lives inside the chain: explain it before releasing the lock */
+    if (found && block && explain && explain_cap) {
+        fossil_ai_jellyfish_block_explain(block, explain, explain_cap);
+    }
+    fish_rwlock_read_unlock(model->lock);
+    FISH_TRACE_END(FISH_STAGE_REASON, trace, 1);
+
+    reasoned[sizeof(reasoned) - 1] = '\0';
+    snprintf(answer, answer_cap, "%s", found ? reasoned : "");
+    if (confidence) *confidence = found ? conf : 0.0f;
+    return found ? 1 : 0;
+}
+
+void fish_model_fingerprint(fish_model_t *model, uint8_t out[FOSSIL_JELLYFISH_HASH_SIZE]) {
+    fish_rwlock_read_lock(model->lock);
+    int ok = model->fingerprint_ok;
+    if (ok) fossil_sys_memory_copy(out, model->fingerprint, FOSSIL_JELLYFISH_HASH_SIZE);
+    fish_rwlock_read_unlock(model->lock);
+    if (ok) return;
+
+    fish_rwlock_write_lock(model->lock);
+    if (!model->fingerprint_ok) {
+        fossil_ai_jellyfish_chain_fingerprint(model->chain, model->fingerprint);
+        model->fingerprint_ok = 1;
+        model->cache_loaded = 0;
+    }
+    fossil_sys_memory_copy(out, model->fingerprint, FOSSIL_JELLYFISH_HASH_SIZE);
+    fish_rwlock_write_unlock(model->lock);
+}
+
+void fish_model_cache_persist(int on) {
+    cache_persist = on;
+}
+
+/* read the model's .jfcache once per fingerprint */
+static void cache_warm(fish_model_t *model, const uint8_t *fingerprint) {
+    fish_rwlock_read_lock(model->lock);
+    int loaded = model->cache_loaded;
+    fish_rwlock_read_unlock(model->lock);
+    if (loaded) return;
+
+    fish_rwlock_write_lock(cache_lock);
+    fish_rwlock_write_lock(model->lock);
+    if (!model->cache_loaded && memcmp(model->fingerprint, fingerprint, FOSSIL_JELLYFISH_HASH_SIZE) == 0) {
+        if (fish_cache_load(&answer_cache, model->name, fingerprint) < 0)
+            fossil_io_printf("{yellow}fish_model: ignoring damaged '%s%s'.{normal}\n", model->name, FISH_CACHE_SUFFIX);
+        model->cache_loaded = 1;
+    }
+    fish_rwlock_write_unlock(model->lock);
+    fish_rwlock_write_unlock(cache_lock);
+}
+
+int fish_model_ask(fish_model_t *model, ccstring prompt,
+                   char *answer, size_t answer_cap, float *confidence,
+                   char *explain, size_t explain_cap) {
+    if (fish_models_init() != 0 || !cache_ready)
+        return fish_model_answer(model, prompt, answer, answer_cap, confidence, explain, explain_cap);
+
+    uint8_t fingerprint[FOSSIL_JELLYFISH_HASH_SIZE];
+    fish_model_fingerprint(model, fingerprint);
+    if (cache_persist) cache_warm(model, fingerprint);
+
+    char stack[MODEL_PROMPT_STACK];
+    size_t len = strlen(prompt);
+    char *buf = len <= sizeof(stack) ? stack : (char *)fossil_sys_memory_alloc(len);
+    if (!buf) return fish_model_answer(model, prompt, answer, answer_cap, confidence, explain, explain_cap);
+    fish_slice_t key = { buf, fish_chain_index_normalize(prompt, len, buf) };
+    int want_explain = explain && explain_cap;
+
+    fish_cache_value_t hit;
+    fish_rwlock_write_lock(cache_lock);
+    int cached = fish_cache_get(&answer_cache, fingerprint, key, want_explain, &hit);
+    if (cached) {
+        snprintf(answer, answer_cap, "%s", hit.answer);
+        if (want_explain) snprintf(explain, explain_cap, "%s", hit.explain);
+        if (confidence) *confidence = hit.confidence;
+        cached = hit.found ? 1 : 2;
+    }
+    fish_rwlock_write_unlock(cache_lock);
+
+    if (cached) {
+        if (buf != stack) fossil_sys_memory_free(buf);
+        return cached == 1;
+    }
+
+    float conf = 0.0f;
+    int found = fish_model_answer(model, prompt, answer, answer_cap, &conf, explain, explain_cap);
+    if (confidence) *confidence = conf;
+
+    fish_cache_value_t value = { found, conf, answer, want_explain ? explain : "" };
+    fish_rwlock_write_lock(cache_lock);
+    fish_cache_put(&answer_cache, fingerprint, key, want_explain, &value);
+    if (cache_persist) fish_cache_append(model->name, fingerprint, key, want_explain, &value);
+    fish_rwlock_write_unlock(cache_lock);
+
+    if (buf != stack) fossil_sys_memory_free(buf);
+    return found;
+}
+
+void fish_model_learn(fish_model_t *model, ccstring input, ccstring output) {
+    fish_rwlock_write_lock(model->lock);
+    fish_pair_t pair = { input, output };
+    fish_chain_learn_bulk(model->chain, &pair, 1);
+    fish_chain_index_sync(&model->index);
+    model->dirty = 1;
+    model->fingerprint_ok = 0;
+    fish_rwlock_write_unlock(model->lock);
+}
+
+int fish_model_chat(fish_model_t *model, ccstring message, int learn,
+                    char *reply, size_t reply_cap, float *confidence) {
+    if (fish_model_answer(model, message, reply, reply_cap, confidence, NULL, 0)) return 1;
+    snprintf(reply, reply_cap, "I received: \"%s\"", message);
+    if (learn) fish_model_learn(model, message, reply);
+    return 0;
+}
+
+int fish_model_save(fish_model_t *model) {
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s.jfchain", model->name);
+
+    fish_rwlock_write_lock(model->lock);
+    FISH_TRACE_BEGIN(trace);
+    int rc = fish_store_save(model->chain, path, NULL);
+    if (rc == 0) rc = fish_chain_index_save(&model->index, model->name);
+    if (rc == 0) fish_page_write(model->chain, model->name);
+    FISH_TRACE_END(FISH_STAGE_SAVE, trace, model->chain->count);
+    if (rc == 0) model->dirty = 0;
+    fish_rwlock_write_unlock(model->lock);
+
+    if (rc != 0) {
+        fossil_io_printf("{red,bold}fish_model: failed to save '{normal}%s{red,bold}'{normal}\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+void fish_models_release(int save_dirty) {
+    fish_model_t *model = registry;
+    while (model) {
+        fish_model_t *next = model->next;
+        if (save_dirty && model->dirty) fish_model_save(model);
+        model_free(model);
+        model = next;
+    }
+    registry = NULL;
+    registry_count = 0;
+    fish_rwlock_destroy(registry_lock);
+    registry_lock = NULL;
+    if (cache_ready) fish_cache_free(&answer_cache);
+    cache_ready = 0;
+    fish_rwlock_destroy(cache_lock);
+    cache_lock = NULL;
+}
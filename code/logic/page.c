@@ -0,0 +1,214 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/page.h"
+#include "fossil/code/trace.h"
+#include "fossil/code/zchain.h"
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <io.h>
+#else
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+static cstring chain_path(ccstring model_name) {
+    return fossil_io_cstring_format("%s.jfchain", model_name);
+}
+
+static cstring page_path(ccstring model_name) {
+    return fossil_io_cstring_format("%s" FISH_PAGE_SUFFIX, model_name);
+}
+
+static void header_from_chain(fish_page_header_t *h, const fossil_ai_jellyfish_chain_t *chain) {
+    fossil_sys_memory_zero(h, sizeof(*h));
+    fossil_sys_memory_copy(h->magic, FISH_PAGE_MAGIC, sizeof(h->magic));
+    h->version = FISH_PAGE_VERSION;
+    h->block_size = (uint32_t)sizeof(fossil_ai_jellyfish_block_t);
+    h->count = chain->count;
+    h->created_at = chain->created_at;
+    h->updated_at = chain->updated_at;
+    h->branch_count = chain->branch_count;
+    h->trust_score = fossil_ai_jellyfish_chain_trust_score(chain);
+    h->coverage = fossil_ai_jellyfish_knowledge_coverage(chain);
+    fossil_sys_memory_copy(h->default_branch, chain->default_branch, sizeof(h->default_branch));
+    h->default_branch[sizeof(h->default_branch) - 1] = '\0';
+    fossil_sys_memory_copy(h->repo_id, chain->repo_id, sizeof(h->repo_id));
+    fossil_ai_jellyfish_chain_fingerprint(chain, h->fingerprint);
+}
+
+int fish_page_write(const fossil_ai_jellyfish_chain_t *chain, ccstring model_name) {
+    cstring source = chain_path(model_name);
+    cstring file = page_path(model_name);
+    fish_row_writer_t out;
+    if (!source || !file || fish_row_writer_open_raw(&out, file) != 0) {
+        fossil_io_cstring_free(source);
+        fossil_io_cstring_free(file);
+        return -1;
+    }
+
+    fish_page_header_t h;
+    header_from_chain(&h, chain);
+    h.source_size = fish_file_size(source);
+    h.source_mtime = fish_file_mtime(source);
+    fish_row_writer_put(&out, (const char *)&h, sizeof(h));
+
+    uint64_t at = sizeof(h) + chain->count * sizeof(fish_page_entry_t);
+    for (size_t i = 0; i < chain->count; i++) {
+        fish_page_entry_t e;
+        e.offset = at + i * sizeof(fossil_ai_jellyfish_block_t);
+        e.commit_index = chain->commits[i].identity.commit_index;
+        e.valid = chain->commits[i].attributes.valid ? 1u : 0u;
+        fish_row_writer_put(&out, (const char *)&e, sizeof(e));
+    }
+    fish_row_writer_put(&out, (const char *)chain->commits, chain->count * sizeof(fossil_ai_jellyfish_block_t));
+
+    int rc = fish_row_writer_commit(&out);
+    fossil_io_cstring_free(source);
+    fossil_io_cstring_free(file);
+    return rc;
+}
+
+/* ---------------- opening ---------------- */
+
+static int page_map(fish_page_t *page, uint64_t size) {
+    if (size == 0 || size > (uint64_t)SIZE_MAX) return -1;
+#ifdef _WIN32
+    HANDLE file = (HANDLE)_get_osfhandle(_fileno(page->file.file));
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) return -1;
+    const char *view = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, (size_t)size);
+    if (!view) {
+        CloseHandle(mapping);
+        return -1;
+    }
+    page->map_handle = mapping;
+#else
+    void *view = mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE, fileno(page->file.file), 0);
+    if (view == MAP_FAILED) return -1;
+#  ifdef MADV_RANDOM
+    madvise(view, (size_t)size, MADV_RANDOM);
+#  endif
+#endif
+    page->map = (const char *)view;
+    page->map_len = (size_t)size;
+    return 0;
+}
+
+/* open an existing page file; -1 if missing, foreign or stale */
+static int page_read(fish_page_t *page, ccstring model_name) {
+    cstring source = chain_path(model_name);
+    cstring file = page_path(model_name);
+    int rc = -1;
+
+    if (source && file && fossil_io_file_file_exists(file) &&
+        fossil_io_file_open(&page->file, file, "rb") == 0) {
+        fish_page_header_t *h = &page->header;
+        uint64_t size = fish_file_size(file);
+        int ok = fossil_io_file_read(&page->file, h, 1, sizeof(*h)) == sizeof(*h) &&
+                 memcmp(h->magic, FISH_PAGE_MAGIC, sizeof(h->magic)) == 0 &&
+                 h->version == FISH_PAGE_VERSION &&
+                 h->block_size == sizeof(fossil_ai_jellyfish_block_t) &&
+                 h->source_size == fish_file_size(source) &&
+                 h->source_mtime == fish_file_mtime(source) &&
+                 h->count <= (size - sizeof(*h)) / (sizeof(fish_page_entry_t) + sizeof(fossil_ai_jellyfish_block_t));
+        if (ok) {
+            size_t n = (size_t)h->count;
+            page->dir = (fish_page_entry_t *)fossil_sys_memory_alloc((n ? n : 1) * sizeof(fish_page_entry_t));
+            ok = page->dir && fossil_io_file_read(&page->file, page->dir, sizeof(fish_page_entry_t), n) == n;
+            for (size_t i = 0; ok && i < n; i++)
+                ok = page->dir[i].offset + sizeof(fossil_ai_jellyfish_block_t) <= size;
+        }
+        if (ok && page_map(page, size) != 0) {
+            /* no mapping: read commits one by one as they are asked for */
+            page->cache = (fossil_ai_jellyfish_block_t **)fossil_sys_memory_calloc(
+                h->count ? (size_t)h->count : 1, sizeof(fossil_ai_jellyfish_block_t *));
+            ok = page->cache != NULL;
+        }
+        if (ok) rc = 0;
+        else fish_page_close(page);
+    }
+    fossil_io_cstring_free(source);
+    fossil_io_cstring_free(file);
+    return rc;
+}
+
+int fish_page_open(fish_page_t *page, ccstring model_name) {
+    fossil_sys_memory_zero(page, sizeof(*page));
+    FISH_TRACE_BEGIN(trace);
+    if (page_read(page, model_name) == 0) {
+        FISH_TRACE_END(FISH_STAGE_LOAD, trace, page->header.count);
+        return 0;
+    }
+
+    /* missing or stale: one full load, then the page file serves later opens */
+    cstring source = chain_path(model_name);
+    fossil_ai_jellyfish_chain_t *chain = (fossil_ai_jellyfish_chain_t *)
+        fossil_sys_memory_calloc(1, sizeof(fossil_ai_jellyfish_chain_t));
+    int loaded = source && chain && fossil_io_file_file_exists(source) &&
+                 fish_chain_load(chain, source) == 0;
+    fossil_io_cstring_free(source);
+    if (!loaded) {
+        fossil_sys_memory_free(chain);
+        return -1;
+    }
+
+    if (fish_page_write(chain, model_name) == 0 && page_read(page, model_name) == 0) {
+        fossil_sys_memory_free(chain);
+        return 0;
+    }
+    /* read-only directory: serve this open from the loaded chain */
+    fossil_sys_memory_zero(page, sizeof(*page));
+    header_from_chain(&page->header, chain);
+    page->chain = chain;
+    return 0;
+}
+
+const fossil_ai_jellyfish_block_t *fish_page_commit(fish_page_t *page, size_t pos) {
+    if (pos >= page->header.count) return NULL;
+    if (page->chain) return &page->chain->commits[pos];
+    if (page->map) return (const fossil_ai_jellyfish_block_t *)(page->map + page->dir[pos].offset);
+
+    if (!page->cache[pos]) {
+        fossil_ai_jellyfish_block_t *b = (fossil_ai_jellyfish_block_t *)fossil_sys_memory_alloc(sizeof(*b));
+        if (!b) return NULL;
+        if (fish_fseek64(page->file.file, (long long)page->dir[pos].offset, SEEK_SET) != 0 ||
+            fossil_io_file_read(&page->file, b, sizeof(*b), 1) != 1) {
+            fossil_sys_memory_free(b);
+            return NULL;
+        }
+        page->cache[pos] = b;
+    }
+    return page->cache[pos];
+}
+
+void fish_page_close(fish_page_t *page) {
+    if (page->map) {
+#ifdef _WIN32
+        UnmapViewOfFile(page->map);
+        CloseHandle((HANDLE)page->map_handle);
+#else
+        munmap((void *)page->map, page->map_len);
+#endif
+    }
+    if (page->cache) {
+        for (size_t i = 0; i < page->header.count; i++) fossil_sys_memory_free(page->cache[i]);
+        fossil_sys_memory_free(page->cache);
+    }
+    if (fossil_io_file_is_open(&page->file)) fossil_io_file_close(&page->file);
+    fossil_sys_memory_free(page->dir);
+    fossil_sys_memory_free(page->chain);
+    fossil_sys_memory_zero(page, sizeof(*page));
+}
@@ -11,30 +11,18 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
-#include "fossil/code/commands.h"
+#include "fossil/code/rowmap.h"
+#include "fossil/code/scan.h"
+#include "fossil/code/schema.h"
+#include "fossil/code/workspace.h"
 
-#define MAX_LINES 200000
 #define MAX_LINE_LEN 4096
 
 /* ---------------- tokenization helpers ---------------- */
 
-static void tokenize_field(const char *in, char *out, size_t outsz) {
-    cstring tmp = fossil_io_cstring_create(in);
-    cstring lower = fossil_io_cstring_to_lower(tmp);
-    size_t w = 0;
-    for (size_t i = 0; lower[i] && w + 1 < outsz; i++) {
-        if (isalnum((unsigned char)lower[i])) {
-            out[w++] = lower[i];
-        } else {
-            if (w > 0 && out[w-1] != ' ')
-                out[w++] = ' ';
-        }
-    }
-    if (w > 0 && out[w-1] == ' ')
-        w--;
-    out[w] = '\0';
-    fossil_io_cstring_free(lower);
-    fossil_io_cstring_free(tmp);
+/* lowercase alnum runs separated by single spaces, written straight from the slice */
+static size_t tokenize_field(fish_slice_t in, char *out, size_t outsz) {
+    return fish_scan_tokens(in, out, outsz);
 }
 
 /* ---------------- categorical encoding ---------------- */
@@ -53,154 +41,144 @@ static int encode_category(const char *s) {
     return (int)(code % 1000000);
 }
 
-/* ---------------- numeric utilities ---------------- */
-
-static int is_numeric(const char *s) {
-    char *end;
-    strtod(s, &end);
-    return end != s;
-}
+/* ---------------- per-row transform ---------------- */
 
-/* ---------------- main preprocess function ---------------- */
+typedef struct {
+    int tokenize;
+    int scale;
+    int encode;
+    const fish_schema_t *schema;
+} preprocess_job_t;
 
-int fish_dataset_preprocess(int tokenize, int scale, int encode)
-{
-    const char *path = "datasets/current.dataset";
-    fossil_io_file_t file_stream;
+static int process_row(void *ctx, fish_row_map_worker_t *worker, fish_slice_t row, uint64_t index) {
+    const preprocess_job_t *job = (const preprocess_job_t *)ctx;
+    const fish_schema_t *schema = job->schema;
+    fish_row_writer_t *writer = &worker->out;
+    fish_row_fields_t *fields = &worker->fields;
 
-    if (fossil_io_file_open(&file_stream, path, "r") != 0 || !fossil_io_file_is_open(&file_stream)) {
-        fossil_io_printf("{red,bold}fish_dataset_preprocess: no active dataset.{normal}\n");
-        return -1;
+    if (schema->has_header) {
+        if (index == 0) return fish_row_writer_write(writer, row.ptr, row.len);
+        index--;
     }
 
-    cstring *rows = (cstring *)fossil_sys_memory_alloc(sizeof(cstring) * MAX_LINES);
-    if (!rows) { fossil_io_file_close(&file_stream); return -1; }
+    size_t fc = fish_row_fields_split(fields, row);
+    const double *values = fc ? fish_schema_values_at(schema, index, fields, &worker->values, &worker->values_cap) : NULL;
+    if (!values) return -1;
+
+    for (size_t c = 0; c < fc; c++) {
+        char buf[MAX_LINE_LEN];
+        fish_slice_t field = fields->field[c];
+        double v = values[c];
+        int numeric = !isnan(v);
+
+        /* --- TOKENIZE TEXT --- */
+        if (job->tokenize && !numeric) {
+            field.len = tokenize_field(field, buf, sizeof(buf));
+            field.ptr = buf;
+            numeric = fish_slice_to_double(field, &v);
+        }
 
-    size_t count = 0;
-    char buf[MAX_LINE_LEN];
+        /* --- ENCODE CATEGORICAL --- */
+        if (job->encode && !numeric) {
+            if (field.ptr != buf) fish_slice_copy(field, buf, sizeof(buf));
+            v = (double)encode_category(buf);
+            field.len = (size_t)snprintf(buf, sizeof(buf), "%d", (int)v);
+            field.ptr = buf;
+            numeric = 1;
+        }
 
-    /* ---------- LOAD ---------- */
-    while (fgets(buf, sizeof(buf), file_stream.file)) {
-        if (count >= MAX_LINES) break;
-        rows[count++] = fossil_io_cstring_create(buf);
-    }
-    fossil_io_file_close(&file_stream);
+        /* --- SCALE NUMERIC --- */
+        if (job->scale && numeric && fish_schema_scalable(schema, c)) {
+            const fish_schema_column_t *col = &schema->col[c];
+            double scaled = (v - col->min) / (col->max - col->min);
+            field.len = (size_t)snprintf(buf, sizeof(buf), "%.6f", scaled);
+            field.ptr = buf;
+        }
 
-    if (count == 0) {
-        fossil_io_printf("{yellow,bold}fish_dataset_preprocess: dataset empty.{normal}\n");
-        fossil_sys_memory_free(rows);
-        return 0;
+        /* write field */
+        fish_row_writer_put_field(writer, field);
+        if (c + 1 < fc)
+            fish_row_writer_put(writer, ",", 1);
     }
+    return fish_row_writer_end_row(writer);
+}
 
-    /* count columns */
-    size_t cols = 1;
-    for (char *p = rows[0]; *p; p++)
-        if (*p == ',') cols++;
+/* ---------------- main preprocess function ---------------- */
 
-    /* storage for scaling */
-    double *minv = NULL;
-    double *maxv = NULL;
+/**
+ * @brief Preprocess the dataset (tokenize, scale, encode).
+ *
+ * Streams the selected dataset record by record into a temp file that
+ * atomically replaces it; a header row is copied through untouched.
+ * Records are transformed on every core by fish_row_map() and written in
+ * their original order. Scaling adds one read-only pass beforehand that
+ * infers the schema, collecting per-column min/max and caching parsed
+ * values for the rewrite.
+ */
+int fish_dataset_preprocess(int tokenize, int scale, int encode)
+{
+    const char *path = fish_workspace_path();
+    fish_row_reader_t reader;
+    fish_row_writer_t writer;
+    fish_schema_t schema;
+    preprocess_job_t job = { tokenize, scale, encode, &schema };
 
-    if (scale) {
-        minv = (double *)fossil_sys_memory_alloc(sizeof(double) * cols);
-        maxv = (double *)fossil_sys_memory_alloc(sizeof(double) * cols);
-        for (size_t c = 0; c < cols; c++) {
-            minv[c] = 1e300;
-            maxv[c] = -1e300;
-        }
+    if (fish_row_reader_open_csv(&reader, path) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_preprocess: no active dataset.{normal}\n");
+        return -1;
+    }
 
+    fish_schema_init(&schema, scale ? FISH_SCHEMA_CACHE_BUDGET : 0);
+    int failed = 0;
+    if (scale) {
         /* scan numeric min/max */
-        for (size_t i = 0; i < count; i++) {
-            cstring row = fossil_io_cstring_create(rows[i]);
-            cstring saveptr = NULL;
-            cstring tok = fossil_io_cstring_token(row, ",", &saveptr);
-            size_t c = 0;
-
-            while (tok && c < cols) {
-                if (is_numeric(tok)) {
-                    double v = atof(tok);
-                    if (v < minv[c]) minv[c] = v;
-                    if (v > maxv[c]) maxv[c] = v;
-                }
-                tok = fossil_io_cstring_token(NULL, ",", &saveptr);
-                c++;
-            }
-            fossil_io_cstring_free(row);
-        }
-
-        fossil_io_printf("{green,bold}fish_dataset_preprocess: numeric scaling enabled.{normal}\n");
+        failed = fish_schema_infer(&schema, path) != 0;
+        if (!failed) fossil_io_printf("{green,bold}fish_dataset_preprocess: numeric scaling enabled.{normal}\n");
+    } else {
+        /* only the header has to be known up front */
+        fish_row_fields_t fields = {0};
+        fish_slice_t row;
+        if (fish_row_reader_next(&reader, &row)) failed = fish_schema_add(&schema, &fields, row) < 0;
+        fish_row_fields_free(&fields);
+        if (fish_row_reader_rewind(&reader) != 0) failed = 1;
+    }
+    if (failed) {
+        fish_schema_free(&schema);
+        fish_row_reader_close(&reader);
+        fossil_io_printf("{red,bold}fish_dataset_preprocess: memory allocation failed.{normal}\n");
+        return -1;
     }
 
     /* ---------- PROCESS ---------- */
-    for (size_t i = 0; i < count; i++) {
-        char out[MAX_LINE_LEN];
-        out[0] = '\0';
-
-        cstring row = fossil_io_cstring_create(rows[i]);
-        cstring saveptr = NULL;
-        cstring tok = fossil_io_cstring_token(row, ",", &saveptr);
-        size_t c = 0;
-
-        while (tok && c < cols) {
-            char field[MAX_LINE_LEN];
-            strncpy(field, tok, MAX_LINE_LEN - 1);
-            field[MAX_LINE_LEN - 1] = '\0';
-
-            /* --- TOKENIZE TEXT --- */
-            if (tokenize && !is_numeric(field)) {
-                char tokbuf[MAX_LINE_LEN];
-                tokenize_field(field, tokbuf, sizeof(tokbuf));
-                strncpy(field, tokbuf, MAX_LINE_LEN - 1);
-                field[MAX_LINE_LEN - 1] = '\0';
-            }
-
-            /* --- ENCODE CATEGORICAL --- */
-            if (encode && !is_numeric(field)) {
-                int code = encode_category(field);
-                snprintf(field, sizeof(field), "%d", code);
-            }
-
-            /* --- SCALE NUMERIC --- */
-            if (scale && is_numeric(field)) {
-                double v = atof(field);
-                if (maxv[c] > minv[c]) {
-                    double scaled = (v - minv[c]) / (maxv[c] - minv[c]);
-                    snprintf(field, sizeof(field), "%.6f", scaled);
-                }
-            }
-
-            /* write field */
-            strncat(out, field, MAX_LINE_LEN - strlen(out) - 1);
-            if (c + 1 < cols)
-                strncat(out, ",", MAX_LINE_LEN - strlen(out) - 1);
-
-            tok = fossil_io_cstring_token(NULL, ",", &saveptr);
-            c++;
-        }
-
-        fossil_io_cstring_free(rows[i]);
-        rows[i] = fossil_io_cstring_create(out);
-        fossil_io_cstring_free(row);
+    if (fish_row_writer_open(&writer, path) != 0) {
+        fish_schema_free(&schema);
+        fish_row_reader_close(&reader);
+        fossil_io_printf("{red,bold}fish_dataset_preprocess: failed to write dataset.{normal}\n");
+        return -1;
     }
 
-    if (scale) {
-        fossil_sys_memory_free(minv);
-        fossil_sys_memory_free(maxv);
-    }
+    failed = fish_row_map(&reader, &writer, process_row, &job, 0) != 0;
 
-    /* ---------- SAVE ---------- */
-    if (fossil_io_file_open(&file_stream, path, "w") != 0 || !fossil_io_file_is_open(&file_stream)) {
+    size_t count = reader.rows;
+    fish_row_reader_close(&reader);
+    fish_schema_free(&schema);
+
+    if (failed) {
+        fish_row_writer_abort(&writer);
         fossil_io_printf("{red,bold}fish_dataset_preprocess: failed to write dataset.{normal}\n");
         return -1;
     }
-
-    for (size_t i = 0; i < count; i++) {
-        fputs(rows[i], file_stream.file);
-        fossil_io_cstring_free(rows[i]);
+    if (count == 0) {
+        fish_row_writer_abort(&writer);
+        fossil_io_printf("{yellow,bold}fish_dataset_preprocess: dataset empty.{normal}\n");
+        return 0;
     }
 
-    fossil_sys_memory_free(rows);
-    fossil_io_file_close(&file_stream);
+    /* ---------- SAVE ---------- */
+    if (fish_row_writer_commit(&writer) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_preprocess: failed to write dataset.{normal}\n");
+        return -1;
+    }
 
     fossil_io_printf("{cyan,bold}fish_dataset_preprocess: completed successfully.{normal}\n");
     return 0;
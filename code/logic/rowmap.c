@@ -0,0 +1,93 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/rowmap.h"
+#include "fossil/code/thread.h"
+
+typedef struct {
+    fish_row_map_fn fn;
+    void *ctx;
+    fish_row_map_worker_t *worker;
+    size_t workers;             /* active for this window */
+    fish_slice_t *row;
+    size_t count;
+    uint64_t first;             /* input index of row[0] */
+} map_window_t;
+
+static void map_worker(void *arg, size_t index) {
+    map_window_t *win = (map_window_t *)arg;
+    fish_row_map_worker_t *worker = &win->worker[index];
+    size_t lo = win->count * index / win->workers;
+    size_t hi = win->count * (index + 1) / win->workers;
+
+    for (size_t i = lo; i < hi && !worker->failed; i++)
+        if (win->fn(win->ctx, worker, win->row[i], win->first + i) != 0) worker->failed = 1;
+}
+
+/* Copy the next window of records into the arena; returns how many were read. */
+static size_t map_read(fish_row_reader_t *reader, fish_arena_t *arena, fish_slice_t *rows) {
+    fish_slice_t row;
+    size_t count = 0;
+
+    fish_arena_reset(arena);
+    while (count < FISH_ROW_MAP_WINDOW_ROWS && fish_row_reader_next(reader, &row)) {
+        char *copy = fish_arena_strndup(arena, row);
+        if (!copy) return SIZE_MAX;
+        rows[count].ptr = copy;
+        rows[count].len = row.len;
+        count++;
+    }
+    return reader->failed ? SIZE_MAX : count;
+}
+
+int fish_row_map(fish_row_reader_t *reader, fish_row_writer_t *writer,
+                 fish_row_map_fn fn, void *ctx, size_t threads) {
+    if (threads == 0) threads = fish_thread_count();
+    if (threads > FISH_THREAD_MAX) threads = FISH_THREAD_MAX;
+
+    map_window_t win = { fn, ctx, NULL, 0, NULL, 0, 0 };
+    fish_arena_t arena;
+    int rc = 0;
+
+    fish_arena_init(&arena, 0);
+    win.worker = (fish_row_map_worker_t *)fossil_sys_memory_calloc(threads, sizeof(fish_row_map_worker_t));
+    win.row = (fish_slice_t *)fossil_sys_memory_alloc(FISH_ROW_MAP_WINDOW_ROWS * sizeof(fish_slice_t));
+    if (!win.worker || !win.row) rc = -1;
+    for (size_t i = 0; rc == 0 && i < threads; i++) fish_row_writer_open_mem(&win.worker[i].out);
+
+    while (rc == 0) {
+        win.first = reader->rows;
+        win.count = map_read(reader, &arena, win.row);
+        if (win.count == SIZE_MAX) rc = -1;
+        if (win.count == 0 || rc != 0) break;
+
+        /* small windows are not worth waking every thread for */
+        win.workers = win.count / FISH_ROW_MAP_MIN_ROWS;
+        if (win.workers < 1) win.workers = 1;
+        if (win.workers > threads) win.workers = threads;
+        fish_thread_run(win.workers, map_worker, &win);
+
+        for (size_t i = 0; rc == 0 && i < win.workers; i++)
+            if (win.worker[i].failed || fish_row_writer_drain(writer, &win.worker[i].out) != 0) rc = -1;
+    }
+
+    for (size_t i = 0; win.worker && i < threads; i++) {
+        fish_row_writer_abort(&win.worker[i].out);
+        fish_row_fields_free(&win.worker[i].fields);
+        fossil_sys_memory_free(win.worker[i].values);
+    }
+    fossil_sys_memory_free(win.worker);
+    fossil_sys_memory_free(win.row);
+    fish_arena_free(&arena);
+    return rc;
+}
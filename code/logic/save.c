@@ -12,12 +12,18 @@
  * -----------------------------------------------------------------------------
  */
 #include "fossil/code/commands.h"
+#include "fossil/code/store.h"
+#include "fossil/code/trace.h"
+#include "fossil/code/zchain.h"
 
 /**
  * @brief Save an AI model to a file using fossil_io_file_t streams.
  *
  * Models are stored in "<model>.jfchain".
- * This function loads the model using fossil_ai_jellyfish_load and saves a copy using fossil_ai_jellyfish_save.
+ * This function loads the model and saves a copy: "bin" through
+ * fossil_ai_jellyfish_save, "zchain" in the block-compressed layout of
+ * zchain.h, "ref" as a ref into the local commit store (store.h), which
+ * copies no commits at all. All are read back by fish_load and fish_inspect.
  * Uses fossil_sys_memory_strdup and fossil_sys_memory_free for string memory management.
  */
 int fish_save(ccstring model_name, ccstring file_path, ccstring format)
@@ -27,9 +33,11 @@ int fish_save(ccstring model_name, ccstring file_path, ccstring format)
         return -1;
     }
 
-    /* Only binary export is meaningful */
-    if (!fossil_io_cstring_iequals(format, "bin")) {
-        fossil_io_printf("{yellow,bold}fish_save: unsupported format '%s' (only 'bin' allowed).{normal}\n", format);
+    /* Only binary exports are meaningful */
+    int compressed = fossil_io_cstring_iequals(format, "zchain");
+    int ref = fossil_io_cstring_iequals(format, "ref");
+    if (!compressed && !ref && !fossil_io_cstring_iequals(format, "bin")) {
+        fossil_io_printf("{yellow,bold}fish_save: unsupported format '%s' (use 'bin', 'zchain' or 'ref').{normal}\n", format);
         return -1;
     }
 
@@ -45,13 +53,17 @@ int fish_save(ccstring model_name, ccstring file_path, ccstring format)
     fossil_ai_jellyfish_chain_t chain;
     fossil_ai_jellyfish_init(&chain);
 
-    if (fossil_ai_jellyfish_load(&chain, src_path) != 0) {
+    if (fish_chain_load(&chain, src_path) != 0) {
         fossil_io_printf("{red,bold}fish_save: failed to load model from '%s'{normal}\n", src_path);
         fossil_sys_memory_free(src_path);
         return -1;
     }
 
-    int result = fossil_ai_jellyfish_save(&chain, file_path);
+    FISH_TRACE_BEGIN(trace);
+    int result = ref ? fish_store_save(&chain, file_path, NULL)
+               : compressed ? fish_zchain_save(&chain, file_path)
+               : fossil_ai_jellyfish_save(&chain, file_path);
+    FISH_TRACE_END(FISH_STAGE_SAVE, trace, chain.count);
     fossil_sys_memory_free(src_path);
 
     if (result == 0) {
@@ -0,0 +1,527 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/scan.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#  define SCAN_SSE2 1
+#  include <emmintrin.h>
+#  if defined(__GNUC__) || defined(__clang__)
+#    define SCAN_AVX2 1
+#    include <immintrin.h>
+#    define SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#  endif
+#endif
+#if (defined(__aarch64__) || defined(_M_ARM64)) && !defined(__ARM_BIG_ENDIAN)
+#  define SCAN_NEON 1
+#  include <arm_neon.h>
+#endif
+
+/* Inputs shorter than this stay on the scalar loop: not worth a vector */
+#define SCAN_SHORT 16
+
+/* Bytes classified per bitmap */
+#define SCAN_BLOCK 64
+
+#define SWAR_ONES  0x0101010101010101ull
+#define SWAR_LOW7  0x7F7F7F7F7F7F7F7Full
+
+typedef struct {
+    size_t (*find)(const char *p, size_t len, char a, char b, char c);
+    size_t (*count)(const char *p, size_t len, char c);
+    uint64_t (*mask)(const char *p, fish_scan_class_t cls);    /* SCAN_BLOCK bytes */
+    void (*lower)(char *out, const char *p, size_t len);
+} scan_ops_t;
+
+static unsigned scan_ctz(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(v);
+#else
+    unsigned n = 0;
+    while (!(v & 1)) { v >>= 1; n++; }
+    return n;
+#endif
+}
+
+static unsigned scan_popcount(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_popcountll(v);
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (unsigned)((v * SWAR_ONES) >> 56);
+#endif
+}
+
+/* ---------------- scalar ---------------- */
+
+static int in_class(unsigned char ch, fish_scan_class_t cls) {
+    if (cls == FISH_SCAN_SPACE) return ch == ' ' || (unsigned)(ch - '\t') < 5;
+    return (unsigned)(ch - '0') < 10 || (unsigned)((ch | 0x20) - 'a') < 26;
+}
+
+static size_t scalar_run(const char *p, size_t len, fish_scan_class_t cls, int in) {
+    size_t i = 0;
+    while (i < len && in_class((unsigned char)p[i], cls) == in) i++;
+    return i;
+}
+
+static uint64_t scalar_mask(const char *p, fish_scan_class_t cls) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < SCAN_BLOCK; i++)
+        bits |= (uint64_t)in_class((unsigned char)p[i], cls) << i;
+    return bits;
+}
+
+static void scalar_lower(char *out, const char *p, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned char ch = (unsigned char)p[i];
+        out[i] = (char)((unsigned)(ch - 'A') < 26 ? ch | 0x20 : ch);
+    }
+}
+
+/* 0x80 in every byte of @p w equal to the byte repeated in @p pat, exact (no carries) */
+static uint64_t swar_eq(uint64_t w, uint64_t pat) {
+    uint64_t x = w ^ pat;
+    return ~(((x & SWAR_LOW7) + SWAR_LOW7) | x | SWAR_LOW7);
+}
+
+/* index of the first flagged byte in memory order */
+static size_t swar_first(uint64_t mask) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#  if defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_clzll(mask) / 8;
+#  else
+    size_t n = 0;
+    while (!(mask & 0x8000000000000000ull)) { mask <<= 8; n++; }
+    return n;
+#  endif
+#else
+    return scan_ctz(mask) / 8;
+#endif
+}
+
+static size_t scalar_find(const char *p, size_t len, char a, char b, char c) {
+    uint64_t pa = SWAR_ONES * (unsigned char)a;
+    uint64_t pb = SWAR_ONES * (unsigned char)b;
+    uint64_t pc = SWAR_ONES * (unsigned char)c;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        uint64_t m = swar_eq(w, pa) | swar_eq(w, pb) | swar_eq(w, pc);
+        if (m) return i + swar_first(m);
+    }
+    for (; i < len; i++)
+        if (p[i] == a || p[i] == b || p[i] == c) return i;
+    return len;
+}
+
+static size_t scalar_count(const char *p, size_t len, char c) {
+    uint64_t pat = SWAR_ONES * (unsigned char)c;
+    size_t i = 0, n = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        n += scan_popcount(swar_eq(w, pat));
+    }
+    for (; i < len; i++) n += p[i] == c;
+    return n;
+}
+
+static const scan_ops_t scalar_ops = { scalar_find, scalar_count, scalar_mask, scalar_lower };
+
+/* ---------------- SSE2 ---------------- */
+
+#ifdef SCAN_SSE2
+
+static __m128i sse2_class(__m128i v, fish_scan_class_t cls) {
+    /* signed compares: bytes >= 0x80 are negative and fall outside every range */
+    if (cls == FISH_SCAN_SPACE)
+        return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                            _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)),
+                                          _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1))));
+    __m128i l = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    return _mm_or_si128(_mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1))),
+                        _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)),
+                                      _mm_cmplt_epi8(l, _mm_set1_epi8('z' + 1))));
+}
+
+static size_t sse2_find(const char *p, size_t len, char a, char b, char c) {
+    const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+                                 _mm_cmpeq_epi8(v, vc));
+        unsigned bits = (unsigned)_mm_movemask_epi8(m);
+        if (bits) return i + scan_ctz(bits);
+    }
+    return i + scalar_find(p + i, len - i, a, b, c);
+}
+
+static size_t sse2_count(const char *p, size_t len, char c) {
+    const __m128i vc = _mm_set1_epi8(c);
+    size_t i = 0, n = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        n += scan_popcount((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vc)));
+    }
+    return n + scalar_count(p + i, len - i, c);
+}
+
+static uint64_t sse2_mask(const char *p, fish_scan_class_t cls) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < SCAN_BLOCK; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        bits |= (uint64_t)(unsigned)_mm_movemask_epi8(sse2_class(v, cls)) << i;
+    }
+    return bits;
+}
+
+static void sse2_lower(char *out, const char *p, size_t len) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        v = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        _mm_storeu_si128((__m128i *)(out + i), v);
+    }
+    scalar_lower(out + i, p + i, len - i);
+}
+
+static const scan_ops_t sse2_ops = { sse2_find, sse2_count, sse2_mask, sse2_lower };
+
+#endif /* SCAN_SSE2 */
+
+/* ---------------- AVX2 ---------------- */
+
+#ifdef SCAN_AVX2
+
+SCAN_TARGET_AVX2 static __m256i avx2_class(__m256i v, fish_scan_class_t cls) {
+    if (cls == FISH_SCAN_SPACE)
+        return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                               _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('\t' - 1)),
+                                                _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), v)));
+    __m256i l = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    return _mm256_or_si256(_mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+                                            _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v)),
+                           _mm256_and_si256(_mm256_cmpgt_epi8(l, _mm256_set1_epi8('a' - 1)),
+                                            _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), l)));
+}
+
+SCAN_TARGET_AVX2 static size_t avx2_find(const char *p, size_t len, char a, char b, char c) {
+    const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b), vc = _mm256_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)),
+                                    _mm256_cmpeq_epi8(v, vc));
+        unsigned bits = (unsigned)_mm256_movemask_epi8(m);
+        if (bits) return i + scan_ctz(bits);
+    }
+    _mm256_zeroupper(); /* the tail runs legacy SSE code */
+    return i + sse2_find(p + i, len - i, a, b, c);
+}
+
+SCAN_TARGET_AVX2 static size_t avx2_count(const char *p, size_t len, char c) {
+    const __m256i vc = _mm256_set1_epi8(c);
+    size_t i = 0, n = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        n += scan_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vc)));
+    }
+    _mm256_zeroupper();
+    return n + sse2_count(p + i, len - i, c);
+}
+
+SCAN_TARGET_AVX2 static uint64_t avx2_mask(const char *p, fish_scan_class_t cls) {
+    __m256i lo = _mm256_loadu_si256((const __m256i *)p);
+    __m256i hi = _mm256_loadu_si256((const __m256i *)(p + 32));
+    return (uint64_t)(unsigned)_mm256_movemask_epi8(avx2_class(lo, cls)) |
+           (uint64_t)(unsigned)_mm256_movemask_epi8(avx2_class(hi, cls)) << 32;
+}
+
+SCAN_TARGET_AVX2 static void avx2_lower(char *out, const char *p, size_t len) {
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+        v = _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+        _mm256_storeu_si256((__m256i *)(out + i), v);
+    }
+    _mm256_zeroupper();
+    sse2_lower(out + i, p + i, len - i);
+}
+
+static const scan_ops_t avx2_ops = { avx2_find, avx2_count, avx2_mask, avx2_lower };
+
+#endif /* SCAN_AVX2 */
+
+/* ---------------- NEON ---------------- */
+
+#ifdef SCAN_NEON
+
+/* 4 bits per byte of a 0x00/0xFF compare result */
+static uint64_t neon_mask(uint8x16_t m) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+}
+
+static uint8x16_t neon_class(uint8x16_t v, fish_scan_class_t cls) {
+    if (cls == FISH_SCAN_SPACE)
+        return vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vcltq_u8(vsubq_u8(v, vdupq_n_u8('\t')), vdupq_n_u8(5)));
+    uint8x16_t l = vorrq_u8(v, vdupq_n_u8(0x20));
+    return vorrq_u8(vcltq_u8(vsubq_u8(v, vdupq_n_u8('0')), vdupq_n_u8(10)),
+                    vcltq_u8(vsubq_u8(l, vdupq_n_u8('a')), vdupq_n_u8(26)));
+}
+
+static size_t neon_find(const char *p, size_t len, char a, char b, char c) {
+    const uint8x16_t va = vdupq_n_u8((uint8_t)a), vb = vdupq_n_u8((uint8_t)b), vc = vdupq_n_u8((uint8_t)c);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)p + i);
+        uint64_t bits = neon_mask(vorrq_u8(vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb)), vceqq_u8(v, vc)));
+        if (bits) return i + scan_ctz(bits) / 4;
+    }
+    return i + scalar_find(p + i, len - i, a, b, c);
+}
+
+static size_t neon_count(const char *p, size_t len, char c) {
+    const uint8x16_t vc = vdupq_n_u8((uint8_t)c);
+    size_t i = 0, n = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)p + i);
+        n += vaddvq_u8(vandq_u8(vceqq_u8(v, vc), vdupq_n_u8(1)));
+    }
+    return n + scalar_count(p + i, len - i, c);
+}
+
+/* one bit per byte for four compare results, byte i of the block at bit i */
+static uint64_t neon_bits(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3) {
+    static const uint8_t weight[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t w = vld1q_u8(weight);
+    uint8x16_t sum = vpaddq_u8(vpaddq_u8(vandq_u8(m0, w), vandq_u8(m1, w)),
+                               vpaddq_u8(vandq_u8(m2, w), vandq_u8(m3, w)));
+    sum = vpaddq_u8(sum, sum);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+}
+
+static uint64_t neon_mask64(const char *p, fish_scan_class_t cls) {
+    const uint8_t *u = (const uint8_t *)p;
+    return neon_bits(neon_class(vld1q_u8(u), cls), neon_class(vld1q_u8(u + 16), cls),
+                     neon_class(vld1q_u8(u + 32), cls), neon_class(vld1q_u8(u + 48), cls));
+}
+
+static void neon_lower(char *out, const char *p, size_t len) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)p + i);
+        uint8x16_t upper = vcltq_u8(vsubq_u8(v, vdupq_n_u8('A')), vdupq_n_u8(26));
+        vst1q_u8((uint8_t *)out + i, vorrq_u8(v, vandq_u8(upper, vdupq_n_u8(0x20))));
+    }
+    scalar_lower(out + i, p + i, len - i);
+}
+
+static const scan_ops_t neon_ops = { neon_find, neon_count, neon_mask64, neon_lower };
+
+#endif /* SCAN_NEON */
+
+/* ---------------- dispatch ---------------- */
+
+static const scan_ops_t *scan_ops = NULL;
+static fish_scan_isa_t scan_current = FISH_SCAN_SCALAR;
+
+static const scan_ops_t *ops_for(fish_scan_isa_t isa) {
+    switch (isa) {
+        case FISH_SCAN_SCALAR: return &scalar_ops;
+#ifdef SCAN_SSE2
+        case FISH_SCAN_SSE2: return &sse2_ops;
+#endif
+#ifdef SCAN_AVX2
+        case FISH_SCAN_AVX2: return __builtin_cpu_supports("avx2") ? &avx2_ops : NULL;
+#endif
+#ifdef SCAN_NEON
+        case FISH_SCAN_NEON: return &neon_ops;
+#endif
+        default: return NULL;
+    }
+}
+
+/* widest set available; every thread resolves to the same one */
+static const scan_ops_t *ops(void) {
+    if (scan_ops) return scan_ops;
+    fish_scan_isa_t isa = FISH_SCAN_ISA_COUNT;
+    const scan_ops_t *found = NULL;
+    while (!found) found = ops_for(--isa);
+    scan_current = isa;
+    scan_ops = found;
+    return found;
+}
+
+fish_scan_isa_t fish_scan_isa(void) {
+    ops();
+    return scan_current;
+}
+
+int fish_scan_select(fish_scan_isa_t isa) {
+    const scan_ops_t *found = ops_for(isa);
+    if (!found) return -1;
+    scan_current = isa;
+    scan_ops = found;
+    return 0;
+}
+
+ccstring fish_scan_isa_name(fish_scan_isa_t isa) {
+    static const char *const names[FISH_SCAN_ISA_COUNT] = { "scalar", "sse2", "avx2", "neon" };
+    return isa < FISH_SCAN_ISA_COUNT ? names[isa] : "unknown";
+}
+
+/* ---------------- kernels ---------------- */
+
+size_t fish_scan_find(const char *p, size_t len, char a, char b, char c) {
+    return len < SCAN_SHORT ? scalar_find(p, len, a, b, c) : ops()->find(p, len, a, b, c);
+}
+
+size_t fish_scan_count(const char *p, size_t len, char c) {
+    return len < SCAN_SHORT ? scalar_count(p, len, c) : ops()->count(p, len, c);
+}
+
+/* class bits of the block at @p p; bytes past @p len are in no class */
+static uint64_t block_mask(const char *p, size_t len, fish_scan_class_t cls) {
+    if (len >= SCAN_BLOCK) return ops()->mask(p, cls);
+    char pad[SCAN_BLOCK] = { 0 };
+    memcpy(pad, p, len);
+    return ops()->mask(pad, cls) & ((1ull << len) - 1);
+}
+
+static size_t run_length(const char *p, size_t len, fish_scan_class_t cls, int in) {
+    if (len < SCAN_SHORT) return scalar_run(p, len, cls, in);
+    for (size_t i = 0; i < len; i += SCAN_BLOCK) {
+        size_t n = len - i < SCAN_BLOCK ? len - i : SCAN_BLOCK;
+        uint64_t bits = block_mask(p + i, n, cls);
+        uint64_t stop = in ? ~bits : bits;
+        if (n < SCAN_BLOCK) stop |= ~0ull << n;
+        if (stop) return i + scan_ctz(stop);
+    }
+    return len;
+}
+
+size_t fish_scan_span(const char *p, size_t len, fish_scan_class_t cls) {
+    return run_length(p, len, cls, 1);
+}
+
+size_t fish_scan_cspan(const char *p, size_t len, fish_scan_class_t cls) {
+    return run_length(p, len, cls, 0);
+}
+
+static void cursor_load(fish_scan_cursor_t *c) {
+    c->base = c->pos - c->pos % SCAN_BLOCK;
+    size_t n = c->len - c->base < SCAN_BLOCK ? c->len - c->base : SCAN_BLOCK;
+    uint64_t bits = block_mask(c->ptr + c->base, n, c->cls);
+    if (!c->in) bits = ~bits & (n < SCAN_BLOCK ? (1ull << n) - 1 : ~0ull);
+    c->bits = bits;
+}
+
+void fish_scan_cursor_init(fish_scan_cursor_t *cursor, fish_slice_t s, fish_scan_class_t cls, int in) {
+    cursor->ptr = s.ptr;
+    cursor->len = s.len;
+    cursor->pos = 0;
+    cursor->cls = cls;
+    cursor->in = in;
+    if (s.len) cursor_load(cursor);
+}
+
+int fish_scan_cursor_next(fish_scan_cursor_t *c, fish_slice_t *run) {
+    /* first byte of the run: next set bit */
+    for (;;) {
+        if (c->pos >= c->len) return 0;
+        if (c->pos >= c->base + SCAN_BLOCK) cursor_load(c);
+        uint64_t bits = c->bits >> (c->pos - c->base);
+        if (bits) {
+            c->pos += scan_ctz(bits);
+            break;
+        }
+        c->pos = c->base + SCAN_BLOCK;
+    }
+    size_t start = c->pos;
+    /* one past its end: next clear bit, bytes past the text count as clear */
+    for (;;) {
+        if (c->pos >= c->len) break;
+        if (c->pos >= c->base + SCAN_BLOCK) cursor_load(c);
+        uint64_t bits = ~c->bits >> (c->pos - c->base);
+        if (bits) {
+            c->pos += scan_ctz(bits);
+            break;
+        }
+        c->pos = c->base + SCAN_BLOCK;
+    }
+    if (c->pos > c->len) c->pos = c->len;
+    run->ptr = c->ptr + start;
+    run->len = c->pos - start;
+    return 1;
+}
+
+void fish_scan_lower(char *out, const char *p, size_t len) {
+    if (len < SCAN_SHORT) scalar_lower(out, p, len);
+    else ops()->lower(out, p, len);
+}
+
+size_t fish_scan_tokens(fish_slice_t in, char *out, size_t cap) {
+    char low[SCAN_BLOCK + 16];      /* lowercased block; the tail slack lets short words go out in one store */
+    size_t w = 0;
+    int in_word = 0;                /* the previous block ended inside a word */
+    int full = 0;
+    if (cap == 0) return 0;
+
+    for (size_t base = 0; base < in.len && !full; base += SCAN_BLOCK) {
+        size_t n = in.len - base < SCAN_BLOCK ? in.len - base : SCAN_BLOCK;
+        const char *block = in.ptr + base;
+        if (n < SCAN_BLOCK) {
+            fossil_sys_memory_zero(low, sizeof(low));
+            memcpy(low, block, n);
+            block = low;
+        }
+        uint64_t bits = ops()->mask(block, FISH_SCAN_ALNUM);
+        int ends_in_word = n == SCAN_BLOCK && (bits >> 63);
+        ops()->lower(low, block, SCAN_BLOCK);
+
+        while (bits && !full) {
+            size_t start = scan_ctz(bits);
+            uint64_t rest = ~(bits >> start);
+            size_t end = rest ? start + scan_ctz(rest) : SCAN_BLOCK;
+            if (end > SCAN_BLOCK) end = SCAN_BLOCK;
+            if (w > 0 && !(start == 0 && in_word)) {
+                if (w + 1 >= cap) {
+                    full = 1;
+                    break;
+                }
+                out[w++] = ' ';
+            }
+            size_t len = end - start;
+            size_t copy = len < cap - 1 - w ? len : cap - 1 - w;
+            if (copy <= 16 && w + 16 <= cap) memcpy(out + w, low + start, 16);
+            else memcpy(out + w, low + start, copy);
+            w += copy;
+            full = copy < len;
+            bits = end < SCAN_BLOCK ? bits & (~0ull << end) : 0;
+        }
+        in_word = ends_in_word;
+    }
+    if (w > 0 && out[w - 1] == ' ') w--;
+    out[w] = '\0';
+    return w;
+}
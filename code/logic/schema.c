@@ -0,0 +1,236 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/schema.h"
+
+/* ---------------- values ---------------- */
+
+/* Value of a field that is a number once trimmed, as columnar types it. */
+static int field_value(fish_slice_t field, double *v) {
+    fish_slice_t s = fish_slice_trim(field);
+    return fish_slice_is_number(s) && fish_slice_to_double(s, v);
+}
+
+/* Type of one field; @p v receives the value of numeric ones. */
+static fish_schema_type_t classify(fish_slice_t field, double *v) {
+    fish_slice_t s = fish_slice_trim(field);
+    if (!field_value(s, v))
+        return s.len ? FISH_SCHEMA_TEXT : FISH_SCHEMA_EMPTY;
+    for (size_t i = 0; i < s.len; i++) {
+        char ch = s.ptr[i];
+        if (ch == '.' || ch == 'e' || ch == 'E') return FISH_SCHEMA_FLOAT;
+    }
+    return FISH_SCHEMA_INT;
+}
+
+static int add_columns(fish_schema_t *schema, size_t count) {
+    if (count <= schema->columns) return 0;
+    if (count > schema->cap) {
+        size_t cap = schema->cap ? schema->cap : 16;
+        while (cap < count) cap *= 2;
+        fish_schema_column_t *grown = (fish_schema_column_t *)fossil_sys_memory_realloc(
+            schema->col, cap * sizeof(fish_schema_column_t));
+        if (!grown) return -1;
+        schema->col = grown;
+        schema->cap = cap;
+    }
+    for (size_t c = schema->columns; c < count; c++) {
+        fish_schema_column_t *col = &schema->col[c];
+        fossil_sys_memory_zero(col, sizeof(*col));
+        col->name = fossil_io_cstring_format("column%zu", c + 1);
+        if (!col->name) return -1;
+        col->min = 1e300;
+        col->max = -1e300;
+        schema->columns = c + 1;
+    }
+    return 0;
+}
+
+static int cache_put(fish_schema_t *schema, const double *v, size_t count) {
+    if (schema->cache_full) return 0;
+    size_t need = schema->cache_len + count + 1;
+    size_t rows = (size_t)schema->cache_rows + 1;
+    if (need + rows > schema->cache_limit) {
+        /* later records are parsed again on replay */
+        schema->cache_full = 1;
+        return 0;
+    }
+    if (need > schema->cache_cap) {
+        size_t cap = schema->cache_cap ? schema->cache_cap * 2 : 65536;
+        while (cap < need) cap *= 2;
+        double *grown = (double *)fossil_sys_memory_realloc(schema->cache, cap * sizeof(double));
+        if (!grown) {
+            schema->cache_full = 1;
+            return 0;
+        }
+        schema->cache = grown;
+        schema->cache_cap = cap;
+    }
+    if (rows > schema->cache_at_cap) {
+        size_t cap = schema->cache_at_cap ? schema->cache_at_cap * 2 : 16384;
+        size_t *grown = (size_t *)fossil_sys_memory_realloc(schema->cache_at, cap * sizeof(size_t));
+        if (!grown) {
+            schema->cache_full = 1;
+            return 0;
+        }
+        schema->cache_at = grown;
+        schema->cache_at_cap = cap;
+    }
+    schema->cache_at[schema->cache_rows++] = schema->cache_len;
+    schema->cache[schema->cache_len++] = (double)count;
+    fossil_sys_memory_copy(schema->cache + schema->cache_len, v, count * sizeof(double));
+    schema->cache_len += count;
+    return 0;
+}
+
+static double *values_reserve(double **values, size_t *values_cap, size_t count) {
+    if (count > *values_cap) {
+        size_t cap = *values_cap ? *values_cap : 16;
+        while (cap < count) cap *= 2;
+        double *grown = (double *)fossil_sys_memory_realloc(*values, cap * sizeof(double));
+        if (!grown) return NULL;
+        *values = grown;
+        *values_cap = cap;
+    }
+    return *values;
+}
+
+/* ---------------- header ---------------- */
+
+int fish_schema_is_header(const fish_row_fields_t *fields) {
+    for (size_t c = 0; c < fields->count; c++) {
+        double v;
+        fish_slice_t name = fish_slice_trim(fields->field[c]);
+        if (classify(name, &v) != FISH_SCHEMA_TEXT) return 0;
+        for (size_t d = 0; d < c; d++) {
+            fish_slice_t other = fish_slice_trim(fields->field[d]);
+            if (other.len == name.len && fossil_io_cstring_iequals_safe(other.ptr, name.ptr, name.len)) return 0;
+        }
+    }
+    return 1;
+}
+
+static int take_header(fish_schema_t *schema, const fish_row_fields_t *fields) {
+    if (add_columns(schema, fields->count) != 0) return -1;
+    for (size_t c = 0; c < fields->count; c++) {
+        fish_slice_t name = fish_slice_trim(fields->field[c]);
+        cstring copy = (cstring)fossil_sys_memory_alloc(name.len + 1);
+        if (!copy) return -1;
+        fish_slice_copy(name, copy, name.len + 1);
+        fossil_sys_memory_free(schema->col[c].name);
+        schema->col[c].name = copy;
+    }
+    schema->has_header = 1;
+    return 0;
+}
+
+/* ---------------- schema ---------------- */
+
+void fish_schema_init(fish_schema_t *schema, size_t cache_budget) {
+    fossil_sys_memory_zero(schema, sizeof(*schema));
+    schema->cache_limit = cache_budget / sizeof(double);
+}
+
+int fish_schema_add(fish_schema_t *schema, fish_row_fields_t *fields, fish_slice_t row) {
+    size_t fc = fish_row_fields_split(fields, row);
+    if (fc == 0) return -1;
+
+    if (!schema->seen) {
+        schema->seen = 1;
+        if (fish_schema_is_header(fields)) return take_header(schema, fields) == 0 ? 1 : -1;
+    }
+
+    double *v = values_reserve(&schema->values, &schema->values_cap, fc);
+    if (!v || add_columns(schema, fc) != 0) return -1;
+    for (size_t c = 0; c < fc; c++) {
+        fish_schema_column_t *col = &schema->col[c];
+        fish_schema_type_t type = classify(fields->field[c], &v[c]);
+        if (type > col->type) col->type = type;
+        if (type == FISH_SCHEMA_INT || type == FISH_SCHEMA_FLOAT) {
+            col->numeric++;
+            if (v[c] < col->min) col->min = v[c];
+            if (v[c] > col->max) col->max = v[c];
+        } else {
+            v[c] = NAN;
+        }
+    }
+    schema->rows++;
+    return cache_put(schema, v, fc);
+}
+
+int fish_schema_infer(fish_schema_t *schema, ccstring path) {
+    fish_row_reader_t reader;
+    fish_row_fields_t fields = {0};
+    fish_slice_t row;
+    int rc = 0;
+
+    if (fish_row_reader_open_csv(&reader, path) != 0) return -1;
+    while (rc == 0 && fish_row_reader_next(&reader, &row))
+        rc = fish_schema_add(schema, &fields, row) < 0 ? -1 : 0;
+    if (reader.failed) rc = -1;
+    fish_row_reader_close(&reader);
+    fish_row_fields_free(&fields);
+
+    if (rc == 0) fish_schema_rewind(schema);
+    return rc;
+}
+
+void fish_schema_rewind(fish_schema_t *schema) {
+    schema->complete = 1;
+    schema->replay = 0;
+}
+
+const double *fish_schema_values_at(const fish_schema_t *schema, uint64_t row,
+                                    const fish_row_fields_t *fields,
+                                    double **scratch, size_t *scratch_cap) {
+    size_t fc = fields->count;
+
+    if (row < schema->cache_rows) {
+        const double *entry = schema->cache + schema->cache_at[row];
+        if ((size_t)entry[0] == fc) return entry + 1;
+    }
+
+    double *v = values_reserve(scratch, scratch_cap, fc);
+    if (!v) return NULL;
+    for (size_t c = 0; c < fc; c++) {
+        int skip = schema->complete && c < schema->columns && schema->col[c].numeric == 0;
+        if (skip || !field_value(fields->field[c], &v[c])) v[c] = NAN;
+    }
+    return v;
+}
+
+const double *fish_schema_values(fish_schema_t *schema, const fish_row_fields_t *fields) {
+    return fish_schema_values_at(schema, schema->replay++, fields, &schema->values, &schema->values_cap);
+}
+
+int fish_schema_scalable(const fish_schema_t *schema, size_t col) {
+    return col < schema->columns && schema->col[col].max > schema->col[col].min;
+}
+
+ccstring fish_schema_type_name(fish_schema_type_t type) {
+    switch (type) {
+    case FISH_SCHEMA_INT: return "int";
+    case FISH_SCHEMA_FLOAT: return "float";
+    case FISH_SCHEMA_TEXT: return "text";
+    default: return "empty";
+    }
+}
+
+void fish_schema_free(fish_schema_t *schema) {
+    for (size_t c = 0; c < schema->columns; c++) fossil_sys_memory_free(schema->col[c].name);
+    fossil_sys_memory_free(schema->col);
+    fossil_sys_memory_free(schema->cache);
+    fossil_sys_memory_free(schema->cache_at);
+    fossil_sys_memory_free(schema->values);
+    fossil_sys_memory_zero(schema, sizeof(*schema));
+}
@@ -0,0 +1,562 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/cache.h"
+#include "fossil/code/commands.h"
+#include "fossil/code/model.h"
+#include "fossil/code/scan.h"
+
+/*
+ * fish serve: a long-running process that keeps models resident and
+ * answers ask/chat requests, so clients no longer pay process start-up
+ * and a full chain load per question.
+ *
+ *   unix:<path>        line protocol, one request per line:
+ *                        ask <model> <prompt>
+ *                        explain <model> <prompt>
+ *                        chat <model> <message>
+ *                        ping | stats | quit
+ *                      replies "OK <found> <confidence> <text>" or "ERR <reason>"
+ *   [<host>:]<port>    HTTP/1.1, one request per connection:
+ *                        POST /ask?model=<m>[&explain=1]   body = prompt
+ *                        POST /chat?model=<m>              body = message
+ *                        GET  /health              status and answer cache counters
+ *                      replies are JSON
+ *
+ * Every worker thread accepts on the shared listening socket; models are
+ * shared between workers under their reader/writer locks.
+ */
+
+#define SERVE_LINE_MAX   4096
+#define SERVE_HEADER_MAX 8192
+#define SERVE_BODY_MAX   ((size_t)64 << 10)
+#define SERVE_POLL_MS    200
+#define SERVE_BACKLOG    128
+#define SERVE_IO_TIMEOUT 10 /* seconds a client may stall mid-request */
+
+#ifdef _WIN32
+
+/*
+ * The server is written against POSIX sockets, poll() and Unix domain
+ * sockets; there is no Winsock port, so `fish serve` is left out of the
+ * Windows build's help and only reports that it is unavailable.
+ */
+int fish_serve(const char *endpoint, const char *models, size_t workers)
+{
+    (void)endpoint;
+    (void)models;
+    (void)workers;
+    fossil_io_printf("{red,bold}fish_serve: not supported on Windows.{normal}\n");
+    return -1;
+}
+
+#else
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t serve_stop = 0;
+
+static void serve_on_signal(int sig) {
+    (void)sig;
+    serve_stop = 1;
+}
+
+typedef struct {
+    int listen_fd;
+    int http;
+    volatile size_t served;
+    volatile size_t failed;
+} serve_ctx_t;
+
+/* ---------------- socket helpers ---------------- */
+
+static int send_all(int fd, const char *buf, size_t len) {
+    while (len) {
+        ssize_t n = send(fd, buf, len, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* buffered reader over a connected socket */
+typedef struct {
+    int fd;
+    char buf[SERVE_HEADER_MAX];
+    size_t start;
+    size_t end;
+} conn_t;
+
+static int conn_fill(conn_t *c) {
+    if (c->start > 0) {
+        memmove(c->buf, c->buf + c->start, c->end - c->start);
+        c->end -= c->start;
+        c->start = 0;
+    }
+    if (c->end == sizeof(c->buf)) return -1;
+    for (;;) {
+        ssize_t n = recv(c->fd, c->buf + c->end, sizeof(c->buf) - c->end, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        c->end += (size_t)n;
+        return 0;
+    }
+}
+
+/* next '\n'-terminated line without the terminator (and any '\r'); -1 at EOF or overflow */
+static int conn_line(conn_t *c, char *line, size_t cap) {
+    for (;;) {
+        char *nl = (char *)memchr(c->buf + c->start, '\n', c->end - c->start);
+        if (nl) {
+            size_t len = (size_t)(nl - (c->buf + c->start));
+            if (len && c->buf[c->start + len - 1] == '\r') len--;
+            if (len >= cap) return -1;
+            memcpy(line, c->buf + c->start, len);
+            line[len] = '\0';
+            c->start = (size_t)(nl - c->buf) + 1;
+            return 0;
+        }
+        if (conn_fill(c) != 0) return -1;
+    }
+}
+
+static int conn_read(conn_t *c, char *out, size_t len) {
+    while (len) {
+        if (c->start == c->end && conn_fill(c) != 0) return -1;
+        size_t take = c->end - c->start;
+        if (take > len) take = len;
+        memcpy(out, c->buf + c->start, take);
+        c->start += take;
+        out += take;
+        len -= take;
+    }
+    return 0;
+}
+
+/* ---------------- request handling ---------------- */
+
+typedef enum { SERVE_ASK, SERVE_CHAT } serve_op_t;
+
+typedef struct {
+    int found;
+    float confidence;
+    char text[FISH_MODEL_REPLY_MAX];
+    char explain[256];
+} serve_reply_t;
+
+static int serve_answer(serve_op_t op, ccstring model_name, ccstring prompt, int explain,
+                        serve_reply_t *reply, ccstring *error) {
+    /* clients only reach preloaded models or ones saved on disk */
+    fish_model_t *model = fish_model_acquire_existing(model_name);
+    if (!model) {
+        *error = !fish_model_valid_name(model_name) ? "invalid model name"
+               : !fish_model_exists(model_name) ? "unknown model" : "model failed to load";
+        return -1;
+    }
+    reply->explain[0] = '\0';
+    if (op == SERVE_CHAT) {
+        reply->found = fish_model_chat(model, prompt, 1, reply->text, sizeof(reply->text), &reply->confidence);
+    } else {
+        reply->found = fish_model_ask(model, prompt, reply->text, sizeof(reply->text), &reply->confidence,
+                                      explain ? reply->explain : NULL, sizeof(reply->explain));
+    }
+    return 0;
+}
+
+static void flatten(char *s) {
+    for (; *s; ++s) {
+        if (*s == '\n' || *s == '\r') *s = ' ';
+    }
+}
+
+static void serve_unix(serve_ctx_t *ctx, int fd) {
+    conn_t *c = (conn_t *)fossil_sys_memory_calloc(1, sizeof(conn_t));
+    if (!c) return;
+    c->fd = fd;
+
+    char line[SERVE_LINE_MAX];
+    char out[SERVE_LINE_MAX + 64];
+    serve_reply_t reply;
+    while (!serve_stop && conn_line(c, line, sizeof(line)) == 0) {
+        char *verb = line;
+        char *model = strchr(verb, ' ');
+        if (model) *model++ = '\0';
+        char *text = model ? strchr(model, ' ') : NULL;
+        if (text) *text++ = '\0';
+
+        ccstring error = NULL;
+        if (strcmp(verb, "ping") == 0) {
+            snprintf(out, sizeof(out), "OK pong\n");
+        } else if (strcmp(verb, "stats") == 0) {
+            snprintf(out, sizeof(out), "OK cache_hit=%llu cache_miss=%llu\n",
+                     (unsigned long long)fish_cache_hits(),
+                     (unsigned long long)fish_cache_misses());
+        } else if (strcmp(verb, "quit") == 0) {
+            break;
+        } else if (!text || !*text) {
+            error = "usage: ask|explain|chat <model> <text>";
+        } else if (strcmp(verb, "ask") == 0 || strcmp(verb, "explain") == 0 || strcmp(verb, "chat") == 0) {
+            serve_op_t op = strcmp(verb, "chat") == 0 ? SERVE_CHAT : SERVE_ASK;
+            if (serve_answer(op, model, text, verb[0] == 'e', &reply, &error) == 0) {
+                if (reply.explain[0]) {
+                    size_t len = strlen(reply.text);
+                    snprintf(reply.text + len, sizeof(reply.text) - len, " (%s)", reply.explain);
+                }
+                flatten(reply.text);
+                snprintf(out, sizeof(out), "OK %d %.2f %s\n", reply.found, reply.confidence, reply.text);
+            }
+        } else {
+            error = "unknown command";
+        }
+
+        if (error) {
+            snprintf(out, sizeof(out), "ERR %s\n", error);
+            fish_thread_claim(&ctx->failed);
+        }
+        fish_thread_claim(&ctx->served);
+        if (send_all(fd, out, strlen(out)) != 0) break;
+    }
+    fossil_sys_memory_free(c);
+}
+
+static int hex_value(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+/* value of @p key in a query string, percent-decoded into @p out */
+static int query_get(ccstring query, ccstring key, char *out, size_t cap) {
+    size_t klen = strlen(key);
+    for (ccstring p = query; p && *p; ) {
+        ccstring amp = strchr(p, '&');
+        size_t len = amp ? (size_t)(amp - p) : strlen(p);
+        if (len > klen && strncmp(p, key, klen) == 0 && p[klen] == '=') {
+            size_t o = 0;
+            for (size_t i = klen + 1; i < len && o + 1 < cap; ++i) {
+                int hi, lo;
+                if (p[i] == '%' && i + 2 < len && (hi = hex_value(p[i + 1])) >= 0 && (lo = hex_value(p[i + 2])) >= 0) {
+                    out[o++] = (char)(hi * 16 + lo);
+                    i += 2;
+                } else {
+                    out[o++] = p[i] == '+' ? ' ' : p[i];
+                }
+            }
+            out[o] = '\0';
+            return 1;
+        }
+        p = amp ? amp + 1 : NULL;
+    }
+    return 0;
+}
+
+static void http_send(int fd, int status, ccstring reason, ccstring body) {
+    char head[256];
+    size_t len = strlen(body);
+    int n = snprintf(head, sizeof(head),
+        "HTTP/1.1 %d %s\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: close\r\n\r\n",
+        status, reason, len);
+    if (send_all(fd, head, (size_t)n) == 0) send_all(fd, body, len);
+}
+
+static void http_error(serve_ctx_t *ctx, int fd, int status, ccstring reason, ccstring message) {
+    char body[256];
+    snprintf(body, sizeof(body), "{\"error\":\"%s\"}", message);
+    http_send(fd, status, reason, body);
+    fish_thread_claim(&ctx->failed);
+}
+
+static void json_field(cstring *body, ccstring key, ccstring value, int comma) {
+    cstring escaped = fossil_io_cstring_escape_json(value);
+    cstring field = fossil_io_cstring_format("%s\"%s\":\"%s\"", comma ? "," : "", key, escaped ? escaped : "");
+    if (field) fossil_io_cstring_append(body, field);
+    fossil_io_cstring_free(field);
+    fossil_io_cstring_free(escaped);
+}
+
+static void serve_http(serve_ctx_t *ctx, int fd) {
+    conn_t *c = (conn_t *)fossil_sys_memory_calloc(1, sizeof(conn_t));
+    if (!c) return;
+    c->fd = fd;
+    fish_thread_claim(&ctx->served);
+
+    char line[SERVE_LINE_MAX];
+    char method[16], target[SERVE_LINE_MAX];
+    if (conn_line(c, line, sizeof(line)) != 0 ||
+        sscanf(line, "%15s %4095s", method, target) != 2) {
+        http_error(ctx, fd, 400, "Bad Request", "malformed request line");
+        fossil_sys_memory_free(c);
+        return;
+    }
+
+    size_t content_length = 0;
+    for (;;) {
+        if (conn_line(c, line, sizeof(line)) != 0) {
+            http_error(ctx, fd, 400, "Bad Request", "malformed headers");
+            fossil_sys_memory_free(c);
+            return;
+        }
+        if (!line[0]) break;
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_length = (size_t)strtoull(line + 15, NULL, 10);
+        }
+    }
+
+    char *query = strchr(target, '?');
+    if (query) *query++ = '\0';
+
+    if (strcmp(target, "/health") == 0) {
+        char health[128];
+        snprintf(health, sizeof(health), "{\"status\":\"ok\",\"cache_hit\":%llu,\"cache_miss\":%llu}",
+                 (unsigned long long)fish_cache_hits(),
+                 (unsigned long long)fish_cache_misses());
+        http_send(fd, 200, "OK", health);
+        fossil_sys_memory_free(c);
+        return;
+    }
+
+    int is_ask = strcmp(target, "/ask") == 0;
+    if (!is_ask && strcmp(target, "/chat") != 0) {
+        http_error(ctx, fd, 404, "Not Found", "unknown endpoint");
+        fossil_sys_memory_free(c);
+        return;
+    }
+    if (strcmp(method, "POST") != 0) {
+        http_error(ctx, fd, 405, "Method Not Allowed", "use POST");
+        fossil_sys_memory_free(c);
+        return;
+    }
+
+    char model[256], flag[8];
+    if (!query_get(query, "model", model, sizeof(model))) {
+        http_error(ctx, fd, 400, "Bad Request", "missing model parameter");
+        fossil_sys_memory_free(c);
+        return;
+    }
+    if (content_length == 0 || content_length > SERVE_BODY_MAX) {
+        http_error(ctx, fd, 413, "Payload Too Large", "body must be 1 byte to 64 KiB");
+        fossil_sys_memory_free(c);
+        return;
+    }
+    int explain = query_get(query, "explain", flag, sizeof(flag)) && strcmp(flag, "0") != 0;
+
+    char *prompt = (char *)fossil_sys_memory_alloc(content_length + 1);
+    if (!prompt || conn_read(c, prompt, content_length) != 0) {
+        if (prompt) http_error(ctx, fd, 400, "Bad Request", "truncated body");
+        fossil_sys_memory_free(prompt);
+        fossil_sys_memory_free(c);
+        return;
+    }
+    prompt[content_length] = '\0';
+    prompt[fish_scan_find(prompt, content_length, '\r', '\n', '\n')] = '\0';
+
+    serve_reply_t reply;
+    ccstring error = NULL;
+    if (serve_answer(is_ask ? SERVE_ASK : SERVE_CHAT, model, prompt, explain, &reply, &error) != 0) {
+        http_error(ctx, fd, 400, "Bad Request", error);
+    } else {
+        char head[96];
+        snprintf(head, sizeof(head), "{\"found\":%s,\"confidence\":%.4f",
+                 reply.found ? "true" : "false", reply.confidence);
+        cstring body = fossil_io_cstring_create(head);
+        json_field(&body, "model", model, 1);
+        json_field(&body, is_ask ? "answer" : "reply", reply.text, 1);
+        if (explain) json_field(&body, "explanation", reply.explain, 1);
+        fossil_io_cstring_append(&body, "}");
+        http_send(fd, 200, "OK", body ? body : "{}");
+        fossil_io_cstring_free(body);
+    }
+
+    fossil_sys_memory_free(prompt);
+    fossil_sys_memory_free(c);
+}
+
+static void serve_worker(void *arg, size_t index) {
+    serve_ctx_t *ctx = (serve_ctx_t *)arg;
+    (void)index;
+
+    struct pollfd pfd;
+    pfd.fd = ctx->listen_fd;
+    pfd.events = POLLIN;
+    while (!serve_stop) {
+        pfd.revents = 0;
+        int ready = poll(&pfd, 1, SERVE_POLL_MS);
+        if (ready <= 0) continue;
+
+        int fd = accept(ctx->listen_fd, NULL, NULL);
+        if (fd < 0) continue; /* another worker took it, or the client left */
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+
+        struct timeval tv;
+        tv.tv_sec = SERVE_IO_TIMEOUT;
+        tv.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+        if (ctx->http) serve_http(ctx, fd);
+        else serve_unix(ctx, fd);
+        close(fd);
+    }
+}
+
+/* ---------------- listening ---------------- */
+
+static int listen_unix(ccstring path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fossil_io_printf("{red,bold}fish_serve: socket path too long.{normal}\n");
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path); /* stale socket from an earlier run */
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SERVE_BACKLOG) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int listen_tcp(ccstring endpoint) {
+    char host[256] = "127.0.0.1";
+    ccstring port = endpoint;
+    ccstring colon = strrchr(endpoint, ':');
+    if (colon) {
+        size_t len = (size_t)(colon - endpoint);
+        if (len >= sizeof(host)) return -1;
+        if (len) {
+            memcpy(host, endpoint, len);
+            host[len] = '\0';
+        }
+        port = colon + 1;
+    }
+
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host, port, &hints, &res) != 0) return -1;
+
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, SERVE_BACKLOG) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+static int preload_models(ccstring models) {
+    if (!models || !*models) return 0;
+    cstring list = fossil_io_cstring_create(models);
+    if (!list) return -1;
+
+    int rc = 0;
+    cstring save = NULL;
+    for (cstring name = fossil_io_cstring_token(list, ",", &save); name;
+         name = fossil_io_cstring_token(NULL, ",", &save)) {
+        name = fossil_io_cstring_trim(name);
+        if (!*name) continue;
+        fish_model_t *model = fish_model_acquire(name);
+        if (!model) {
+            fossil_io_printf("{red,bold}fish_serve: cannot load model '{normal}%s{red,bold}'{normal}\n", name);
+            rc = -1;
+            break;
+        }
+        fossil_io_printf("{cyan}fish_serve: model '%s' %s.{normal}\n", name,
+                         model->loaded ? "resident" : "not found, starting empty");
+    }
+    fossil_io_cstring_free(list);
+    return rc;
+}
+
+int fish_serve(const char *endpoint, const char *models, size_t workers)
+{
+    if (!endpoint || !*endpoint) {
+        fossil_io_printf("{red,bold}fish_serve: endpoint required (unix:<path> or [host:]port).{normal}\n");
+        return -1;
+    }
+    if (workers == 0) workers = fish_thread_count();
+    if (workers > FISH_THREAD_MAX) workers = FISH_THREAD_MAX;
+
+    if (fish_models_init() != 0 || preload_models(models) != 0) {
+        fish_models_release(0);
+        return -1;
+    }
+
+    serve_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    int is_unix = strncmp(endpoint, "unix:", 5) == 0;
+    ctx.http = !is_unix;
+    ctx.listen_fd = is_unix ? listen_unix(endpoint + 5) : listen_tcp(endpoint);
+    if (ctx.listen_fd < 0) {
+        fossil_io_printf("{red,bold}fish_serve: cannot listen on '{normal}%s{red,bold}': %s{normal}\n",
+                         endpoint, strerror(errno));
+        fish_models_release(0);
+        return -1;
+    }
+    /* workers poll before accepting; non-blocking keeps a lost race from stalling one */
+    fcntl(ctx.listen_fd, F_SETFL, fcntl(ctx.listen_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = serve_on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = SIG_IGN; /* a client hanging up mid-reply is not fatal */
+    sigaction(SIGPIPE, &sa, NULL);
+    serve_stop = 0;
+
+    fossil_io_printf("{green,bold}fish_serve: listening on '{normal}%s{green,bold}' (%s, %zu workers).{normal}\n",
+                     endpoint, ctx.http ? "http" : "line protocol", workers);
+
+    fish_thread_run(workers, serve_worker, &ctx);
+
+    close(ctx.listen_fd);
+    if (is_unix) unlink(endpoint + 5);
+
+    fossil_io_printf("{green,bold}fish_serve: stopped after %zu requests (%zu failed); saving learned models.{normal}\n",
+                     ctx.served, ctx.failed);
+    fish_models_release(1);
+    return 0;
+}
+
+#endif
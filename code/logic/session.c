@@ -0,0 +1,194 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/session.h"
+
+/* Characters of each side of a turn kept in a summary */
+#define SESSION_CLIP 96
+
+/* ---------------- text ---------------- */
+
+/* one-line plain copy: the ring and the transcript hold a turn per line */
+static cstring plain_dup(fish_slice_t s) {
+    cstring out = (cstring)fossil_sys_memory_alloc(s.len + 1);
+    if (!out) return NULL;
+    for (size_t i = 0; i < s.len; i++)
+        out[i] = (s.ptr[i] == '\n' || s.ptr[i] == '\r') ? ' ' : s.ptr[i];
+    out[s.len] = '\0';
+    return out;
+}
+
+static fish_slice_t slice_of(ccstring text) {
+    fish_slice_t s = { text, strlen(text) };
+    return s;
+}
+
+/* ---------------- summaries ---------------- */
+
+static void summary_flush(fish_session_t *session) {
+    if (session->summary_len == 0) return;
+    cstring input = fossil_io_cstring_format("%s chat turns %zu-%zu", session->model->name,
+                                             session->summary_first, session->turns);
+    if (input) {
+        fish_model_learn(session->model, input, session->summary);
+        fossil_io_cstring_free(input);
+        session->summaries++;
+    }
+    session->summary_len = 0;
+    session->summary[0] = '\0';
+}
+
+static void summary_fold(fish_session_t *session, const fish_turn_t *turn) {
+    char entry[SESSION_CLIP * 2 + 16];
+    int n = snprintf(entry, sizeof(entry), "%.*s -> %.*s; ",
+                     SESSION_CLIP, turn->user, SESSION_CLIP, turn->reply);
+    if (n <= 0) return;
+    if ((size_t)n >= sizeof(entry)) n = (int)sizeof(entry) - 1;
+
+    if (session->summary_len + (size_t)n >= FISH_SESSION_SUMMARY) summary_flush(session);
+    if (session->summary_len == 0) session->summary_first = session->turns;
+    fossil_sys_memory_copy(session->summary + session->summary_len, entry, (size_t)n);
+    session->summary_len += (size_t)n;
+    session->summary[session->summary_len] = '\0';
+}
+
+/* ---------------- ring ---------------- */
+
+static void ring_evict(fish_session_t *session) {
+    fish_turn_t *turn = &session->turn[session->head];
+    if (session->learn && !turn->learned) summary_fold(session, turn);
+    session->bytes -= strlen(turn->user) + strlen(turn->reply);
+    fossil_sys_memory_free(turn->user);
+    fossil_sys_memory_free(turn->reply);
+    turn->user = NULL;
+    turn->reply = NULL;
+    session->head = (session->head + 1) % FISH_SESSION_TURNS;
+    session->count--;
+}
+
+static int ring_push(fish_session_t *session, fish_slice_t user, fish_slice_t reply, int learned) {
+    size_t bytes = user.len + reply.len;
+    while (session->count == FISH_SESSION_TURNS ||
+           (session->count > 0 && session->bytes + bytes > FISH_SESSION_BYTES))
+        ring_evict(session);
+
+    fish_turn_t *turn = &session->turn[(session->head + session->count) % FISH_SESSION_TURNS];
+    turn->user = plain_dup(user);
+    turn->reply = plain_dup(reply);
+    if (!turn->user || !turn->reply) {
+        fossil_sys_memory_free(turn->user);
+        fossil_sys_memory_free(turn->reply);
+        turn->user = NULL;
+        turn->reply = NULL;
+        return -1;
+    }
+    turn->learned = learned;
+    session->bytes += bytes;
+    session->count++;
+    session->turns++;
+    return 0;
+}
+
+/* ---------------- transcript ---------------- */
+
+/* "user: <message>" then "<model>: <reply>", one turn per line pair */
+static void transcript_restore(fish_session_t *session, ccstring path) {
+    fish_row_reader_t reader;
+    fish_slice_t row;
+    cstring pending = NULL;
+
+    if (fish_row_reader_open(&reader, path) != 0) return;
+    while (fish_row_reader_next(&reader, &row)) {
+        if (row.len >= 6 && memcmp(row.ptr, "user: ", 6) == 0) {
+            fish_slice_t text = { row.ptr + 6, row.len - 6 };
+            fossil_sys_memory_free(pending);
+            pending = plain_dup(text);
+            continue;
+        }
+        const char *sep = pending ? (const char *)memchr(row.ptr, ':', row.len) : NULL;
+        if (!sep) continue;
+        fish_slice_t reply = { sep + 1, row.len - (size_t)(sep + 1 - row.ptr) };
+        if (reply.len && reply.ptr[0] == ' ') {
+            reply.ptr++;
+            reply.len--;
+        }
+        ring_push(session, slice_of(pending), reply, 1);
+        fossil_sys_memory_free(pending);
+        pending = NULL;
+    }
+    fossil_sys_memory_free(pending);
+    fish_row_reader_close(&reader);
+}
+
+static void transcript_append(fish_session_t *session, const fish_turn_t *turn) {
+    if (!session->logging) return;
+    cstring line = fossil_io_cstring_format("user: %s\n%s: %s\n", turn->user, session->model->name, turn->reply);
+    if (!line) {
+        session->log_failed = 1;
+        return;
+    }
+    size_t len = strlen(line);
+    if (fossil_io_file_write(&session->log, line, 1, len) != len ||
+        fossil_io_file_flush(&session->log) != 0)
+        session->log_failed = 1;
+    fossil_io_cstring_free(line);
+}
+
+/* ---------------- session ---------------- */
+
+int fish_session_open(fish_session_t *session, fish_model_t *model, int learn, ccstring save_file) {
+    fossil_sys_memory_zero(session, sizeof(*session));
+    session->model = model;
+    session->learn = learn;
+    if (!save_file) return 0;
+
+    if (fossil_io_file_file_exists(save_file)) transcript_restore(session, save_file);
+    if (fossil_io_file_open(&session->log, save_file, "ab") != 0) {
+        fish_session_close(session);
+        return -1;
+    }
+    session->logging = 1;
+    return 0;
+}
+
+int fish_session_turn(fish_session_t *session, ccstring message,
+                      char *reply, size_t reply_cap, float *confidence) {
+    int learn_now = session->learn && session->commits < FISH_SESSION_COMMITS;
+    int found = fish_model_chat(session->model, message, learn_now, reply, reply_cap, confidence);
+    if (!found && learn_now) session->commits++;
+
+    /* a known answer adds nothing to compact; a learned one is already a commit */
+    if (ring_push(session, slice_of(message), slice_of(reply), found || learn_now) == 0)
+        transcript_append(session, &session->turn[(session->head + session->count - 1) % FISH_SESSION_TURNS]);
+    return found;
+}
+
+void fish_session_print(const fish_session_t *session) {
+    for (size_t i = 0; i < session->count; i++) {
+        const fish_turn_t *turn = &session->turn[(session->head + i) % FISH_SESSION_TURNS];
+        fossil_io_printf("{dim}user:{normal} %s\n{dim}%s:{normal} %s\n",
+                         turn->user, session->model->name, turn->reply);
+    }
+}
+
+int fish_session_close(fish_session_t *session) {
+    /* fold whatever was never learned so the context survives the session */
+    while (session->count > 0) ring_evict(session);
+    if (session->learn) summary_flush(session);
+
+    if (session->logging) {
+        fossil_io_file_close(&session->log);
+        session->logging = 0;
+    }
+    return session->log_failed ? -1 : 0;
+}
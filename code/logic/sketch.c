@@ -0,0 +1,234 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/sketch.h"
+
+/* ---------------- moments ---------------- */
+
+void fish_moments_init(fish_moments_t *m) {
+    m->n = 0;
+    m->mean = 0.0;
+    m->m2 = 0.0;
+    m->min = HUGE_VAL;
+    m->max = -HUGE_VAL;
+}
+
+void fish_moments_add(fish_moments_t *m, double x) {
+    m->n++;
+    double delta = x - m->mean;
+    m->mean += delta / (double)m->n;
+    m->m2 += delta * (x - m->mean);
+    if (x < m->min) m->min = x;
+    if (x > m->max) m->max = x;
+}
+
+void fish_moments_merge(fish_moments_t *dst, const fish_moments_t *src) {
+    if (src->n == 0) return;
+    if (dst->n == 0) {
+        *dst = *src;
+        return;
+    }
+    double na = (double)dst->n, nb = (double)src->n, n = na + nb;
+    double delta = src->mean - dst->mean;
+    dst->mean += delta * nb / n;
+    dst->m2 += src->m2 + delta * delta * na * nb / n;
+    dst->n += src->n;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+double fish_moments_variance(const fish_moments_t *m) {
+    return m->n > 1 ? m->m2 / (double)(m->n - 1) : 0.0;
+}
+
+/* ---------------- HyperLogLog ---------------- */
+
+void fish_hll_init(fish_hll_t *h) {
+    fossil_sys_memory_zero(h->reg, sizeof(h->reg));
+}
+
+void fish_hll_add(fish_hll_t *h, uint64_t digest) {
+    size_t idx = (size_t)(digest >> (64 - FISH_HLL_BITS));
+    /* guard bit caps the rank when the remaining bits are all zero */
+    uint64_t rest = (digest << FISH_HLL_BITS) | (1ull << (FISH_HLL_BITS - 1));
+    uint8_t rank = 1;
+    while (!(rest & 0x8000000000000000ull)) {
+        rest <<= 1;
+        rank++;
+    }
+    if (rank > h->reg[idx]) h->reg[idx] = rank;
+}
+
+void fish_hll_merge(fish_hll_t *dst, const fish_hll_t *src) {
+    for (size_t i = 0; i < FISH_HLL_REGS; i++)
+        if (src->reg[i] > dst->reg[i]) dst->reg[i] = src->reg[i];
+}
+
+double fish_hll_estimate(const fish_hll_t *h) {
+    double m = (double)FISH_HLL_REGS;
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (size_t i = 0; i < FISH_HLL_REGS; i++) {
+        sum += ldexp(1.0, -(int)h->reg[i]);
+        if (h->reg[i] == 0) zeros++;
+    }
+    double est = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+    /* small cardinalities: linear counting is far more accurate */
+    if (est <= 2.5 * m && zeros > 0)
+        est = m * log(m / (double)zeros);
+    return est;
+}
+
+/* ---------------- KLL ---------------- */
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static size_t kll_level_capacity(const fish_kll_t *s, size_t h) {
+    double cap = (double)s->k;
+    for (size_t d = h + 1; d < s->levels; d++) cap *= 2.0 / 3.0;
+    return cap < 2.0 ? 2 : (size_t)cap;
+}
+
+static size_t kll_capacity(const fish_kll_t *s) {
+    size_t total = 0;
+    for (size_t h = 0; h < s->levels; h++) total += kll_level_capacity(s, h);
+    return total;
+}
+
+static int kll_reserve(fish_kll_level_t *lv, size_t need) {
+    if (need <= lv->cap) return 0;
+    size_t cap = lv->cap ? lv->cap : 16;
+    while (cap < need) cap *= 2;
+    double *grown = (double *)fossil_sys_memory_realloc(lv->item, cap * sizeof(double));
+    if (!grown) return -1;
+    lv->item = grown;
+    lv->cap = cap;
+    return 0;
+}
+
+static int kll_add_level(fish_kll_t *s) {
+    fish_kll_level_t *grown = (fish_kll_level_t *)fossil_sys_memory_realloc(
+        s->level, (s->levels + 1) * sizeof(fish_kll_level_t));
+    if (!grown) return -1;
+    s->level = grown;
+    fossil_sys_memory_zero(&s->level[s->levels], sizeof(fish_kll_level_t));
+    s->levels++;
+    return 0;
+}
+
+/* Promote half of the lowest full level until the sketch fits again. */
+static int kll_compress(fish_kll_t *s) {
+    while (s->size > kll_capacity(s)) {
+        size_t h = 0;
+        while (h < s->levels && s->level[h].n < kll_level_capacity(s, h)) h++;
+        if (h == s->levels) break;
+        if (h + 1 == s->levels && kll_add_level(s) != 0) return -1;
+
+        fish_kll_level_t *lv = &s->level[h];
+        fish_kll_level_t *up = &s->level[h + 1];
+        size_t pairs = lv->n / 2;
+        if (kll_reserve(up, up->n + pairs) != 0) return -1;
+
+        qsort(lv->item, lv->n, sizeof(double), compare_double);
+        size_t off = s->toggle;
+        s->toggle ^= 1u;
+        for (size_t i = 0; i < pairs; i++)
+            up->item[up->n++] = lv->item[2 * i + off];
+
+        /* an odd item out stays behind at its current weight */
+        if (lv->n % 2) lv->item[0] = lv->item[lv->n - 1];
+        lv->n %= 2;
+        s->size -= pairs;
+    }
+    return 0;
+}
+
+int fish_kll_init(fish_kll_t *s, size_t k) {
+    fossil_sys_memory_zero(s, sizeof(*s));
+    s->k = k < 8 ? 8 : k;
+    return kll_add_level(s);
+}
+
+int fish_kll_add(fish_kll_t *s, double x) {
+    fish_kll_level_t *lv = &s->level[0];
+    if (kll_reserve(lv, lv->n + 1) != 0) return -1;
+    lv->item[lv->n++] = x;
+    s->size++;
+    s->n++;
+    return s->size > kll_capacity(s) ? kll_compress(s) : 0;
+}
+
+int fish_kll_merge(fish_kll_t *dst, const fish_kll_t *src) {
+    while (dst->levels < src->levels)
+        if (kll_add_level(dst) != 0) return -1;
+    for (size_t h = 0; h < src->levels; h++) {
+        const fish_kll_level_t *from = &src->level[h];
+        fish_kll_level_t *to = &dst->level[h];
+        if (from->n == 0) continue;
+        if (kll_reserve(to, to->n + from->n) != 0) return -1;
+        fossil_sys_memory_copy(to->item + to->n, from->item, from->n * sizeof(double));
+        to->n += from->n;
+        dst->size += from->n;
+    }
+    dst->n += src->n;
+    return kll_compress(dst);
+}
+
+typedef struct {
+    double value;
+    uint64_t weight;
+} kll_weighted_t;
+
+static int compare_weighted(const void *a, const void *b) {
+    return compare_double(&((const kll_weighted_t *)a)->value, &((const kll_weighted_t *)b)->value);
+}
+
+int fish_kll_quantile(const fish_kll_t *s, double q, double *out) {
+    if (s->size == 0) return -1;
+    kll_weighted_t *all = (kll_weighted_t *)fossil_sys_memory_alloc(s->size * sizeof(kll_weighted_t));
+    if (!all) return -1;
+
+    size_t n = 0;
+    uint64_t total = 0;
+    for (size_t h = 0; h < s->levels; h++) {
+        for (size_t i = 0; i < s->level[h].n; i++) {
+            all[n].value = s->level[h].item[i];
+            all[n].weight = 1ull << h;
+            total += all[n].weight;
+            n++;
+        }
+    }
+    qsort(all, n, sizeof(kll_weighted_t), compare_weighted);
+
+    if (q < 0.0) q = 0.0;
+    if (q > 1.0) q = 1.0;
+    double target = q * (double)total;
+    uint64_t seen = 0;
+    size_t i = 0;
+    for (; i + 1 < n; i++) {
+        seen += all[i].weight;
+        if ((double)seen >= target) break;
+    }
+    *out = all[i].value;
+    fossil_sys_memory_free(all);
+    return 0;
+}
+
+void fish_kll_free(fish_kll_t *s) {
+    for (size_t h = 0; h < s->levels; h++) fossil_sys_memory_free(s->level[h].item);
+    fossil_sys_memory_free(s->level);
+    fossil_sys_memory_zero(s, sizeof(*s));
+}
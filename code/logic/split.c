@@ -11,127 +11,339 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
-#include "fossil/code/commands.h"
+#include "fossil/code/meta.h"
+#include "fossil/code/workspace.h"
+
+/* Seed used when the caller passes 0 */
+#define FISH_SPLIT_DEFAULT_SEED 0x73706c6974ull /* "split" */
+
+/* Upper bound on shard / fold count (each output keeps a write buffer) */
+#define FISH_SPLIT_MAX_SHARDS 256
+
+/* ---------------- row keys ---------------- */
+
+typedef struct {
+    fish_row_reader_t reader;
+    fish_row_fields_t fields;
+    long key_col;           /* -1 = whole row */
+    uint64_t seed;
+    uint64_t index;         /* data rows read so far */
+    int has_header;         /* first record is a header, copied to every output */
+} split_input_t;
+
+/* Position of @p name in the header, -1 if absent. */
+static long find_column(fish_slice_t header, ccstring name, fish_row_fields_t *fields) {
+    size_t want = strlen(name);
+    size_t fc = fish_row_fields_split(fields, header);
+    for (size_t c = 0; c < fc; c++) {
+        fish_slice_t col = fish_slice_trim(fields->field[c]);
+        if (col.len != want) continue;
+        size_t i = 0;
+        while (i < want && tolower((unsigned char)col.ptr[i]) == tolower((unsigned char)name[i])) i++;
+        if (i == want) return (long)c;
+    }
+    return -1;
+}
+
+static int split_input_open(split_input_t *in, ccstring path, ccstring key_column,
+                            uint64_t seed, fish_slice_t *header) {
+    fossil_sys_memory_zero(in, sizeof(*in));
+    in->key_col = -1;
+    in->seed = seed ? seed : FISH_SPLIT_DEFAULT_SEED;
+
+    if (fish_row_reader_open_csv(&in->reader, path) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_split: No active dataset found.{normal}\n");
+        return -1;
+    }
+    /* a headerless dataset splits its first record like any other */
+    in->has_header = fish_row_reader_header(&in->reader, &in->fields, header);
+    if (in->has_header < 0) {
+        fish_row_fields_free(&in->fields);
+        fish_row_reader_close(&in->reader);
+        fossil_io_printf("{red,bold}fish_dataset_split: Dataset empty.{normal}\n");
+        return -1;
+    }
+    if (key_column && *key_column) {
+        in->key_col = in->has_header ? find_column(*header, key_column, &in->fields) : -1;
+        if (in->key_col < 0) {
+            fish_row_fields_free(&in->fields);
+            fish_row_reader_close(&in->reader);
+            if (in->has_header)
+                fossil_io_printf("{red,bold}fish_dataset_split: unknown key column '%s'.{normal}\n", key_column);
+            else
+                fossil_io_printf("{red,bold}fish_dataset_split: key column '%s' needs a header row.{normal}\n", key_column);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void split_input_close(split_input_t *in) {
+    fish_row_fields_free(&in->fields);
+    fish_row_reader_close(&in->reader);
+}
+
+/*
+ * Seeded digest of the row's key. Rows sharing a key always land in the
+ * same bucket, and XXH64 reads little-endian everywhere, so assignments
+ * are identical across runs and machines.
+ */
+static uint64_t row_digest(split_input_t *in, fish_slice_t row) {
+    fish_slice_t key = row;
+    if (in->key_col >= 0) {
+        size_t fc = fish_row_fields_split(&in->fields, row);
+        key = (size_t)in->key_col < fc ? fish_slice_trim(in->fields.field[in->key_col])
+                                       : (fish_slice_t){ row.ptr, 0 };
+    }
+    return fish_hash64(key.ptr, key.len, in->seed);
+}
+
+/* Map a digest to a uniform value in [0, 1). */
+static double unit_interval(uint64_t digest) {
+    return (double)(digest >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* ---------------- outputs ---------------- */
+
+/* Open every output and copy the header, if the dataset has one, into each. */
+static int open_outputs(fish_row_writer_t *out, cstring *paths, size_t count, const split_input_t *in,
+                        fish_slice_t header) {
+    for (size_t i = 0; i < count; i++) {
+        if (fish_row_writer_open(&out[i], paths[i]) != 0 ||
+            (in->has_header && fish_row_writer_write(&out[i], header.ptr, header.len) != 0)) {
+            fossil_io_printf("{red,bold}fish_dataset_split: Failed to create output files.{normal}\n");
+            for (size_t j = 0; j <= i && j < count; j++) fish_row_writer_abort(&out[j]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int close_outputs(fish_row_writer_t *out, size_t count, int failed) {
+    for (size_t i = 0; i < count; i++) {
+        if (failed) fish_row_writer_abort(&out[i]);
+        else if (fish_row_writer_commit(&out[i]) != 0) failed = 1;
+    }
+    if (failed) fossil_io_printf("{red,bold}fish_dataset_split: Failed to write output files.{normal}\n");
+    return failed ? -1 : 0;
+}
+
+/* ---------------- train / val / test ---------------- */
 
 /**
  * @brief Split the dataset into train, validation, and test sets.
- * 
+ *
+ * Uses the default seed, whole-row keys and hash (approximate-ratio) mode.
+ * See fish_dataset_split_seeded().
+ *
  * @param train_frac Fraction for training set.
  * @param val_frac Fraction for validation set.
  * @param test_frac Fraction for test set.
  * @return int Status code.
  */
 int fish_dataset_split(float train_frac, float val_frac, float test_frac)
+{
+    return fish_dataset_split_seeded(train_frac, val_frac, test_frac, 0, NULL, 0);
+}
+
+/**
+ * @brief Split the dataset into train, validation, and test sets in one pass.
+ *
+ * Rows stream straight from the dataset into the three outputs; nothing
+ * is held in memory. Hash mode buckets each row by a seeded hash of the
+ * row (or of @p key_column), so the split is reproducible, rows with the
+ * same key never leak across sets and the fractions hold in expectation.
+ * Exact mode takes the row count from the .meta sidecar and uses
+ * selection sampling, giving precisely round(frac * rows) train and val
+ * rows while staying single-pass. Its draw depends on the row position
+ * as well as the row, so it takes no key column: equal keys could land
+ * in different sets. A header row is copied to every output; a dataset
+ * without one (see fish_row_reader_header()) has every record split.
+ *
+ * @param train_frac Fraction for training set.
+ * @param val_frac Fraction for validation set.
+ * @param test_frac Fraction for test set.
+ * @param seed Hash seed (0 = default).
+ * @param key_column Column to hash instead of the whole row (NULL = row).
+ * @param exact Hit the fractions exactly (1) instead of in expectation (0).
+ * @return int Status code (-1 when @p exact is combined with @p key_column).
+ */
+int fish_dataset_split_seeded(float train_frac, float val_frac, float test_frac,
+                              uint64_t seed, const char *key_column, int exact)
 {
     if (train_frac < 0 || val_frac < 0 || test_frac < 0 ||
-        train_frac + val_frac + test_frac != 1.0f) {
+        fabs((double)train_frac + val_frac + test_frac - 1.0) > 1e-4) {
         fossil_io_printf("{red,bold}fish_dataset_split: Fractions must sum to 1.0{normal}\n");
         return -1;
     }
-
-    ccstring dataset_path = "datasets/current.dataset";
-    fossil_io_file_t fin, ftrain, fval, ftest;
-
-    if (fossil_io_file_open(&fin, dataset_path, "r") != 0) {
-        fossil_io_printf("{red,bold}fish_dataset_split: No active dataset found.{normal}\n");
+    if (exact && key_column && *key_column) {
+        fossil_io_printf("{red,bold}fish_dataset_split: --exact cannot keep --key groups together; use one or the other.{normal}\n");
         return -1;
     }
 
-    if (fossil_io_file_open(&ftrain, "datasets/train.dataset", "w") != 0 ||
-        fossil_io_file_open(&fval,   "datasets/val.dataset",   "w") != 0 ||
-        fossil_io_file_open(&ftest,  "datasets/test.dataset",  "w") != 0) {
-        fossil_io_file_close(&fin);
-        if (fossil_io_file_is_open(&ftrain)) fossil_io_file_close(&ftrain);
-        if (fossil_io_file_is_open(&fval))   fossil_io_file_close(&fval);
-        if (fossil_io_file_is_open(&ftest))  fossil_io_file_close(&ftest);
-        fossil_io_printf("{red,bold}fish_dataset_split: Failed to create output files.{normal}\n");
-        return -1;
+    ccstring dataset_path = fish_workspace_path();
+    uint64_t total = 0;
+    if (exact) {
+        fish_meta_t meta;
+        if (fish_meta_sync(&meta, dataset_path) < 0) {
+            fossil_io_printf("{red,bold}fish_dataset_split: No active dataset found.{normal}\n");
+            return -1;
+        }
+        total = meta.rows;
+        fish_meta_free(&meta);
     }
 
-    // Read header
-    char header[4096];
-    if (!fgets(header, sizeof(header), fin.file)) {
-        fossil_io_file_close(&fin); fossil_io_file_close(&ftrain);
-        fossil_io_file_close(&fval); fossil_io_file_close(&ftest);
-        fossil_io_printf("{red,bold}fish_dataset_split: Dataset empty.{normal}\n");
+    split_input_t in;
+    fish_slice_t row;
+    if (split_input_open(&in, dataset_path, key_column, seed, &row) != 0) return -1;
+
+    cstring paths[3] = {
+        fish_workspace_output("train"), fish_workspace_output("val"), fish_workspace_output("test")
+    };
+    fish_row_writer_t out[3];
+    int opened = 0;
+    if (!paths[0] || !paths[1] || !paths[2])
+        fossil_io_printf("{red,bold}fish_dataset_split: Memory allocation failed.{normal}\n");
+    else
+        opened = open_outputs(out, paths, 3, &in, row) == 0;
+    for (int i = 0; i < 3; i++) fossil_io_cstring_free(paths[i]);
+    if (!opened) {
+        split_input_close(&in);
         return -1;
     }
-    fossil_io_fputs(&ftrain, header);
-    fossil_io_fputs(&fval, header);
-    fossil_io_fputs(&ftest, header);
 
-    // Count lines (rows)
-    int row_count = 0;
-    char line[4096];
-    while (fgets(line, sizeof(line), fin.file)) row_count++;
+    /* exact mode: rows still wanted per bucket, drawn without replacement */
+    uint64_t want[3] = { 0, 0, 0 };
+    want[0] = (uint64_t)((double)train_frac * (double)total + 0.5);
+    want[1] = (uint64_t)((double)val_frac * (double)total + 0.5);
+    if (want[0] > total) want[0] = total;
+    if (want[1] > total - want[0]) want[1] = total - want[0];
+    want[2] = total - want[0] - want[1];
+
+    uint64_t count[3] = { 0, 0, 0 };
+    int failed = 0;
+    while (!failed && fish_row_reader_next(&in.reader, &row)) {
+        uint64_t digest = row_digest(&in, row);
+        size_t bucket;
+
+        if (exact && in.index < total) {
+            /* Algorithm S style: P(bucket) = still wanted / rows left */
+            uint64_t left = total - in.index;
+            uint8_t index[8];
+            for (int b = 0; b < 8; b++) index[b] = (uint8_t)(in.index >> (8 * b));
+            uint64_t mixed = fish_hash64(index, sizeof(index), digest); /* little-endian on every host */
+            double u = unit_interval(mixed) * (double)left;
+            bucket = u < (double)want[0] ? 0 : u < (double)(want[0] + want[1]) ? 1 : 2;
+            if (want[bucket] == 0) bucket = want[0] ? 0 : want[1] ? 1 : 2;
+            if (want[bucket]) want[bucket]--;
+        } else {
+            double u = unit_interval(digest);
+            bucket = u < train_frac ? 0 : u < (double)train_frac + val_frac ? 1 : 2;
+        }
 
-    if (row_count == 0) {
-        fossil_io_file_close(&fin); fossil_io_file_close(&ftrain);
-        fossil_io_file_close(&fval); fossil_io_file_close(&ftest);
+        in.index++;
+        count[bucket]++;
+        if (fish_row_writer_write(&out[bucket], row.ptr, row.len) != 0) failed = 1;
+    }
+    if (in.reader.failed) failed = 1;
+    split_input_close(&in);
+
+    if (!failed && in.index == 0) {
         fossil_io_printf("{red,bold}fish_dataset_split: Dataset has no rows.{normal}\n");
+        close_outputs(out, 3, 1);
         return -1;
     }
+    if (close_outputs(out, 3, failed) != 0) return -1;
+
+    fossil_io_printf(
+        "{green,bold}Dataset split completed:{normal} "
+        "{yellow}%llu train{normal}, {cyan}%llu val{normal}, {magenta}%llu test rows{normal}\n",
+        (unsigned long long)count[0], (unsigned long long)count[1], (unsigned long long)count[2]
+    );
+    return 0;
+}
 
-    // Rewind to data lines
-    fossil_io_file_rewind(&fin);
-    fgets(header, sizeof(header), fin.file); // skip header
+/* ---------------- shards / folds ---------------- */
 
-    // Allocate array to shuffle rows using fossil_sys_memory_alloc
-    cstring *rows = (cstring *)fossil_sys_memory_alloc(sizeof(cstring) * row_count);
-    if (!rows) {
-        fossil_io_file_close(&fin); fossil_io_file_close(&ftrain);
-        fossil_io_file_close(&fval); fossil_io_file_close(&ftest);
-        fossil_io_printf("{red,bold}fish_dataset_split: Memory allocation failed.{normal}\n");
+/**
+ * @brief Shard the dataset N ways, or write k-fold train/val pairs.
+ *
+ * Each row goes to shard hash(key) % @p shards in a single streaming
+ * pass, so every worker of a distributed job can take one file. Shards
+ * are written to datasets/shard-<i>.dataset. With @p kfold, fold i uses
+ * shard i as its validation set and all other shards as training data,
+ * written to datasets/fold-<i>.train.dataset and datasets/fold-<i>.val.dataset.
+ * A named dataset prefixes each file with its name (fish_workspace_output()).
+ *
+ * @param shards Number of shards / folds (2 .. FISH_SPLIT_MAX_SHARDS).
+ * @param kfold Write k-fold pairs (1) instead of plain shards (0).
+ * @param seed Hash seed (0 = default).
+ * @param key_column Column to hash instead of the whole row (NULL = row).
+ * @return int Status code.
+ */
+int fish_dataset_shard(size_t shards, int kfold, uint64_t seed, const char *key_column)
+{
+    if (shards < 2 || shards > FISH_SPLIT_MAX_SHARDS) {
+        fossil_io_printf("{red,bold}fish_dataset_split: shard count must be 2..%d.{normal}\n", FISH_SPLIT_MAX_SHARDS);
         return -1;
     }
 
-    int idx = 0;
-    while (fgets(line, sizeof(line), fin.file)) {
-        line[strcspn(line, "\r\n")] = 0;
-        rows[idx] = fossil_io_cstring_create(line);
-        if (!rows[idx]) {
-            fossil_io_printf("{red,bold}fish_dataset_split: Memory allocation failed for row.{normal}\n");
-            for (int j=0; j<idx; ++j) fossil_io_cstring_free(rows[j]);
-            fossil_sys_memory_free(rows);
-            fossil_io_file_close(&fin); fossil_io_file_close(&ftrain);
-            fossil_io_file_close(&fval); fossil_io_file_close(&ftest);
-            return -1;
-        }
-        idx++;
-    }
-    fossil_io_file_close(&fin);
+    split_input_t in;
+    fish_slice_t row;
+    if (split_input_open(&in, fish_workspace_path(), key_column, seed, &row) != 0) return -1;
+
+    size_t outputs = kfold ? shards * 2 : shards;
+    cstring *paths = (cstring *)fossil_sys_memory_calloc(outputs, sizeof(cstring));
+    fish_row_writer_t *out = (fish_row_writer_t *)fossil_sys_memory_calloc(outputs, sizeof(fish_row_writer_t));
+    uint64_t *count = (uint64_t *)fossil_sys_memory_calloc(shards, sizeof(uint64_t));
+    int failed = !paths || !out || !count;
 
-    // Shuffle rows
-    srand((unsigned int)time(NULL));
-    for (int i = row_count - 1; i > 0; --i) {
-        int j = rand() % (i + 1);
-        fossil_sys_memory_swap(&rows[i], &rows[j], sizeof(cstring));
+    for (size_t i = 0; i < shards && !failed; i++) {
+        if (kfold) {
+            char role[48];
+            snprintf(role, sizeof(role), "fold-%zu.train", i);
+            paths[2 * i] = fish_workspace_output(role);
+            snprintf(role, sizeof(role), "fold-%zu.val", i);
+            paths[2 * i + 1] = fish_workspace_output(role);
+        } else {
+            char role[48];
+            snprintf(role, sizeof(role), "shard-%zu", i);
+            paths[i] = fish_workspace_output(role);
+        }
     }
+    for (size_t i = 0; i < outputs && !failed; i++)
+        if (!paths[i]) failed = 1;
+    if (failed) fossil_io_printf("{red,bold}fish_dataset_split: Memory allocation failed.{normal}\n");
 
-    int train_end = (int)(train_frac * row_count);
-    int val_end   = train_end + (int)(val_frac * row_count);
+    int opened = !failed && open_outputs(out, paths, outputs, &in, row) == 0;
+    failed = !opened;
 
-    // Write rows to files and hash each row for fingerprinting
-    uint8_t hash_buf[32];
-    for (int i = 0; i < row_count; ++i) {
-        fossil_io_file_t *out = (i < train_end) ? &ftrain :
-                                (i < val_end)   ? &fval :
-                                                  &ftest;
-        fossil_io_fprintf(out, "%s\n", rows[i]);
-        fossil_ai_jellyfish_hash(rows[i], "", hash_buf);
-        fossil_io_cstring_free(rows[i]);
+    while (!failed && fish_row_reader_next(&in.reader, &row)) {
+        size_t s = (size_t)(row_digest(&in, row) % shards);
+        count[s]++;
+        if (!kfold) {
+            failed = fish_row_writer_write(&out[s], row.ptr, row.len) != 0;
+            continue;
+        }
+        for (size_t f = 0; f < shards && !failed; f++) {
+            fish_row_writer_t *dst = &out[2 * f + (f == s ? 1 : 0)];
+            failed = fish_row_writer_write(dst, row.ptr, row.len) != 0;
+        }
     }
-    fossil_sys_memory_free(rows);
-
-    fossil_io_file_close(&ftrain);
-    fossil_io_file_close(&fval);
-    fossil_io_file_close(&ftest);
+    if (in.reader.failed) failed = 1;
+    split_input_close(&in);
 
-    fossil_io_printf(
-        "{green,bold}Dataset split completed:{normal} "
-        "{yellow}%d train{normal}, {cyan}%d val{normal}, {magenta}%d test rows{normal}\n",
-        train_end, val_end - train_end, row_count - val_end
-    );
+    int rc = opened ? close_outputs(out, outputs, failed) : -1;
+    if (rc == 0) {
+        fossil_io_printf("{green,bold}Dataset sharded into %zu %s:{normal}", shards, kfold ? "folds" : "shards");
+        for (size_t i = 0; i < shards; i++)
+            fossil_io_printf(" {yellow}%llu{normal}", (unsigned long long)count[i]);
+        fossil_io_printf(" rows\n");
+    }
 
-    return 0;
+    for (size_t i = 0; paths && i < outputs; i++) fossil_io_cstring_free(paths[i]);
+    fossil_sys_memory_free(paths);
+    fossil_sys_memory_free(out);
+    fossil_sys_memory_free(count);
+    return rc;
 }
@@ -11,11 +11,519 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
-#include "fossil/code/commands.h"
+#include "fossil/code/columnar.h"
+#include "fossil/code/meta.h"
+#include "fossil/code/thread.h"
+#include "fossil/code/workspace.h"
+
+/* Smallest byte range worth handing to its own worker thread */
+#ifndef FISH_STATS_MIN_SPAN
+#define FISH_STATS_MIN_SPAN ((uint64_t)4 << 20)
+#endif
+
+/* Cap on per-thread sketch memory; fewer workers are used above it */
+#ifndef FISH_STATS_MEM_BUDGET
+#define FISH_STATS_MEM_BUDGET ((size_t)256 << 20)
+#endif
+
+/* Histogram bar length for --plot */
+#define FISH_STATS_BAR_WIDTH 40
+
+#define NOT_SELECTED ((size_t)-1)
+
+/* ---------------- per-column state ---------------- */
+
+/* everything one worker accumulates over its byte range */
+typedef struct {
+    fish_column_stats_t *col; /* one per header column */
+    uint64_t rows;
+    int failed;
+} stats_partial_t;
+
+typedef struct {
+    ccstring path;
+    const fish_meta_t *meta;
+    uint64_t begin;         /* rows start at or after this offset */
+    uint64_t end;
+    size_t workers;
+    size_t cols;            /* header columns */
+    stats_partial_t *part;
+    const fish_column_stats_t *edges; /* merged min/max, set for the binning pass */
+    const size_t *todo;     /* columnar: projected columns */
+    size_t todo_count;
+} stats_job_t;
+
+static int partial_init(stats_partial_t *part, size_t cols) {
+    fossil_sys_memory_zero(part, sizeof(*part));
+    part->col = (fish_column_stats_t *)fossil_sys_memory_calloc(cols ? cols : 1, sizeof(fish_column_stats_t));
+    if (!part->col) return -1;
+    for (size_t c = 0; c < cols; c++)
+        if (fish_column_stats_init(&part->col[c]) != 0) return -1;
+    return 0;
+}
+
+static void partial_free(stats_partial_t *part, size_t cols) {
+    if (!part->col) return;
+    for (size_t c = 0; c < cols; c++) fish_column_stats_free(&part->col[c]);
+    fossil_sys_memory_free(part->col);
+    part->col = NULL;
+}
+
+static void numeric_observe(fish_column_stats_t *col, double v, int *failed) {
+    fish_moments_add(&col->moments, v);
+    if (fish_kll_add(&col->quantiles, v) != 0) *failed = 1;
+}
+
+static void column_observe(fish_column_stats_t *col, fish_slice_t value, int *failed) {
+    double v;
+    if (value.len == 0) {
+        col->nulls++;
+        return;
+    }
+    col->present++;
+    fish_hll_add(&col->distinct, fish_hash64(value.ptr, value.len, 0));
+    if (fish_slice_to_double(value, &v)) numeric_observe(col, v, failed);
+}
+
+static void numeric_bin(fish_column_stats_t *col, const fish_column_stats_t *edge, double v) {
+    size_t b = 0;
+    if (edge->moments.max > edge->moments.min) {
+        double pos = (v - edge->moments.min) / (edge->moments.max - edge->moments.min);
+        b = pos <= 0.0 ? 0 : (size_t)(pos * FISH_STATS_BINS);
+        if (b >= FISH_STATS_BINS) b = FISH_STATS_BINS - 1;
+    }
+    col->bins[b]++;
+}
+
+static void column_bin(fish_column_stats_t *col, const fish_column_stats_t *edge, fish_slice_t value) {
+    double v;
+    if (value.len == 0 || !fish_slice_to_double(value, &v)) return;
+    numeric_bin(col, edge, v);
+}
+
+/*
+ * Typed chunks skip text parsing: numbers feed the sketches directly and
+ * dictionary entries are hashed and parsed once per chunk, not per row.
+ */
+static void chunk_observe(fish_column_stats_t *col, const fish_column_stats_t *edge,
+                          const fish_col_chunk_t *chunk, int *failed) {
+    size_t rows = chunk->rows;
+    uint64_t *hash = NULL;
+    double *num = NULL;
+    uint8_t *is_num = NULL;
+
+    if (chunk->type == FISH_COL_DICT) {
+        hash = (uint64_t *)fossil_sys_memory_alloc((chunk->dict_count + 1) * sizeof(uint64_t));
+        num = (double *)fossil_sys_memory_alloc((chunk->dict_count + 1) * sizeof(double));
+        is_num = (uint8_t *)fossil_sys_memory_alloc(chunk->dict_count + 1);
+        if (!hash || !num || !is_num) {
+            *failed = 1;
+            rows = 0;
+        }
+        for (size_t i = 0; rows && i < chunk->dict_count; i++) {
+            hash[i] = fish_hash64(chunk->dict[i].ptr, chunk->dict[i].len, 0);
+            is_num[i] = (uint8_t)fish_slice_to_double(chunk->dict[i], &num[i]);
+        }
+    }
+
+    for (size_t r = 0; r < rows; r++) {
+        if (!fish_col_present(chunk, r)) {
+            if (!edge) col->nulls++;
+            continue;
+        }
+        double v;
+        switch (chunk->type) {
+        case FISH_COL_INT64:
+        case FISH_COL_F64:
+            v = chunk->type == FISH_COL_INT64 ? (double)chunk->i64[r] : chunk->f64[r];
+            if (edge) {
+                numeric_bin(col, edge, v);
+                break;
+            }
+            col->present++;
+            fish_hll_add(&col->distinct, fish_hash64(&v, sizeof(v), 0));
+            numeric_observe(col, v, failed);
+            break;
+        case FISH_COL_DICT: {
+            uint32_t code = chunk->code[r];
+            if (edge) {
+                column_bin(col, edge, chunk->dict[code]);
+                break;
+            }
+            col->present++;
+            fish_hll_add(&col->distinct, hash[code]);
+            if (is_num[code]) numeric_observe(col, num[code], failed);
+            break;
+        }
+        default:
+            if (edge) column_bin(col, edge, chunk->dict[r]);
+            else column_observe(col, chunk->dict[r], failed);
+            break;
+        }
+    }
+
+    fossil_sys_memory_free(hash);
+    fossil_sys_memory_free(num);
+    fossil_sys_memory_free(is_num);
+}
+
+/* ---------------- workers ---------------- */
+
+static int at_todo(const size_t *todo, size_t count, size_t c) {
+    for (size_t t = 0; t < count; t++)
+        if (todo[t] == c) return 1;
+    return 0;
+}
+
+static void stats_worker(void *ctx, size_t index) {
+    stats_job_t *job = (stats_job_t *)ctx;
+    stats_partial_t *part = &job->part[index];
+    uint64_t span = job->end - job->begin;
+    uint64_t lo = job->begin + span * index / job->workers;
+    uint64_t hi = index + 1 == job->workers ? job->end : job->begin + span * (index + 1) / job->workers;
+    fish_row_reader_t reader;
+    fish_row_fields_t fields = {0};
+    fish_slice_t row;
+
+    /* cut at record starts, so a quoted newline never splits a record */
+    lo = fish_meta_record_start(job->meta, job->path, lo);
+    if (hi < job->end) hi = fish_meta_record_start(job->meta, job->path, hi);
+    if (fish_row_reader_open_range_csv(&reader, job->path, lo, hi) != 0) {
+        part->failed = 1;
+        return;
+    }
+
+    while (!part->failed && fish_row_reader_next(&reader, &row)) {
+        size_t fc = fish_row_fields_split(&fields, row);
+        if (fc == 0) {
+            part->failed = 1;
+            break;
+        }
+        part->rows++;
+        for (size_t c = 0; c < job->cols; c++) {
+            fish_slice_t value = { NULL, 0 };
+            if (c < fc) value = fish_slice_trim(fields.field[c]);
+            if (job->edges) column_bin(&part->col[c], &job->edges[c], value);
+            else column_observe(&part->col[c], value, &part->failed);
+        }
+    }
+    if (reader.failed) part->failed = 1;
+
+    fish_row_fields_free(&fields);
+    fish_row_reader_close(&reader);
+}
+
+/* Columnar: row groups are dealt round-robin, only projected columns are read. */
+static void stats_col_worker(void *ctx, size_t index) {
+    stats_job_t *job = (stats_job_t *)ctx;
+    stats_partial_t *part = &job->part[index];
+    fish_col_reader_t reader;
+    fish_col_chunk_t chunk;
+
+    if (fish_col_open(&reader, job->path) != 0) {
+        part->failed = 1;
+        return;
+    }
+
+    for (size_t g = index; g < reader.groups && !part->failed; g += job->workers) {
+        part->rows += reader.group_rows[g];
+        for (size_t t = 0; t < job->todo_count && !part->failed; t++) {
+            size_t c = job->todo[t];
+            const fish_column_stats_t *edge = job->edges ? &job->edges[c] : NULL;
+            if (c >= reader.columns) {
+                if (!edge) part->col[c].nulls += reader.group_rows[g];
+                continue;
+            }
+            if (fish_col_read(&reader, g, c, &chunk) != 0) {
+                part->failed = 1;
+                break;
+            }
+            chunk_observe(&part->col[c], edge, &chunk, &part->failed);
+            fish_col_chunk_free(&chunk);
+        }
+    }
+    fish_col_close(&reader);
+}
+
+static size_t pick_workers(uint64_t bytes, size_t cols) {
+    size_t workers = (size_t)(bytes / FISH_STATS_MIN_SPAN);
+    size_t hw = fish_thread_count();
+    if (workers > hw) workers = hw;
+    if (workers < 1) workers = 1;
+    while (workers > 1 && workers * cols * sizeof(fish_column_stats_t) > FISH_STATS_MEM_BUDGET)
+        workers--;
+    return workers;
+}
+
+/*
+ * Run one parallel pass over [begin, end) and fold the partials into @p into.
+ * With @p todo set the dataset is columnar and only those columns are read.
+ */
+static int stats_pass(const fish_meta_t *meta, ccstring path, uint64_t begin, uint64_t end,
+                      size_t cols, const size_t *todo, size_t todo_count, size_t groups,
+                      const fish_column_stats_t *edges, fish_column_stats_t *into, uint64_t *rows) {
+    stats_job_t job;
+    int rc = 0;
+
+    fossil_sys_memory_zero(&job, sizeof(job));
+    job.path = path;
+    job.meta = meta;
+    job.begin = begin;
+    job.end = end;
+    job.cols = cols;
+    job.edges = edges;
+    job.todo = todo;
+    job.todo_count = todo_count;
+    job.workers = pick_workers(end - begin, cols);
+    if (todo && job.workers > groups) job.workers = groups ? groups : 1;
+    job.part = (stats_partial_t *)fossil_sys_memory_calloc(job.workers, sizeof(stats_partial_t));
+    if (!job.part) return -1;
+
+    for (size_t w = 0; w < job.workers && rc == 0; w++)
+        rc = partial_init(&job.part[w], cols);
+    if (rc == 0) fish_thread_run(job.workers, todo ? stats_col_worker : stats_worker, &job);
+
+    for (size_t w = 0; w < job.workers && rc == 0; w++) {
+        if (job.part[w].failed) rc = -1;
+        for (size_t c = 0; c < cols && rc == 0; c++)
+            if (!todo || at_todo(todo, todo_count, c))
+                rc = fish_column_stats_merge(&into[c], &job.part[w].col[c]);
+        if (rows) *rows += job.part[w].rows;
+    }
+
+    for (size_t w = 0; w < job.workers; w++) partial_free(&job.part[w], cols);
+    fossil_sys_memory_free(job.part);
+    return rc;
+}
+
+/* Offset data rows start at: a range starting at 1 skips the header record. */
+static uint64_t data_start(const fish_meta_t *meta) {
+    return meta->has_header ? 1 : 0;
+}
+
+/* bin edges come from the merged min/max, so binning is its own pass */
+static int bin_pass(fish_meta_t *meta, ccstring path, size_t cols,
+                    const size_t *todo, size_t todo_count, size_t groups) {
+    fish_column_stats_t *edges = meta->stats;
+    fish_column_stats_t *bins = (fish_column_stats_t *)fossil_sys_memory_calloc(cols ? cols : 1, sizeof(fish_column_stats_t));
+    int rc = bins ? 0 : -1;
+    for (size_t c = 0; c < cols && rc == 0; c++) rc = fish_column_stats_init(&bins[c]);
+    if (rc == 0)
+        rc = stats_pass(meta, path, data_start(meta), meta->file_size, cols,
+                        todo, todo_count, groups, edges, bins, NULL);
+    for (size_t c = 0; c < cols && rc == 0; c++) {
+        if (todo && !at_todo(todo, todo_count, c)) continue;
+        fossil_sys_memory_copy(edges[c].bins, bins[c].bins, sizeof(edges[c].bins));
+        edges[c].flags |= FISH_STATS_BINNED;
+    }
+    for (size_t c = 0; c < cols && bins; c++) fish_column_stats_free(&bins[c]);
+    fossil_sys_memory_free(bins);
+    return rc;
+}
+
+/* Selected columns of a columnar dataset still missing @p flag. */
+static size_t pending_columns(const fish_meta_t *meta, const size_t *slot, size_t cols,
+                              uint32_t flag, size_t *todo) {
+    size_t n = 0;
+    for (size_t c = 0; c < cols; c++)
+        if (slot[c] != NOT_SELECTED && !(meta->stats[c].flags & flag)) todo[n++] = c;
+    return n;
+}
+
+/*
+ * Bring the cached stats up to date. Text datasets scan only rows past
+ * stats_end (all rows on a cold cache), then rebin if a histogram is
+ * wanted and stale. Columnar datasets read just the selected columns
+ * that are not cached yet.
+ */
+static int stats_update(fish_meta_t *meta, ccstring path, size_t cols, const size_t *slot, int plot) {
+    int changed = 0;
+    int rc = 0;
+
+    if (!meta->has_stats || meta->columns != cols) {
+        if (fish_meta_stats_reset(meta, cols) != 0) return -1;
+        meta->stats_end = data_start(meta);
+        meta->has_stats = 1;
+    }
+
+    fish_col_reader_t col;
+    if (fish_col_probe(path)) {
+        size_t *todo = (size_t *)fossil_sys_memory_alloc((cols ? cols : 1) * sizeof(size_t));
+        if (!todo || fish_col_open(&col, path) != 0) {
+            fossil_sys_memory_free(todo);
+            return -1;
+        }
+        size_t groups = col.groups;
+        fish_col_close(&col);
+
+        size_t n = pending_columns(meta, slot, cols, FISH_STATS_READY, todo);
+        if (n > 0) {
+            rc = stats_pass(meta, path, 0, meta->file_size, cols, todo, n, groups, NULL, meta->stats, NULL);
+            for (size_t t = 0; t < n && rc == 0; t++) meta->stats[todo[t]].flags |= FISH_STATS_READY;
+            meta->stats_end = meta->file_size;
+            changed = 1;
+        }
+        meta->stats_rows = meta->rows;
+        n = rc == 0 && plot ? pending_columns(meta, slot, cols, FISH_STATS_BINNED, todo) : 0;
+        if (n > 0) {
+            rc = bin_pass(meta, path, cols, todo, n, groups);
+            changed = 1;
+        }
+        fossil_sys_memory_free(todo);
+    } else {
+        if (meta->stats_end < meta->file_size) {
+            rc = stats_pass(meta, path, meta->stats_end, meta->file_size, cols, NULL, 0, 0, NULL, meta->stats, &meta->stats_rows);
+            meta->stats_end = meta->file_size;
+            for (size_t c = 0; c < cols; c++) {
+                meta->stats[c].flags |= FISH_STATS_READY;
+                meta->stats[c].flags &= ~FISH_STATS_BINNED;
+            }
+            changed = 1;
+        }
+        if (rc == 0 && plot && cols > 0 && !(meta->stats[0].flags & FISH_STATS_BINNED)) {
+            rc = bin_pass(meta, path, cols, NULL, 0, 0);
+            changed = 1;
+        }
+    }
+
+    if (rc != 0) return -1;
+    if (changed) fish_meta_save(meta, path);
+    return 0;
+}
+
+/* ---------------- header / selection ---------------- */
+
+/*
+ * Column names from the header row; unnamed columns, and every column of
+ * a headerless dataset (@p named = 0), get a positional name.
+ */
+static cstring *column_names(ccstring header, int named, size_t *count) {
+    fish_row_fields_t fields = {0};
+    fish_slice_t row = { header, strlen(header) };
+
+    size_t fc = fish_row_fields_split(&fields, row);
+    cstring *names = fc ? (cstring *)fossil_sys_memory_calloc(fc, sizeof(cstring)) : NULL;
+    if (!names) {
+        fish_row_fields_free(&fields);
+        return NULL;
+    }
+
+    for (size_t f = 0; f < fc; f++) {
+        fish_slice_t name = fish_slice_trim(fields.field[f]);
+        if (!named || name.len == 0) {
+            names[f] = fossil_io_cstring_format("column%zu", f + 1);
+        } else {
+            names[f] = (cstring)fossil_sys_memory_alloc(name.len + 1);
+            if (names[f]) fish_slice_copy(name, names[f], name.len + 1);
+        }
+    }
+    *count = fc;
+
+    fish_row_fields_free(&fields);
+    return names;
+}
+
+static size_t select_columns(ccstring columns, cstring *names, size_t count, size_t *slot) {
+    size_t selected = 0;
+
+    for (size_t i = 0; i < count; i++) slot[i] = columns ? NOT_SELECTED : selected++;
+    if (!columns) return selected;
+
+    cstring temp = fossil_io_cstring_create(columns);
+    cstring saveptr = NULL;
+    cstring token = temp ? fossil_io_cstring_token(temp, ",", &saveptr) : NULL;
+    while (token) {
+        int found = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!names[i] || !fossil_io_cstring_iequals_safe(token, names[i], 256)) continue;
+            found = 1;
+            if (slot[i] == NOT_SELECTED) slot[i] = 0;
+        }
+        if (!found)
+            fossil_io_printf("{yellow}fish_dataset_stats: unknown column '%s'.{normal}\n", token);
+        token = fossil_io_cstring_token(NULL, ",", &saveptr);
+    }
+    fossil_io_cstring_free(temp);
+
+    /* number selected columns in header order */
+    for (size_t i = 0; i < count; i++)
+        if (slot[i] != NOT_SELECTED) slot[i] = selected++;
+    return selected;
+}
+
+/* ---------------- output ---------------- */
+
+static void print_column(ccstring name, const fish_column_stats_t *col) {
+    double distinct = fish_hll_estimate(&col->distinct);
+    if (distinct > (double)col->present) distinct = (double)col->present;
+
+    fossil_io_printf(" - {magenta}%s{normal}\n", name);
+    fossil_io_printf("     count: %llu  nulls: %llu  distinct: ~%.0f\n",
+                     (unsigned long long)col->present, (unsigned long long)col->nulls, distinct);
+
+    const fish_moments_t *m = &col->moments;
+    if (m->n == 0) {
+        fossil_io_printf("     (no numeric values)\n");
+        return;
+    }
+    double var = fish_moments_variance(m);
+    fossil_io_printf("     numeric: %llu  min: %g  max: %g  mean: %g  variance: %g  stddev: %g\n",
+                     (unsigned long long)m->n, m->min, m->max, m->mean, var, sqrt(var));
+
+    double p25 = 0, p50 = 0, p75 = 0, p99 = 0;
+    if (fish_kll_quantile(&col->quantiles, 0.25, &p25) == 0 &&
+        fish_kll_quantile(&col->quantiles, 0.50, &p50) == 0 &&
+        fish_kll_quantile(&col->quantiles, 0.75, &p75) == 0 &&
+        fish_kll_quantile(&col->quantiles, 0.99, &p99) == 0)
+        fossil_io_printf("     p25: ~%g  median: ~%g  p75: ~%g  p99: ~%g\n", p25, p50, p75, p99);
+}
+
+static void print_histogram(ccstring name, const fish_column_stats_t *col) {
+    const fish_moments_t *m = &col->moments;
+    uint64_t peak = 0;
+
+    fossil_io_printf("{magenta}%s{normal}\n", name);
+    if (m->n == 0) {
+        fossil_io_printf("  (no numeric values)\n");
+        return;
+    }
+    for (size_t b = 0; b < FISH_STATS_BINS; b++)
+        if (col->bins[b] > peak) peak = col->bins[b];
+
+    size_t last = m->max > m->min ? FISH_STATS_BINS : 1;
+    double width = (m->max - m->min) / FISH_STATS_BINS;
+    for (size_t b = 0; b < last; b++) {
+        double lo = m->min + width * (double)b;
+        size_t bars = peak ? (size_t)(col->bins[b] * FISH_STATS_BAR_WIDTH / peak) : 0;
+        if (bars == 0 && col->bins[b] > 0) bars = 1;
+        fossil_io_printf("  %12g | ", lo);
+        for (size_t j = 0; j < bars; ++j) fossil_io_putchar('#');
+        fossil_io_printf(" (%llu)\n", (unsigned long long)col->bins[b]);
+    }
+}
+
+/* ---------------- command ---------------- */
 
 /**
  * @brief Get statistics for the dataset and optionally compute a fingerprint hash using Jellyfish.
- * 
+ *
+ * The first row is the header when it reads as one (see
+ * fish_row_reader_header()); otherwise it is counted as data and the
+ * columns are named by position. Data rows are split into byte ranges, one
+ * per worker thread, and each worker builds count/null/min/max/mean/
+ * variance (Welford), a HyperLogLog distinct count and a KLL quantile
+ * sketch for every column. Partials are merged at the end, so large
+ * datasets are read once and memory stays bounded by the sketches. With
+ * @p plot a second parallel pass bins numeric values into a histogram
+ * over [min, max].
+ *
+ * Results are cached in the dataset's .meta sidecar: unchanged data is
+ * answered without reading it, appended rows are scanned and merged in.
+ * Columnar datasets are read column by column, so only the requested
+ * columns are decoded and each is cached once computed.
+ *
+ * Null fields are empty (after trimming) or missing from short rows.
+ *
  * @param summary Show summary (1: yes, 0: no).
  * @param columns Comma-separated list of columns to include (NULL = all).
  * @param plot Plot statistics (1: yes, 0: no).
@@ -23,95 +531,58 @@
  */
 int fish_dataset_stats(int summary, const char *columns, int plot)
 {
-    ccstring dataset_path = "datasets/current.dataset";
-    fossil_io_file_t dataset_stream;
-    if (fossil_io_file_open(&dataset_stream, dataset_path, "r") != 0 || !fossil_io_file_is_open(&dataset_stream)) {
+    ccstring dataset_path = fish_workspace_path();
+    fish_meta_t meta;
+    size_t col_count = 0;
+
+    if (fish_meta_sync(&meta, dataset_path) < 0) {
         fossil_io_printf("{red,bold}fish_dataset_stats: no active dataset found.{normal}\n");
         return -1;
     }
-
-    // Use memory API for buffers and arrays
-    char *buf = (char *)fossil_sys_memory_alloc(4096);
-    int row_count = 0;
-    int col_count = 0;
-    cstring *col_names = (cstring *)fossil_sys_memory_calloc(64, sizeof(cstring)); // support up to 64 columns
-    int *selected = (int *)fossil_sys_memory_calloc(64, sizeof(int));
-
-    // Read header line for column names
-    if (!fgets(buf, 4096, dataset_stream.file)) {
-        fossil_sys_memory_free(buf);
-        fossil_sys_memory_free(col_names);
-        fossil_sys_memory_free(selected);
-        fossil_io_file_close(&dataset_stream);
+    if (!meta.header) {
+        fish_meta_free(&meta);
         fossil_io_printf("{red,bold}fish_dataset_stats: empty dataset.{normal}\n");
         return -1;
     }
 
-    buf[strcspn(buf, "\r\n")] = 0;
-    cstring saveptr = NULL;
-    cstring token = fossil_io_cstring_token(buf, ",", &saveptr);
-    while (token && col_count < 64) {
-        col_names[col_count] = fossil_io_cstring_create(token);
-        col_count++;
-        token = fossil_io_cstring_token(NULL, ",", &saveptr);
-    }
+    cstring *col_names = column_names(meta.header, meta.has_header, &col_count);
+    size_t *slot = (size_t *)fossil_sys_memory_calloc(col_count ? col_count : 1, sizeof(size_t));
+    if (col_names && slot) select_columns(columns, col_names, col_count, slot);
+    int rc = col_names && slot ? stats_update(&meta, dataset_path, col_count, slot, plot) : -1;
 
-    // Determine selected columns
-    if (columns) {
-        char *temp = (char *)fossil_sys_memory_alloc(1024);
-        strncpy(temp, columns, 1023);
-        temp[1023] = 0;
-        fossil_sys_memory_zero(selected, sizeof(int) * 64);
-        cstring saveptr2 = NULL;
-        token = fossil_io_cstring_token(temp, ",", &saveptr2);
-        while (token) {
-            for (int i = 0; i < col_count; ++i) {
-                if (fossil_io_cstring_iequals(token, col_names[i], 256)) selected[i] = 1;
-            }
-            token = fossil_io_cstring_token(NULL, ",", &saveptr2);
-        }
-        fossil_sys_memory_free(temp);
+    if (rc != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_stats: failed to compute statistics.{normal}\n");
     } else {
-        for (int i = 0; i < col_count; ++i) selected[i] = 1;
-    }
 
-    // Count rows
-    while (fgets(buf, 4096, dataset_stream.file)) row_count++;
-
-    if (summary) {
-        fossil_io_printf("{green,bold}Dataset summary:{normal}\n");
-        fossil_io_printf("{yellow}Rows: {normal}%d\n", row_count);
-        fossil_io_printf("{yellow}Columns: {normal}%d\n", col_count);
-        fossil_io_printf("{cyan}Selected columns:{normal}\n");
-        for (int i = 0; i < col_count; ++i) {
-            if (selected[i]) fossil_io_printf(" - {magenta}%s{normal}\n", col_names[i]);
+        if (summary) {
+            fossil_io_printf("{green,bold}Dataset summary:{normal}\n");
+            fossil_io_printf("{yellow}Rows: {normal}%llu\n", (unsigned long long)meta.stats_rows);
+            fossil_io_printf("{yellow}Columns: {normal}%zu\n", col_count);
+            fossil_io_printf("{yellow}Fingerprint: {normal}%016llx\n", (unsigned long long)meta.root);
         }
-    }
 
-    if (plot) {
-        fossil_io_printf("\n{blue,bold}ASCII Plot (row count per column selected):{normal}\n");
-        for (int i = 0; i < col_count; ++i) {
-            if (!selected[i]) continue;
-            fossil_io_printf("{magenta}%-15s{normal}: ", col_names[i]);
-            int bars = row_count / 10;
-            if (bars == 0) bars = 1;
-            for (int j = 0; j < bars; ++j) fossil_io_putchar('#');
-            fossil_io_printf(" (%d)\n", row_count);
+        fossil_io_printf("{cyan}Column statistics:{normal}\n");
+        for (size_t i = 0; i < col_count; ++i)
+            if (slot[i] != NOT_SELECTED) print_column(col_names[i], &meta.stats[i]);
+
+        if (plot) {
+            fossil_io_printf("\n{blue,bold}ASCII Histogram (%d bins per column):{normal}\n", FISH_STATS_BINS);
+            for (size_t i = 0; i < col_count; ++i)
+                if (slot[i] != NOT_SELECTED) print_histogram(col_names[i], &meta.stats[i]);
         }
-    }
 
-    // Example: Compute a fingerprint hash of the dataset header using Jellyfish
-    uint8_t hash_out[FOSSIL_JELLYFISH_HASH_SIZE];
-    fossil_ai_jellyfish_hash(buf, NULL, hash_out);
-    fossil_io_printf("{blue}Dataset header hash (Jellyfish):{normal} ");
-    for (size_t i = 0; i < FOSSIL_JELLYFISH_HASH_SIZE; ++i)
-        fossil_io_printf("%02x", hash_out[i]);
-    fossil_io_printf("\n");
+        // Compute a fingerprint hash of the dataset header using Jellyfish
+        uint8_t hash_out[FOSSIL_JELLYFISH_HASH_SIZE];
+        fossil_ai_jellyfish_hash(meta.header, NULL, hash_out);
+        fossil_io_printf("{blue}Dataset header hash (Jellyfish):{normal} ");
+        for (size_t i = 0; i < FOSSIL_JELLYFISH_HASH_SIZE; ++i)
+            fossil_io_printf("%02x", hash_out[i]);
+        fossil_io_printf("\n");
+    }
 
-    for (int i = 0; i < col_count; ++i) fossil_io_cstring_free(col_names[i]);
+    for (size_t i = 0; col_names && i < col_count; ++i) fossil_sys_memory_free(col_names[i]);
     fossil_sys_memory_free(col_names);
-    fossil_sys_memory_free(selected);
-    fossil_sys_memory_free(buf);
-    fossil_io_file_close(&dataset_stream);
-    return 0;
+    fossil_sys_memory_free(slot);
+    fish_meta_free(&meta);
+    return rc;
 }
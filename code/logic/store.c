@@ -0,0 +1,262 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/store.h"
+#include "fossil/code/zchain.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#  include <direct.h>
+#else
+#  include <sys/stat.h>
+#endif
+
+typedef struct {
+    uint8_t b[FISH_SHA256_SIZE];
+} object_id_t;
+
+typedef struct {
+    uint8_t magic[8];
+    uint32_t version;
+    uint32_t block_size;
+    uint64_t count;
+    uint64_t chain_len;             /* bytes of the chain record that follows */
+    uint8_t head[FISH_SHA256_SIZE];
+} ref_header_t;
+
+/* ---------------- objects ---------------- */
+
+static void object_id(const fossil_ai_jellyfish_block_t *block, object_id_t *id) {
+    fish_sha256_t sha;
+    fish_sha256_init(&sha);
+    fish_sha256_update(&sha, block, sizeof(*block));
+    fish_sha256_final(&sha, id->b);
+}
+
+/* store next to the ref: "<dir>/.jfstore", or ".jfstore" for a bare file name */
+static cstring store_root(ccstring ref_path) {
+    ccstring slash = strrchr(ref_path, '/');
+#ifdef _WIN32
+    ccstring back = strrchr(ref_path, '\\');
+    if (back && (!slash || back > slash)) slash = back;
+#endif
+    if (!slash) return fossil_io_cstring_create(FISH_STORE_DIR);
+    return fossil_io_cstring_format("%.*s/" FISH_STORE_DIR, (int)(slash - ref_path), ref_path);
+}
+
+/* "<root>/objects/xx" for the first byte, then the other 31 as hex */
+static cstring object_path(ccstring root, const object_id_t *id, int dir_only) {
+    static const char hex[] = "0123456789abcdef";
+    char rest[2 * FISH_SHA256_SIZE - 1];
+    for (size_t i = 1; i < FISH_SHA256_SIZE; i++) {
+        rest[2 * i - 2] = hex[id->b[i] >> 4];
+        rest[2 * i - 1] = hex[id->b[i] & 0xf];
+    }
+    rest[sizeof(rest) - 1] = '\0';
+    if (dir_only) return fossil_io_cstring_format("%s/objects/%02x", root, id->b[0]);
+    return fossil_io_cstring_format("%s/objects/%02x/%s", root, id->b[0], rest);
+}
+
+/* best-effort: an existing directory is fine */
+static void make_dir(ccstring path) {
+#if defined(_WIN32)
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+static int id_compare(const void *a, const void *b) {
+    return memcmp(a, b, sizeof(object_id_t));
+}
+
+/* write one object unless the store already has it */
+static int object_put(ccstring root, const fossil_ai_jellyfish_block_t *block, const object_id_t *id,
+                      fish_store_stats_t *stats) {
+    cstring path = object_path(root, id, 0);
+    if (!path) return -1;
+    if (fossil_io_file_file_exists(path)) {
+        fossil_io_cstring_free(path);
+        stats->shared++;
+        return 0;
+    }
+
+    cstring dir = object_path(root, id, 1);
+    if (dir) make_dir(dir);
+    fossil_io_cstring_free(dir);
+
+    fish_row_writer_t out;
+    int rc = fish_row_writer_open_raw(&out, path);
+    fossil_io_cstring_free(path);
+    if (rc != 0) return -1;
+    fish_row_writer_put(&out, (const char *)block, sizeof(*block));
+    if (fish_row_writer_commit(&out) != 0) return -1;
+    stats->written++;
+    return 0;
+}
+
+static int object_get(ccstring root, const object_id_t *id, fossil_ai_jellyfish_block_t *block) {
+    cstring path = object_path(root, id, 0);
+    fossil_io_file_t file;
+    int rc = path && fish_file_size(path) == sizeof(*block) && fossil_io_file_open(&file, path, "rb") == 0 ? 0 : -1;
+    fossil_io_cstring_free(path);
+    if (rc != 0) return -1;
+    rc = fossil_io_file_read(&file, block, sizeof(*block), 1) == 1 ? 0 : -1;
+    fossil_io_file_close(&file);
+
+    object_id_t check;
+    if (rc == 0) object_id(block, &check);
+    return rc == 0 && memcmp(check.b, id->b, FISH_SHA256_SIZE) == 0 ? 0 : -1;
+}
+
+/* ---------------- refs ---------------- */
+
+static int ref_read_header(fossil_io_file_t *file, ccstring path, ref_header_t *h) {
+    uint64_t size = fish_file_size(path);
+    if (fossil_io_file_read(file, h, 1, sizeof(*h)) != sizeof(*h)) return -1;
+    if (memcmp(h->magic, FISH_REF_MAGIC, sizeof(h->magic)) != 0 || h->version != FISH_REF_VERSION ||
+        h->block_size != sizeof(fossil_ai_jellyfish_block_t) || h->chain_len != FISH_CHAIN_FIELDS ||
+        h->count > FOSSIL_JELLYFISH_MAX_MEM)
+        return -1;
+    return size == sizeof(*h) + h->chain_len + h->count * sizeof(object_id_t) ? 0 : -1;
+}
+
+/* object ids of the ref at @p path, or NULL when it holds none */
+static object_id_t *ref_read_ids(fossil_io_file_t *file, const ref_header_t *h) {
+    object_id_t *ids = (object_id_t *)fossil_sys_memory_alloc((h->count ? (size_t)h->count : 1) * sizeof(object_id_t));
+    if (!ids) return NULL;
+    if (fish_fseek64(file->file, (long long)(sizeof(*h) + h->chain_len), SEEK_SET) != 0 ||
+        fossil_io_file_read(file, ids, sizeof(object_id_t), (size_t)h->count) != (size_t)h->count) {
+        fossil_sys_memory_free(ids);
+        return NULL;
+    }
+    return ids;
+}
+
+int fish_ref_probe(ccstring path) {
+    fossil_io_file_t file;
+    ref_header_t h;
+    if (fossil_io_file_open(&file, path, "rb") != 0) return 0;
+    int yes = fossil_io_file_read(&file, &h, 1, sizeof(h)) == sizeof(h) &&
+              memcmp(h.magic, FISH_REF_MAGIC, sizeof(h.magic)) == 0;
+    fossil_io_file_close(&file);
+    return yes;
+}
+
+/* ids the ref at @p path points to, sorted for lookup; NULL if it is not a ref */
+static object_id_t *known_ids(ccstring path, size_t *count) {
+    *count = 0;
+    fossil_io_file_t file;
+    if (!fossil_io_file_file_exists(path) || fossil_io_file_open(&file, path, "rb") != 0) return NULL;
+    ref_header_t h;
+    object_id_t *ids = ref_read_header(&file, path, &h) == 0 ? ref_read_ids(&file, &h) : NULL;
+    fossil_io_file_close(&file);
+    if (!ids) return NULL;
+    qsort(ids, (size_t)h.count, sizeof(object_id_t), id_compare);
+    *count = (size_t)h.count;
+    return ids;
+}
+
+int fish_store_save(const fossil_ai_jellyfish_chain_t *chain, ccstring path, fish_store_stats_t *stats) {
+    size_t count = chain->count <= FOSSIL_JELLYFISH_MAX_MEM ? chain->count : FOSSIL_JELLYFISH_MAX_MEM;
+    object_id_t *ids = (object_id_t *)fossil_sys_memory_alloc((count ? count : 1) * sizeof(object_id_t));
+    uint8_t *raw = (uint8_t *)fossil_sys_memory_alloc(FISH_CHAIN_FIELDS);
+    cstring root = store_root(path);
+    cstring objects = root ? fossil_io_cstring_format("%s/objects", root) : NULL;
+    if (!ids || !raw || !objects) {
+        fossil_sys_memory_free(ids);
+        fossil_sys_memory_free(raw);
+        fossil_io_cstring_free(root);
+        fossil_io_cstring_free(objects);
+        return -1;
+    }
+
+    /* commits of the previous save are in the store already */
+    size_t known_count = 0;
+    object_id_t *known = known_ids(path, &known_count);
+
+    fish_store_stats_t st = { 0, 0 };
+    make_dir(root);
+    make_dir(objects);
+    fossil_io_cstring_free(objects);
+    int rc = 0;
+    for (size_t i = 0; rc == 0 && i < count; i++) {
+        object_id(&chain->commits[i], &ids[i]);
+        if (known && bsearch(&ids[i], known, known_count, sizeof(object_id_t), id_compare)) {
+            st.shared++;
+            continue;
+        }
+        rc = object_put(root, &chain->commits[i], &ids[i], &st);
+    }
+    fossil_sys_memory_free(known);
+
+    fish_row_writer_t out;
+    if (rc == 0 && fish_row_writer_open_raw(&out, path) == 0) {
+        ref_header_t h;
+        fossil_sys_memory_zero(&h, sizeof(h));
+        fossil_sys_memory_copy(h.magic, FISH_REF_MAGIC, sizeof(h.magic));
+        h.version = FISH_REF_VERSION;
+        h.block_size = (uint32_t)sizeof(fossil_ai_jellyfish_block_t);
+        h.count = count;
+        h.chain_len = FISH_CHAIN_FIELDS;
+        if (count) fossil_sys_memory_copy(h.head, ids[count - 1].b, FISH_SHA256_SIZE);
+
+        const uint8_t *base = (const uint8_t *)chain;
+        fossil_sys_memory_copy(raw, base, FISH_CHAIN_HEAD);
+        fossil_sys_memory_copy(raw + FISH_CHAIN_HEAD, base + FISH_CHAIN_TAIL, sizeof(*chain) - FISH_CHAIN_TAIL);
+
+        fish_row_writer_put(&out, (const char *)&h, sizeof(h));
+        fish_row_writer_put(&out, (const char *)raw, FISH_CHAIN_FIELDS);
+        fish_row_writer_put(&out, (const char *)ids, count * sizeof(object_id_t));
+        rc = fish_row_writer_commit(&out);
+    } else {
+        rc = -1;
+    }
+
+    fossil_sys_memory_free(ids);
+    fossil_sys_memory_free(raw);
+    fossil_io_cstring_free(root);
+    if (stats) *stats = st;
+    return rc;
+}
+
+int fish_ref_load(fossil_ai_jellyfish_chain_t *chain, ccstring path) {
+    fossil_io_file_t file;
+    if (fossil_io_file_open(&file, path, "rb") != 0) return -1;
+
+    ref_header_t h;
+    uint8_t *raw = (uint8_t *)fossil_sys_memory_alloc(FISH_CHAIN_FIELDS);
+    int rc = raw && ref_read_header(&file, path, &h) == 0 &&
+             fossil_io_file_read(&file, raw, 1, FISH_CHAIN_FIELDS) == FISH_CHAIN_FIELDS ? 0 : -1;
+    object_id_t *ids = rc == 0 ? ref_read_ids(&file, &h) : NULL;
+    fossil_io_file_close(&file);
+    if (!ids) rc = -1;
+
+    if (rc == 0) {
+        uint8_t *base = (uint8_t *)chain;
+        fossil_sys_memory_copy(base, raw, FISH_CHAIN_HEAD);
+        fossil_sys_memory_copy(base + FISH_CHAIN_TAIL, raw + FISH_CHAIN_HEAD, sizeof(*chain) - FISH_CHAIN_TAIL);
+    }
+    cstring root = rc == 0 ? store_root(path) : NULL;
+    if (!root) rc = -1;
+    for (uint64_t i = 0; rc == 0 && i < h.count; i++)
+        rc = object_get(root, &ids[i], &chain->commits[i]);
+    if (rc == 0) chain->count = (size_t)h.count;
+
+    fossil_io_cstring_free(root);
+    fossil_sys_memory_free(ids);
+    fossil_sys_memory_free(raw);
+    return rc;
+}
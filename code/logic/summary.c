@@ -11,105 +11,321 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
-#include "fossil/code/commands.h"
+#include "fossil/code/arena.h"
+#include "fossil/code/scan.h"
+#include "fossil/code/thread.h"
+#include "fossil/code/trace.h"
 
-#define MAX_INPUT_SIZE   (256 * 1024)   // 256 KB buffer for input file
-#define MAX_SENTENCES    2048
-#define MAX_WORDS_SENT   2048
-#define MAX_WORD_LEN     64
-#define MAX_VOCAB        65536
+#include <stdarg.h>
+#include <sys/stat.h>
 
+
+#define MAX_WORD_LEN     64    /* longer words are truncated, as before */
+#define MAX_SUMMARY      10    /* sentences picked at the highest depth */
+
+/* A sentence picked for the summary, kept in document order on output. */
+typedef struct {
+    double score;
+    uint64_t index;     /* sentence number in the document */
+    char *text;
+    size_t cap;
+} summary_pick_t;
+
+/* Outcome of summarizing one document. */
 typedef struct {
-    char *word;
-    int df;        // number of sentences containing the word
-    long tf_total; // total occurrences across all sentences (not strictly required)
-} VocabEntry;
-
-static void strtolower_inplace(char *s) {
-    cstring lower = fossil_io_cstring_to_lower(s);
-    if (lower) {
-        strcpy(s, lower);
-        fossil_io_cstring_free(lower);
+    summary_pick_t pick[MAX_SUMMARY];
+    size_t picked;
+    uint64_t sentences;
+    uint64_t bytes;
+    uint64_t count_ns;  /* vocabulary / document-frequency pass */
+    uint64_t score_ns;  /* scoring pass */
+} summary_doc_t;
+
+/*
+ * Per-thread workspace, reused from one document to the next: the arena,
+ * intern table and scratch arrays keep their capacity between documents.
+ */
+typedef struct {
+    fish_arena_t arena;         /* interned words */
+    fish_intern_t vocab;
+    uint32_t *df;               /* sentences containing each word */
+    uint64_t *stamp;            /* last sentence that touched each word */
+    uint32_t *slot;             /* word -> position in the sentence's term list */
+    size_t scratch_cap;
+    uint64_t epoch;             /* sentence stamp, never reused */
+    double *idf;
+    size_t idf_cap;
+    uint64_t sentences;         /* sentences counted into df */
+
+    uint32_t *term;             /* current sentence: unique words in first-seen order */
+    uint32_t *tf;
+    size_t terms;
+    size_t term_cap;
+} summary_t;
+
+/* Shared read-only IDF table for corpus mode. */
+typedef struct {
+    fish_intern_t *vocab;
+    const double *idf;
+} summary_corpus_t;
+
+/* ---------------- text ---------------- */
+
+/* Cut the next trimmed, non-empty sentence off the front of @p rest. */
+static int next_sentence(fish_slice_t *rest, fish_slice_t *sent) {
+    while (rest->len > 0) {
+        size_t i = fish_scan_find(rest->ptr, rest->len, '.', '?', '!');
+        if (i < rest->len) i++; /* the terminator belongs to the sentence */
+        fish_slice_t s = { rest->ptr, i };
+        rest->ptr += i;
+        rest->len -= i;
+        *sent = fish_slice_trim(s);
+        if (sent->len > 0) return 1;
     }
+    return 0;
+}
+
+/* Next lowercased alphanumeric word of the sentence, truncated to MAX_WORD_LEN - 1. */
+static int next_word(fish_scan_cursor_t *words, char buf[MAX_WORD_LEN], fish_slice_t *word) {
+    fish_slice_t run;
+    if (!fish_scan_cursor_next(words, &run)) return 0;
+    size_t n = run.len < MAX_WORD_LEN - 1 ? run.len : MAX_WORD_LEN - 1;
+    fish_scan_lower(buf, run.ptr, n);
+    word->ptr = buf;
+    word->len = n;
+    return 1;
+}
+
+/* ---------------- workspace ---------------- */
+
+static int summary_init(summary_t *sm) {
+    fossil_sys_memory_zero(sm, sizeof(*sm));
+    fish_arena_init(&sm->arena, 0);
+    return fish_intern_init(&sm->vocab, &sm->arena, 4096);
+}
+
+/* Make the per-word arrays cover @p words ids (new entries zeroed). */
+static int scratch_reserve(summary_t *sm, size_t words) {
+    if (words <= sm->scratch_cap) return 0;
+    size_t cap = sm->scratch_cap ? sm->scratch_cap * 2 : 1024;
+    while (cap < words) cap *= 2;
+    uint32_t *df = (uint32_t *)fossil_sys_memory_realloc(sm->df, cap * sizeof(uint32_t));
+    if (df) sm->df = df;
+    uint64_t *stamp = (uint64_t *)fossil_sys_memory_realloc(sm->stamp, cap * sizeof(uint64_t));
+    if (stamp) sm->stamp = stamp;
+    uint32_t *slot = (uint32_t *)fossil_sys_memory_realloc(sm->slot, cap * sizeof(uint32_t));
+    if (slot) sm->slot = slot;
+    if (!df || !stamp || !slot) return -1;
+    fossil_sys_memory_zero(sm->df + sm->scratch_cap, (cap - sm->scratch_cap) * sizeof(uint32_t));
+    fossil_sys_memory_zero(sm->stamp + sm->scratch_cap, (cap - sm->scratch_cap) * sizeof(uint64_t));
+    sm->scratch_cap = cap;
+    return 0;
+}
+
+/* Forget the vocabulary but keep every buffer for the next document. */
+static void summary_reset(summary_t *sm) {
+    fossil_sys_memory_zero(sm->df, sm->vocab.count * sizeof(uint32_t));
+    fish_intern_reset(&sm->vocab);
+    fish_arena_reset(&sm->arena);
+    sm->sentences = 0;
+}
+
+static void summary_free(summary_t *sm) {
+    fish_intern_free(&sm->vocab);
+    fish_arena_free(&sm->arena);
+    fossil_sys_memory_free(sm->df);
+    fossil_sys_memory_free(sm->stamp);
+    fossil_sys_memory_free(sm->slot);
+    fossil_sys_memory_free(sm->idf);
+    fossil_sys_memory_free(sm->term);
+    fossil_sys_memory_free(sm->tf);
 }
 
-/* Trim leading/trailing whitespace */
-static char *trim(char *s) {
-    fossil_io_cstring_trim(s);
-    return s;
+static void doc_free(summary_doc_t *doc) {
+    for (size_t i = 0; i < MAX_SUMMARY; ++i) fossil_sys_memory_free(doc->pick[i].text);
+    fossil_sys_memory_zero(doc, sizeof(*doc));
 }
 
-/* Split content into sentences. Returns number of sentences. */
-static int split_sentences(char *content, char *sentences[], int max_sentences) {
-    int count = 0;
-    char *p = content;
-    char *start = p;
-    while (*p && count < max_sentences) {
-        if (*p == '.' || *p == '?' || *p == '!' || *p == '\n') {
-            char save = p[1];
-            p[1] = '\0';
-            char *s = trim(start);
-            if (*s) {
-                sentences[count++] = fossil_io_cstring_dup(s);
+/* ---------------- passes ---------------- */
+
+/* Pass 1: intern every word and count document frequencies. */
+static int summary_count(summary_t *sm, fish_row_reader_t *reader) {
+    fish_slice_t line, sent, word;
+    fish_scan_cursor_t words;
+    char buf[MAX_WORD_LEN];
+
+    while (fish_row_reader_next(reader, &line)) {
+        while (next_sentence(&line, &sent)) {
+            uint64_t stamp = ++sm->epoch;
+            sm->sentences++;
+            fish_scan_cursor_init(&words, sent, FISH_SCAN_ALNUM, 1);
+            while (next_word(&words, buf, &word)) {
+                uint32_t id;
+                if (fish_intern_add(&sm->vocab, word, &id) < 0 || scratch_reserve(sm, sm->vocab.count) != 0)
+                    return -1;
+                if (sm->stamp[id] != stamp) {
+                    sm->stamp[id] = stamp;
+                    sm->df[id]++;
+                }
             }
-            p[1] = save;
-            p++;
-            while (*p && isspace((unsigned char)*p)) p++;
-            start = p;
-            continue;
         }
-        p++;
     }
-    if (*start && count < max_sentences) {
-        char *s = trim(start);
-        if (*s) sentences[count++] = fossil_io_cstring_dup(s);
+    return reader->failed ? -1 : 0;
+}
+
+/* IDF over @p sentences sentences from the workspace's document frequencies. */
+static int summary_idf(summary_t *sm, uint64_t sentences) {
+    size_t n = sm->vocab.count;
+    if (n + 1 > sm->idf_cap) {
+        double *idf = (double *)fossil_sys_memory_realloc(sm->idf, (n + 1) * sizeof(double));
+        if (!idf) return -1;
+        sm->idf = idf;
+        sm->idf_cap = n + 1;
     }
-    return count;
+    for (size_t v = 0; v < n; ++v)
+        sm->idf[v] = log((double)sentences / (1.0 + (double)sm->df[v]));
+    return 0;
 }
 
-/* Tokenize a sentence into words (alphanumeric sequences). Returns word count. */
-static int tokenize_sentence(const char *sent, char words[][MAX_WORD_LEN], int max_words) {
-    int w = 0;
-    size_t len = strlen(sent);
+/* TF * IDF sum over the sentence's unique words, in first-occurrence order. */
+static double sentence_score(summary_t *sm, fish_intern_t *vocab, const double *idf, fish_slice_t sent) {
+    fish_slice_t word;
+    fish_scan_cursor_t words;
     char buf[MAX_WORD_LEN];
-    int bi = 0;
-    for (size_t i = 0; i <= len && w < max_words; ++i) {
-        char c = sent[i];
-        if (isalnum((unsigned char)c)) {
-            if (bi < MAX_WORD_LEN - 1) buf[bi++] = (char)tolower((unsigned char)c);
-        } else {
-            if (bi > 0) {
-                buf[bi] = '\0';
-                strncpy(words[w++], buf, MAX_WORD_LEN);
-                bi = 0;
-            }
+    uint64_t stamp = ++sm->epoch;
+    double score = 0.0;
+
+    sm->terms = 0;
+    fish_scan_cursor_init(&words, sent, FISH_SCAN_ALNUM, 1);
+    while (next_word(&words, buf, &word)) {
+        uint32_t id;
+        if (fish_intern_find(vocab, word, &id) != 1) continue;
+        if (sm->stamp[id] == stamp) {
+            sm->tf[sm->slot[id]]++;
+            continue;
+        }
+        if (sm->terms == sm->term_cap) {
+            size_t cap = sm->term_cap ? sm->term_cap * 2 : 256;
+            uint32_t *term = (uint32_t *)fossil_sys_memory_realloc(sm->term, cap * sizeof(uint32_t));
+            if (term) sm->term = term;
+            uint32_t *tf = (uint32_t *)fossil_sys_memory_realloc(sm->tf, cap * sizeof(uint32_t));
+            if (tf) sm->tf = tf;
+            if (!term || !tf) return score;
+            sm->term_cap = cap;
         }
+        sm->stamp[id] = stamp;
+        sm->slot[id] = (uint32_t)sm->terms;
+        sm->term[sm->terms] = id;
+        sm->tf[sm->terms++] = 1;
+    }
+    for (size_t z = 0; z < sm->terms; z++) score += (double)sm->tf[z] * idf[sm->term[z]];
+    return score;
+}
+
+/* Keep the best @p k sentences; ties go to the earlier one. */
+static int pick_offer(summary_doc_t *doc, size_t k, double score, uint64_t index, fish_slice_t text) {
+    summary_pick_t *pick = doc->pick;
+    size_t at = doc->picked;
+    if (at == k && !(score > pick[k - 1].score)) return 0;
+    if (at == k) at = k - 1;
+    while (at > 0 && score > pick[at - 1].score) at--;
+
+    /* reuse the evicted buffer */
+    size_t last = doc->picked == k ? k - 1 : doc->picked;
+    summary_pick_t slot = pick[last];
+    for (size_t i = last; i > at; i--) pick[i] = pick[i - 1];
+    if (text.len + 1 > slot.cap) {
+        char *grown = (char *)fossil_sys_memory_realloc(slot.text, text.len + 1);
+        if (!grown) {
+            pick[at] = slot;
+            return -1;
+        }
+        slot.text = grown;
+        slot.cap = text.len + 1;
+    }
+    fish_slice_copy(text, slot.text, slot.cap);
+    slot.score = score;
+    slot.index = index;
+    pick[at] = slot;
+    if (doc->picked < k) doc->picked++;
+    return 0;
+}
+
+/* Pass 2: score every sentence and keep the top @p k in document order. */
+static int summary_select(summary_t *sm, fish_intern_t *vocab, const double *idf,
+                          fish_row_reader_t *reader, size_t k, summary_doc_t *doc) {
+    fish_slice_t line, sent;
+    int rc = 0;
+
+    if (scratch_reserve(sm, vocab->count) != 0) return -1;
+    while (rc == 0 && fish_row_reader_next(reader, &line)) {
+        while (rc == 0 && next_sentence(&line, &sent)) {
+            double score = sentence_score(sm, vocab, idf, sent);
+            rc = k > 0 ? pick_offer(doc, k, score, ++doc->sentences, sent) : 0;
+        }
+    }
+    if (reader->failed) rc = -1;
+
+    for (size_t i = 1; i < doc->picked; ++i) {
+        summary_pick_t p = doc->pick[i];
+        size_t j = i;
+        while (j > 0 && doc->pick[j - 1].index > p.index) { doc->pick[j] = doc->pick[j - 1]; j--; }
+        doc->pick[j] = p;
     }
-    return w;
+    return rc;
 }
 
-/* Vocabulary helpers using simple linear search (ok for moderate text sizes) */
-static int vocab_find(VocabEntry *vocab, int vcount, const char *word) {
-    for (int i = 0; i < vcount; ++i)
-        if (fossil_io_cstring_compare(vocab[i].word, word) == 0) return i;
-    return -1;
+static size_t depth_sentences(int depth) {
+    if (depth <= 1) return 1;
+    if (depth == 2) return 3;
+    if (depth == 3) return 5;
+    return MAX_SUMMARY;
 }
 
-static int vocab_add(VocabEntry *vocab, int *vcount, const char *word) {
-    int idx = vocab_find(vocab, *vcount, word);
-    if (idx >= 0) return idx;
-    if (*vcount >= MAX_VOCAB) return -1;
-    vocab[*vcount].word = fossil_io_cstring_dup(word);
-    vocab[*vcount].df = 0;
-    vocab[*vcount].tf_total = 0;
-    return (*vcount)++;
+/*
+ * Summarize one file: IDF comes from the document itself, or from
+ * @p corpus when set (the counting pass is then skipped).
+ */
+static int summarize_file(summary_t *sm, ccstring path, size_t k, const summary_corpus_t *corpus,
+                          summary_doc_t *doc) {
+    fish_row_reader_t reader;
+    int rc = 0;
+
+    fossil_sys_memory_zero(doc, sizeof(*doc));
+    if (fish_row_reader_open(&reader, path) != 0) return -1;
+    doc->bytes = fish_file_size(path);
+
+    uint64_t t0 = fish_clock_ns();
+    if (!corpus) {
+        FISH_TRACE_BEGIN(trace);
+        rc = summary_count(sm, &reader);
+        FISH_TRACE_END(FISH_STAGE_PARSE, trace, doc->bytes);
+        if (rc == 0) rc = summary_idf(sm, sm->sentences);
+        if (rc == 0 && fish_row_reader_rewind(&reader) != 0) rc = -1;
+    }
+    uint64_t t1 = fish_clock_ns();
+    if (rc == 0) {
+        rc = corpus ? summary_select(sm, corpus->vocab, corpus->idf, &reader, k, doc)
+                    : summary_select(sm, &sm->vocab, sm->idf, &reader, k, doc);
+    }
+    doc->count_ns = t1 - t0;
+    doc->score_ns = fish_clock_ns() - t1;
+
+    fish_row_reader_close(&reader);
+    if (!corpus) summary_reset(sm);
+    return rc;
 }
 
 /**
  * fish_summary: real extractive summarizer
  * - file_path: path to file to summarize
  * - depth: 1 -> 1 sentence, 2 -> 3, 3 -> 5, >=4 -> min(10, N)
- * - time_flag: print timing if 1
+ * - time_flag: print wall-clock timing per stage if 1
+ *
+ * The file is streamed twice through the row reader, so input of any size
+ * works in memory proportional to the vocabulary: the first pass interns
+ * words (hash table, strings in one arena) and counts document
+ * frequencies, the second scores sentences by TF * IDF and keeps the best.
  */
 int fish_summary(const char *file_path, int depth, int time_flag)
 {
@@ -117,174 +333,279 @@ int fish_summary(const char *file_path, int depth, int time_flag)
         fossil_io_printf("{red,bold}[Error]{normal} fish_summary: null file path\n");
         return -1;
     }
-
-    fossil_io_file_t file_stream;
-    if (fossil_io_file_open(&file_stream, file_path, "rb") != 0) {
+    if (!fossil_io_file_file_exists(file_path)) {
         fossil_io_printf("{red,bold}[Error]{normal} fish_summary: cannot open '%s'\n", file_path);
         return -1;
     }
 
-    char *content = (char *)fossil_sys_memory_alloc(MAX_INPUT_SIZE);
-    if (!content) {
-        fossil_io_file_close(&file_stream);
+    summary_t sm;
+    summary_doc_t doc;
+    if (summary_init(&sm) != 0) {
+        summary_free(&sm);
         fossil_io_printf("{red,bold}[Error]{normal} fish_summary: OOM\n");
         return -1;
     }
 
-    size_t r = fossil_io_file_read(&file_stream, content, 1, MAX_INPUT_SIZE - 1);
-    content[r] = '\0';
-    fossil_io_file_close(&file_stream);
+    int rc = summarize_file(&sm, file_path, depth_sentences(depth), NULL, &doc);
+    if (rc != 0) {
+        fossil_io_printf("{red,bold}[Error]{normal} fish_summary: cannot summarize '%s'\n", file_path);
+    } else if (doc.sentences == 0) {
+        fossil_io_printf("{yellow,bold}[Summary]{normal} (empty or no sentences)\n");
+    } else {
+        fossil_io_printf("{cyan,bold}=== Extractive Summary (depth=%d) ==={normal}\n\n", depth);
+        for (size_t i = 0; i < doc.picked; ++i)
+            fossil_io_printf("{green}%s{normal}\n\n", doc.pick[i].text);
 
-    clock_t t0 = 0, t1 = 0;
-    if (time_flag) t0 = clock();
+        if (time_flag) {
+            double count_s = (double)doc.count_ns / 1e9;
+            double score_s = (double)doc.score_ns / 1e9;
+            double total_s = count_s + score_s;
+            fossil_io_printf("{yellow}[Timing]{normal} vocabulary %.4f s, scoring %.4f s, total %.4f s (wall)\n",
+                             count_s, score_s, total_s);
+            if (total_s > 0)
+                fossil_io_printf("{yellow}[Timing]{normal} %.2f MB/s, %.0f sentences/s\n",
+                                 (double)doc.bytes / 1048576.0 / total_s, (double)doc.sentences / total_s);
+        }
+    }
 
-    /* 1) Split into sentences */
-    char *sentences[MAX_SENTENCES];
-    int nsent = split_sentences(content, sentences, MAX_SENTENCES);
-    if (nsent == 0) {
-        fossil_io_printf("{yellow,bold}[Summary]{normal} (empty or no sentences)\n");
-        fossil_sys_memory_free(content);
-        return 0;
+    doc_free(&doc);
+    summary_free(&sm);
+    return rc;
+}
+
+/* ---------------- batch mode ---------------- */
+
+/* Small append-only string builder for JSONL lines. */
+typedef struct {
+    char *ptr;
+    size_t len;
+    size_t cap;
+    int failed;
+} jsonl_buf_t;
+
+static void jsonl_printf(jsonl_buf_t *b, const char *fmt, ...) {
+    va_list args;
+    if (b->failed) return;
+    for (;;) {
+        size_t room = b->cap - b->len;
+        va_start(args, fmt);
+        int n = b->ptr ? vsnprintf(b->ptr + b->len, room, fmt, args) : -1;
+        va_end(args);
+        if (n >= 0 && (size_t)n < room) {
+            b->len += (size_t)n;
+            return;
+        }
+        size_t cap = b->cap ? b->cap * 2 : 256;
+        while (n >= 0 && cap < b->len + (size_t)n + 1) cap *= 2;
+        char *grown = (char *)fossil_sys_memory_realloc(b->ptr, cap);
+        if (!grown) {
+            b->failed = 1;
+            return;
+        }
+        b->ptr = grown;
+        b->cap = cap;
     }
+}
 
-    /* 2) Build vocab and per-sentence term lists */
-    VocabEntry *vocab = (VocabEntry *)fossil_sys_memory_alloc(sizeof(VocabEntry) * MAX_VOCAB);
-    if (!vocab) {
-        fossil_io_printf("{red,bold}[Error]{normal} fish_summary: OOM vocab\n");
-        fossil_sys_memory_free(content);
-        return -1;
+static void jsonl_string(jsonl_buf_t *b, ccstring s) {
+    cstring escaped = fossil_io_cstring_escape_json(s);
+    jsonl_printf(b, "\"%s\"", escaped ? escaped : "");
+    fossil_io_cstring_free(escaped);
+}
+
+/* One path per line; blank lines and '#' comments are skipped. */
+static int inputs_from_list(fish_path_list_t *in, ccstring list) {
+    fish_row_reader_t reader;
+    fish_slice_t line;
+    int rc = 0;
+
+    if (fish_row_reader_open(&reader, list) != 0) return -1;
+    while (rc == 0 && fish_row_reader_next(&reader, &line)) {
+        line = fish_slice_trim(line);
+        if (line.len == 0 || line.ptr[0] == '#') continue;
+        cstring path = (cstring)fossil_sys_memory_alloc(line.len + 1);
+        if (path) fish_slice_copy(line, path, line.len + 1);
+        rc = fish_path_list_add(in, path);
     }
-    int vcount = 0;
+    if (reader.failed) rc = -1;
+    fish_row_reader_close(&reader);
+    return rc;
+}
 
-    int *sent_word_counts[MAX_SENTENCES];
-    int sent_word_counts_len[MAX_SENTENCES];
-    for (int i = 0; i < nsent; ++i) { sent_word_counts[i] = NULL; sent_word_counts_len[i] = 0; }
+typedef struct {
+    const fish_path_list_t *in;
+    summary_t *ws;              /* one workspace per worker */
+    size_t k;
+    const summary_corpus_t *corpus;
+    cstring *line;              /* JSONL result per document */
+    volatile size_t next;
+    uint64_t *bytes;            /* per worker totals */
+    uint64_t *sentences;
+    size_t *failed;
+} batch_job_t;
 
-    char tokens[MAX_WORDS_SENT][MAX_WORD_LEN];
+/* Corpus pass: every worker folds its share of documents into its own df table. */
+static void batch_count_worker(void *ctx, size_t index) {
+    batch_job_t *job = (batch_job_t *)ctx;
+    summary_t *sm = &job->ws[index];
+    size_t i;
 
-    for (int i = 0; i < nsent; ++i) {
-        int tw = tokenize_sentence(sentences[i], tokens, MAX_WORDS_SENT);
-        int unique_indices[MAX_WORDS_SENT];
-        int unique_count = 0;
+    while ((i = fish_thread_claim(&job->next)) < job->in->count) {
+        fish_row_reader_t reader;
+        if (fish_row_reader_open(&reader, job->in->path[i]) != 0) continue; /* reported by the scoring pass */
+        summary_count(sm, &reader);
+        fish_row_reader_close(&reader);
+    }
+}
 
-        int idx_list[MAX_WORDS_SENT];
-        int count_list[MAX_WORDS_SENT];
-        int idx_list_len = 0;
+static void batch_worker(void *ctx, size_t index) {
+    batch_job_t *job = (batch_job_t *)ctx;
+    summary_t *sm = &job->ws[index];
+    summary_doc_t doc;
+    size_t i;
 
-        for (int t = 0; t < tw; ++t) {
-            if (tokens[t][0] == '\0') continue;
-            int vidx = vocab_find(vocab, vcount, tokens[t]);
-            if (vidx < 0) {
-                vidx = vocab_add(vocab, &vcount, tokens[t]);
-                if (vidx < 0) break;
-            }
-            vocab[vidx].tf_total += 1;
+    while ((i = fish_thread_claim(&job->next)) < job->in->count) {
+        jsonl_buf_t b = { NULL, 0, 0, 0 };
+        ccstring path = job->in->path[i];
+        uint64_t t0 = fish_clock_ns();
+        int rc = summarize_file(sm, path, job->k, job->corpus, &doc);
+        double total_ms = (double)(fish_clock_ns() - t0) / 1e6;
 
-            int found = -1;
-            for (int z = 0; z < idx_list_len; ++z) {
-                if (idx_list[z] == vidx) { found = z; break; }
-            }
-            if (found >= 0) {
-                count_list[found] += 1;
-            } else {
-                idx_list[idx_list_len] = vidx;
-                count_list[idx_list_len] = 1;
-                idx_list_len++;
-                unique_indices[unique_count++] = vidx;
+        jsonl_printf(&b, "{\"file\":");
+        jsonl_string(&b, path);
+        if (rc != 0) {
+            jsonl_printf(&b, ",\"error\":\"cannot summarize\"}");
+            job->failed[index]++;
+        } else {
+            jsonl_printf(&b, ",\"bytes\":%llu,\"sentences\":%llu,\"summary\":[",
+                         (unsigned long long)doc.bytes, (unsigned long long)doc.sentences);
+            for (size_t p = 0; p < doc.picked; ++p) {
+                if (p) jsonl_printf(&b, ",");
+                jsonl_string(&b, doc.pick[p].text);
             }
+            jsonl_printf(&b, "],\"count_ms\":%.3f,\"score_ms\":%.3f,\"total_ms\":%.3f}",
+                         (double)doc.count_ns / 1e6, (double)doc.score_ns / 1e6, total_ms);
+            job->bytes[index] += doc.bytes;
+            job->sentences[index] += doc.sentences;
         }
-
-        for (int u = 0; u < unique_count; ++u) {
-            int vidx = unique_indices[u];
-            vocab[vidx].df += 1;
+        doc_free(&doc);
+        if (b.failed) {
+            fossil_sys_memory_free(b.ptr);
+            b.ptr = NULL;
         }
+        job->line[i] = b.ptr;
+    }
+}
 
-        if (idx_list_len > 0) {
-            sent_word_counts_len[i] = idx_list_len;
-            sent_word_counts[i] = (int *)fossil_sys_memory_alloc(sizeof(int) * idx_list_len * 2);
-            for (int z = 0; z < idx_list_len; ++z) {
-                sent_word_counts[i][2*z] = idx_list[z];
-                sent_word_counts[i][2*z+1] = count_list[z];
-            }
-        } else {
-            sent_word_counts_len[i] = 0;
-            sent_word_counts[i] = NULL;
+/* Merge every worker's df table into one corpus-wide IDF table. */
+static int corpus_merge(summary_t *global, summary_t *ws, size_t workers) {
+    uint64_t sentences = 0;
+    for (size_t w = 0; w < workers; ++w) {
+        summary_t *sm = &ws[w];
+        for (size_t id = 0; id < sm->vocab.count; ++id) {
+            uint32_t gid;
+            if (fish_intern_add(&global->vocab, sm->vocab.str[id], &gid) < 0 ||
+                scratch_reserve(global, global->vocab.count) != 0)
+                return -1;
+            global->df[gid] += sm->df[id];
         }
+        sentences += sm->sentences;
+        summary_reset(sm);
     }
+    return summary_idf(global, sentences);
+}
 
-    /* 3) Compute IDF and sentence scores (TF * IDF sum) */
-    double *idf = (double *)fossil_sys_memory_alloc(sizeof(double) * vcount);
-    if (!idf) {
-        fossil_io_printf("{red,bold}[Error]{normal} fish_summary: OOM idf\n");
-        for (int i = 0; i < nsent; ++i) {
-            fossil_io_cstring_free(sentences[i]);
-            if (sent_word_counts[i]) fossil_sys_memory_free(sent_word_counts[i]);
-        }
-        for (int v = 0; v < vcount; ++v) fossil_io_cstring_free(vocab[v].word);
-        fossil_sys_memory_free(vocab);
-        fossil_sys_memory_free(content);
+/**
+ * @brief Summarize many documents in parallel and write one JSON line each.
+ */
+int fish_summary_batch(const char *source, int depth, int corpus_idf, const char *out_path)
+{
+    if (!source || !out_path) {
+        fossil_io_printf("{red,bold}[Error]{normal} fish_summary_batch: source and output are required\n");
         return -1;
     }
-    for (int v = 0; v < vcount; ++v) {
-        idf[v] = log((double)nsent / (1.0 + (double)vocab[v].df));
-    }
 
-    double sent_score[MAX_SENTENCES];
-    for (int i = 0; i < nsent; ++i) {
-        double score = 0.0;
-        int len = sent_word_counts_len[i];
-        for (int z = 0; z < len; ++z) {
-            int vidx = sent_word_counts[i][2*z];
-            int tf = sent_word_counts[i][2*z+1];
-            score += (double)tf * idf[vidx];
-        }
-        sent_score[i] = score;
+    fish_path_list_t in = { NULL, 0, 0 };
+    int rc = fish_file_is_directory(source) ? fish_path_list_dir(&in, source) : inputs_from_list(&in, source);
+    if (rc != 0) {
+        fossil_io_printf("{red,bold}[Error]{normal} fish_summary_batch: cannot list '%s'\n", source);
+        fish_path_list_free(&in);
+        return -1;
     }
 
-    int K;
-    if (depth <= 1) K = 1;
-    else if (depth == 2) K = 3;
-    else if (depth == 3) K = 5;
-    else K = 10;
-    if (K > nsent) K = nsent;
-
-    int selected_idx[MAX_SENTENCES] = {0};
-    for (int k = 0; k < K; ++k) {
-        int best = -1;
-        double best_score = -1e300;
-        for (int i = 0; i < nsent; ++i) {
-            if (selected_idx[i]) continue;
-            if (sent_score[i] > best_score) {
-                best_score = sent_score[i];
-                best = i;
-            }
-        }
-        if (best >= 0) selected_idx[best] = 1;
-    }
+    size_t workers = fish_thread_count();
+    if (workers > in.count) workers = in.count ? in.count : 1;
 
-    int out_order[MAX_SENTENCES];
-    int out_count = 0;
-    for (int i = 0; i < nsent; ++i) if (selected_idx[i]) out_order[out_count++] = i;
+    batch_job_t job;
+    summary_t global;
+    summary_corpus_t corpus;
+    fossil_sys_memory_zero(&job, sizeof(job));
+    fossil_sys_memory_zero(&global, sizeof(global));
+    job.in = &in;
+    job.k = depth_sentences(depth);
+    job.ws = (summary_t *)fossil_sys_memory_calloc(workers, sizeof(summary_t));
+    job.line = (cstring *)fossil_sys_memory_calloc(in.count + 1, sizeof(cstring));
+    job.bytes = (uint64_t *)fossil_sys_memory_calloc(workers, sizeof(uint64_t));
+    job.sentences = (uint64_t *)fossil_sys_memory_calloc(workers, sizeof(uint64_t));
+    job.failed = (size_t *)fossil_sys_memory_calloc(workers, sizeof(size_t));
+    rc = job.ws && job.line && job.bytes && job.sentences && job.failed ? 0 : -1;
+    for (size_t w = 0; w < workers && rc == 0; ++w) rc = summary_init(&job.ws[w]);
+    if (rc == 0 && corpus_idf) rc = summary_init(&global);
 
-    fossil_io_printf("{cyan,bold}=== Extractive Summary (depth=%d) ==={normal}\n\n", depth);
-    for (int i = 0; i < out_count; ++i) {
-        int si = out_order[i];
-        fossil_io_printf("{green}%s{normal}\n\n", sentences[si]);
+    uint64_t t0 = fish_clock_ns();
+    if (rc == 0 && corpus_idf) {
+        fish_thread_run(workers, batch_count_worker, &job);
+        rc = corpus_merge(&global, job.ws, workers);
+        corpus.vocab = &global.vocab;
+        corpus.idf = global.idf;
+        job.corpus = &corpus;
+        job.next = 0;
     }
+    uint64_t t1 = fish_clock_ns();
+    if (rc == 0) fish_thread_run(workers, batch_worker, &job);
+    uint64_t t2 = fish_clock_ns();
 
-    if (time_flag) {
-        t1 = clock();
-        double elapsed = (double)(t1 - t0) / (double)CLOCKS_PER_SEC;
-        fossil_io_printf("{yellow}[Timing]{normal} summary generated in %.4f seconds\n", elapsed);
+    fish_row_writer_t out;
+    if (rc == 0 && fish_row_writer_open_raw(&out, out_path) != 0) rc = -1;
+    if (rc == 0) {
+        for (size_t i = 0; i < in.count; ++i)
+            if (job.line[i]) fish_row_writer_write(&out, job.line[i], strlen(job.line[i]));
+        rc = fish_row_writer_commit(&out);
     }
 
-    for (int i = 0; i < nsent; ++i) {
-        fossil_io_cstring_free(sentences[i]);
-        if (sent_word_counts[i]) fossil_sys_memory_free(sent_word_counts[i]);
+    if (rc != 0) {
+        fossil_io_printf("{red,bold}[Error]{normal} fish_summary_batch: failed to write '%s'\n", out_path);
+    } else {
+        uint64_t bytes = 0, sentences = 0;
+        size_t failed = 0;
+        for (size_t w = 0; w < workers; ++w) {
+            bytes += job.bytes[w];
+            sentences += job.sentences[w];
+            failed += job.failed[w];
+        }
+        double idf_s = (double)(t1 - t0) / 1e9;
+        double score_s = (double)(t2 - t1) / 1e9;
+        double total_s = idf_s + score_s;
+        fossil_io_printf("{green,bold}fish_summary_batch: %zu documents (%zu failed) -> %s{normal}\n",
+                         in.count, failed, out_path);
+        if (corpus_idf)
+            fossil_io_printf("{yellow}[Timing]{normal} corpus IDF %.3f s, %zu terms\n", idf_s, global.vocab.count);
+        fossil_io_printf("{yellow}[Timing]{normal} summarize %.3f s on %zu threads, total %.3f s (wall)\n",
+                         score_s, workers, total_s);
+        if (total_s > 0)
+            fossil_io_printf("{yellow}[Timing]{normal} %.1f docs/s, %.2f MB/s, %llu sentences\n",
+                             (double)in.count / total_s, (double)bytes / 1048576.0 / total_s,
+                             (unsigned long long)sentences);
     }
-    for (int v = 0; v < vcount; ++v) fossil_io_cstring_free(vocab[v].word);
-    fossil_sys_memory_free(vocab);
-    fossil_sys_memory_free(idf);
-    fossil_sys_memory_free(content);
-    return 0;
+
+    for (size_t i = 0; job.line && i < in.count; ++i) fossil_sys_memory_free(job.line[i]);
+    for (size_t w = 0; job.ws && w < workers; ++w) summary_free(&job.ws[w]);
+    if (corpus_idf) summary_free(&global);
+    fossil_sys_memory_free(job.ws);
+    fossil_sys_memory_free(job.line);
+    fossil_sys_memory_free(job.bytes);
+    fossil_sys_memory_free(job.sentences);
+    fossil_sys_memory_free(job.failed);
+    fish_path_list_free(&in);
+    return rc;
 }
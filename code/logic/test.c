@@ -12,108 +12,334 @@
  * -----------------------------------------------------------------------------
  */
 #include "fossil/code/commands.h"
+#include "fossil/code/model.h"
+#include "fossil/code/trace.h"
+#include "fossil/code/workspace.h"
 
-/**
- * @brief Generate a simple deterministic metric from a commit hash.
+#include <stdarg.h>
+
+/*
+ * Evaluation streams the dataset in batches of rows, read as pairs the
+ * same way training reads them (see fish_pair_split). The workers share
+ * one resident model under its read lock. Each worker claims rows, asks
+ * the model for each input and keeps its own counters and latency
+ * histogram. The per-worker results are merged once at the end.
+ *
+ * Metrics:
+ *   accuracy    answers equal to the expected output (trimmed, exact)
+ *   coverage    inputs the model had any answer for
+ *   confidence  mean reported confidence (0 when nothing was found)
+ *   loss        Brier score of confidence against exact match
+ *   latency     per-row answer time: mean, p50, p90, p99, max
  */
-static float compute_metric_from_hash(const uint8_t *hash, size_t len) {
-       uint32_t sum = 0;
-       for (size_t i = 0; i < len; i++)
-              sum += hash[i];
-       return (float)(sum % 1000) / 10.0f;  // 0.0 - 100.0
+
+#define EVAL_BATCH_ROWS 4096
+#define EVAL_CLAIM_ROWS 32
+#define EVAL_INPUT_MAX  sizeof(((fossil_ai_jellyfish_block_t *)0)->input)
+#define EVAL_OUTPUT_MAX sizeof(((fossil_ai_jellyfish_block_t *)0)->output)
+#define EVAL_DEFAULT_METRICS "accuracy,coverage,confidence,loss,latency"
+
+enum {
+    EVAL_ACCURACY   = 1 << 0,
+    EVAL_COVERAGE   = 1 << 1,
+    EVAL_CONFIDENCE = 1 << 2,
+    EVAL_LOSS       = 1 << 3,
+    EVAL_LATENCY    = 1 << 4
+};
+
+typedef struct {
+    uint64_t rows;              /* evaluated */
+    uint64_t skipped;           /* no usable input/output */
+    uint64_t found;
+    uint64_t correct;
+    double confidence;
+    double loss;
+    fish_hist_t latency;        /* ns */
+} eval_stats_t;
+
+typedef struct {
+    fish_model_t *model;
+    fish_pair_cols_t cols;
+    char *bytes;                /* rows of the current batch, copied out of the reader */
+    size_t bytes_cap;
+    fish_slice_t row[EVAL_BATCH_ROWS];
+    size_t row_at[EVAL_BATCH_ROWS];
+    size_t rows;
+    volatile size_t next;
+    fish_row_fields_t fields[FISH_THREAD_MAX];
+    eval_stats_t stats[FISH_THREAD_MAX];
+} eval_ctx_t;
+
+static void eval_row(eval_ctx_t *ctx, fish_row_fields_t *fields, fish_slice_t row, eval_stats_t *st) {
+    char prompt[EVAL_INPUT_MAX];
+    char answer[FISH_MODEL_REPLY_MAX];
+    fish_slice_t input, expected;
+
+    if (!fish_pair_split(&ctx->cols, fields, row, &input, &expected)) {
+        st->skipped++;
+        return;
+    }
+    fish_slice_copy(input, prompt, sizeof(prompt));
+    /* a block cannot hold more than this, so training stored no more */
+    if (expected.len > EVAL_OUTPUT_MAX - 1) expected.len = EVAL_OUTPUT_MAX - 1;
+
+    float conf = 0.0f;
+    uint64_t start = fish_clock_ns();
+    int found = fish_model_answer(ctx->model, prompt, answer, sizeof(answer), &conf, NULL, 0);
+    uint64_t ns = fish_clock_ns() - start;
+
+    fish_slice_t got = { answer, strlen(answer) };
+    got = fish_slice_trim(got);
+    int correct = found && got.len == expected.len && memcmp(got.ptr, expected.ptr, got.len) == 0;
+    double miss = (correct ? 1.0 : 0.0) - (double)conf;
+
+    st->rows++;
+    st->found += (uint64_t)found;
+    st->correct += (uint64_t)correct;
+    st->confidence += conf;
+    st->loss += miss * miss;
+    fish_hist_add(&st->latency, ns);
 }
 
-/**
- * @brief Generate a metric from input/output using the chain's hash function.
- * Uses fossil_ai_jellyfish_hash as per prototype.
- */
-static float compute_metric_from_io(const char *input, const char *output) {
-       fossil_sys_memory_t hash_mem = fossil_sys_memory_alloc(FOSSIL_JELLYFISH_HASH_SIZE);
-       uint8_t *hash = (uint8_t *)hash_mem;
-       fossil_ai_jellyfish_hash(input, output, hash);
-       float score = compute_metric_from_hash(hash, FOSSIL_JELLYFISH_HASH_SIZE);
-       fossil_sys_memory_free(hash_mem);
-       return score;
+static void eval_worker(void *arg, size_t index) {
+    eval_ctx_t *ctx = (eval_ctx_t *)arg;
+    for (;;) {
+        size_t begin = fish_thread_claim(&ctx->next) * EVAL_CLAIM_ROWS;
+        if (begin >= ctx->rows) break;
+        size_t end = begin + EVAL_CLAIM_ROWS < ctx->rows ? begin + EVAL_CLAIM_ROWS : ctx->rows;
+        for (size_t r = begin; r < end; r++) eval_row(ctx, &ctx->fields[index], ctx->row[r], &ctx->stats[index]);
+    }
+}
+
+/* Copy the next batch of rows out of the reader; returns rows read, or -1 on OOM or a read error */
+static int eval_read(eval_ctx_t *ctx, fish_row_reader_t *reader) {
+    fish_slice_t row;
+    size_t len = 0;
+    ctx->rows = 0;
+    ctx->next = 0;
+    while (ctx->rows < EVAL_BATCH_ROWS && fish_row_reader_next(reader, &row)) {
+        if (len + row.len > ctx->bytes_cap) {
+            size_t cap = ctx->bytes_cap ? ctx->bytes_cap : ((size_t)1 << 16);
+            while (cap < len + row.len) cap *= 2;
+            char *grown = (char *)fossil_sys_memory_realloc(ctx->bytes, cap);
+            if (!grown) return -1;
+            ctx->bytes = grown;
+            ctx->bytes_cap = cap;
+        }
+        if (row.len) fossil_sys_memory_copy(ctx->bytes + len, row.ptr, row.len);
+        ctx->row_at[ctx->rows] = len;
+        ctx->row[ctx->rows].len = row.len;
+        len += row.len;
+        ctx->rows++;
+    }
+    if (reader->failed) return -1;
+    for (size_t r = 0; r < ctx->rows; r++) ctx->row[r].ptr = ctx->bytes + ctx->row_at[r];
+    return (int)ctx->rows;
+}
+
+static int parse_metrics(ccstring list) {
+    static const struct { const char *name; int bit; } known[] = {
+        { "accuracy", EVAL_ACCURACY }, { "coverage", EVAL_COVERAGE },
+        { "confidence", EVAL_CONFIDENCE }, { "loss", EVAL_LOSS }, { "latency", EVAL_LATENCY }
+    };
+    cstring copy = fossil_sys_memory_strdup(list);
+    cstring saveptr = NULL;
+    int wanted = 0;
+    if (!copy) return 0;
+
+    for (cstring token = fossil_io_cstring_token(copy, ",", &saveptr); token;
+         token = fossil_io_cstring_token(NULL, ",", &saveptr)) {
+        fossil_io_cstring_trim(token);
+        if (token[0] == '\0') continue;
+        size_t k = 0;
+        while (k < sizeof(known) / sizeof(known[0]) && !fossil_io_cstring_iequals(token, known[k].name)) k++;
+        if (k < sizeof(known) / sizeof(known[0])) wanted |= known[k].bit;
+        else fossil_io_printf("{yellow}fish_test: unknown metric '%s' ignored.{normal}\n", token);
+    }
+    fossil_sys_memory_free(copy);
+    return wanted;
+}
+
+static double ratio(double part, uint64_t whole) {
+    return whole ? part / (double)whole : 0.0;
+}
+
+static void put_text(fish_row_writer_t *out, ccstring s) {
+    fish_row_writer_put(out, s, strlen(s));
+}
+
+static void put_format(fish_row_writer_t *out, const char *fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > 0) fish_row_writer_put(out, buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+static void put_string(fish_row_writer_t *out, ccstring s) {
+    cstring escaped = fossil_io_cstring_escape_json(s);
+    put_format(out, "\"");
+    put_text(out, escaped ? escaped : "");
+    put_format(out, "\"");
+    fossil_io_cstring_free(escaped);
+}
+
+static int save_report(ccstring path, ccstring model_name, ccstring dataset_path, int wanted,
+                       const eval_stats_t *st, size_t workers, double secs) {
+    fish_row_writer_t out;
+    if (fish_row_writer_open_raw(&out, path) != 0) return -1;
+
+    put_text(&out, "{\"model\":");
+    put_string(&out, model_name);
+    put_text(&out, ",\"dataset\":");
+    put_string(&out, dataset_path);
+    put_format(&out, ",\"rows\":%llu,\"skipped\":%llu,\"threads\":%zu,\"seconds\":%.6f,\"metrics\":{",
+               (unsigned long long)st->rows, (unsigned long long)st->skipped, workers, secs);
+
+    const char *sep = "";
+    if (wanted & EVAL_ACCURACY) {
+        put_format(&out, "%s\"accuracy\":%.6f", sep, ratio((double)st->correct, st->rows));
+        sep = ",";
+    }
+    if (wanted & EVAL_COVERAGE) {
+        put_format(&out, "%s\"coverage\":%.6f", sep, ratio((double)st->found, st->rows));
+        sep = ",";
+    }
+    if (wanted & EVAL_CONFIDENCE) {
+        put_format(&out, "%s\"confidence\":%.6f", sep, ratio(st->confidence, st->rows));
+        sep = ",";
+    }
+    if (wanted & EVAL_LOSS) {
+        put_format(&out, "%s\"loss\":%.6f", sep, ratio(st->loss, st->rows));
+        sep = ",";
+    }
+    if (wanted & EVAL_LATENCY) {
+        put_format(&out, "%s\"latency_us\":{\"mean\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f}", sep,
+                   ratio((double)st->latency.sum, st->rows) / 1e3,
+                   (double)fish_hist_percentile(&st->latency, 0.50) / 1e3,
+                   (double)fish_hist_percentile(&st->latency, 0.90) / 1e3,
+                   (double)fish_hist_percentile(&st->latency, 0.99) / 1e3, (double)st->latency.max / 1e3);
+    }
+    put_text(&out, "}}\n");
+    return fish_row_writer_commit(&out);
+}
+
+static void print_report(int wanted, const eval_stats_t *st) {
+    if (wanted & EVAL_ACCURACY)
+        fossil_io_printf("{blue,bold}Metric %-12s{normal} = {yellow,bold}%.4f{normal} (%llu/%llu)\n", "accuracy",
+                         ratio((double)st->correct, st->rows),
+                         (unsigned long long)st->correct, (unsigned long long)st->rows);
+    if (wanted & EVAL_COVERAGE)
+        fossil_io_printf("{blue,bold}Metric %-12s{normal} = {yellow,bold}%.4f{normal}\n", "coverage",
+                         ratio((double)st->found, st->rows));
+    if (wanted & EVAL_CONFIDENCE)
+        fossil_io_printf("{blue,bold}Metric %-12s{normal} = {yellow,bold}%.4f{normal}\n", "confidence",
+                         ratio(st->confidence, st->rows));
+    if (wanted & EVAL_LOSS)
+        fossil_io_printf("{blue,bold}Metric %-12s{normal} = {yellow,bold}%.4f{normal}\n", "loss",
+                         ratio(st->loss, st->rows));
+    if (wanted & EVAL_LATENCY)
+        fossil_io_printf("{blue,bold}Metric %-12s{normal} = {yellow,bold}p50 %.1fus p90 %.1fus p99 %.1fus max %.1fus{normal}\n",
+                         "latency", (double)fish_hist_percentile(&st->latency, 0.50) / 1e3,
+                         (double)fish_hist_percentile(&st->latency, 0.90) / 1e3,
+                         (double)fish_hist_percentile(&st->latency, 0.99) / 1e3, (double)st->latency.max / 1e3);
+}
+
+static void stats_merge(eval_stats_t *into, const eval_stats_t *from) {
+    into->rows += from->rows;
+    into->skipped += from->skipped;
+    into->found += from->found;
+    into->correct += from->correct;
+    into->confidence += from->confidence;
+    into->loss += from->loss;
+    fish_hist_merge(&into->latency, &from->latency);
 }
 
 /**
  * @brief Test an AI model using a dataset and metrics.
  */
 int fish_test(const char *model_name, const char *dataset_path,
-                       const char *metrics_list, const char *save_file)
+              const char *metrics_list, const char *save_file)
 {
-       if (!model_name || !metrics_list) {
-              fossil_io_printf("{red,bold}fish_test: missing model or metrics.{normal}\n");
-              return -1;
-       }
-
-       // Build file path
-       cstring filepath = fossil_io_cstring_format("%s.jfchain", model_name);
-
-       // Load the model chain
-       fossil_ai_jellyfish_chain_t chain;
-       if (fossil_ai_jellyfish_load(&chain, filepath) != 0) {
-              fossil_io_printf("{red,bold}fish_test: failed to load model: %s{normal}\n", filepath);
-              fossil_io_cstring_free(filepath);
-              return -1;
-       }
-
-       if (chain.count == 0) {
-              fossil_io_printf("{yellow,bold}fish_test: model has no commits.{normal}\n");
-              fossil_io_cstring_free(filepath);
-              return -1;
-       }
-
-       fossil_ai_jellyfish_block_t *latest = &chain.commits[chain.count - 1];
-
-       fossil_io_printf("{green,bold}Testing model '{cyan}%s{normal}{green,bold}' with dataset '{magenta}%s{normal}{green,bold}'{normal}\n",
-                 model_name,
-                 dataset_path ? dataset_path : "N/A");
-
-       // Copy metrics list using memory API
-       cstring metrics_copy = fossil_sys_memory_strdup(metrics_list);
-
-       // Prepare optional results file using fossil_io_file_t
-       fossil_io_file_t out_file;
-       fossil_io_file_t *out = NULL;
-       if (save_file) {
-              if (fossil_io_file_open(&out_file, save_file, "w") == 0) {
-                     out = &out_file;
-              } else {
-                     fossil_io_printf("{red,bold}fish_test: could not open save file.{normal}\n");
-                     fossil_io_cstring_free(filepath);
-                     fossil_sys_memory_free(metrics_copy);
-                     return -1;
-              }
-       }
-
-       // Parse comma-separated metrics using fossil_io_cstring_token
-       cstring saveptr = NULL;
-       cstring token = fossil_io_cstring_token(metrics_copy, ",", &saveptr);
-       while (token) {
-              fossil_io_cstring_trim(token);
-
-              // Use input/output from latest block for metric calculation
-              float score = compute_metric_from_io(
-                     latest->input,
-                     latest->output
-              );
-
-              // Use robust terminal formatting functions for output
-              fossil_io_printf("{blue,bold}Metric %-12s{normal} = {yellow,bold}%.2f{normal}\n", token, score);
-              if (out) {
-                     char line[512];
-                     snprintf(line, sizeof(line), "%s=%.2f\n", token, score);
-                     fossil_io_file_write(out, line, 1, strlen(line));
-              }
-
-              token = fossil_io_cstring_token(NULL, ",", &saveptr);
-       }
-
-       if (out) fossil_io_file_close(out);
-
-       fossil_io_cstring_free(filepath);
-       fossil_sys_memory_free(metrics_copy);
-
-       return 0;
+    if (!model_name) {
+        fossil_io_printf("{red,bold}fish_test: missing model.{normal}\n");
+        return -1;
+    }
+    if (!dataset_path) dataset_path = fish_workspace_path();
+    int wanted = parse_metrics(metrics_list ? metrics_list : EVAL_DEFAULT_METRICS);
+    if (!wanted) {
+        fossil_io_printf("{red,bold}fish_test: no known metrics in '%s'.{normal}\n", metrics_list);
+        return -1;
+    }
+
+    cstring filepath = fossil_io_cstring_format("%s.jfchain", model_name);
+    int exists = filepath && fossil_io_file_file_exists(filepath);
+    fossil_io_cstring_free(filepath);
+    if (!exists) {
+        fossil_io_printf("{red,bold}fish_test: failed to load model: %s.jfchain{normal}\n", model_name);
+        return -1;
+    }
+
+    fish_row_reader_t reader;
+    if (fish_row_reader_open_csv(&reader, dataset_path) != 0) {
+        fossil_io_printf("{red,bold}fish_test: cannot open dataset '%s'.{normal}\n", dataset_path);
+        return -1;
+    }
+
+    eval_ctx_t *ctx = (eval_ctx_t *)fossil_sys_memory_calloc(1, sizeof(eval_ctx_t));
+    fish_model_t *model = ctx && fish_models_init() == 0 ? fish_model_acquire(model_name) : NULL;
+    fish_slice_t first;
+    int rc = -1;
+    if (!model) {
+        fossil_io_printf("{red,bold}fish_test: failed to load model: %s.jfchain{normal}\n", model_name);
+    } else if (!fish_row_reader_next(&reader, &first) && reader.failed) {
+        fossil_io_printf("{red,bold}fish_test: cannot read dataset '%s'.{normal}\n", dataset_path);
+    } else if (reader.rows == 0) {
+        fossil_io_printf("{yellow,bold}fish_test: dataset '%s' is empty.{normal}\n", dataset_path);
+    } else if (!fish_pair_cols_pick(&ctx->cols, &ctx->fields[0], first) && fish_row_reader_rewind(&reader) != 0) {
+        /* no header: the first record is evaluated with the rest */
+        fossil_io_printf("{red,bold}fish_test: cannot read dataset '%s'.{normal}\n", dataset_path);
+    } else {
+        size_t workers = fish_thread_count();
+        uint64_t start = fish_clock_ns();
+        int got;
+
+        ctx->model = model;
+        fossil_io_printf("{green,bold}Testing model '{cyan}%s{normal}{green,bold}' with dataset '{magenta}%s{normal}{green,bold}' on %zu threads{normal}\n",
+                               model_name, dataset_path, workers);
+        while ((got = eval_read(ctx, &reader)) > 0)
+            fish_thread_run(workers, eval_worker, ctx);
+
+        eval_stats_t *total = &ctx->stats[0];
+        for (size_t w = 1; w < workers; w++) stats_merge(total, &ctx->stats[w]);
+        double secs = (double)(fish_clock_ns() - start) / 1e9;
+
+        if (got < 0 && reader.failed) {
+            fossil_io_printf("{red,bold}fish_test: cannot read dataset '%s'.{normal}\n", dataset_path);
+        } else if (got < 0) {
+            fossil_io_printf("{red,bold}fish_test: out of memory.{normal}\n");
+        } else if (total->rows == 0) {
+            fossil_io_printf("{yellow,bold}fish_test: dataset has no usable rows.{normal}\n");
+        } else {
+            print_report(wanted, total);
+            fossil_io_printf("{cyan}fish_test: %llu rows (%llu skipped) in %.3fs (%.0f rows/s){normal}\n",
+                                      (unsigned long long)total->rows, (unsigned long long)total->skipped,
+                                      secs, secs > 0 ? (double)total->rows / secs : 0.0);
+            rc = 0;
+            if (save_file && save_report(save_file, model_name, dataset_path, wanted, total, workers, secs) != 0) {
+                fossil_io_printf("{red,bold}fish_test: could not write report '%s'.{normal}\n", save_file);
+                rc = -1;
+            }
+        }
+    }
+
+    if (model) fish_models_release(0);
+    if (ctx) {
+        for (size_t w = 0; w < FISH_THREAD_MAX; w++) fish_row_fields_free(&ctx->fields[w]);
+        fossil_sys_memory_free(ctx->bytes);
+    }
+    fossil_sys_memory_free(ctx);
+    fish_row_reader_close(&reader);
+    return rc;
 }
@@ -0,0 +1,239 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/thread.h"
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <process.h>
+#else
+#  include <pthread.h>
+#  include <time.h>
+#  include <unistd.h>
+#endif
+
+typedef struct {
+    fish_thread_fn fn;
+    void *ctx;
+    size_t index;
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    int started;
+} worker_t;
+
+#ifdef _WIN32
+static unsigned __stdcall worker_main(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    w->fn(w->ctx, w->index);
+    return 0;
+}
+#else
+static void *worker_main(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    w->fn(w->ctx, w->index);
+    return NULL;
+}
+#endif
+
+static int worker_start(worker_t *w) {
+#ifdef _WIN32
+    uintptr_t h = _beginthreadex(NULL, 0, worker_main, w, 0, NULL);
+    if (h == 0) return -1;
+    w->handle = (HANDLE)h;
+#else
+    if (pthread_create(&w->handle, NULL, worker_main, w) != 0) return -1;
+#endif
+    w->started = 1;
+    return 0;
+}
+
+static void worker_join(worker_t *w) {
+    if (!w->started) return;
+#ifdef _WIN32
+    WaitForSingleObject(w->handle, INFINITE);
+    CloseHandle(w->handle);
+#else
+    pthread_join(w->handle, NULL);
+#endif
+    w->started = 0;
+}
+
+size_t fish_thread_count(void) {
+    long n;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    n = (long)info.dwNumberOfProcessors;
+#else
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (n < 1) n = 1;
+    if (n > FISH_THREAD_MAX) n = FISH_THREAD_MAX;
+    return (size_t)n;
+}
+
+int fish_thread_run(size_t count, fish_thread_fn fn, void *ctx) {
+    if (count == 0) return -1;
+    if (count == 1) {
+        fn(ctx, 0);
+        return 0;
+    }
+
+    worker_t *workers = (worker_t *)fossil_sys_memory_calloc(count, sizeof(worker_t));
+    if (!workers) {
+        /* no room to track threads: run everything here */
+        for (size_t i = 0; i < count; i++) fn(ctx, i);
+        return 0;
+    }
+
+    for (size_t i = 1; i < count; i++) {
+        workers[i].fn = fn;
+        workers[i].ctx = ctx;
+        workers[i].index = i;
+        worker_start(&workers[i]);
+    }
+    fn(ctx, 0);
+    for (size_t i = 1; i < count; i++) {
+        if (workers[i].started) worker_join(&workers[i]);
+        else fn(ctx, i);
+    }
+
+    fossil_sys_memory_free(workers);
+    return 0;
+}
+
+size_t fish_thread_claim(volatile size_t *next) {
+#ifdef _WIN32
+#  ifdef _WIN64
+    return (size_t)InterlockedExchangeAdd64((volatile LONG64 *)next, 1);
+#  else
+    return (size_t)InterlockedExchangeAdd((volatile LONG *)next, 1);
+#  endif
+#else
+    return __atomic_fetch_add(next, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+uint64_t fish_thread_add(volatile uint64_t *counter, uint64_t n) {
+#ifdef _WIN32
+    return (uint64_t)InterlockedExchangeAdd64((volatile LONG64 *)counter, (LONG64)n);
+#else
+    return __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+#endif
+}
+
+void fish_thread_max(volatile uint64_t *value, uint64_t candidate) {
+    uint64_t seen = *value;
+    while (candidate > seen) {
+#ifdef _WIN32
+        uint64_t was = (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)value, (LONG64)candidate, (LONG64)seen);
+        if (was == seen) break;
+        seen = was;
+#else
+        if (__atomic_compare_exchange_n(value, &seen, candidate, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+#endif
+    }
+}
+
+#ifdef _MSC_VER
+#  define FISH_THREAD_LOCAL __declspec(thread)
+#else
+#  define FISH_THREAD_LOCAL _Thread_local
+#endif
+
+size_t fish_thread_self(void) {
+    static volatile size_t next_id = 1;
+    static FISH_THREAD_LOCAL size_t self = 0;
+    if (!self) self = fish_thread_claim(&next_id);
+    return self;
+}
+
+uint64_t fish_clock_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* ---------------- reader/writer lock ---------------- */
+
+struct fish_rwlock {
+#ifdef _WIN32
+    SRWLOCK lock;
+#else
+    pthread_rwlock_t lock;
+#endif
+};
+
+fish_rwlock_t *fish_rwlock_create(void) {
+    fish_rwlock_t *lock = (fish_rwlock_t *)fossil_sys_memory_calloc(1, sizeof(fish_rwlock_t));
+    if (!lock) return NULL;
+#ifdef _WIN32
+    InitializeSRWLock(&lock->lock);
+#else
+    if (pthread_rwlock_init(&lock->lock, NULL) != 0) {
+        fossil_sys_memory_free(lock);
+        return NULL;
+    }
+#endif
+    return lock;
+}
+
+void fish_rwlock_read_lock(fish_rwlock_t *lock) {
+#ifdef _WIN32
+    AcquireSRWLockShared(&lock->lock);
+#else
+    pthread_rwlock_rdlock(&lock->lock);
+#endif
+}
+
+void fish_rwlock_read_unlock(fish_rwlock_t *lock) {
+#ifdef _WIN32
+    ReleaseSRWLockShared(&lock->lock);
+#else
+    pthread_rwlock_unlock(&lock->lock);
+#endif
+}
+
+void fish_rwlock_write_lock(fish_rwlock_t *lock) {
+#ifdef _WIN32
+    AcquireSRWLockExclusive(&lock->lock);
+#else
+    pthread_rwlock_wrlock(&lock->lock);
+#endif
+}
+
+void fish_rwlock_write_unlock(fish_rwlock_t *lock) {
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(&lock->lock);
+#else
+    pthread_rwlock_unlock(&lock->lock);
+#endif
+}
+
+void fish_rwlock_destroy(fish_rwlock_t *lock) {
+    if (!lock) return;
+#ifndef _WIN32
+    pthread_rwlock_destroy(&lock->lock);
+#endif
+    fossil_sys_memory_free(lock);
+}
@@ -0,0 +1,246 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/trace.h"
+#include "fossil/code/dataset.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+static const char *const stage_names[FISH_STAGE_COUNT] = {
+    "load", "parse", "hash", "learn", "reason", "save"
+};
+
+static const char *const counter_names[FISH_COUNTER_COUNT] = {
+    "cache_hit", "cache_miss"
+};
+
+ccstring fish_stage_name(fish_stage_t stage) {
+    return (unsigned)stage < FISH_STAGE_COUNT ? stage_names[stage] : "unknown";
+}
+
+ccstring fish_counter_name(fish_counter_t counter) {
+    return (unsigned)counter < FISH_COUNTER_COUNT ? counter_names[counter] : "unknown";
+}
+
+/* ---------------- histogram ---------------- */
+
+static size_t hist_bucket(uint64_t value) {
+    if (value < 16) return (size_t)value;
+    unsigned k = 63;
+    while (!(value >> k)) k--;
+    return 16 + (size_t)(k - 4) * 8 + (size_t)((value >> (k - 3)) & 7);
+}
+
+/* largest value that falls into bucket b */
+static uint64_t hist_bucket_high(size_t b) {
+    if (b < 16) return b;
+    unsigned k = (unsigned)((b - 16) / 8) + 4;
+    uint64_t sub = (b - 16) % 8;
+    return ((8 + sub) << (k - 3)) + ((uint64_t)1 << (k - 3)) - 1;
+}
+
+void fish_hist_add(fish_hist_t *hist, uint64_t value) {
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max) hist->max = value;
+    hist->bucket[hist_bucket(value)]++;
+}
+
+void fish_hist_merge(fish_hist_t *into, const fish_hist_t *from) {
+    into->count += from->count;
+    into->sum += from->sum;
+    if (from->max > into->max) into->max = from->max;
+    for (size_t b = 0; b < FISH_HIST_BUCKETS; b++) into->bucket[b] += from->bucket[b];
+}
+
+uint64_t fish_hist_percentile(const fish_hist_t *hist, double p) {
+    uint64_t want = (uint64_t)ceil(p * (double)hist->count);
+    uint64_t seen = 0;
+    if (want == 0) want = 1;
+    for (size_t b = 0; b < FISH_HIST_BUCKETS; b++) {
+        seen += hist->bucket[b];
+        if (seen >= want) {
+            uint64_t high = hist_bucket_high(b);
+            return high < hist->max ? high : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+#if FISH_TRACE
+
+/* ---------------- collection ---------------- */
+
+typedef struct {
+    uint32_t stage;
+    uint32_t tid;
+    uint64_t start;             /* ns since tracing was enabled */
+    uint64_t duration;
+} trace_event_t;
+
+/* fish_hist_t fields updated with atomics, plus the item counter */
+typedef struct {
+    volatile uint64_t count;
+    volatile uint64_t sum;
+    volatile uint64_t max;
+    volatile uint64_t bucket[FISH_HIST_BUCKETS];
+    volatile uint64_t items;
+} trace_stage_t;
+
+static struct {
+    volatile int on;
+    fish_trace_format_t format;
+    cstring path;
+    uint64_t origin;
+    trace_stage_t stage[FISH_STAGE_COUNT];
+    volatile uint64_t counter[FISH_COUNTER_COUNT];
+    trace_event_t *events;      /* Chrome format only */
+    volatile size_t event_next;
+} trace;
+
+static void trace_at_exit(void) {
+    if (fish_trace_write() != 0)
+        fossil_io_printf("{red,bold}fish: could not write trace '%s'.{normal}\n", trace.path);
+}
+
+int fish_trace_enable(ccstring path, fish_trace_format_t format) {
+    if (trace.on || !path || path[0] == '\0') return -1;
+    trace.path = fossil_io_cstring_create(path);
+    if (format == FISH_TRACE_CHROME)
+        trace.events = (trace_event_t *)fossil_sys_memory_alloc(FISH_TRACE_EVENTS_MAX * sizeof(trace_event_t));
+    if (!trace.path || (format == FISH_TRACE_CHROME && !trace.events)) {
+        fossil_io_cstring_free(trace.path);
+        fossil_sys_memory_free(trace.events);
+        trace.path = NULL;
+        trace.events = NULL;
+        return -1;
+    }
+    trace.format = format;
+    trace.origin = fish_clock_ns();
+    trace.on = 1;
+    atexit(trace_at_exit);
+    return 0;
+}
+
+int fish_trace_on(void) {
+    return trace.on;
+}
+
+uint64_t fish_trace_begin(void) {
+    return trace.on ? fish_clock_ns() : 0;
+}
+
+void fish_trace_end(fish_stage_t stage, uint64_t start, uint64_t items) {
+    uint64_t ns = fish_clock_ns() - start;
+    trace_stage_t *s = &trace.stage[stage];
+
+    fish_thread_add(&s->count, 1);
+    fish_thread_add(&s->sum, ns);
+    fish_thread_add(&s->items, items);
+    fish_thread_max(&s->max, ns);
+    fish_thread_add(&s->bucket[hist_bucket(ns)], 1);
+
+    if (trace.events) {
+        size_t at = fish_thread_claim(&trace.event_next);
+        if (at < FISH_TRACE_EVENTS_MAX) {
+            trace.events[at].stage = (uint32_t)stage;
+            trace.events[at].tid = (uint32_t)fish_thread_self();
+            trace.events[at].start = start - trace.origin;
+            trace.events[at].duration = ns;
+        }
+    }
+}
+
+void fish_trace_count(fish_counter_t counter, uint64_t n) {
+    fish_thread_add(&trace.counter[counter], n);
+}
+
+uint64_t fish_trace_counter(fish_counter_t counter) {
+    return trace.counter[counter];
+}
+
+/* ---------------- report ---------------- */
+
+static void put_format(fish_row_writer_t *out, const char *fmt, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > 0) fish_row_writer_put(out, buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+static void stage_snapshot(const trace_stage_t *s, fish_hist_t *hist) {
+    hist->count = s->count;
+    hist->sum = s->sum;
+    hist->max = s->max;
+    for (size_t b = 0; b < FISH_HIST_BUCKETS; b++) hist->bucket[b] = s->bucket[b];
+}
+
+static void put_stages(fish_row_writer_t *out) {
+    fish_hist_t hist;
+    put_format(out, "{");
+    for (size_t i = 0; i < FISH_STAGE_COUNT; i++) {
+        stage_snapshot(&trace.stage[i], &hist);
+        put_format(out, "%s\"%s\":{\"calls\":%llu,\"items\":%llu,\"total_ms\":%.3f,\"mean_us\":%.3f,"
+                        "\"p50_us\":%.3f,\"p90_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}",
+                   i ? "," : "", stage_names[i],
+                   (unsigned long long)hist.count, (unsigned long long)trace.stage[i].items,
+                   (double)hist.sum / 1e6, hist.count ? (double)hist.sum / (double)hist.count / 1e3 : 0.0,
+                   (double)fish_hist_percentile(&hist, 0.50) / 1e3, (double)fish_hist_percentile(&hist, 0.90) / 1e3,
+                   (double)fish_hist_percentile(&hist, 0.99) / 1e3, (double)hist.max / 1e3);
+    }
+    put_format(out, "}");
+}
+
+static void put_counters(fish_row_writer_t *out) {
+    put_format(out, "{");
+    for (size_t i = 0; i < FISH_COUNTER_COUNT; i++)
+        put_format(out, "%s\"%s\":%llu", i ? "," : "", counter_names[i], (unsigned long long)trace.counter[i]);
+    put_format(out, "}");
+}
+
+int fish_trace_write(void) {
+    if (!trace.on) return 0;
+
+    fish_row_writer_t out;
+    if (fish_row_writer_open_raw(&out, trace.path) != 0) return -1;
+
+    size_t events = trace.event_next < FISH_TRACE_EVENTS_MAX ? trace.event_next : FISH_TRACE_EVENTS_MAX;
+    if (trace.format == FISH_TRACE_CHROME) {
+        put_format(&out, "{\"traceEvents\":[\n");
+        for (size_t i = 0; i < events; i++) {
+            const trace_event_t *e = &trace.events[i];
+            put_format(&out, "%s{\"name\":\"%s\",\"cat\":\"fish\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                       i ? ",\n" : "", stage_names[e->stage], (double)e->start / 1e3, (double)e->duration / 1e3,
+                       (unsigned)e->tid);
+        }
+        put_format(&out, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%llu,\"stages\":",
+                   (unsigned long long)(trace.event_next - events));
+        put_stages(&out);
+        put_format(&out, ",\"counters\":");
+        put_counters(&out);
+        put_format(&out, "}}\n");
+    } else {
+        put_format(&out, "{\"seconds\":%.6f,\"stages\":", (double)(fish_clock_ns() - trace.origin) / 1e9);
+        put_stages(&out);
+        put_format(&out, ",\"counters\":");
+        put_counters(&out);
+        put_format(&out, "}\n");
+    }
+    return fish_row_writer_commit(&out);
+}
+
+#endif /* FISH_TRACE */
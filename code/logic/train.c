@@ -11,83 +11,393 @@
  * Copyright (C) 2024 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
+#include "fossil/code/arena.h"
+#include "fossil/code/cache.h"
 #include "fossil/code/commands.h"
+#include "fossil/code/index.h"
+#include "fossil/code/learn.h"
+#include "fossil/code/page.h"
+#include "fossil/code/store.h"
+#include "fossil/code/thread.h"
+#include "fossil/code/trace.h"
+#include "fossil/code/workspace.h"
+#include "fossil/code/zchain.h"
 
-int fish_train(ccstring model_name, ccstring dataset_path,
-               int epochs, int batch_size, float lr)
-{
-    if (!model_name) return -1;
+/*
+ * Training streams the dataset in batches of rows and turns each row into
+ * an input/output pair:
+ *
+ *   - the first record is a header only if it reads as one (see
+ *     fish_schema_is_header()); otherwise it is trained on like the rest;
+ *   - columns named input/prompt/question and output/response/answer/label
+ *     are used when the header has them, otherwise the first two columns;
+ *   - a single-column row is its own input and output.
+ *
+ * The first epoch learns new pairs. Every pass, a pair the chain already
+ * holds is reinforced instead: its confidence moves towards 1 by @p lr.
+ *
+ * Batches are pipelined: while the calling thread commits batch k into
+ * the chain, the other workers split, trim and hash batch k+1. A batch's
+ * new pairs go into the chain with one fish_chain_learn_bulk() call.
+ */
 
-    // Allocate filepath using memory API
-    cstring filepath = (cstring)fossil_sys_memory_alloc(512);
-    if (!filepath) return -1;
-    fossil_io_cstring_format(filepath, 512, "%s.jfchain", model_name);
+#define TRAIN_INPUT_MAX  sizeof(((fossil_ai_jellyfish_block_t *)0)->input)
+#define TRAIN_OUTPUT_MAX sizeof(((fossil_ai_jellyfish_block_t *)0)->output)
+#define TRAIN_CLAIM_ROWS 256
+#define TRAIN_SEED 0x747261696eull /* "train" */
 
-    // Use fossil_io_file_t to check if the model file exists and is readable
-    if (!fossil_io_file_file_exists(filepath) || !fossil_io_file_is_readable(filepath)) {
-        fossil_io_printf("{red,bold}Model file does not exist or is not readable: %s{normal}\n", filepath);
-        fossil_sys_memory_free(filepath);
-        return -1;
-    }
+typedef struct {
+    char input[TRAIN_INPUT_MAX];
+    char output[TRAIN_OUTPUT_MAX];
+    uint8_t hash[FOSSIL_JELLYFISH_HASH_SIZE];
+    int ok;                     /* row produced a pair */
+} train_pair_t;
 
-    fossil_ai_jellyfish_chain_t chain;
-    if (fossil_ai_jellyfish_load(&chain, filepath) != 0) {
-        fossil_io_printf("{red,bold}Failed to load model: %s{normal}\n", filepath);
-        fossil_sys_memory_free(filepath);
-        return -1;
+typedef struct {
+    char *bytes;                /* rows copied out of the reader */
+    size_t len;
+    size_t bytes_cap;
+    fish_slice_t *row;          /* slices into bytes, rebased after copying */
+    size_t *row_at;
+    size_t rows;
+    train_pair_t *pair;
+    volatile size_t next;       /* prepare: next claim */
+} train_batch_t;
+
+typedef struct {
+    fossil_ai_jellyfish_chain_t *chain;
+    fish_chain_index_t *index;
+    float lr;
+    fish_pair_cols_t cols;
+    train_batch_t *commit;      /* batch committed by worker 0 (may be NULL) */
+    train_batch_t *prepare;     /* batch prepared by the others (may be NULL) */
+    fish_row_fields_t fields[FISH_THREAD_MAX];
+    fish_hashset_t pending;     /* new pairs of the committing batch, by pair hash */
+    fish_pair_t *fresh;         /* new pairs, in row order */
+    size_t *fresh_row;          /* fresh pair -> row in the committing batch */
+    uint32_t *repeat;           /* fresh pair -> further occurrences in the batch */
+    uint64_t learned;
+    uint64_t reinforced;
+    uint64_t dropped;           /* chain full */
+    uint64_t empty;             /* rows without usable fields */
+    int header;                 /* first record is a header, skipped every epoch */
+} train_ctx_t;
+
+static int batch_init(train_batch_t *batch, size_t batch_size) {
+    fossil_sys_memory_zero(batch, sizeof(*batch));
+    batch->row = (fish_slice_t *)fossil_sys_memory_alloc(batch_size * sizeof(fish_slice_t));
+    batch->row_at = (size_t *)fossil_sys_memory_alloc(batch_size * sizeof(size_t));
+    batch->pair = (train_pair_t *)fossil_sys_memory_alloc(batch_size * sizeof(train_pair_t));
+    return batch->row && batch->row_at && batch->pair ? 0 : -1;
+}
+
+static void batch_free(train_batch_t *batch) {
+    fossil_sys_memory_free(batch->bytes);
+    fossil_sys_memory_free(batch->row);
+    fossil_sys_memory_free(batch->row_at);
+    fossil_sys_memory_free(batch->pair);
+    fossil_sys_memory_zero(batch, sizeof(*batch));
+}
+
+/* Copy up to @p batch_size rows out of the reader; returns rows read, or -1 on OOM or a read error */
+static int batch_read(train_batch_t *batch, fish_row_reader_t *reader, size_t batch_size) {
+    fish_slice_t row;
+    batch->len = 0;
+    batch->rows = 0;
+    batch->next = 0;
+    while (batch->rows < batch_size && fish_row_reader_next(reader, &row)) {
+        if (batch->len + row.len > batch->bytes_cap) {
+            size_t cap = batch->bytes_cap ? batch->bytes_cap : ((size_t)1 << 16);
+            while (cap < batch->len + row.len) cap *= 2;
+            char *grown = (char *)fossil_sys_memory_realloc(batch->bytes, cap);
+            if (!grown) return -1;
+            batch->bytes = grown;
+            batch->bytes_cap = cap;
+        }
+        if (row.len) fossil_sys_memory_copy(batch->bytes + batch->len, row.ptr, row.len);
+        batch->row_at[batch->rows] = batch->len;
+        batch->row[batch->rows].len = row.len;
+        batch->len += row.len;
+        batch->rows++;
     }
+    if (reader->failed) return -1;
+    /* the buffer may have moved while growing: point the slices last */
+    for (size_t r = 0; r < batch->rows; r++) batch->row[r].ptr = batch->bytes + batch->row_at[r];
+    return (int)batch->rows;
+}
 
-    if (chain.count >= FOSSIL_JELLYFISH_MAX_MEM) {
-        fossil_io_printf("{yellow,bold}Chain is full, cannot add new commit.{normal}\n");
-        fossil_sys_memory_free(filepath);
-        return -1;
+static void pair_prepare(train_ctx_t *ctx, fish_row_fields_t *fields, fish_slice_t row, train_pair_t *pair) {
+    fish_slice_t in, out;
+    pair->ok = 0;
+    if (!fish_pair_split(&ctx->cols, fields, row, &in, &out)) return;
+
+    fish_slice_copy(in, pair->input, sizeof(pair->input));
+    fish_slice_copy(out, pair->output, sizeof(pair->output));
+    fossil_ai_jellyfish_hash(pair->input, pair->output, pair->hash);
+    pair->ok = 1;
+}
+
+static int pending_resolve(void *arg, uint64_t ref, size_t len, fish_slice_t *out) {
+    const train_ctx_t *ctx = (const train_ctx_t *)arg;
+    out->ptr = (const char *)ctx->commit->pair[ctx->fresh_row[ref]].hash;
+    out->len = FOSSIL_JELLYFISH_HASH_SIZE;
+    return 0;
+}
+
+static void reinforce(fossil_ai_jellyfish_block_t *block, float lr, uint32_t times) {
+    for (uint32_t t = 0; t < times; t++)
+        block->attributes.confidence += lr * (1.0f - block->attributes.confidence);
+}
+
+/* reinforce the pairs the chain knows, then learn the batch's new ones in bulk */
+static void batch_commit(train_ctx_t *ctx, const train_batch_t *batch) {
+    size_t fresh = 0;
+    FISH_TRACE_BEGIN(trace);
+    fish_hashset_clear(&ctx->pending);
+
+    for (size_t r = 0; r < batch->rows; r++) {
+        const train_pair_t *pair = &batch->pair[r];
+        if (!pair->ok) {
+            ctx->empty++;
+            continue;
+        }
+
+        /* the chain may fold more than the pair into its commit hashes: fall back to the input */
+        fossil_ai_jellyfish_block_t *known = fish_chain_index_hash(ctx->index, pair->hash);
+        if (!known) known = fish_chain_index_input(ctx->index, pair->input);
+        if (known && strcmp(known->input, pair->input) == 0 && strcmp(known->output, pair->output) == 0) {
+            reinforce(known, ctx->lr, 1);
+            ctx->reinforced++;
+            continue;
+        }
+
+        /* repeated within this batch: reinforce once it is learned */
+        fish_slice_t key = { (const char *)pair->hash, FOSSIL_JELLYFISH_HASH_SIZE };
+        uint64_t digest = fish_hash64(pair->hash, FOSSIL_JELLYFISH_HASH_SIZE, TRAIN_SEED);
+        uint64_t first = 0;
+        if (fish_hashset_lookup(&ctx->pending, digest, key, &first) == 1) {
+            ctx->repeat[first]++;
+            continue;
+        }
+        ctx->fresh[fresh].input = pair->input;
+        ctx->fresh[fresh].output = pair->output;
+        ctx->fresh_row[fresh] = r;
+        ctx->repeat[fresh] = 0;
+        fish_hashset_insert(&ctx->pending, digest, key, fresh);
+        fresh++;
     }
 
-    // Simulate training by adding a new commit using the learn API
-    cstring input = (cstring)fossil_sys_memory_alloc(128);
-    cstring output = (cstring)fossil_sys_memory_alloc(128);
-    fossil_io_cstring_format(input, 128, "epoch:%d batch:%d lr:%.4f", epochs, batch_size, lr);
-    fossil_io_cstring_format(output, 128, "trained on %s", dataset_path ? dataset_path : "N/A");
+    /* the bulk learn below traces itself */
+    FISH_TRACE_END(FISH_STAGE_LEARN, trace, batch->rows - fresh);
 
-    // Generate hash for input/output pair
-    uint8_t hash[FOSSIL_JELLYFISH_HASH_SIZE];
-    fossil_ai_jellyfish_hash(input, output, hash);
+    size_t base = ctx->chain->count;
+    size_t learned = fish_chain_learn_bulk(ctx->chain, ctx->fresh, fresh);
+    for (size_t i = 0; i < fresh; i++) {
+        if (i < learned) {
+            reinforce(&ctx->chain->commits[base + i], ctx->lr, ctx->repeat[i]);
+            ctx->reinforced += ctx->repeat[i];
+        } else {
+            ctx->dropped += 1 + ctx->repeat[i];
+        }
+    }
+    ctx->learned += learned;
+    fish_chain_index_sync(ctx->index);
+}
+
+/* worker 0 commits one batch while the others prepare the next */
+static void train_worker(void *arg, size_t index) {
+    train_ctx_t *ctx = (train_ctx_t *)arg;
 
-    // Learn new input-output pair (commit)
-    fossil_ai_jellyfish_learn(&chain, input, output);
+    if (index == 0 && ctx->commit) batch_commit(ctx, ctx->commit);
 
-    // Optionally, find the block just added and set its hash explicitly (if needed)
-    fossil_ai_jellyfish_block_t *block = fossil_ai_jellyfish_find(&chain, hash);
-    if (block) {
-        fossil_ai_jellyfish_mark_immutable(block);
-        fossil_ai_jellyfish_block_set_message(block, "Training commit");
-        fossil_ai_jellyfish_tag_block(block, "train");
+    train_batch_t *batch = ctx->prepare;
+    if (!batch || (index == 0 && ctx->commit)) return;
+    for (;;) {
+        size_t begin = fish_thread_claim(&batch->next) * TRAIN_CLAIM_ROWS;
+        if (begin >= batch->rows) break;
+        size_t end = begin + TRAIN_CLAIM_ROWS < batch->rows ? begin + TRAIN_CLAIM_ROWS : batch->rows;
+        FISH_TRACE_BEGIN(trace);
+        for (size_t r = begin; r < end; r++) pair_prepare(ctx, &ctx->fields[index], batch->row[r], &batch->pair[r]);
+        FISH_TRACE_END(FISH_STAGE_PARSE, trace, end - begin);
     }
+}
 
-    fossil_sys_memory_free(input);
-    fossil_sys_memory_free(output);
+static int train_checkpoint(fossil_ai_jellyfish_chain_t *chain, const fish_chain_index_t *index,
+                            ccstring model_name, ccstring filepath) {
+    FISH_TRACE_BEGIN(trace);
+    chain->updated_at = (uint64_t)time(NULL);
+    /* only commits added or reinforced since the last checkpoint become new objects */
+    int rc = fish_store_save(chain, filepath, NULL);
+    /* missing sidecars only make the next load slower */
+    if (rc == 0) {
+        fish_chain_index_save(index, model_name);
+        fish_page_write(chain, model_name);
+        /* reinforcement moves confidences without always moving the fingerprint */
+        cstring cache = fish_scratch_format("%s%s", model_name, FISH_CACHE_SUFFIX);
+        if (cache && fossil_io_file_file_exists(cache)) fossil_io_file_delete(cache);
+        fish_scratch_free(cache);
+    }
+    FISH_TRACE_END(FISH_STAGE_SAVE, trace, chain->count);
+    return rc;
+}
 
-    chain.updated_at = (uint64_t)time(NULL);
+static int train_run(train_ctx_t *ctx, fish_row_reader_t *reader, ccstring model_name, ccstring filepath,
+                     int epochs, size_t batch_size, int checkpoint_every) {
+    train_batch_t slot[2];
+    size_t workers = fish_thread_count();
+    if (workers < 2) workers = 2; /* keep the pipeline even on one core */
 
-    // Use fossil_io_file_is_writable before saving
-    if (!fossil_io_file_is_writable(filepath)) {
-        fossil_io_printf("{red,bold}Model file is not writable: %s{normal}\n", filepath);
-        fossil_sys_memory_free(filepath);
+    ctx->fresh = (fish_pair_t *)fossil_sys_memory_alloc(batch_size * sizeof(fish_pair_t));
+    ctx->fresh_row = (size_t *)fossil_sys_memory_alloc(batch_size * sizeof(size_t));
+    ctx->repeat = (uint32_t *)fossil_sys_memory_alloc(batch_size * sizeof(uint32_t));
+    int ready = batch_init(&slot[0], batch_size) == 0 && batch_init(&slot[1], batch_size) == 0 &&
+                ctx->fresh && ctx->fresh_row && ctx->repeat &&
+                fish_hashset_init(&ctx->pending, batch_size, pending_resolve, ctx) == 0;
+    if (!ready) {
+        batch_free(&slot[0]);
+        batch_free(&slot[1]);
         return -1;
     }
 
-    if (fossil_ai_jellyfish_save(&chain, filepath) != 0) {
-        fossil_io_printf("{red,bold}Failed to save model after training.{normal}\n");
-        fossil_sys_memory_free(filepath);
+    int rc = 0;
+    uint64_t batches = 0;
+    fish_slice_t first;
+    if (!fish_row_reader_next(reader, &first)) rc = -1;
+    else ctx->header = fish_pair_cols_pick(&ctx->cols, &ctx->fields[0], first);
+
+    for (int epoch = 1; epoch <= epochs && rc == 0; epoch++) {
+        uint64_t start = fish_clock_ns();
+        uint64_t rows = 0;
+        uint64_t learned = ctx->learned, reinforced = ctx->reinforced;
+
+        /* a headerless dataset trains on its first record too */
+        if (fish_row_reader_rewind(reader) != 0 || (ctx->header && !fish_row_reader_next(reader, &first))) {
+            rc = -1;
+            break;
+        }
+
+        int cur = 0;
+        int got = batch_read(&slot[cur], reader, batch_size);
+        if (got < 0) {
+            rc = -1;
+            break;
+        }
+        ctx->commit = NULL;
+        ctx->prepare = got > 0 ? &slot[cur] : NULL;
+        while (got > 0) {
+            /* prepare the batch just read while committing the previous one */
+            fish_thread_run(workers, train_worker, ctx);
+            rows += slot[cur].rows;
+
+            int nxt = cur ^ 1;
+            got = batch_read(&slot[nxt], reader, batch_size);
+            if (got < 0) {
+                rc = -1;
+                break;
+            }
+            ctx->commit = &slot[cur];
+            ctx->prepare = got > 0 ? &slot[nxt] : NULL;
+            if (!ctx->prepare) {
+                fish_thread_run(1, train_worker, ctx);
+                ctx->commit = NULL;
+            }
+            cur = nxt;
+
+            batches++;
+            if (checkpoint_every > 0 && batches % (uint64_t)checkpoint_every == 0 &&
+                train_checkpoint(ctx->chain, ctx->index, model_name, filepath) != 0) {
+                fossil_io_printf("{red,bold}fish_train: checkpoint failed.{normal}\n");
+                rc = -1;
+                break;
+            }
+        }
+
+        double secs = (double)(fish_clock_ns() - start) / 1e9;
+        fossil_io_printf("{cyan}fish_train: epoch %d/%d: %llu rows, %llu learned, %llu reinforced in %.3fs (%.0f rows/s){normal}\n",
+                         epoch, epochs, (unsigned long long)rows,
+                         (unsigned long long)(ctx->learned - learned),
+                         (unsigned long long)(ctx->reinforced - reinforced),
+                         secs, secs > 0 ? (double)rows / secs : 0.0);
+    }
+
+    batch_free(&slot[0]);
+    batch_free(&slot[1]);
+    return rc;
+}
+
+int fish_train(ccstring model_name, ccstring dataset_path,
+               int epochs, int batch_size, float lr, int checkpoint_every)
+{
+    if (!model_name) return -1;
+    if (!dataset_path) dataset_path = fish_workspace_path();
+    if (epochs < 1) epochs = 1;
+    if (batch_size < 1) batch_size = 1024;
+    if (lr < 0.0f) lr = 0.0f;
+    if (lr > 1.0f) lr = 1.0f;
+
+    cstring filepath = fish_scratch_format("%s.jfchain", model_name);
+    if (!filepath) return -1;
+
+    // Use fossil_io_file_t to check if the model file exists and is readable
+    if (!fossil_io_file_file_exists(filepath) || !fossil_io_file_is_readable(filepath)) {
+        fossil_io_printf("{red,bold}Model file does not exist or is not readable: %s{normal}\n", filepath);
         return -1;
     }
 
-    fossil_io_printf(
-        "{green,bold}Trained model '{cyan}%s{green}' on dataset '{magenta}%s{green}' "
-        "(%d epochs, batch %d, lr %.4f){normal}\n",
-        model_name, dataset_path ? dataset_path : "N/A", epochs, batch_size, lr
-    );
+    fossil_ai_jellyfish_chain_t *chain = (fossil_ai_jellyfish_chain_t *)
+        fossil_sys_memory_calloc(1, sizeof(fossil_ai_jellyfish_chain_t));
+    train_ctx_t *ctx = (train_ctx_t *)fossil_sys_memory_calloc(1, sizeof(train_ctx_t));
+    fish_chain_index_t index;
+    fish_row_reader_t reader;
+    fossil_sys_memory_zero(&index, sizeof(index));
 
-    fossil_sys_memory_free(filepath);
-    return 0;
+    int rc = -1;
+    if (!chain || !ctx) {
+        fossil_io_printf("{red,bold}fish_train: out of memory.{normal}\n");
+    } else if (fish_chain_load(chain, filepath) != 0) {
+        fossil_io_printf("{red,bold}Failed to load model: %s{normal}\n", filepath);
+    } else if (fish_chain_index_open(&index, chain, model_name) != 0) {
+        fossil_io_printf("{red,bold}Failed to index model: %s{normal}\n", filepath);
+    } else if (fish_row_reader_open_csv(&reader, dataset_path) != 0) {
+        fossil_io_printf("{red,bold}fish_train: cannot open dataset '%s'.{normal}\n", dataset_path);
+    } else {
+        uint64_t start = fish_clock_ns();
+        ctx->chain = chain;
+        ctx->index = &index;
+        ctx->lr = lr;
+
+        rc = train_run(ctx, &reader, model_name, filepath, epochs, (size_t)batch_size, checkpoint_every);
+        fish_row_reader_close(&reader);
+
+        if (rc == 0 && train_checkpoint(chain, &index, model_name, filepath) != 0) {
+            fossil_io_printf("{red,bold}Failed to save model after training.{normal}\n");
+            rc = -1;
+        }
+        if (rc == 0) {
+            double secs = (double)(fish_clock_ns() - start) / 1e9;
+            fossil_io_printf(
+                "{green,bold}Trained model '{cyan}%s{green}' on dataset '{magenta}%s{green}' "
+                "(%d epochs, batch %d, lr %.4f): %llu learned, %llu reinforced in %.3fs{normal}\n",
+                model_name, dataset_path, epochs, batch_size, lr,
+                (unsigned long long)ctx->learned, (unsigned long long)ctx->reinforced, secs);
+            if (ctx->dropped)
+                fossil_io_printf("{yellow,bold}fish_train: chain full, %llu pairs not learned.{normal}\n",
+                                 (unsigned long long)ctx->dropped);
+            if (ctx->empty)
+                fossil_io_printf("{yellow}fish_train: %llu rows had no usable input/output.{normal}\n",
+                                 (unsigned long long)ctx->empty);
+        }
+    }
+
+    if (ctx) {
+        for (size_t w = 0; w < FISH_THREAD_MAX; w++) fish_row_fields_free(&ctx->fields[w]);
+        fish_hashset_free(&ctx->pending);
+        fossil_sys_memory_free(ctx->fresh);
+        fossil_sys_memory_free(ctx->fresh_row);
+        fossil_sys_memory_free(ctx->repeat);
+    }
+    fish_chain_index_free(&index);
+    fossil_sys_memory_free(ctx);
+    fossil_sys_memory_free(chain);
+    return rc;
 }
@@ -0,0 +1,190 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/workspace.h"
+#include "fossil/code/arena.h"
+#include "fossil/code/meta.h"
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/file.h>
+#  include <unistd.h>
+#endif
+
+/* datasets/current.dataset until a dataset is selected */
+static cstring selected;
+
+/* ---------------- names ---------------- */
+
+int fish_workspace_valid_name(ccstring name) {
+    return name && name[0] && name[0] != '.' && !strpbrk(name, "/\\");
+}
+
+/* datasets/<name>, then with the extensions import gives registered files */
+static cstring name_path(ccstring name) {
+    static ccstring const ext[] = { "", ".fcol", ".dataset" };
+    for (size_t i = 0; i < sizeof(ext) / sizeof(ext[0]); i++) {
+        cstring path = fossil_io_cstring_format(FISH_DATASET_DIR "/%s%s", name, ext[i]);
+        if (!path || fossil_io_file_file_exists(path)) return path;
+        fossil_io_cstring_free(path);
+    }
+    return fossil_io_cstring_format(FISH_DATASET_DIR "/%s", name);
+}
+
+int fish_workspace_select(ccstring name) {
+    cstring path = NULL;
+    if (name) {
+        if (!fish_workspace_valid_name(name)) return -1;
+        if (!(path = name_path(name))) return -1;
+    }
+    fossil_io_cstring_free(selected);
+    selected = path;
+    return 0;
+}
+
+ccstring fish_workspace_path(void) {
+    return selected ? selected : FISH_DATASET_PATH;
+}
+
+ccstring fish_workspace_resolve(ccstring name_or_path) {
+    if (fossil_io_file_file_exists(name_or_path) || !fish_workspace_valid_name(name_or_path))
+        return name_or_path;
+    cstring path = name_path(name_or_path);
+    ccstring out = path ? fish_scratch_format("%s", path) : NULL;
+    fossil_io_cstring_free(path);
+    return out;
+}
+
+static ccstring base_name(ccstring path) {
+    ccstring slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+cstring fish_workspace_output(ccstring role) {
+    if (!selected || strcmp(selected, FISH_DATASET_PATH) == 0)
+        return fossil_io_cstring_format(FISH_DATASET_DIR "/%s.dataset", role);
+    ccstring base = base_name(selected);
+    ccstring dot = strrchr(base, '.');
+    int stem = dot && dot != base ? (int)(dot - base) : (int)strlen(base);
+    return fossil_io_cstring_format(FISH_DATASET_DIR "/%.*s.%s.dataset", stem, base, role);
+}
+
+/* ---------------- locking ---------------- */
+
+int fish_workspace_lock(fish_workspace_lock_t *lock) {
+    lock->handle = -1;
+    if (!fish_file_is_directory(FISH_DATASET_DIR)) return 0; /* nothing to guard yet */
+
+    ccstring path = fish_workspace_path();
+    ccstring base = base_name(path);
+    cstring file = fossil_io_cstring_format("%.*s.%s.lock", (int)(base - path), path, base);
+    if (!file) return -1;
+
+#ifdef _WIN32
+    HANDLE h = CreateFileA(file, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                           NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_HIDDEN, NULL);
+    fossil_io_cstring_free(file);
+    if (h == INVALID_HANDLE_VALUE) return -1;
+    OVERLAPPED at;
+    fossil_sys_memory_zero(&at, sizeof(at));
+    if (!LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &at)) {
+        fossil_io_printf("{yellow}Waiting for another job on '%s'...{normal}\n", path);
+        if (!LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &at)) {
+            CloseHandle(h);
+            return -1;
+        }
+    }
+    lock->handle = (intptr_t)h;
+#else
+    int fd = open(file, O_RDWR | O_CREAT, 0644);
+    fossil_io_cstring_free(file);
+    if (fd < 0) return -1;
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        int held = errno == EWOULDBLOCK;
+        if (held) fossil_io_printf("{yellow}Waiting for another job on '%s'...{normal}\n", path);
+        int rc = -1;
+        while (held && (rc = flock(fd, LOCK_EX)) != 0 && errno == EINTR) {}
+        if (rc != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    lock->handle = fd;
+#endif
+    return 0;
+}
+
+void fish_workspace_unlock(fish_workspace_lock_t *lock) {
+    if (lock->handle < 0) return;
+    /* the lock file stays: removing it would race with a job about to lock it */
+#ifdef _WIN32
+    CloseHandle((HANDLE)lock->handle);
+#else
+    close((int)lock->handle);
+#endif
+    lock->handle = -1;
+}
+
+/* ---------------- listing ---------------- */
+
+/* temp files, sidecars, locks and dedup partitions share the directory */
+static int is_dataset_file(ccstring base) {
+    static ccstring const aux[] = { ".tmp", FISH_META_SUFFIX };
+    size_t len = strlen(base);
+    if (base[0] == '.') return 0; /* lock files */
+    for (size_t i = 0; i < sizeof(aux) / sizeof(aux[0]); i++) {
+        size_t n = strlen(aux[i]);
+        if (len >= n && strcmp(base + len - n, aux[i]) == 0) return 0;
+    }
+    return strstr(base, ".dedup.") == NULL;
+}
+
+/**
+ * @brief List the datasets of the workspace.
+ *
+ * The selected dataset is marked with '*'.
+ */
+int fish_dataset_list(void) {
+    fish_path_list_t list = { NULL, 0, 0 };
+    if (!fish_file_is_directory(FISH_DATASET_DIR)) {
+        fossil_io_printf("{yellow}fish_dataset_list: no datasets yet (import one first).{normal}\n");
+        return 0;
+    }
+    if (fish_path_list_dir(&list, FISH_DATASET_DIR) != 0) {
+        fossil_io_printf("{red,bold}fish_dataset_list: cannot read '" FISH_DATASET_DIR "'.{normal}\n");
+        fish_path_list_free(&list);
+        return -1;
+    }
+
+    ccstring active = fish_workspace_path();
+    size_t shown = 0;
+    for (size_t i = 0; i < list.count; i++) {
+        ccstring base = base_name(list.path[i]);
+        if (!is_dataset_file(base)) continue;
+        double size = (double)fish_file_size(list.path[i]);
+        ccstring unit = "B";
+        if (size >= 1024.0 * 1024.0) { size /= 1024.0 * 1024.0; unit = "MiB"; }
+        else if (size >= 1024.0) { size /= 1024.0; unit = "KiB"; }
+        int current = strcmp(list.path[i], active) == 0;
+        fossil_io_printf("%s{cyan}%-32s{normal} %8.1f %s\n", current ? "* " : "  ", base, size, unit);
+        shown++;
+    }
+    if (shown == 0) fossil_io_printf("{yellow}fish_dataset_list: no datasets yet (import one first).{normal}\n");
+    fish_path_list_free(&list);
+    return 0;
+}
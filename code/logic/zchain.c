@@ -0,0 +1,289 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/code/zchain.h"
+#include "fossil/code/store.h"
+#include "fossil/code/trace.h"
+
+#define ZCHAIN_TRAILER_SIZE (sizeof(uint64_t) + 8)
+
+typedef fossil_ai_jellyfish_block_t zc_block_t;
+
+/* worst case for an encoded record of n bytes: one literal run */
+#define RECORD_BOUND(n) ((n) + 24)
+
+/* ---------------- run coding ---------------- */
+
+static size_t put_varint(uint8_t *out, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static int get_varint(const uint8_t **p, const uint8_t *end, uint64_t *v) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64 && *p < end; shift += 7) {
+        uint8_t byte = *(*p)++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *v = value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* (zero run, literal run) pairs; lone zeros stay inside literals */
+static size_t run_encode(const uint8_t *x, size_t n, uint8_t *out) {
+    size_t len = 0, i = 0;
+    while (i < n) {
+        size_t zeros = i;
+        while (i < n && x[i] == 0) i++;
+        zeros = i - zeros;
+
+        size_t start = i;
+        while (i < n && (x[i] != 0 || (i + 1 < n && x[i + 1] != 0))) i++;
+
+        len += put_varint(out + len, zeros);
+        len += put_varint(out + len, i - start);
+        if (i > start) fossil_sys_memory_copy(out + len, x + start, i - start);
+        len += i - start;
+    }
+    return len;
+}
+
+static int run_decode(const uint8_t *p, size_t len, uint8_t *x, size_t n) {
+    const uint8_t *end = p + len;
+    size_t i = 0;
+    while (i < n) {
+        uint64_t zeros, lit;
+        if (get_varint(&p, end, &zeros) != 0 || get_varint(&p, end, &lit) != 0) return -1;
+        if (zeros > n - i || lit > n - i - zeros || lit > (uint64_t)(end - p)) return -1;
+        fossil_sys_memory_zero(x + i, (size_t)zeros);
+        i += (size_t)zeros;
+        if (lit) fossil_sys_memory_copy(x + i, p, (size_t)lit);
+        i += (size_t)lit;
+        p += lit;
+    }
+    return p == end ? 0 : -1;
+}
+
+/* what block pos is expected to look like given the one before it */
+static void predict(const zc_block_t *prev, zc_block_t *ref) {
+    if (!prev) {
+        fossil_sys_memory_zero(ref, sizeof(*ref));
+        return;
+    }
+    *ref = *prev;
+    ref->identity.commit_index = prev->identity.commit_index + 1;
+    fossil_sys_memory_copy(ref->identity.parent_hashes[0], prev->identity.commit_hash, FOSSIL_JELLYFISH_HASH_SIZE);
+}
+
+static void xor_bytes(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = a[i] ^ b[i];
+}
+
+/* ---------------- writer ---------------- */
+
+typedef struct {
+    uint8_t magic[8];
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t keyframe;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t chain_len;             /* bytes of the chain record that follows */
+} zc_header_t;
+
+int fish_zchain_save(const fossil_ai_jellyfish_chain_t *chain, ccstring path) {
+    size_t count = chain->count <= FOSSIL_JELLYFISH_MAX_MEM ? chain->count : FOSSIL_JELLYFISH_MAX_MEM;
+    uint64_t *offset = (uint64_t *)fossil_sys_memory_alloc((count ? count : 1) * sizeof(uint64_t));
+    uint8_t *record = (uint8_t *)fossil_sys_memory_alloc(RECORD_BOUND(sizeof(zc_block_t) + FISH_CHAIN_FIELDS));
+    uint8_t *raw = (uint8_t *)fossil_sys_memory_alloc(sizeof(zc_block_t) + FISH_CHAIN_FIELDS);
+    fish_row_writer_t out;
+    if (!offset || !record || !raw || fish_row_writer_open_raw(&out, path) != 0) {
+        fossil_sys_memory_free(offset);
+        fossil_sys_memory_free(record);
+        fossil_sys_memory_free(raw);
+        return -1;
+    }
+
+    /* chain fields, coded against zeros */
+    const uint8_t *base = (const uint8_t *)chain;
+    fossil_sys_memory_copy(raw, base, FISH_CHAIN_HEAD);
+    fossil_sys_memory_copy(raw + FISH_CHAIN_HEAD, base + FISH_CHAIN_TAIL, sizeof(*chain) - FISH_CHAIN_TAIL);
+    size_t len = run_encode(raw, FISH_CHAIN_FIELDS, record);
+
+    zc_header_t h;
+    fossil_sys_memory_zero(&h, sizeof(h));
+    fossil_sys_memory_copy(h.magic, FISH_ZCHAIN_MAGIC, sizeof(h.magic));
+    h.version = FISH_ZCHAIN_VERSION;
+    h.block_size = (uint32_t)sizeof(zc_block_t);
+    h.keyframe = FISH_ZCHAIN_KEYFRAME;
+    h.count = count;
+    h.chain_len = len;
+    fish_row_writer_put(&out, (const char *)&h, sizeof(h));
+    fish_row_writer_put(&out, (const char *)record, len);
+    uint64_t at = sizeof(h) + len;
+
+    zc_block_t ref;
+    for (size_t i = 0; i < count; i++) {
+        predict(i % FISH_ZCHAIN_KEYFRAME ? &chain->commits[i - 1] : NULL, &ref);
+        xor_bytes(raw, (const uint8_t *)&chain->commits[i], (const uint8_t *)&ref, sizeof(zc_block_t));
+        len = run_encode(raw, sizeof(zc_block_t), record);
+        fish_row_writer_put(&out, (const char *)record, len);
+        offset[i] = at;
+        at += len;
+    }
+
+    fish_row_writer_put(&out, (const char *)offset, count * sizeof(uint64_t));
+    fish_row_writer_put(&out, (const char *)&at, sizeof(at));
+    fish_row_writer_put(&out, FISH_ZCHAIN_MAGIC, 8);
+
+    fossil_sys_memory_free(offset);
+    fossil_sys_memory_free(record);
+    fossil_sys_memory_free(raw);
+    return fish_row_writer_commit(&out);
+}
+
+/* ---------------- reader ---------------- */
+
+int fish_zchain_probe(ccstring path) {
+    fossil_io_file_t file;
+    zc_header_t h;
+    if (fossil_io_file_open(&file, path, "rb") != 0) return 0;
+    int yes = fossil_io_file_read(&file, &h, 1, sizeof(h)) == sizeof(h) &&
+              memcmp(h.magic, FISH_ZCHAIN_MAGIC, sizeof(h.magic)) == 0;
+    fossil_io_file_close(&file);
+    return yes;
+}
+
+static int read_at(fish_zchain_t *z, uint64_t at, void *data, size_t len) {
+    if (fish_fseek64(z->file.file, (long long)at, SEEK_SET) != 0) return -1;
+    return len == 0 || fossil_io_file_read(&z->file, data, 1, len) == len ? 0 : -1;
+}
+
+/* read [at, at + len) into the scratch record */
+static int read_record(fish_zchain_t *z, uint64_t at, uint64_t len) {
+    if (len > RECORD_BOUND(sizeof(zc_block_t) + FISH_CHAIN_FIELDS)) return -1;
+    if (len > z->record_cap) {
+        uint8_t *grown = (uint8_t *)fossil_sys_memory_realloc(z->record, (size_t)len);
+        if (!grown) return -1;
+        z->record = grown;
+        z->record_cap = (size_t)len;
+    }
+    return read_at(z, at, z->record, (size_t)len);
+}
+
+static int zchain_load_dir(fish_zchain_t *z, ccstring path, fossil_ai_jellyfish_chain_t *chain) {
+    zc_header_t h;
+    uint64_t size = fish_file_size(path);
+    if (size < sizeof(h) + ZCHAIN_TRAILER_SIZE || read_at(z, 0, &h, sizeof(h)) != 0) return -1;
+    if (memcmp(h.magic, FISH_ZCHAIN_MAGIC, sizeof(h.magic)) != 0 || h.version != FISH_ZCHAIN_VERSION ||
+        h.block_size != sizeof(zc_block_t) || h.keyframe == 0)
+        return -1;
+
+    uint64_t dir = 0;
+    char magic[8];
+    if (read_at(z, size - ZCHAIN_TRAILER_SIZE, &dir, sizeof(dir)) != 0 ||
+        fossil_io_file_read(&z->file, magic, 1, sizeof(magic)) != sizeof(magic) ||
+        memcmp(magic, FISH_ZCHAIN_MAGIC, sizeof(magic)) != 0)
+        return -1;
+    if (dir < sizeof(h) + h.chain_len || (size - ZCHAIN_TRAILER_SIZE - dir) / sizeof(uint64_t) != h.count)
+        return -1;
+
+    z->count = h.count;
+    z->keyframe = h.keyframe;
+    z->offset = (uint64_t *)fossil_sys_memory_alloc(((size_t)h.count + 1) * sizeof(uint64_t));
+    if (!z->offset || read_at(z, dir, z->offset, (size_t)h.count * sizeof(uint64_t)) != 0) return -1;
+    z->offset[h.count] = dir;
+    for (uint64_t i = 0; i < h.count; i++)
+        if (z->offset[i] > z->offset[i + 1] || z->offset[i] < sizeof(h) + h.chain_len) return -1;
+
+    if (!chain) return 0;
+    uint8_t *raw = (uint8_t *)fossil_sys_memory_alloc(FISH_CHAIN_FIELDS);
+    int rc = raw && read_record(z, sizeof(h), h.chain_len) == 0 &&
+             run_decode(z->record, (size_t)h.chain_len, raw, FISH_CHAIN_FIELDS) == 0 ? 0 : -1;
+    if (rc == 0) {
+        uint8_t *base = (uint8_t *)chain;
+        fossil_sys_memory_copy(base, raw, FISH_CHAIN_HEAD);
+        fossil_sys_memory_copy(base + FISH_CHAIN_TAIL, raw + FISH_CHAIN_HEAD, sizeof(*chain) - FISH_CHAIN_TAIL);
+    }
+    fossil_sys_memory_free(raw);
+    return rc;
+}
+
+int fish_zchain_open(fish_zchain_t *z, ccstring path, fossil_ai_jellyfish_chain_t *chain) {
+    fossil_sys_memory_zero(z, sizeof(*z));
+    z->last_pos = UINT64_MAX;
+    if (fossil_io_file_open(&z->file, path, "rb") != 0) return -1;
+    if (zchain_load_dir(z, path, chain) != 0) {
+        fish_zchain_close(z);
+        return -1;
+    }
+    return 0;
+}
+
+int fish_zchain_read(fish_zchain_t *z, uint64_t pos, fossil_ai_jellyfish_block_t *out) {
+    if (pos >= z->count) return -1;
+
+    /* continue from the last block when it is in the same interval */
+    uint64_t from = pos - pos % z->keyframe;
+    if (z->last_pos != UINT64_MAX && z->last_pos >= from && z->last_pos <= pos) from = z->last_pos + 1;
+    if (z->last_pos == pos) from = pos + 1;
+
+    zc_block_t ref;
+    for (uint64_t i = from; i <= pos; i++) {
+        predict(i % z->keyframe ? &z->last : NULL, &ref);
+        if (read_record(z, z->offset[i], z->offset[i + 1] - z->offset[i]) != 0 ||
+            run_decode(z->record, (size_t)(z->offset[i + 1] - z->offset[i]), (uint8_t *)&z->last, sizeof(zc_block_t)) != 0) {
+            z->last_pos = UINT64_MAX;
+            return -1;
+        }
+        xor_bytes((uint8_t *)&z->last, (const uint8_t *)&z->last, (const uint8_t *)&ref, sizeof(zc_block_t));
+        z->last_pos = i;
+    }
+    *out = z->last;
+    return 0;
+}
+
+void fish_zchain_close(fish_zchain_t *z) {
+    if (fossil_io_file_is_open(&z->file)) fossil_io_file_close(&z->file);
+    fossil_sys_memory_free(z->offset);
+    fossil_sys_memory_free(z->record);
+    fossil_sys_memory_zero(z, sizeof(*z));
+}
+
+static int zchain_load(fossil_ai_jellyfish_chain_t *chain, ccstring path) {
+    fish_zchain_t z;
+    if (fish_zchain_open(&z, path, chain) != 0) return -1;
+    int rc = z.count <= FOSSIL_JELLYFISH_MAX_MEM ? 0 : -1;
+    for (uint64_t i = 0; rc == 0 && i < z.count; i++)
+        rc = fish_zchain_read(&z, i, &chain->commits[i]);
+    if (rc == 0) chain->count = (size_t)z.count;
+    fish_zchain_close(&z);
+    return rc;
+}
+
+int fish_chain_load(fossil_ai_jellyfish_chain_t *chain, ccstring path) {
+    FISH_TRACE_BEGIN(trace);
+    int rc = fish_ref_probe(path) ? fish_ref_load(chain, path)
+           : fish_zchain_probe(path) ? zchain_load(chain, path)
+           : fossil_ai_jellyfish_load(chain, path);
+    FISH_TRACE_END(FISH_STAGE_LOAD, trace, rc == 0 ? chain->count : 0);
+    return rc;
+}
@@ -0,0 +1,231 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/cache.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+#define CACHE_TEST_MODEL "cache_test"
+#define CACHE_TEST_FILE CACHE_TEST_MODEL FISH_CACHE_SUFFIX
+
+static const uint8_t cache_fp[FOSSIL_JELLYFISH_HASH_SIZE] = { 1, 2, 3 };
+static const uint8_t cache_other_fp[FOSSIL_JELLYFISH_HASH_SIZE] = { 9, 9, 9 };
+
+static fish_slice_t prompt_of(const char *s) {
+    fish_slice_t out = { s, strlen(s) };
+    return out;
+}
+
+static int put(fish_cache_t *cache, const char *prompt, const char *answer) {
+    fish_cache_value_t value = { 1, 0.5f, answer, "" };
+    return fish_cache_put(cache, cache_fp, prompt_of(prompt), 0, &value);
+}
+
+// 1 with the answer matching @p answer, 0 on a miss
+static int hit(fish_cache_t *cache, const char *prompt, const char *answer) {
+    fish_cache_value_t value;
+    if (!fish_cache_get(cache, cache_fp, prompt_of(prompt), 0, &value)) return 0;
+    return strcmp(value.answer, answer) == 0;
+}
+
+// The cache's key digest (see cache.c), to pick prompts that share a home slot
+static size_t home_slot(const fish_cache_t *cache, const char *prompt) {
+    uint64_t h = fish_hash64(cache_fp, FOSSIL_JELLYFISH_HASH_SIZE, 0x6a666361ull);
+    return (size_t)fish_hash64(prompt, strlen(prompt), h) & cache->slot_mask;
+}
+
+// Next prompt "p<n>" at or after *n whose home slot is @p slot
+static const char *prompt_at(const fish_cache_t *cache, size_t slot, size_t *n, char *buf, size_t cap) {
+    for (;; (*n)++) {
+        snprintf(buf, cap, "p%zu", *n);
+        if (home_slot(cache, buf) == slot) {
+            (*n)++;
+            return buf;
+        }
+    }
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_cache_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_cache_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_cache_suite) {
+    remove(CACHE_TEST_FILE);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// The answer cache evicts in LRU order, keeps its probe chains
+// intact through deletes, and survives a torn log.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_cache_evicts_least_recent) {
+    fish_cache_t cache;
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_init(&cache, 3));
+    put(&cache, "a", "A");
+    put(&cache, "b", "B");
+    put(&cache, "c", "C");
+
+    // reading "a" makes "b" the oldest
+    ASSUME_ITS_TRUE(hit(&cache, "a", "A"));
+    put(&cache, "d", "D");
+    ASSUME_ITS_TRUE(!hit(&cache, "b", "B"));
+    ASSUME_ITS_EQUAL_I32(3, (int)cache.count);
+
+    // replacing "c" refreshes it, so "a" goes next
+    put(&cache, "c", "C2");
+    put(&cache, "e", "E");
+    ASSUME_ITS_TRUE(!hit(&cache, "a", "A"));
+    ASSUME_ITS_TRUE(hit(&cache, "c", "C2"));
+    ASSUME_ITS_TRUE(hit(&cache, "d", "D"));
+    ASSUME_ITS_TRUE(hit(&cache, "e", "E"));
+    ASSUME_ITS_EQUAL_I32(3, (int)cache.count);
+    fish_cache_free(&cache);
+}
+
+FOSSIL_TEST_CASE(c_test_cache_remove_shifts_collisions) {
+    fish_cache_t cache;
+    char a[16], b[16], c[16], d[16], e[16];
+    size_t n = 0;
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_init(&cache, 4));
+
+    // three prompts share the last slot and wrap around; a fourth
+    // belongs to slot 0, so it sits behind them
+    const size_t last = cache.slot_mask;
+    prompt_at(&cache, last, &n, a, sizeof(a));
+    prompt_at(&cache, last, &n, b, sizeof(b));
+    prompt_at(&cache, last, &n, c, sizeof(c));
+    prompt_at(&cache, 0, &n, d, sizeof(d));
+    prompt_at(&cache, 5, &n, e, sizeof(e));
+    put(&cache, a, "A");
+    put(&cache, b, "B");
+    put(&cache, c, "C");
+    put(&cache, d, "D");
+
+    // evicting "a" empties the head of the cluster; the rest must shift back
+    put(&cache, e, "E");
+    ASSUME_ITS_TRUE(!hit(&cache, a, "A"));
+    ASSUME_ITS_TRUE(hit(&cache, b, "B"));
+    ASSUME_ITS_TRUE(hit(&cache, c, "C"));
+    ASSUME_ITS_TRUE(hit(&cache, d, "D"));
+    ASSUME_ITS_TRUE(hit(&cache, e, "E"));
+
+    // and again from the middle of the cluster, by replacing "c"
+    put(&cache, c, "C2");
+    ASSUME_ITS_TRUE(hit(&cache, b, "B"));
+    ASSUME_ITS_TRUE(hit(&cache, c, "C2"));
+    ASSUME_ITS_TRUE(hit(&cache, d, "D"));
+    ASSUME_ITS_EQUAL_I32(4, (int)cache.count);
+    fish_cache_free(&cache);
+}
+
+FOSSIL_TEST_CASE(c_test_cache_key_mismatch) {
+    fish_cache_t cache;
+    fish_cache_value_t value;
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_init(&cache, 0));
+    put(&cache, "what is fish", "a tool");
+
+    // another model version or the explain flag make a different key
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_get(&cache, cache_other_fp, prompt_of("what is fish"), 0, &value));
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_get(&cache, cache_fp, prompt_of("what is fish"), 1, &value));
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_get(&cache, cache_fp, prompt_of("what is"), 0, &value));
+    ASSUME_ITS_EQUAL_I32(1, fish_cache_get(&cache, cache_fp, prompt_of("what is fish"), 0, &value));
+    fish_cache_free(&cache);
+}
+
+FOSSIL_TEST_CASE(c_test_cache_counts_lookups) {
+    fish_cache_t cache;
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_init(&cache, 0));
+    put(&cache, "known", "yes");
+    uint64_t hits = fish_cache_hits();
+    uint64_t misses = fish_cache_misses();
+
+    // counted with or without tracing, for serve stats and /health
+    ASSUME_ITS_TRUE(hit(&cache, "known", "yes"));
+    ASSUME_ITS_TRUE(hit(&cache, "known", "yes"));
+    ASSUME_ITS_TRUE(!hit(&cache, "unknown", "yes"));
+    ASSUME_ITS_EQUAL_I32(2, (int)(fish_cache_hits() - hits));
+    ASSUME_ITS_EQUAL_I32(1, (int)(fish_cache_misses() - misses));
+    fish_cache_free(&cache);
+}
+
+FOSSIL_TEST_CASE(c_test_cache_load_skips_torn_tail) {
+    const fish_cache_value_t stored = { 1, 0.75f, "answer", "because" };
+    fish_cache_value_t value;
+    fish_cache_t cache;
+    remove(CACHE_TEST_FILE);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_append(CACHE_TEST_MODEL, cache_fp, prompt_of("one"), 0, &stored));
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_append(CACHE_TEST_MODEL, cache_other_fp, prompt_of("stale"), 0, &stored));
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_append(CACHE_TEST_MODEL, cache_fp, prompt_of("two"), 1, &stored));
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_append(CACHE_TEST_MODEL, cache_fp, prompt_of("three"), 0, &stored));
+
+    // cut the last record short, as a crash mid-append would
+    FILE *f = fopen(CACHE_TEST_FILE, "rb");
+    ASSUME_ITS_TRUE(f != NULL);
+    char buf[4096];
+    size_t len = f ? fread(buf, 1, sizeof(buf), f) : 0;
+    if (f) fclose(f);
+    f = fopen(CACHE_TEST_FILE, "wb");
+    if (f) {
+        fwrite(buf, 1, len - 4, f);
+        fclose(f);
+    }
+
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_init(&cache, 0));
+    ASSUME_ITS_EQUAL_I32(2, fish_cache_load(&cache, CACHE_TEST_MODEL, cache_fp));
+    ASSUME_ITS_EQUAL_I32(1, fish_cache_get(&cache, cache_fp, prompt_of("one"), 0, &value));
+    ASSUME_ITS_EQUAL_CSTR("answer", value.answer);
+    ASSUME_ITS_EQUAL_CSTR("because", value.explain);
+    ASSUME_ITS_EQUAL_I32(1, fish_cache_get(&cache, cache_fp, prompt_of("two"), 1, &value));
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_get(&cache, cache_fp, prompt_of("three"), 0, &value));
+    fish_cache_free(&cache);
+
+    // the torn tail was compacted away, so the log loads cleanly again
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_init(&cache, 0));
+    ASSUME_ITS_EQUAL_I32(2, fish_cache_load(&cache, CACHE_TEST_MODEL, cache_fp));
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_append(CACHE_TEST_MODEL, cache_fp, prompt_of("four"), 0, &stored));
+    fish_cache_free(&cache);
+    ASSUME_ITS_EQUAL_I32(0, fish_cache_init(&cache, 0));
+    ASSUME_ITS_EQUAL_I32(3, fish_cache_load(&cache, CACHE_TEST_MODEL, cache_fp));
+    fish_cache_free(&cache);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_cache_tests) {
+    FOSSIL_TEST_ADD(c_cache_suite, c_test_cache_evicts_least_recent);
+    FOSSIL_TEST_ADD(c_cache_suite, c_test_cache_remove_shifts_collisions);
+    FOSSIL_TEST_ADD(c_cache_suite, c_test_cache_key_mismatch);
+    FOSSIL_TEST_ADD(c_cache_suite, c_test_cache_counts_lookups);
+    FOSSIL_TEST_ADD(c_cache_suite, c_test_cache_load_skips_torn_tail);
+
+    FOSSIL_TEST_REGISTER(c_cache_suite);
+}
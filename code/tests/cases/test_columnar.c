@@ -0,0 +1,259 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/columnar.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+#define COLUMNAR_TEST_TEXT "columnar_test.csv"
+#define COLUMNAR_TEST_FCOL "columnar_test.fcol"
+
+static void write_text(const char *path, const char *text) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return;
+    fwrite(text, 1, strlen(text), f);
+    fclose(f);
+}
+
+static int slice_is(fish_slice_t s, const char *want) {
+    return s.len == strlen(want) && memcmp(s.ptr, want, s.len) == 0;
+}
+
+#define COLUMNAR_TEST_ROWS 200
+
+// Header plus rows of every chunk type: ints, floats with nulls, repeated
+// strings (some quoted), zero-padded codes and unique quoted text
+static char *write_typed(void) {
+    static const char *const names[] = { "ada", "bob", "\"a,b\"" };
+    size_t cap = 64 + COLUMNAR_TEST_ROWS * 96, len = 0;
+    char *text = (char *)malloc(cap);
+    if (!text) return NULL;
+    len += (size_t)snprintf(text + len, cap - len, "id,name,score,zip,note\n");
+    for (int i = 0; i < COLUMNAR_TEST_ROWS; i++) {
+        char score[16] = "";
+        if (i % 5) snprintf(score, sizeof(score), "%d.25", i);
+        len += (size_t)snprintf(text + len, cap - len, "%d,%s,%s,0213%d,", i - 50, names[i % 3], score, i % 10);
+        switch (i % 4) {
+            case 0: len += (size_t)snprintf(text + len, cap - len, "\"say \"\"hi\"\" %d\"\n", i); break;
+            case 1: len += (size_t)snprintf(text + len, cap - len, "\"line\nbreak %d\"\n", i); break;
+            case 2: len += (size_t)snprintf(text + len, cap - len, "\"cr\rhere %d\"\n", i); break;
+            default: len += (size_t)snprintf(text + len, cap - len, "plain %d\n", i); break;
+        }
+    }
+    write_text(COLUMNAR_TEST_TEXT, text);
+    return text;
+}
+
+// Bytes a converter showed its watcher, kept in order
+typedef struct {
+    char text[256];
+    size_t len;
+    int calls;
+} watched_t;
+
+static void watch_bytes(void *ctx, const char *data, size_t len) {
+    watched_t *w = (watched_t *)ctx;
+    if (w->len + len <= sizeof(w->text)) memcpy(w->text + w->len, data, len);
+    w->len += len;
+    w->calls++;
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_columnar_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_columnar_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_columnar_suite) {
+    remove(COLUMNAR_TEST_TEXT);
+    remove(COLUMNAR_TEST_FCOL);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// A converted dataset reads back as the rows it came from, and
+// only a real header row names the columns.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_columnar_headerless) {
+    fish_col_reader_t reader;
+    fish_col_rows_t *rows;
+    fish_slice_t row;
+
+    write_text(COLUMNAR_TEST_TEXT, "1,x\n2,y\n3,z\n");
+    ASSUME_ITS_EQUAL_I32(0, fish_col_convert(COLUMNAR_TEST_TEXT, COLUMNAR_TEST_FCOL));
+    ASSUME_ITS_EQUAL_I32(0, fish_col_open(&reader, COLUMNAR_TEST_FCOL));
+    ASSUME_ITS_EQUAL_I32(3, (int)reader.rows);
+    ASSUME_ITS_EQUAL_I32(2, (int)reader.columns);
+    ASSUME_ITS_TRUE(!(reader.flags & FISH_COL_NAMED));
+    if (reader.columns == 2) {
+        ASSUME_ITS_EQUAL_CSTR("column1", reader.names[0]);
+        ASSUME_ITS_EQUAL_CSTR("column2", reader.names[1]);
+    }
+    fish_col_close(&reader);
+
+    // the row view starts at the first data row, not at made-up names
+    rows = fish_col_rows_open(COLUMNAR_TEST_FCOL);
+    ASSUME_ITS_TRUE(rows != NULL);
+    ASSUME_ITS_TRUE(rows && fish_col_rows_next(rows, &row) == 1 && slice_is(row, "1,x"));
+    fish_col_rows_close(rows);
+}
+
+FOSSIL_TEST_CASE(c_test_columnar_rows_quote) {
+    fish_col_rows_t *rows;
+    fish_slice_t row;
+
+    // a bare carriage return is quoted like a comma, quote or newline
+    write_text(COLUMNAR_TEST_TEXT, "id,note\n1,\"a\rb\"\n2,\"x,\"\"y\"\"\"\n3,plain\n");
+    ASSUME_ITS_EQUAL_I32(0, fish_col_convert(COLUMNAR_TEST_TEXT, COLUMNAR_TEST_FCOL));
+    rows = fish_col_rows_open(COLUMNAR_TEST_FCOL);
+    ASSUME_ITS_TRUE(rows != NULL);
+    if (!rows) return;
+    ASSUME_ITS_TRUE(fish_col_rows_next(rows, &row) == 1 && slice_is(row, "id,note"));
+    ASSUME_ITS_TRUE(fish_col_rows_next(rows, &row) == 1 && slice_is(row, "1,\"a\rb\""));
+    ASSUME_ITS_TRUE(fish_col_rows_next(rows, &row) == 1 && slice_is(row, "2,\"x,\"\"y\"\"\""));
+    ASSUME_ITS_TRUE(fish_col_rows_next(rows, &row) == 1 && slice_is(row, "3,plain"));
+    ASSUME_ITS_EQUAL_I32(0, fish_col_rows_next(rows, &row));
+    fish_col_rows_close(rows);
+}
+
+FOSSIL_TEST_CASE(c_test_columnar_convert_watched) {
+    static const char *const sources[] = { "a,b\r\n1,2\r\n3,4", "1,2\n3,4\n" };
+    for (size_t i = 0; i < 2; i++) {
+        watched_t w = {0};
+        size_t len = strlen(sources[i]);
+        write_text(COLUMNAR_TEST_TEXT, sources[i]);
+
+        // every byte once, even though a headerless source is rewound
+        ASSUME_ITS_EQUAL_I32((int)len, (int)fish_col_convert_watched(COLUMNAR_TEST_TEXT, COLUMNAR_TEST_FCOL, watch_bytes, &w));
+        ASSUME_ITS_EQUAL_I32((int)len, (int)w.len);
+        ASSUME_ITS_TRUE(w.calls >= 1 && memcmp(w.text, sources[i], len) == 0);
+    }
+}
+
+FOSSIL_TEST_CASE(c_test_columnar_round_trip) {
+    fish_row_reader_t reader;
+    fish_slice_t row;
+    char *text = write_typed();
+    ASSUME_ITS_TRUE(text != NULL);
+    if (!text) return;
+    ASSUME_ITS_EQUAL_I32(0, fish_col_convert(COLUMNAR_TEST_TEXT, COLUMNAR_TEST_FCOL));
+
+    // the rows read back are the text they came from, byte for byte
+    size_t at = 0, text_len = strlen(text);
+    int same = 1;
+    ASSUME_ITS_EQUAL_I32(0, fish_row_reader_open(&reader, COLUMNAR_TEST_FCOL));
+    while (same && fish_row_reader_next(&reader, &row)) {
+        same = at + row.len < text_len && memcmp(text + at, row.ptr, row.len) == 0 && text[at + row.len] == '\n';
+        at += row.len + 1;
+    }
+    fish_row_reader_close(&reader);
+    ASSUME_ITS_TRUE(same);
+    ASSUME_ITS_EQUAL_I32((int)text_len, (int)at);
+    free(text);
+}
+
+FOSSIL_TEST_CASE(c_test_columnar_projection) {
+    fish_col_reader_t reader;
+    fish_col_chunk_t chunk;
+    char value[64];
+    free(write_typed());
+    ASSUME_ITS_EQUAL_I32(0, fish_col_convert(COLUMNAR_TEST_TEXT, COLUMNAR_TEST_FCOL));
+    ASSUME_ITS_EQUAL_I32(0, fish_col_open(&reader, COLUMNAR_TEST_FCOL));
+    ASSUME_ITS_EQUAL_I32(COLUMNAR_TEST_ROWS, (int)reader.rows);
+    ASSUME_ITS_EQUAL_I32(5, (int)reader.columns);
+    if (reader.columns != 5 || reader.groups == 0) {
+        fish_col_close(&reader);
+        return;
+    }
+
+    // one column decodes on its own, typed, with its zone map
+    ASSUME_ITS_EQUAL_I32(0, fish_col_read(&reader, 0, 2, &chunk));
+    ASSUME_ITS_EQUAL_I32(FISH_COL_F64, chunk.type);
+    ASSUME_ITS_TRUE(!fish_col_present(&chunk, 0) && fish_col_present(&chunk, 1));
+    ASSUME_ITS_TRUE(chunk.f64 && chunk.f64[1] == 1.25);
+    ASSUME_ITS_EQUAL_I32(COLUMNAR_TEST_ROWS / 5, (int)fish_col_info(&reader, 0, 2)->nulls);
+    fish_col_chunk_free(&chunk);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_col_read(&reader, 0, 0, &chunk));
+    ASSUME_ITS_EQUAL_I32(FISH_COL_INT64, chunk.type);
+    ASSUME_ITS_TRUE(fish_col_info(&reader, 0, 0)->min == -50.0);
+    ASSUME_ITS_TRUE(fish_col_info(&reader, 0, 0)->max == COLUMNAR_TEST_ROWS - 51.0);
+    fish_col_chunk_free(&chunk);
+
+    // zero-padded codes are text, not numbers
+    ASSUME_ITS_EQUAL_I32(0, fish_col_read(&reader, 0, 3, &chunk));
+    ASSUME_ITS_TRUE(chunk.type == FISH_COL_DICT || chunk.type == FISH_COL_STRING);
+    fish_col_format(&chunk, 4, value, sizeof(value));
+    ASSUME_ITS_EQUAL_CSTR("02134", value);
+    fish_col_chunk_free(&chunk);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_col_read(&reader, 0, 4, &chunk));
+    fish_col_format(&chunk, 2, value, sizeof(value));
+    ASSUME_ITS_EQUAL_CSTR("cr\rhere 2", value);
+    fish_col_chunk_free(&chunk);
+    fish_col_close(&reader);
+}
+
+FOSSIL_TEST_CASE(c_test_columnar_byte_order) {
+    fish_col_reader_t reader;
+    unsigned char marker[8];
+    write_text(COLUMNAR_TEST_TEXT, "a,b\n1,2\n");
+    ASSUME_ITS_EQUAL_I32(0, fish_col_convert(COLUMNAR_TEST_TEXT, COLUMNAR_TEST_FCOL));
+
+    // what a host of the other byte order would have written
+    FILE *f = fopen(COLUMNAR_TEST_FCOL, "r+b");
+    ASSUME_ITS_TRUE(f != NULL);
+    if (!f) return;
+    fseek(f, 8, SEEK_SET);
+    ASSUME_ITS_EQUAL_I32(8, (int)fread(marker, 1, 8, f));
+    for (int i = 0; i < 4; i++) {
+        unsigned char t = marker[i];
+        marker[i] = marker[7 - i];
+        marker[7 - i] = t;
+    }
+    fseek(f, 8, SEEK_SET);
+    fwrite(marker, 1, 8, f);
+    fclose(f);
+
+    ASSUME_ITS_TRUE(fish_col_probe(COLUMNAR_TEST_FCOL));
+    ASSUME_ITS_EQUAL_I32(-1, fish_col_open(&reader, COLUMNAR_TEST_FCOL));
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_columnar_tests) {
+    FOSSIL_TEST_ADD(c_columnar_suite, c_test_columnar_headerless);
+    FOSSIL_TEST_ADD(c_columnar_suite, c_test_columnar_rows_quote);
+    FOSSIL_TEST_ADD(c_columnar_suite, c_test_columnar_convert_watched);
+    FOSSIL_TEST_ADD(c_columnar_suite, c_test_columnar_round_trip);
+    FOSSIL_TEST_ADD(c_columnar_suite, c_test_columnar_projection);
+    FOSSIL_TEST_ADD(c_columnar_suite, c_test_columnar_byte_order);
+
+    FOSSIL_TEST_REGISTER(c_columnar_suite);
+}
@@ -0,0 +1,221 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/dataset.h"
+#include "fossil/code/schema.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+#define DATASET_TEST_PATH "dataset_test.csv"
+
+static fish_slice_t slice_of(const char *s) {
+    fish_slice_t out = { s, strlen(s) };
+    return out;
+}
+
+static int slice_is(fish_slice_t s, const char *want) {
+    return s.len == strlen(want) && memcmp(s.ptr, want, s.len) == 0;
+}
+
+static void write_text(const char *path, const char *text) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return;
+    fwrite(text, 1, strlen(text), f);
+    fclose(f);
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_dataset_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_dataset_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_dataset_suite) {
+    remove(DATASET_TEST_PATH);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Field splitting, field quoting, number parsing and read
+// errors on the CSV paths every dataset command shares.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_fields_split_quoted_comma) {
+    fish_row_fields_t fields = {0};
+    ASSUME_ITS_EQUAL_I32(3, (int)fish_row_fields_split(&fields, slice_of("a,\"b, c\",d")));
+    ASSUME_ITS_TRUE(slice_is(fields.field[0], "a"));
+    ASSUME_ITS_TRUE(slice_is(fields.field[1], "b, c"));
+    ASSUME_ITS_TRUE(slice_is(fields.field[2], "d"));
+    fish_row_fields_free(&fields);
+}
+
+FOSSIL_TEST_CASE(c_test_fields_split_doubled_quotes) {
+    fish_row_fields_t fields = {0};
+    ASSUME_ITS_EQUAL_I32(3, (int)fish_row_fields_split(&fields, slice_of("\"say \"\"hi\"\"\",,\"\"\"\"")));
+    ASSUME_ITS_TRUE(slice_is(fields.field[0], "say \"hi\""));
+    ASSUME_ITS_TRUE(slice_is(fields.field[1], ""));
+    ASSUME_ITS_TRUE(slice_is(fields.field[2], "\""));
+    fish_row_fields_free(&fields);
+}
+
+FOSSIL_TEST_CASE(c_test_fields_split_quoted_newline) {
+    fish_row_reader_t reader;
+    fish_row_fields_t fields = {0};
+    fish_slice_t row;
+
+    // a CSV reader keeps the quoted newline inside its record
+    write_text(DATASET_TEST_PATH, "x,y\n1,\"two\nlines\"\n3,four\n");
+    ASSUME_ITS_EQUAL_I32(0, fish_row_reader_open_csv(&reader, DATASET_TEST_PATH));
+    ASSUME_ITS_TRUE(fish_row_reader_next(&reader, &row));
+    ASSUME_ITS_TRUE(fish_row_reader_next(&reader, &row));
+    ASSUME_ITS_EQUAL_I32(2, (int)fish_row_fields_split(&fields, row));
+    ASSUME_ITS_TRUE(slice_is(fields.field[1], "two\nlines"));
+    ASSUME_ITS_TRUE(fish_row_reader_next(&reader, &row));
+    ASSUME_ITS_TRUE(slice_is(row, "3,four"));
+    ASSUME_ITS_TRUE(!fish_row_reader_next(&reader, &row));
+    fish_row_reader_close(&reader);
+    fish_row_fields_free(&fields);
+}
+
+FOSSIL_TEST_CASE(c_test_fields_split_unterminated_quote) {
+    // an open quote runs to the end of the row, commas included
+    fish_row_fields_t fields = {0};
+    ASSUME_ITS_EQUAL_I32(2, (int)fish_row_fields_split(&fields, slice_of("a,\"b,c")));
+    ASSUME_ITS_TRUE(slice_is(fields.field[0], "a"));
+    ASSUME_ITS_TRUE(slice_is(fields.field[1], "b,c"));
+    fish_row_fields_free(&fields);
+}
+
+FOSSIL_TEST_CASE(c_test_writer_put_field_round_trip) {
+    static const char *const values[] = {
+        "plain", "with,comma", "with \"quote\"", "two\nlines", "", "ends in\r"
+    };
+    const size_t count = sizeof(values) / sizeof(values[0]);
+    fish_row_writer_t writer;
+    fish_row_reader_t reader;
+    fish_row_fields_t fields = {0};
+    fish_slice_t row;
+
+    ASSUME_ITS_EQUAL_I32(0, fish_row_writer_open_raw(&writer, DATASET_TEST_PATH));
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) ASSUME_ITS_EQUAL_I32(0, fish_row_writer_put(&writer, ",", 1));
+        ASSUME_ITS_EQUAL_I32(0, fish_row_writer_put_field(&writer, slice_of(values[i])));
+    }
+    ASSUME_ITS_EQUAL_I32(0, fish_row_writer_end_row(&writer));
+    ASSUME_ITS_EQUAL_I32(0, fish_row_writer_commit(&writer));
+
+    ASSUME_ITS_EQUAL_I32(0, fish_row_reader_open_csv(&reader, DATASET_TEST_PATH));
+    ASSUME_ITS_TRUE(fish_row_reader_next(&reader, &row));
+    ASSUME_ITS_EQUAL_I32((int)count, (int)fish_row_fields_split(&fields, row));
+    for (size_t i = 0; i < count && i < fields.count; i++)
+        ASSUME_ITS_TRUE(slice_is(fields.field[i], values[i]));
+    ASSUME_ITS_TRUE(!fish_row_reader_next(&reader, &row));
+    fish_row_reader_close(&reader);
+    fish_row_fields_free(&fields);
+}
+
+FOSSIL_TEST_CASE(c_test_slice_to_double) {
+    double v = 0.0;
+    ASSUME_ITS_TRUE(fish_slice_to_double(slice_of("42"), &v) && v == 42.0);
+    ASSUME_ITS_TRUE(fish_slice_to_double(slice_of("  -2.5e3"), &v) && v == -2500.0);
+    ASSUME_ITS_TRUE(fish_slice_to_double(slice_of(".5"), &v) && v == 0.5);
+    ASSUME_ITS_TRUE(fish_slice_to_double(slice_of("3.5kg"), &v) && v == 3.5);
+    ASSUME_ITS_TRUE(fish_slice_to_double(slice_of("1e"), &v) && v == 1.0);
+    ASSUME_ITS_TRUE(!fish_slice_to_double(slice_of(""), &v));
+    ASSUME_ITS_TRUE(!fish_slice_to_double(slice_of("abc"), &v));
+    ASSUME_ITS_TRUE(!fish_slice_to_double(slice_of("-."), &v));
+}
+
+FOSSIL_TEST_CASE(c_test_slice_is_number) {
+    ASSUME_ITS_TRUE(fish_slice_is_number(slice_of("42")));
+    ASSUME_ITS_TRUE(fish_slice_is_number(slice_of("-2.5e3")));
+    ASSUME_ITS_TRUE(fish_slice_is_number(slice_of(".5")));
+    ASSUME_ITS_TRUE(fish_slice_is_number(slice_of("0")));
+    ASSUME_ITS_TRUE(!fish_slice_is_number(slice_of("3.5kg")));
+    ASSUME_ITS_TRUE(!fish_slice_is_number(slice_of("12px")));
+    ASSUME_ITS_TRUE(!fish_slice_is_number(slice_of("2024-01-05")));
+    ASSUME_ITS_TRUE(!fish_slice_is_number(slice_of("1e")));
+    ASSUME_ITS_TRUE(!fish_slice_is_number(slice_of("02134")));
+    ASSUME_ITS_TRUE(!fish_slice_is_number(slice_of(" 7")));
+    ASSUME_ITS_TRUE(!fish_slice_is_number(slice_of("")));
+}
+
+FOSSIL_TEST_CASE(c_test_schema_whole_field_numbers) {
+    fish_schema_t schema;
+    write_text(DATASET_TEST_PATH, "weight,size,day,count\n3.5kg,12px,2024-01-05, 7 \n4,13,2024-01-06,8\n");
+    fish_schema_init(&schema, 0);
+    ASSUME_ITS_EQUAL_I32(0, fish_schema_infer(&schema, DATASET_TEST_PATH));
+    ASSUME_ITS_EQUAL_I32(4, (int)schema.columns);
+    if (schema.columns == 4) {
+        // a numeric prefix is not enough; surrounding whitespace is fine
+        ASSUME_ITS_EQUAL_I32(FISH_SCHEMA_TEXT, schema.col[0].type);
+        ASSUME_ITS_EQUAL_I32(FISH_SCHEMA_TEXT, schema.col[1].type);
+        ASSUME_ITS_EQUAL_I32(FISH_SCHEMA_TEXT, schema.col[2].type);
+        ASSUME_ITS_EQUAL_I32(FISH_SCHEMA_INT, schema.col[3].type);
+        ASSUME_ITS_EQUAL_I32(1, (int)schema.col[0].numeric);
+    }
+    fish_schema_free(&schema);
+}
+
+FOSSIL_TEST_CASE(c_test_reader_error_is_sticky) {
+    fish_row_reader_t reader;
+    fish_slice_t row;
+    // a directory opens as a stream on POSIX but every read of it fails
+    if (fish_row_reader_open(&reader, ".") == 0) {
+        ASSUME_ITS_EQUAL_I32(0, fish_row_reader_next(&reader, &row));
+        ASSUME_ITS_EQUAL_I32(1, reader.failed);
+        ASSUME_ITS_EQUAL_I32(-1, fish_row_reader_rewind(&reader));
+        ASSUME_ITS_EQUAL_I32(0, fish_row_reader_next(&reader, &row));
+        ASSUME_ITS_EQUAL_I32(1, reader.failed);
+        fish_row_reader_close(&reader);
+    }
+
+    // a clean end of file is not a failure
+    write_text(DATASET_TEST_PATH, "a,1\nb,2");
+    ASSUME_ITS_EQUAL_I32(0, fish_row_reader_open(&reader, DATASET_TEST_PATH));
+    while (fish_row_reader_next(&reader, &row)) {}
+    ASSUME_ITS_EQUAL_I32(2, (int)reader.rows);
+    ASSUME_ITS_EQUAL_I32(0, reader.failed);
+    fish_row_reader_close(&reader);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_dataset_tests) {
+    FOSSIL_TEST_ADD(c_dataset_suite, c_test_fields_split_quoted_comma);
+    FOSSIL_TEST_ADD(c_dataset_suite, c_test_fields_split_doubled_quotes);
+    FOSSIL_TEST_ADD(c_dataset_suite, c_test_fields_split_quoted_newline);
+    FOSSIL_TEST_ADD(c_dataset_suite, c_test_fields_split_unterminated_quote);
+    FOSSIL_TEST_ADD(c_dataset_suite, c_test_writer_put_field_round_trip);
+    FOSSIL_TEST_ADD(c_dataset_suite, c_test_slice_to_double);
+    FOSSIL_TEST_ADD(c_dataset_suite, c_test_slice_is_number);
+    FOSSIL_TEST_ADD(c_dataset_suite, c_test_schema_whole_field_numbers);
+    FOSSIL_TEST_ADD(c_dataset_suite, c_test_reader_error_is_sticky);
+
+    FOSSIL_TEST_REGISTER(c_dataset_suite);
+}
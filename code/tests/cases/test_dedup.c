@@ -0,0 +1,131 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/dedup.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+#define DEDUP_TEST_PATH "dedup_test.csv"
+#define DEDUP_TEST_DISTINCT 6000
+#define DEDUP_TEST_BUDGET 2048
+
+// Survivors joined by newlines
+typedef struct {
+    char *text;
+    size_t len;
+    size_t cap;
+    size_t rows;
+} dedup_out_t;
+
+static int collect(void *ctx, fish_slice_t row) {
+    dedup_out_t *out = (dedup_out_t *)ctx;
+    if (out->len + row.len + 1 > out->cap) {
+        size_t cap = out->cap ? out->cap * 2 : 4096;
+        while (cap < out->len + row.len + 1) cap *= 2;
+        char *grown = (char *)realloc(out->text, cap);
+        if (!grown) return -1;
+        out->text = grown;
+        out->cap = cap;
+    }
+    memcpy(out->text + out->len, row.ptr, row.len);
+    out->len += row.len;
+    out->text[out->len++] = '\n';
+    out->rows++;
+    return 0;
+}
+
+// Distinct rows interleaved with thousands of copies of one row, so a
+// single partition swells far past the budget
+static void write_skewed(void) {
+    FILE *f = fopen(DEDUP_TEST_PATH, "wb");
+    if (!f) return;
+    for (int i = 0; i < DEDUP_TEST_DISTINCT; i++) {
+        fprintf(f, "row %d,%d\n", i, i * 7);
+        fprintf(f, "same,row\n");
+        if (i % 3 == 0) fprintf(f, "row %d,%d\n", i / 2, (i / 2) * 7);
+    }
+    fclose(f);
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_dedup_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_dedup_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_dedup_suite) {
+    remove(DEDUP_TEST_PATH);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// External mode must keep the first copy of every row, in the
+// original order, however skewed the partitions get.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_dedup_external_small_budget) {
+    dedup_out_t memory = {0}, external = {0};
+    write_skewed();
+
+    ASSUME_ITS_EQUAL_I32(0, fish_dedup_run(DEDUP_TEST_PATH, 0, FISH_DEDUP_MEMORY, 0, collect, &memory));
+    ASSUME_ITS_EQUAL_I32(DEDUP_TEST_DISTINCT + 1, (int)memory.rows);
+
+    // a tiny budget sends AUTO external and forces partitions to split again
+    ASSUME_ITS_EQUAL_I32(0, fish_dedup_run(DEDUP_TEST_PATH, 0, FISH_DEDUP_AUTO, DEDUP_TEST_BUDGET, collect, &external));
+    ASSUME_ITS_EQUAL_I32((int)memory.rows, (int)external.rows);
+    ASSUME_ITS_TRUE(memory.len == external.len && memcmp(memory.text, external.text, memory.len) == 0);
+
+    // partition files are gone afterwards
+    ASSUME_ITS_TRUE(!fossil_io_file_file_exists(DEDUP_TEST_PATH ".dedup.0"));
+    ASSUME_ITS_TRUE(!fossil_io_file_file_exists(DEDUP_TEST_PATH ".dedup.0.out"));
+    ASSUME_ITS_TRUE(!fossil_io_file_file_exists(DEDUP_TEST_PATH ".dedup.0.dedup.0"));
+    free(memory.text);
+    free(external.text);
+}
+
+FOSSIL_TEST_CASE(c_test_dedup_drop_null) {
+    dedup_out_t out = {0};
+    FILE *f = fopen(DEDUP_TEST_PATH, "wb");
+    if (f) {
+        fputs("a,1\n  \n\"x\ny\",2\na,1\n\n  a,1  \n\"x\ny\",2\n", f);
+        fclose(f);
+    }
+    ASSUME_ITS_EQUAL_I32(0, fish_dedup_run(DEDUP_TEST_PATH, 1, FISH_DEDUP_EXTERNAL, 0, collect, &out));
+    ASSUME_ITS_EQUAL_I32(2, (int)out.rows);
+    ASSUME_ITS_TRUE(out.text && out.len == 12 && memcmp(out.text, "a,1\n\"x\ny\",2\n", 12) == 0);
+    free(out.text);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_dedup_tests) {
+    FOSSIL_TEST_ADD(c_dedup_suite, c_test_dedup_external_small_budget);
+    FOSSIL_TEST_ADD(c_dedup_suite, c_test_dedup_drop_null);
+
+    FOSSIL_TEST_REGISTER(c_dedup_suite);
+}
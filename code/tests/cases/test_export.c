@@ -0,0 +1,151 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/meta.h"
+#include "fossil/code/workspace.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+#define EXPORT_TEST_VARINTS "export_test.varint"
+#define EXPORT_TEST_FSON "export_test.fson"
+#define EXPORT_TEST_IMPORTED "datasets/export_test.dataset"
+
+static void write_text(const char *path, const char *text) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return;
+    fwrite(text, 1, strlen(text), f);
+    fclose(f);
+}
+
+// Whole file into a NUL-terminated buffer; *len gets its size
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = (char *)malloc((size_t)size + 1);
+    if (data && fread(data, 1, (size_t)size, f) != (size_t)size) size = 0;
+    if (data) data[size] = '\0';
+    if (len) *len = (size_t)size;
+    fclose(f);
+    return data;
+}
+
+// Rows of 127 and 128 bytes take one- and two-byte length prefixes
+static const char *export_dataset(void) {
+    static char text[1024];
+    char wide[129];
+    size_t len = (size_t)snprintf(text, sizeof(text), "input,output\nhello,world\n\"a, b\",\"say \"\"hi\"\"\"\n");
+    for (size_t width = 127; width <= 128; width++) {
+        memset(wide, 'x', width);
+        wide[width] = '\0';
+        len += (size_t)snprintf(text + len, sizeof(text) - len, "%s\n", wide);
+    }
+    snprintf(text + len, sizeof(text) - len, ",\n");
+    return text;
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_export_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_export_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_export_suite) {
+    remove(EXPORT_TEST_VARINTS);
+    remove(EXPORT_TEST_FSON);
+    remove(EXPORT_TEST_IMPORTED);
+    remove(FISH_DATASET_PATH);
+    fish_meta_invalidate(FISH_DATASET_PATH);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// FSON rows are LEB128 length-prefixed; an export read back by
+// import must give the dataset it started from.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_varint_encoding) {
+    static const uint64_t values[] = { 0, 127, 128, (uint64_t)1 << 63 };
+    static const size_t widths[] = { 1, 1, 2, 10 };
+    const size_t count = sizeof(values) / sizeof(values[0]);
+    fish_row_writer_t writer;
+    size_t len = 0, pos = 0;
+
+    ASSUME_ITS_EQUAL_I32(0, fish_row_writer_open_raw(&writer, EXPORT_TEST_VARINTS));
+    for (size_t i = 0; i < count; i++)
+        ASSUME_ITS_EQUAL_I32(0, fish_row_writer_put_varint(&writer, values[i]));
+    ASSUME_ITS_EQUAL_I32(0, fish_row_writer_commit(&writer));
+
+    char *data = read_file(EXPORT_TEST_VARINTS, &len);
+    ASSUME_ITS_TRUE(data != NULL);
+    ASSUME_ITS_EQUAL_I32(14, (int)len);
+    ASSUME_ITS_TRUE(data && (uint8_t)data[0] == 0x00 && (uint8_t)data[1] == 0x7f);
+    ASSUME_ITS_TRUE(data && (uint8_t)data[2] == 0x80 && (uint8_t)data[3] == 0x01);
+    for (size_t i = 0; data && i < count; i++) {
+        uint64_t value = 0;
+        ASSUME_ITS_EQUAL_I32((int)widths[i], (int)fish_varint_read(data + pos, len - pos, &value));
+        ASSUME_ITS_TRUE(value == values[i]);
+        pos += widths[i];
+    }
+
+    // cut short, and longer than FISH_VARINT_MAX bytes
+    uint64_t value = 0;
+    static const char endless[FISH_VARINT_MAX + 1] = {
+        '\x80', '\x80', '\x80', '\x80', '\x80', '\x80', '\x80', '\x80', '\x80', '\x80', '\x01'
+    };
+    ASSUME_ITS_EQUAL_I32(0, (int)fish_varint_read(data ? data + 2 : "", 1, &value));
+    ASSUME_ITS_EQUAL_I32(0, (int)fish_varint_read(endless, sizeof(endless), &value));
+    free(data);
+}
+
+FOSSIL_TEST_CASE(c_test_fson_export_import_round_trip) {
+    const char *text = export_dataset();
+    MKDIR(FISH_DATASET_DIR);
+    remove(EXPORT_TEST_IMPORTED);
+    fish_meta_invalidate(FISH_DATASET_PATH);
+    write_text(FISH_DATASET_PATH, text);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_dataset_export(EXPORT_TEST_FSON, "fson"));
+    ASSUME_ITS_EQUAL_I32(0, fish_dataset_import(EXPORT_TEST_FSON, "fson"));
+
+    char *imported = read_file(EXPORT_TEST_IMPORTED, NULL);
+    ASSUME_ITS_TRUE(imported != NULL);
+    if (imported) ASSUME_ITS_EQUAL_CSTR(text, imported);
+    free(imported);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_export_tests) {
+    FOSSIL_TEST_ADD(c_export_suite, c_test_varint_encoding);
+    FOSSIL_TEST_ADD(c_export_suite, c_test_fson_export_import_round_trip);
+
+    FOSSIL_TEST_REGISTER(c_export_suite);
+}
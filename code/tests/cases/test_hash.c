@@ -0,0 +1,162 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/hash.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+static const char *const hash_fox = "The quick brown fox jumps over the lazy dog";
+
+// Lowercase hex of a SHA-256 digest
+static void sha256_hex(const uint8_t digest[FISH_SHA256_SIZE], char out[2 * FISH_SHA256_SIZE + 1]) {
+    for (size_t i = 0; i < FISH_SHA256_SIZE; i++) snprintf(out + 2 * i, 3, "%02x", digest[i]);
+}
+
+static void sha256_once(const void *data, size_t len, char out[2 * FISH_SHA256_SIZE + 1]) {
+    fish_sha256_t sha;
+    uint8_t digest[FISH_SHA256_SIZE];
+    fish_sha256_init(&sha);
+    fish_sha256_update(&sha, data, len);
+    fish_sha256_final(&sha, digest);
+    sha256_hex(digest, out);
+}
+
+// Hashset keys live in this table; a reference is the key's index
+static const char *const hash_keys[] = { "alpha", "beta", "gamma", "delta" };
+
+static int resolve_key(void *ctx, uint64_t ref, size_t len, fish_slice_t *out) {
+    const char *const *keys = (const char *const *)ctx;
+    out->ptr = keys[ref];
+    out->len = len;
+    return 0;
+}
+
+static fish_slice_t key_slice(size_t i) {
+    fish_slice_t s = { hash_keys[i], strlen(hash_keys[i]) };
+    return s;
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_hash_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_hash_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_hash_suite) {
+    // Teardown code here
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Digests are checked against published vectors, and the set
+// against keys whose digests collide on purpose.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_hash64_known_answers) {
+    ASSUME_ITS_TRUE(fish_hash64("", 0, 0) == 0xEF46DB3751D8E999ull);
+    ASSUME_ITS_TRUE(fish_hash64("a", 1, 0) == 0xD24EC4F1A98C6E5Bull);
+    ASSUME_ITS_TRUE(fish_hash64("abc", 3, 0) == 0x44BC2CF5AD770999ull);
+    // 43 bytes: one 32-byte stripe, then an 8-byte and three 1-byte tail steps
+    ASSUME_ITS_TRUE(fish_hash64(hash_fox, strlen(hash_fox), 0) == 0x0B242D361FDA71BCull);
+    ASSUME_ITS_TRUE(fish_hash64(hash_fox, strlen(hash_fox), 0x66697368ull) == 0x92C8EC2C982876F2ull);
+}
+
+FOSSIL_TEST_CASE(c_test_sha256_known_answers) {
+    char hex[2 * FISH_SHA256_SIZE + 1];
+    sha256_once("", 0, hex);
+    ASSUME_ITS_EQUAL_CSTR("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", hex);
+    sha256_once("abc", 3, hex);
+    ASSUME_ITS_EQUAL_CSTR("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", hex);
+    // 56 bytes: the length no longer fits the first padding block
+    const char *two = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    sha256_once(two, strlen(two), hex);
+    ASSUME_ITS_EQUAL_CSTR("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", hex);
+}
+
+FOSSIL_TEST_CASE(c_test_sha256_streaming) {
+    // one million 'a' in uneven pieces, crossing block boundaries every way
+    static const size_t pieces[] = { 1, 63, 64, 65, 127, 1000, 4096 };
+    char chunk[4096];
+    char hex[2 * FISH_SHA256_SIZE + 1];
+    uint8_t digest[FISH_SHA256_SIZE];
+    fish_sha256_t sha;
+    size_t left = 1000000;
+
+    memset(chunk, 'a', sizeof(chunk));
+    fish_sha256_init(&sha);
+    for (size_t i = 0; left > 0; i++) {
+        size_t n = pieces[i % (sizeof(pieces) / sizeof(pieces[0]))];
+        if (n > left) n = left;
+        fish_sha256_update(&sha, chunk, n);
+        left -= n;
+    }
+    fish_sha256_final(&sha, digest);
+    sha256_hex(digest, hex);
+    ASSUME_ITS_EQUAL_CSTR("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", hex);
+}
+
+FOSSIL_TEST_CASE(c_test_hashset_colliding_digests) {
+    fish_hashset_t set;
+    uint64_t ref = 0;
+
+    // every key gets the same digest, so only the byte compare tells them apart
+    ASSUME_ITS_EQUAL_I32(0, fish_hashset_init(&set, 2, resolve_key, (void *)hash_keys));
+    for (size_t i = 0; i < 3; i++)
+        ASSUME_ITS_EQUAL_I32(1, fish_hashset_insert(&set, 42, key_slice(i), i));
+    ASSUME_ITS_EQUAL_I32(0, fish_hashset_insert(&set, 42, key_slice(1), 1));
+    ASSUME_ITS_EQUAL_I32(3, (int)set.count);
+
+    for (size_t i = 0; i < 3; i++) {
+        ASSUME_ITS_EQUAL_I32(1, fish_hashset_lookup(&set, 42, key_slice(i), &ref));
+        ASSUME_ITS_EQUAL_I32((int)i, (int)ref);
+    }
+    ASSUME_ITS_EQUAL_I32(0, fish_hashset_lookup(&set, 42, key_slice(3), NULL));
+
+    // a digest of 0 marks empty slots, but still has to work as a key
+    ASSUME_ITS_EQUAL_I32(1, fish_hashset_insert(&set, 0, key_slice(3), 3));
+    ASSUME_ITS_EQUAL_I32(1, fish_hashset_lookup(&set, 0, key_slice(3), &ref));
+    ASSUME_ITS_EQUAL_I32(3, (int)ref);
+
+    fish_hashset_clear(&set);
+    ASSUME_ITS_EQUAL_I32(0, (int)set.count);
+    for (size_t i = 0; i < 4; i++)
+        ASSUME_ITS_EQUAL_I32(0, fish_hashset_lookup(&set, i < 3 ? 42 : 0, key_slice(i), NULL));
+    ASSUME_ITS_EQUAL_I32(1, fish_hashset_insert(&set, 42, key_slice(2), 2));
+    fish_hashset_free(&set);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_hash_tests) {
+    FOSSIL_TEST_ADD(c_hash_suite, c_test_hash64_known_answers);
+    FOSSIL_TEST_ADD(c_hash_suite, c_test_sha256_known_answers);
+    FOSSIL_TEST_ADD(c_hash_suite, c_test_sha256_streaming);
+    FOSSIL_TEST_ADD(c_hash_suite, c_test_hashset_colliding_digests);
+
+    FOSSIL_TEST_REGISTER(c_hash_suite);
+}
@@ -0,0 +1,147 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/learn.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+static fossil_ai_jellyfish_chain_t *new_chain(void) {
+    fossil_ai_jellyfish_chain_t *chain = (fossil_ai_jellyfish_chain_t *)calloc(1, sizeof(*chain));
+    if (chain) fossil_ai_jellyfish_init(chain);
+    return chain;
+}
+
+static void free_chain(fossil_ai_jellyfish_chain_t *chain) {
+    if (!chain) return;
+    fossil_ai_jellyfish_cleanup(chain);
+    free(chain);
+}
+
+// Hands out "pair <n>" until @p left runs out
+typedef struct {
+    size_t left;
+    size_t served;
+} pair_source_t;
+
+static int next_pair(void *ctx, char *input, size_t input_cap, char *output, size_t output_cap) {
+    pair_source_t *src = (pair_source_t *)ctx;
+    if (src->left == 0) return 0;
+    src->left--;
+    snprintf(input, input_cap, "pair %zu", src->served);
+    snprintf(output, output_cap, "out %zu", src->served);
+    src->served++;
+    return 1;
+}
+
+// The fields fish_chain_learn_bulk documents, timestamp aside
+static void check_same_commit(const fossil_ai_jellyfish_block_t *want, const fossil_ai_jellyfish_block_t *got) {
+    ASSUME_ITS_EQUAL_CSTR(want->input, got->input);
+    ASSUME_ITS_EQUAL_CSTR(want->output, got->output);
+    ASSUME_ITS_TRUE(memcmp(want->identity.commit_hash, got->identity.commit_hash, FOSSIL_JELLYFISH_HASH_SIZE) == 0);
+    ASSUME_ITS_EQUAL_I32((int)want->identity.commit_index, (int)got->identity.commit_index);
+    ASSUME_ITS_EQUAL_I32((int)want->identity.parent_count, (int)got->identity.parent_count);
+    ASSUME_ITS_TRUE(memcmp(want->identity.parent_hashes[0], got->identity.parent_hashes[0], FOSSIL_JELLYFISH_HASH_SIZE) == 0);
+    ASSUME_ITS_EQUAL_I32((int)want->block_type, (int)got->block_type);
+    ASSUME_ITS_EQUAL_I32((int)want->attributes.valid, (int)got->attributes.valid);
+    ASSUME_ITS_TRUE(want->attributes.confidence == got->attributes.confidence);
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_learn_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_learn_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_learn_suite) {
+    // Teardown code here
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Bulk learning must leave the chain as the library's own
+// learn call would, and never lose a pair without saying so.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_learn_bulk_matches_library) {
+    fossil_ai_jellyfish_chain_t *lib = new_chain();
+    fossil_ai_jellyfish_chain_t *bulk = new_chain();
+    fish_pair_t pairs[] = { { "hello", "world" }, { "fish", "swims" } };
+    ASSUME_ITS_TRUE(lib != NULL && bulk != NULL);
+
+    // the second commit also covers the parent link
+    fossil_ai_jellyfish_learn(lib, pairs[0].input, pairs[0].output);
+    fossil_ai_jellyfish_learn(lib, pairs[1].input, pairs[1].output);
+    ASSUME_ITS_EQUAL_I32(2, (int)fish_chain_learn_bulk(bulk, pairs, 2));
+    ASSUME_ITS_EQUAL_I32((int)lib->count, (int)bulk->count);
+    check_same_commit(&lib->commits[0], &bulk->commits[0]);
+    check_same_commit(&lib->commits[1], &bulk->commits[1]);
+
+    free_chain(lib);
+    free_chain(bulk);
+}
+
+FOSSIL_TEST_CASE(c_test_learn_iter_reports_dropped) {
+    fossil_ai_jellyfish_chain_t *chain = new_chain();
+    pair_source_t src = { 5, 0 };
+    size_t learned = 0, dropped = 0;
+    ASSUME_ITS_TRUE(chain != NULL);
+
+    // two free slots: the pair that finds the chain full is counted too
+    chain->count = FOSSIL_JELLYFISH_MAX_MEM - 2;
+    ASSUME_ITS_EQUAL_I32(1, fish_chain_learn_iter(chain, next_pair, &src, &learned, &dropped));
+    ASSUME_ITS_EQUAL_I32(2, (int)learned);
+    ASSUME_ITS_EQUAL_I32(3, (int)dropped);
+    ASSUME_ITS_EQUAL_I32(5, (int)src.served);
+    ASSUME_ITS_EQUAL_CSTR("pair 1", chain->commits[FOSSIL_JELLYFISH_MAX_MEM - 1].input);
+
+    free_chain(chain);
+}
+
+FOSSIL_TEST_CASE(c_test_learn_iter_fits) {
+    fossil_ai_jellyfish_chain_t *chain = new_chain();
+    pair_source_t src = { 3, 0 };
+    size_t learned = 0, dropped = 7;
+    ASSUME_ITS_TRUE(chain != NULL);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_chain_learn_iter(chain, next_pair, &src, &learned, &dropped));
+    ASSUME_ITS_EQUAL_I32(3, (int)learned);
+    ASSUME_ITS_EQUAL_I32(0, (int)dropped);
+    ASSUME_ITS_EQUAL_I32(3, (int)chain->count);
+
+    free_chain(chain);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_learn_tests) {
+    FOSSIL_TEST_ADD(c_learn_suite, c_test_learn_bulk_matches_library);
+    FOSSIL_TEST_ADD(c_learn_suite, c_test_learn_iter_reports_dropped);
+    FOSSIL_TEST_ADD(c_learn_suite, c_test_learn_iter_fits);
+
+    FOSSIL_TEST_REGISTER(c_learn_suite);
+}
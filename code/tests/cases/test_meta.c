@@ -0,0 +1,160 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/meta.h"
+#include "fossil/code/workspace.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+static void write_text(const char *path, const char *text) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return;
+    fwrite(text, 1, strlen(text), f);
+    fclose(f);
+}
+
+static void write_dataset(const char *text) {
+    MKDIR(FISH_DATASET_DIR);
+    fish_meta_invalidate(FISH_DATASET_PATH);
+    write_text(FISH_DATASET_PATH, text);
+}
+
+// Rows "<i>,<i * 3>" from @p first up to @p bytes or more, appended to the dataset
+static int append_rows(int first, uint64_t bytes) {
+    FILE *f = fopen(FISH_DATASET_PATH, "ab");
+    int i = first;
+    if (!f) return first;
+    for (uint64_t written = 0; written < bytes; i++)
+        written += (uint64_t)fprintf(f, "%d,%d\n", i, i * 3);
+    fclose(f);
+    return i;
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_meta_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_meta_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_meta_suite) {
+    remove(FISH_DATASET_PATH);
+    fish_meta_invalidate(FISH_DATASET_PATH);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Row counts and cached stats follow the header decision, and
+// an append refreshes them without losing the cached prefix.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_meta_counts_header) {
+    fish_meta_t meta;
+    write_dataset("name,score\nada,1\n\"b, c\",2\n");
+    ASSUME_ITS_TRUE(fish_meta_sync(&meta, FISH_DATASET_PATH) >= 0);
+    ASSUME_ITS_EQUAL_I32(1, meta.has_header);
+    ASSUME_ITS_EQUAL_I32(2, (int)meta.rows);
+    ASSUME_ITS_EQUAL_CSTR("name,score", meta.header);
+    fish_meta_free(&meta);
+}
+
+FOSSIL_TEST_CASE(c_test_meta_headerless) {
+    fish_meta_t meta;
+    write_dataset("1,2\n3,4\n5,6");
+    ASSUME_ITS_TRUE(fish_meta_sync(&meta, FISH_DATASET_PATH) >= 0);
+    ASSUME_ITS_EQUAL_I32(0, meta.has_header);
+    ASSUME_ITS_EQUAL_I32(3, (int)meta.rows);
+    fish_meta_free(&meta);
+
+    // the decision is kept in the sidecar
+    ASSUME_ITS_EQUAL_I32(FISH_META_UNCHANGED, fish_meta_sync(&meta, FISH_DATASET_PATH));
+    ASSUME_ITS_EQUAL_I32(0, meta.has_header);
+    ASSUME_ITS_EQUAL_I32(3, (int)meta.rows);
+    fish_meta_free(&meta);
+}
+
+FOSSIL_TEST_CASE(c_test_stats_headerless) {
+    fish_meta_t meta;
+    const char *const datasets[] = { "x,y\n1,10\n2,20\n3,30\n", "1,10\n2,20\n3,30\n" };
+    for (int header = 1; header >= 0; header--) {
+        write_dataset(datasets[header ? 0 : 1]);
+        ASSUME_ITS_EQUAL_I32(0, fish_dataset_stats(1, NULL, 1));
+        ASSUME_ITS_TRUE(fish_meta_sync(&meta, FISH_DATASET_PATH) >= 0);
+        ASSUME_ITS_EQUAL_I32(1, meta.has_stats);
+        ASSUME_ITS_EQUAL_I32(3, (int)meta.stats_rows);
+        ASSUME_ITS_EQUAL_I32(2, (int)meta.columns);
+        if (meta.has_stats && meta.columns == 2) {
+            // the first data row is counted whether or not a header precedes it
+            ASSUME_ITS_EQUAL_I32(3, (int)meta.stats[0].present);
+            ASSUME_ITS_TRUE(meta.stats[0].moments.min == 1.0);
+            ASSUME_ITS_TRUE(meta.stats[1].moments.max == 30.0);
+        }
+        fish_meta_free(&meta);
+    }
+}
+
+FOSSIL_TEST_CASE(c_test_meta_append_updates_root) {
+    fish_meta_t meta, fresh;
+    write_dataset("key,value\n");
+    int rows = append_rows(0, (uint64_t)FISH_META_BLOCK_SIZE * 2 + FISH_META_BLOCK_SIZE / 2);
+    ASSUME_ITS_TRUE(fish_meta_sync(&meta, FISH_DATASET_PATH) >= 0);
+    ASSUME_ITS_EQUAL_I32(rows, (int)meta.rows);
+    uint64_t root = meta.root;
+    size_t blocks = meta.blocks;
+    fish_meta_free(&meta);
+
+    // grow past the old final block into a new one
+    rows = append_rows(rows, FISH_META_BLOCK_SIZE);
+    ASSUME_ITS_EQUAL_I32(FISH_META_APPENDED, fish_meta_sync(&meta, FISH_DATASET_PATH));
+    ASSUME_ITS_EQUAL_I32(rows, (int)meta.rows);
+    ASSUME_ITS_TRUE(meta.blocks > blocks);
+    ASSUME_ITS_TRUE(meta.root != root);
+
+    // the same leaves, counts and root as a scan from scratch
+    fish_meta_invalidate(FISH_DATASET_PATH);
+    ASSUME_ITS_EQUAL_I32(FISH_META_REBUILT, fish_meta_sync(&fresh, FISH_DATASET_PATH));
+    ASSUME_ITS_EQUAL_I32((int)fresh.rows, (int)meta.rows);
+    ASSUME_ITS_TRUE(fresh.root == meta.root);
+    ASSUME_ITS_EQUAL_I32((int)fresh.blocks, (int)meta.blocks);
+    for (size_t i = 0; i < meta.blocks && i < fresh.blocks; i++) {
+        ASSUME_ITS_TRUE(fresh.block[i].digest == meta.block[i].digest);
+        ASSUME_ITS_TRUE(fresh.block[i].records == meta.block[i].records);
+    }
+    fish_meta_free(&fresh);
+    fish_meta_free(&meta);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_meta_tests) {
+    FOSSIL_TEST_ADD(c_meta_suite, c_test_meta_counts_header);
+    FOSSIL_TEST_ADD(c_meta_suite, c_test_meta_headerless);
+    FOSSIL_TEST_ADD(c_meta_suite, c_test_stats_headerless);
+    FOSSIL_TEST_ADD(c_meta_suite, c_test_meta_append_updates_root);
+
+    FOSSIL_TEST_REGISTER(c_meta_suite);
+}
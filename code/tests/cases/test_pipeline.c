@@ -0,0 +1,156 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/cli.h"
+#include "fossil/code/meta.h"
+#include "fossil/code/workspace.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+// Files a dataset command may write, compared between the two runs
+static const char *const pipeline_outputs[] = {
+    FISH_DATASET_PATH,
+    "datasets/train.dataset",
+    "datasets/val.dataset",
+    "datasets/test.dataset"
+};
+#define PIPELINE_OUTPUTS (sizeof(pipeline_outputs) / sizeof(pipeline_outputs[0]))
+
+// Header plus 40 rows, a quarter of them repeats
+static const char *pipeline_dataset(void) {
+    static char text[4096];
+    size_t len = (size_t)snprintf(text, sizeof(text), "x,y,label\n");
+    for (int i = 0; i < 40; i++) {
+        int v = i % 4 == 3 ? i - 1 : i;
+        len += (size_t)snprintf(text + len, sizeof(text) - len, "%d,%d.5,\"row %d, quoted\"\n", v, v * 3, v);
+    }
+    return text;
+}
+
+static void write_text(const char *path, const char *text) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return;
+    fwrite(text, 1, strlen(text), f);
+    fclose(f);
+}
+
+static char *read_text(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = (char *)malloc((size_t)size + 1);
+    if (text && fread(text, 1, (size_t)size, f) != (size_t)size) size = 0;
+    if (text) text[size] = '\0';
+    fclose(f);
+    return text;
+}
+
+static void reset_workspace(void) {
+    MKDIR(FISH_DATASET_DIR);
+    for (size_t i = 0; i < PIPELINE_OUTPUTS; i++) remove(pipeline_outputs[i]);
+    fish_meta_invalidate(FISH_DATASET_PATH);
+    write_text(FISH_DATASET_PATH, pipeline_dataset());
+}
+
+static int dispatch(int argc, const char **argv) {
+    char *args[16];
+    for (int i = 0; i < argc; i++) args[i] = (char *)argv[i];
+    return fish_cli_dispatch(argc, args);
+}
+
+static void snapshot(char **out) {
+    for (size_t i = 0; i < PIPELINE_OUTPUTS; i++) out[i] = read_text(pipeline_outputs[i]);
+}
+
+// Run @p first then @p second one after another, then as one `run`, and compare every output
+static void check_pipeline(const char **first, int first_argc, const char **second, int second_argc) {
+    char *sequential[PIPELINE_OUTPUTS], *piped[PIPELINE_OUTPUTS];
+    const char *run[16] = { "run" };
+    int run_argc = 1;
+
+    reset_workspace();
+    ASSUME_ITS_EQUAL_I32(0, dispatch(first_argc, first));
+    ASSUME_ITS_EQUAL_I32(0, dispatch(second_argc, second));
+    snapshot(sequential);
+
+    for (int i = 1; i < first_argc; i++) run[run_argc++] = first[i];
+    run[run_argc++] = FISH_CLI_STAGE_SEP;
+    for (int i = 1; i < second_argc; i++) run[run_argc++] = second[i];
+    reset_workspace();
+    ASSUME_ITS_EQUAL_I32(0, dispatch(run_argc, run));
+    snapshot(piped);
+
+    for (size_t i = 0; i < PIPELINE_OUTPUTS; i++) {
+        ASSUME_ITS_TRUE(sequential[i] != NULL && piped[i] != NULL);
+        if (sequential[i] && piped[i]) ASSUME_ITS_EQUAL_CSTR(sequential[i], piped[i]);
+        free(sequential[i]);
+        free(piped[i]);
+    }
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_pipeline_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_pipeline_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_pipeline_suite) {
+    for (size_t i = 0; i < PIPELINE_OUTPUTS; i++) remove(pipeline_outputs[i]);
+    fish_meta_invalidate(FISH_DATASET_PATH);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// A `fish run` pipeline must write the same files as running its
+// stages as separate commands.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_pipeline_dedup_then_exact_split) {
+    // dedup shrinks the data, so exact split must count the staged rows
+    const char *clean[] = { "dataset", "clean", "--dedup" };
+    const char *split[] = { "dataset", "split", "--exact", "--seed", "7" };
+    check_pipeline(clean, 3, split, 5);
+}
+
+FOSSIL_TEST_CASE(c_test_pipeline_augment_then_exact_split) {
+    // augment grows the data past the size of the file on disk
+    const char *augment[] = { "dataset", "augment", "--factor", "2", "--seed", "3" };
+    const char *split[] = { "dataset", "split", "--exact", "--seed", "7" };
+    check_pipeline(augment, 6, split, 5);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_pipeline_tests) {
+    FOSSIL_TEST_ADD(c_pipeline_suite, c_test_pipeline_dedup_then_exact_split);
+    FOSSIL_TEST_ADD(c_pipeline_suite, c_test_pipeline_augment_then_exact_split);
+
+    FOSSIL_TEST_REGISTER(c_pipeline_suite);
+}
@@ -0,0 +1,222 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/scan.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+// Around every vector width and its tails
+static const size_t scan_lengths[] = { 0, 1, 15, 16, 31, 32, 33, 63, 64, 65, 127, 128, 129 };
+#define SCAN_LENGTHS (sizeof(scan_lengths) / sizeof(scan_lengths[0]))
+#define SCAN_OFFSETS 4
+
+static fish_scan_isa_t scan_saved;
+
+// Bytes of every kind the kernels tell apart, including >= 0x80
+static void fill_mixed(char *p, size_t len, uint32_t seed) {
+    static const char alphabet[] = "aZ9 ,\t\"\n\rxQ_-\x80\xff";
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        p[i] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+    }
+}
+
+// Plain byte loops the kernels must agree with
+static size_t ref_find(const char *p, size_t len, char a, char b, char c) {
+    for (size_t i = 0; i < len; i++)
+        if (p[i] == a || p[i] == b || p[i] == c) return i;
+    return len;
+}
+
+static size_t ref_count(const char *p, size_t len, char c) {
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) n += p[i] == c;
+    return n;
+}
+
+static int ref_in(unsigned char ch, fish_scan_class_t cls) {
+    if (cls == FISH_SCAN_SPACE) return ch == ' ' || (ch >= '\t' && ch <= '\r');
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+static size_t ref_run(const char *p, size_t len, fish_scan_class_t cls, int in) {
+    size_t i = 0;
+    while (i < len && ref_in((unsigned char)p[i], cls) == in) i++;
+    return i;
+}
+
+// Every kernel on p[0, len) against the reference; the buffer is exactly
+// len bytes on the heap so an overread trips the sanitizer
+static int kernels_agree(const char *src, size_t len) {
+    char *p = (char *)malloc(len ? len : 1);
+    char *low = (char *)malloc(len ? len : 1);
+    int ok = p && low;
+    if (ok) memcpy(p, src, len);
+
+    if (ok && fish_scan_find(p, len, ',', '"', '\n') != ref_find(p, len, ',', '"', '\n')) ok = 0;
+    if (ok && fish_scan_find(p, len, '\r', '\r', '\r') != ref_find(p, len, '\r', '\r', '\r')) ok = 0;
+    if (ok && fish_scan_count(p, len, ',') != ref_count(p, len, ',')) ok = 0;
+    if (ok && fish_scan_count(p, len, '\x80') != ref_count(p, len, '\x80')) ok = 0;
+    for (int cls = FISH_SCAN_ALNUM; ok && cls <= FISH_SCAN_SPACE; cls++) {
+        if (fish_scan_span(p, len, (fish_scan_class_t)cls) != ref_run(p, len, (fish_scan_class_t)cls, 1)) ok = 0;
+        if (fish_scan_cspan(p, len, (fish_scan_class_t)cls) != ref_run(p, len, (fish_scan_class_t)cls, 0)) ok = 0;
+    }
+    if (ok) {
+        fish_scan_lower(low, p, len);
+        for (size_t i = 0; i < len && ok; i++)
+            if (low[i] != (char)((p[i] >= 'A' && p[i] <= 'Z') ? p[i] + 32 : p[i])) ok = 0;
+    }
+
+    // the cursor yields exactly the maximal alnum runs
+    if (ok) {
+        fish_scan_cursor_t cursor;
+        fish_slice_t whole = { p, len }, run;
+        size_t at = 0;
+        fish_scan_cursor_init(&cursor, whole, FISH_SCAN_ALNUM, 1);
+        while (ok && fish_scan_cursor_next(&cursor, &run)) {
+            size_t start = (size_t)(run.ptr - p);
+            if (start < at || start > len) { ok = 0; break; }
+            at += ref_run(p + at, start - at, FISH_SCAN_ALNUM, 0);
+            if (at != start || run.len == 0 || run.len != ref_run(p + start, len - start, FISH_SCAN_ALNUM, 1)) ok = 0;
+            at = start + run.len;
+        }
+        if (ok && at + ref_run(p + at, len - at, FISH_SCAN_ALNUM, 0) != len) ok = 0;
+    }
+    free(p);
+    free(low);
+    return ok;
+}
+
+// Run @p check under every kernel set this build and CPU have; returns how many ran
+static int each_isa(int (*check)(void)) {
+    int ran = 0;
+    for (int isa = FISH_SCAN_SCALAR; isa < FISH_SCAN_ISA_COUNT; isa++) {
+        if (fish_scan_select((fish_scan_isa_t)isa) != 0) continue;
+        ran++;
+        if (!check()) {
+            fossil_io_printf("{red}scan kernels disagree under %s{normal}\n", fish_scan_isa_name((fish_scan_isa_t)isa));
+            return -1;
+        }
+    }
+    return ran;
+}
+
+// Mixed bytes at every length and misalignment
+static int check_mixed(void) {
+    char buf[256 + SCAN_OFFSETS];
+    for (size_t l = 0; l < SCAN_LENGTHS; l++) {
+        for (size_t off = 0; off < SCAN_OFFSETS; off++) {
+            fill_mixed(buf, sizeof(buf), (uint32_t)(l * 31 + off));
+            if (!kernels_agree(buf + off, scan_lengths[l])) return 0;
+        }
+    }
+    return 1;
+}
+
+// A single hit in each of the last bytes, after a vector-width miss
+static int check_tail_hits(void) {
+    char buf[256 + SCAN_OFFSETS];
+    for (size_t l = 0; l < SCAN_LENGTHS; l++) {
+        size_t len = scan_lengths[l];
+        for (size_t back = 1; back <= 3 && back <= len; back++) {
+            for (size_t off = 0; off < SCAN_OFFSETS; off++) {
+                memset(buf, 'x', sizeof(buf));
+                buf[off + len - back] = '"';
+                if (!kernels_agree(buf + off, len)) return 0;
+                if (fish_scan_find(buf + off, len, ',', '"', '\n') != len - back) return 0;
+                if (fish_scan_count(buf + off, len, '"') != 1) return 0;
+                // the byte just past the end must not count
+                buf[off + len] = ',';
+                if (fish_scan_find(buf + off, len, ',', ',', ',') != len) return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Identical token strings whatever the kernel set
+static int check_tokens(void) {
+    static char expect[4][512];
+    static int have = 0;
+    char text[300], out[512];
+    for (int t = 0; t < 4; t++) {
+        fill_mixed(text, sizeof(text), (uint32_t)(t + 7));
+        fish_slice_t in = { text + t, sizeof(text) - 1 - (size_t)t * 70 };
+        size_t n = fish_scan_tokens(in, out, sizeof(out));
+        if (n >= sizeof(out) || out[n] != '\0') return 0;
+        if (!have) memcpy(expect[t], out, n + 1);
+        else if (strcmp(expect[t], out) != 0) return 0;
+    }
+    have = 1;
+    return 1;
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_scan_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_scan_suite) {
+    scan_saved = fish_scan_isa();
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_scan_suite) {
+    fish_scan_select(scan_saved);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Every kernel set (SSE2, AVX2, NEON and the portable SWAR one)
+// answers exactly like a plain byte loop.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_scan_mixed_lengths) {
+    ASSUME_ITS_TRUE(each_isa(check_mixed) >= 1);
+}
+
+FOSSIL_TEST_CASE(c_test_scan_tail_hits) {
+    ASSUME_ITS_TRUE(each_isa(check_tail_hits) >= 1);
+}
+
+FOSSIL_TEST_CASE(c_test_scan_tokens_match) {
+    ASSUME_ITS_TRUE(each_isa(check_tokens) >= 1);
+}
+
+FOSSIL_TEST_CASE(c_test_scan_select_unknown) {
+    ASSUME_ITS_EQUAL_I32(-1, fish_scan_select(FISH_SCAN_ISA_COUNT));
+    ASSUME_ITS_EQUAL_I32(0, fish_scan_select(FISH_SCAN_SCALAR));
+    ASSUME_ITS_EQUAL_I32(FISH_SCAN_SCALAR, fish_scan_isa());
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_scan_tests) {
+    FOSSIL_TEST_ADD(c_scan_suite, c_test_scan_mixed_lengths);
+    FOSSIL_TEST_ADD(c_scan_suite, c_test_scan_tail_hits);
+    FOSSIL_TEST_ADD(c_scan_suite, c_test_scan_tokens_match);
+    FOSSIL_TEST_ADD(c_scan_suite, c_test_scan_select_unknown);
+
+    FOSSIL_TEST_REGISTER(c_scan_suite);
+}
@@ -0,0 +1,252 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/meta.h"
+#include "fossil/code/workspace.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+#define SPLIT_TEST_ROWS 200
+#define SPLIT_TEST_SHARDS 4
+
+static const char *const split_outputs[] = {
+    "datasets/train.dataset",
+    "datasets/val.dataset",
+    "datasets/test.dataset"
+};
+#define SPLIT_OUTPUTS (sizeof(split_outputs) / sizeof(split_outputs[0]))
+
+static void write_text(const char *path, const char *text) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return;
+    fwrite(text, 1, strlen(text), f);
+    fclose(f);
+}
+
+static char *read_text(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = (char *)malloc((size_t)size + 1);
+    if (text && fread(text, 1, (size_t)size, f) != (size_t)size) size = 0;
+    if (text) text[size] = '\0';
+    fclose(f);
+    return text;
+}
+
+// Rows "r<i>,<group>,<i>"; every tenth row shares its group with nine others
+static void write_dataset(int header) {
+    static char text[SPLIT_TEST_ROWS * 32 + 64];
+    size_t len = header ? (size_t)snprintf(text, sizeof(text), "id,group,value\n") : 0;
+    for (int i = 0; i < SPLIT_TEST_ROWS; i++)
+        len += (size_t)snprintf(text + len, sizeof(text) - len, "r%d,g%d,%d\n", i, i / 10, i);
+    MKDIR(FISH_DATASET_DIR);
+    fish_meta_invalidate(FISH_DATASET_PATH);
+    write_text(FISH_DATASET_PATH, text);
+}
+
+static char *shard_path(const char *role, size_t i) {
+    static char path[64];
+    snprintf(path, sizeof(path), "datasets/%s-%zu%s.dataset", role, i,
+             strcmp(role, "fold") == 0 ? ".val" : "");
+    return path;
+}
+
+// Record which rows @p path holds in @p where (as @p tag); returns the row
+// count, or -1 if the file is missing, a row repeats, or the header is not
+// where @p header says it is
+static int collect(const char *path, int header, int *where, int tag) {
+    char *text = read_text(path);
+    int rows = 0;
+    if (!text) return -1;
+    char *line = text;
+    if (header) {
+        if (strncmp(line, "id,group,value\n", 15) != 0) rows = -1;
+        else line += 15;
+    }
+    while (rows >= 0 && *line) {
+        int id = -1;
+        if (sscanf(line, "r%d,", &id) != 1 || id < 0 || id >= SPLIT_TEST_ROWS || where[id] != -1) {
+            rows = -1;
+            break;
+        }
+        where[id] = tag;
+        rows++;
+        char *end = strchr(line, '\n');
+        line = end ? end + 1 : line + strlen(line);
+    }
+    free(text);
+    return rows;
+}
+
+static int all_assigned(const int *where) {
+    for (int i = 0; i < SPLIT_TEST_ROWS; i++)
+        if (where[i] < 0) return 0;
+    return 1;
+}
+
+static void forget(int *where) {
+    for (int i = 0; i < SPLIT_TEST_ROWS; i++) where[i] = -1;
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_split_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_split_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_split_suite) {
+    for (size_t i = 0; i < SPLIT_OUTPUTS; i++) remove(split_outputs[i]);
+    for (size_t i = 0; i < SPLIT_TEST_SHARDS; i++) {
+        char role[32];
+        remove(shard_path("shard", i));
+        remove(shard_path("fold", i));
+        snprintf(role, sizeof(role), "datasets/fold-%zu.train.dataset", i);
+        remove(role);
+    }
+    remove(FISH_DATASET_PATH);
+    fish_meta_invalidate(FISH_DATASET_PATH);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Every row lands in exactly one set, the same one for the same
+// seed, and rows sharing a key never leave their group.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_split_disjoint_and_complete) {
+    int where[SPLIT_TEST_ROWS];
+    for (int header = 1; header >= 0; header--) {
+        write_dataset(header);
+        forget(where);
+        ASSUME_ITS_EQUAL_I32(0, fish_dataset_split_seeded(0.6f, 0.2f, 0.2f, 7, NULL, 0));
+        int total = 0;
+        for (size_t i = 0; i < SPLIT_OUTPUTS; i++) {
+            int rows = collect(split_outputs[i], header, where, (int)i);
+            ASSUME_ITS_TRUE(rows >= 0);
+            total += rows;
+        }
+        // a headerless dataset splits its first record as data, once
+        ASSUME_ITS_EQUAL_I32(SPLIT_TEST_ROWS, total);
+        ASSUME_ITS_TRUE(all_assigned(where));
+    }
+}
+
+FOSSIL_TEST_CASE(c_test_split_seed_determinism) {
+    int first[SPLIT_TEST_ROWS], again[SPLIT_TEST_ROWS], other[SPLIT_TEST_ROWS];
+    int *runs[3] = { first, again, other };
+    const uint64_t seeds[3] = { 7, 7, 8 };
+    write_dataset(1);
+
+    for (int r = 0; r < 3; r++) {
+        forget(runs[r]);
+        ASSUME_ITS_EQUAL_I32(0, fish_dataset_split_seeded(0.5f, 0.25f, 0.25f, seeds[r], NULL, 0));
+        for (size_t i = 0; i < SPLIT_OUTPUTS; i++)
+            ASSUME_ITS_TRUE(collect(split_outputs[i], 1, runs[r], (int)i) >= 0);
+    }
+    ASSUME_ITS_TRUE(memcmp(first, again, sizeof(first)) == 0);
+    ASSUME_ITS_TRUE(memcmp(first, other, sizeof(first)) != 0);
+}
+
+FOSSIL_TEST_CASE(c_test_split_exact_counts) {
+    int where[SPLIT_TEST_ROWS];
+    for (int header = 1; header >= 0; header--) {
+        write_dataset(header);
+        forget(where);
+        ASSUME_ITS_EQUAL_I32(0, fish_dataset_split_seeded(0.7f, 0.2f, 0.1f, 3, NULL, 1));
+        ASSUME_ITS_EQUAL_I32(140, collect(split_outputs[0], header, where, 0));
+        ASSUME_ITS_EQUAL_I32(40, collect(split_outputs[1], header, where, 1));
+        ASSUME_ITS_EQUAL_I32(20, collect(split_outputs[2], header, where, 2));
+    }
+    // exact draws depend on the row position, so keys cannot be kept together
+    ASSUME_ITS_EQUAL_I32(-1, fish_dataset_split_seeded(0.7f, 0.2f, 0.1f, 3, "group", 1));
+}
+
+FOSSIL_TEST_CASE(c_test_split_key_keeps_groups) {
+    int where[SPLIT_TEST_ROWS];
+    write_dataset(1);
+    forget(where);
+    ASSUME_ITS_EQUAL_I32(0, fish_dataset_split_seeded(0.5f, 0.25f, 0.25f, 11, "group", 0));
+    for (size_t i = 0; i < SPLIT_OUTPUTS; i++)
+        ASSUME_ITS_TRUE(collect(split_outputs[i], 1, where, (int)i) >= 0);
+    ASSUME_ITS_TRUE(all_assigned(where));
+    for (int i = 0; i < SPLIT_TEST_ROWS; i++)
+        ASSUME_ITS_EQUAL_I32(where[i - i % 10], where[i]);
+
+    // without a header there is no column to key on
+    write_dataset(0);
+    ASSUME_ITS_EQUAL_I32(-1, fish_dataset_split_seeded(0.5f, 0.25f, 0.25f, 11, "group", 0));
+}
+
+FOSSIL_TEST_CASE(c_test_shard_assignment) {
+    int shard[SPLIT_TEST_ROWS], again[SPLIT_TEST_ROWS], fold[SPLIT_TEST_ROWS];
+    write_dataset(1);
+
+    // each row in exactly one shard, the same one on every run
+    forget(shard);
+    forget(again);
+    for (int run = 0; run < 2; run++) {
+        int *where = run ? again : shard;
+        ASSUME_ITS_EQUAL_I32(0, fish_dataset_shard(SPLIT_TEST_SHARDS, 0, 5, "group"));
+        for (size_t i = 0; i < SPLIT_TEST_SHARDS; i++)
+            ASSUME_ITS_TRUE(collect(shard_path("shard", i), 1, where, (int)i) >= 0);
+        ASSUME_ITS_TRUE(all_assigned(where));
+    }
+    ASSUME_ITS_TRUE(memcmp(shard, again, sizeof(shard)) == 0);
+    for (int i = 0; i < SPLIT_TEST_ROWS; i++)
+        ASSUME_ITS_EQUAL_I32(shard[i - i % 10], shard[i]);
+
+    // fold i validates on shard i and trains on the rest
+    forget(fold);
+    ASSUME_ITS_EQUAL_I32(0, fish_dataset_shard(SPLIT_TEST_SHARDS, 1, 5, "group"));
+    for (size_t i = 0; i < SPLIT_TEST_SHARDS; i++) {
+        int train[SPLIT_TEST_ROWS];
+        char path[64];
+        forget(train);
+        ASSUME_ITS_TRUE(collect(shard_path("fold", i), 1, fold, (int)i) >= 0);
+        snprintf(path, sizeof(path), "datasets/fold-%zu.train.dataset", i);
+        ASSUME_ITS_TRUE(collect(path, 1, train, 1) >= 0);
+        for (int r = 0; r < SPLIT_TEST_ROWS; r++)
+            ASSUME_ITS_EQUAL_I32(shard[r] == (int)i ? -1 : 1, train[r]);
+    }
+    ASSUME_ITS_TRUE(memcmp(shard, fold, sizeof(shard)) == 0);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_split_tests) {
+    FOSSIL_TEST_ADD(c_split_suite, c_test_split_disjoint_and_complete);
+    FOSSIL_TEST_ADD(c_split_suite, c_test_split_seed_determinism);
+    FOSSIL_TEST_ADD(c_split_suite, c_test_split_exact_counts);
+    FOSSIL_TEST_ADD(c_split_suite, c_test_split_key_keeps_groups);
+    FOSSIL_TEST_ADD(c_split_suite, c_test_shard_assignment);
+
+    FOSSIL_TEST_REGISTER(c_split_suite);
+}
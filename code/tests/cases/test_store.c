@@ -0,0 +1,211 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/store.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+// The ref lives in its own directory so the store next to it does too
+#define STORE_TEST_DIR "store_test"
+#define STORE_TEST_REF STORE_TEST_DIR "/model.jfchain"
+#define STORE_TEST_OBJECTS STORE_TEST_DIR "/" FISH_STORE_DIR "/objects"
+#define STORE_TEST_COMMITS 12
+
+static fossil_ai_jellyfish_chain_t *store_sample(size_t commits) {
+    fossil_ai_jellyfish_chain_t *chain = (fossil_ai_jellyfish_chain_t *)calloc(1, sizeof(*chain));
+    char input[32], output[32];
+    if (!chain) return NULL;
+
+    fossil_ai_jellyfish_init(chain);
+    for (size_t i = 0; i < commits; i++) {
+        snprintf(input, sizeof(input), "question %zu", i);
+        snprintf(output, sizeof(output), "answer %zu", i % 3);
+        fossil_ai_jellyfish_learn(chain, input, output);
+    }
+    return chain;
+}
+
+static int same_chain(const fossil_ai_jellyfish_chain_t *a, const fossil_ai_jellyfish_chain_t *b) {
+    if (a->count != b->count) return 0;
+    for (size_t i = 0; i < a->count; i++)
+        if (memcmp(&a->commits[i], &b->commits[i], sizeof(a->commits[i])) != 0) return 0;
+    return 1;
+}
+
+// Object files of the store, sorted by name
+static int store_objects(fish_path_list_t *list) {
+    fossil_sys_memory_zero(list, sizeof(*list));
+    return fish_path_list_glob(list, STORE_TEST_OBJECTS "/*/*");
+}
+
+static size_t read_object(const char *path, char *block) {
+    FILE *f = fopen(path, "rb");
+    size_t got = f ? fread(block, 1, sizeof(fossil_ai_jellyfish_block_t), f) : 0;
+    if (f) fclose(f);
+    return got;
+}
+
+static void write_object(const char *path, const char *block, size_t len) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return;
+    fwrite(block, 1, len, f);
+    fclose(f);
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_store_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_store_suite) {
+    MKDIR(STORE_TEST_DIR);
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_store_suite) {
+    fish_path_list_t objects;
+    char dir[sizeof(STORE_TEST_OBJECTS) + 4];
+    if (store_objects(&objects) == 0)
+        for (size_t i = 0; i < objects.count; i++) remove(objects.path[i]);
+    fish_path_list_free(&objects);
+    // every fan-out directory, including those a test emptied
+    for (int b = 0; b < 256; b++) {
+        snprintf(dir, sizeof(dir), STORE_TEST_OBJECTS "/%02x", b);
+        remove(dir);
+    }
+    remove(STORE_TEST_OBJECTS);
+    remove(STORE_TEST_DIR "/" FISH_STORE_DIR);
+    remove(STORE_TEST_REF);
+    remove(STORE_TEST_DIR);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// A ref must load back the exact commits it was saved from, a
+// resave must reuse the objects it already points to, and a
+// missing or damaged object must fail the load.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_store_round_trip) {
+    fossil_ai_jellyfish_chain_t *chain = store_sample(STORE_TEST_COMMITS);
+    fossil_ai_jellyfish_chain_t *loaded = (fossil_ai_jellyfish_chain_t *)calloc(1, sizeof(*loaded));
+    fish_store_stats_t stats;
+    fish_path_list_t objects;
+    ASSUME_ITS_TRUE(chain != NULL && loaded != NULL);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_store_save(chain, STORE_TEST_REF, &stats));
+    ASSUME_ITS_EQUAL_I32(STORE_TEST_COMMITS, (int)stats.written);
+    ASSUME_ITS_EQUAL_I32(0, (int)stats.shared);
+    ASSUME_ITS_TRUE(fish_ref_probe(STORE_TEST_REF));
+
+    // one object per commit
+    ASSUME_ITS_EQUAL_I32(0, store_objects(&objects));
+    ASSUME_ITS_EQUAL_I32(STORE_TEST_COMMITS, (int)objects.count);
+    fish_path_list_free(&objects);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_ref_load(loaded, STORE_TEST_REF));
+    ASSUME_ITS_TRUE(same_chain(chain, loaded));
+
+    free(chain);
+    free(loaded);
+}
+
+FOSSIL_TEST_CASE(c_test_store_resave_shares_known) {
+    fossil_ai_jellyfish_chain_t *chain = store_sample(STORE_TEST_COMMITS);
+    fossil_ai_jellyfish_chain_t *loaded = (fossil_ai_jellyfish_chain_t *)calloc(1, sizeof(*loaded));
+    fish_store_stats_t stats;
+    ASSUME_ITS_TRUE(chain != NULL && loaded != NULL);
+    ASSUME_ITS_EQUAL_I32(0, fish_store_save(chain, STORE_TEST_REF, NULL));
+
+    // an unchanged chain writes nothing
+    ASSUME_ITS_EQUAL_I32(0, fish_store_save(chain, STORE_TEST_REF, &stats));
+    ASSUME_ITS_EQUAL_I32(0, (int)stats.written);
+    ASSUME_ITS_EQUAL_I32(STORE_TEST_COMMITS, (int)stats.shared);
+
+    // a grown chain writes only its new commits
+    fossil_ai_jellyfish_learn(chain, "one more", "answer");
+    fossil_ai_jellyfish_learn(chain, "and another", "answer");
+    ASSUME_ITS_EQUAL_I32(0, fish_store_save(chain, STORE_TEST_REF, &stats));
+    ASSUME_ITS_EQUAL_I32(2, (int)stats.written);
+    ASSUME_ITS_EQUAL_I32(STORE_TEST_COMMITS, (int)stats.shared);
+    ASSUME_ITS_EQUAL_I32(0, fish_ref_load(loaded, STORE_TEST_REF));
+    ASSUME_ITS_TRUE(same_chain(chain, loaded));
+
+    free(chain);
+    free(loaded);
+}
+
+FOSSIL_TEST_CASE(c_test_store_damaged_object) {
+    fossil_ai_jellyfish_chain_t *chain = store_sample(STORE_TEST_COMMITS);
+    fossil_ai_jellyfish_chain_t *loaded = (fossil_ai_jellyfish_chain_t *)calloc(1, sizeof(*loaded));
+    fish_path_list_t objects;
+    ASSUME_ITS_TRUE(chain != NULL && loaded != NULL);
+    ASSUME_ITS_EQUAL_I32(0, fish_store_save(chain, STORE_TEST_REF, NULL));
+    ASSUME_ITS_EQUAL_I32(0, store_objects(&objects));
+    ASSUME_ITS_TRUE(objects.count > 0);
+
+    if (objects.count > 0) {
+        const char *path = objects.path[objects.count / 2];
+        char good[sizeof(fossil_ai_jellyfish_block_t)], bad[sizeof(good)];
+        ASSUME_ITS_EQUAL_I32((int)sizeof(good), (int)read_object(path, good));
+
+        // torn
+        write_object(path, good, sizeof(good) / 2);
+        ASSUME_ITS_EQUAL_I32(-1, fish_ref_load(loaded, STORE_TEST_REF));
+
+        // right size, wrong bytes
+        memcpy(bad, good, sizeof(bad));
+        bad[sizeof(bad) / 2] ^= 0x5a;
+        write_object(path, bad, sizeof(bad));
+        ASSUME_ITS_EQUAL_I32(-1, fish_ref_load(loaded, STORE_TEST_REF));
+
+        // gone
+        remove(path);
+        ASSUME_ITS_EQUAL_I32(-1, fish_ref_load(loaded, STORE_TEST_REF));
+
+        // and whole again
+        write_object(path, good, sizeof(good));
+        ASSUME_ITS_EQUAL_I32(0, fish_ref_load(loaded, STORE_TEST_REF));
+        ASSUME_ITS_TRUE(same_chain(chain, loaded));
+    }
+    fish_path_list_free(&objects);
+
+    // a missing ref fails the same way
+    remove(STORE_TEST_REF);
+    ASSUME_ITS_TRUE(!fish_ref_probe(STORE_TEST_REF));
+    ASSUME_ITS_EQUAL_I32(-1, fish_ref_load(loaded, STORE_TEST_REF));
+
+    free(chain);
+    free(loaded);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_store_tests) {
+    FOSSIL_TEST_ADD(c_store_suite, c_test_store_round_trip);
+    FOSSIL_TEST_ADD(c_store_suite, c_test_store_resave_shares_known);
+    FOSSIL_TEST_ADD(c_store_suite, c_test_store_damaged_object);
+
+    FOSSIL_TEST_REGISTER(c_store_suite);
+}
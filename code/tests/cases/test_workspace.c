@@ -0,0 +1,193 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/workspace.h"
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/file.h>
+#  include <unistd.h>
+#endif
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+#define WS_TEST_PLAIN FISH_DATASET_DIR "/ws_plain"
+#define WS_TEST_FCOL FISH_DATASET_DIR "/ws_col.fcol"
+#define WS_TEST_BOTH FISH_DATASET_DIR "/ws_both"
+#define WS_TEST_BOTH_FCOL FISH_DATASET_DIR "/ws_both.fcol"
+#define WS_TEST_IMPORTED FISH_DATASET_DIR "/ws_imported.dataset"
+
+static void touch(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f) fclose(f);
+}
+
+// Whether another opener of the lock file @p path could take it right now
+static int lock_is_free(const char *path) {
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                           NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    OVERLAPPED at;
+    int free_now;
+    if (h == INVALID_HANDLE_VALUE) return 0;
+    memset(&at, 0, sizeof(at));
+    free_now = LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &at) != 0;
+    if (free_now) UnlockFileEx(h, 0, 1, 0, &at);
+    CloseHandle(h);
+    return free_now;
+#else
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    int free_now;
+    if (fd < 0) return 0;
+    free_now = flock(fd, LOCK_EX | LOCK_NB) == 0;
+    close(fd);
+    return free_now;
+#endif
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_workspace_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_workspace_suite) {
+    MKDIR(FISH_DATASET_DIR);
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_workspace_suite) {
+    static const char *const files[] = {
+        WS_TEST_PLAIN, WS_TEST_FCOL, WS_TEST_BOTH, WS_TEST_BOTH_FCOL, WS_TEST_IMPORTED,
+        FISH_DATASET_DIR "/.current.dataset.lock", FISH_DATASET_DIR "/.ws_plain.lock",
+        FISH_DATASET_DIR "/.ws_col.fcol.lock"
+    };
+    fish_workspace_select(NULL);
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) remove(files[i]);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// `--dataset` names find their file in datasets/, and the lock of
+// a dataset excludes other jobs on it but not on its neighbours.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_workspace_valid_names) {
+    ASSUME_ITS_TRUE(fish_workspace_valid_name("s3"));
+    ASSUME_ITS_TRUE(fish_workspace_valid_name("train.v2"));
+    ASSUME_ITS_TRUE(!fish_workspace_valid_name(NULL));
+    ASSUME_ITS_TRUE(!fish_workspace_valid_name(""));
+    ASSUME_ITS_TRUE(!fish_workspace_valid_name(".hidden"));
+    ASSUME_ITS_TRUE(!fish_workspace_valid_name("../escape"));
+    ASSUME_ITS_TRUE(!fish_workspace_valid_name("a\\b"));
+    ASSUME_ITS_EQUAL_I32(-1, fish_workspace_select("a/b"));
+}
+
+FOSSIL_TEST_CASE(c_test_workspace_select_by_name) {
+    touch(WS_TEST_PLAIN);
+    touch(WS_TEST_FCOL);
+    touch(WS_TEST_BOTH);
+    touch(WS_TEST_BOTH_FCOL);
+    touch(WS_TEST_IMPORTED);
+
+    // nothing selected: the current dataset
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_select(NULL));
+    ASSUME_ITS_EQUAL_CSTR(FISH_DATASET_PATH, fish_workspace_path());
+
+    // the bare file first, then .fcol, then .dataset
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_select("ws_plain"));
+    ASSUME_ITS_EQUAL_CSTR(WS_TEST_PLAIN, fish_workspace_path());
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_select("ws_col"));
+    ASSUME_ITS_EQUAL_CSTR(WS_TEST_FCOL, fish_workspace_path());
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_select("ws_both"));
+    ASSUME_ITS_EQUAL_CSTR(WS_TEST_BOTH, fish_workspace_path());
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_select("ws_imported"));
+    ASSUME_ITS_EQUAL_CSTR(WS_TEST_IMPORTED, fish_workspace_path());
+
+    // a name with no file yet is where an import would create it
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_select("ws_new"));
+    ASSUME_ITS_EQUAL_CSTR(FISH_DATASET_DIR "/ws_new", fish_workspace_path());
+
+    // a rejected name keeps the previous selection
+    ASSUME_ITS_EQUAL_I32(-1, fish_workspace_select(".lock"));
+    ASSUME_ITS_EQUAL_CSTR(FISH_DATASET_DIR "/ws_new", fish_workspace_path());
+
+    // existing paths pass through, names resolve like --dataset
+    ASSUME_ITS_EQUAL_CSTR(WS_TEST_BOTH_FCOL, fish_workspace_resolve(WS_TEST_BOTH_FCOL));
+    ASSUME_ITS_EQUAL_CSTR(WS_TEST_FCOL, fish_workspace_resolve("ws_col"));
+}
+
+FOSSIL_TEST_CASE(c_test_workspace_outputs_per_dataset) {
+    cstring out;
+    touch(WS_TEST_FCOL);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_select(NULL));
+    out = fish_workspace_output("train");
+    ASSUME_ITS_EQUAL_CSTR(FISH_DATASET_DIR "/train.dataset", out);
+    fossil_io_cstring_free(out);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_select("ws_col"));
+    out = fish_workspace_output("train");
+    ASSUME_ITS_EQUAL_CSTR(FISH_DATASET_DIR "/ws_col.train.dataset", out);
+    fossil_io_cstring_free(out);
+}
+
+FOSSIL_TEST_CASE(c_test_workspace_lock_excludes) {
+    fish_workspace_lock_t held, other;
+    touch(WS_TEST_PLAIN);
+    touch(WS_TEST_FCOL);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_select("ws_plain"));
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_lock(&held));
+    ASSUME_ITS_TRUE(held.handle >= 0);
+    ASSUME_ITS_TRUE(!lock_is_free(FISH_DATASET_DIR "/.ws_plain.lock"));
+
+    // another dataset does not wait
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_select("ws_col"));
+    ASSUME_ITS_EQUAL_I32(0, fish_workspace_lock(&other));
+    ASSUME_ITS_TRUE(other.handle >= 0);
+    ASSUME_ITS_TRUE(!lock_is_free(FISH_DATASET_DIR "/.ws_col.fcol.lock"));
+    fish_workspace_unlock(&other);
+    ASSUME_ITS_TRUE(other.handle == -1);
+
+    fish_workspace_unlock(&held);
+    ASSUME_ITS_TRUE(lock_is_free(FISH_DATASET_DIR "/.ws_plain.lock"));
+    ASSUME_ITS_TRUE(lock_is_free(FISH_DATASET_DIR "/.ws_col.fcol.lock"));
+
+    // unlocking twice is harmless
+    fish_workspace_unlock(&held);
+    ASSUME_ITS_TRUE(held.handle == -1);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_workspace_tests) {
+    FOSSIL_TEST_ADD(c_workspace_suite, c_test_workspace_valid_names);
+    FOSSIL_TEST_ADD(c_workspace_suite, c_test_workspace_select_by_name);
+    FOSSIL_TEST_ADD(c_workspace_suite, c_test_workspace_outputs_per_dataset);
+    FOSSIL_TEST_ADD(c_workspace_suite, c_test_workspace_lock_excludes);
+
+    FOSSIL_TEST_REGISTER(c_workspace_suite);
+}
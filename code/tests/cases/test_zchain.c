@@ -0,0 +1,164 @@
+/*
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop high-
+ * performance, cross-platform applications and libraries. The code contained
+ * herein is subject to the terms and conditions defined in the project license.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ *
+ * Copyright (C) 2024 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+
+#include "fossil/code/app.h"
+#include "fossil/code/learn.h"
+#include "fossil/code/zchain.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilites
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+#define ZCHAIN_TEST_PATH "zchain_test.jfchain"
+#define ZCHAIN_TEST_TORN "zchain_torn.jfchain"
+
+// Two full keyframe intervals and a partial third, as far as the chain allows
+#define ZCHAIN_TEST_COMMITS \
+    (2 * FISH_ZCHAIN_KEYFRAME + 5 < FOSSIL_JELLYFISH_MAX_MEM ? 2 * FISH_ZCHAIN_KEYFRAME + 5 : FOSSIL_JELLYFISH_MAX_MEM)
+
+// A chain whose commits repeat text, as real ones do, with a few odd ones out
+static fossil_ai_jellyfish_chain_t *zchain_sample(void) {
+    fossil_ai_jellyfish_chain_t *chain = (fossil_ai_jellyfish_chain_t *)calloc(1, sizeof(*chain));
+    static char inputs[ZCHAIN_TEST_COMMITS][32], outputs[ZCHAIN_TEST_COMMITS][32];
+    static fish_pair_t pairs[ZCHAIN_TEST_COMMITS];
+    if (!chain) return NULL;
+
+    fossil_ai_jellyfish_init(chain);
+    for (size_t i = 0; i < ZCHAIN_TEST_COMMITS; i++) {
+        snprintf(inputs[i], sizeof(inputs[i]), "question %zu", i % 7 == 3 ? i * 977 : i / 4);
+        snprintf(outputs[i], sizeof(outputs[i]), "answer %zu", i % 5);
+        pairs[i].input = inputs[i];
+        pairs[i].output = outputs[i];
+    }
+    fish_chain_learn_bulk(chain, pairs, ZCHAIN_TEST_COMMITS);
+    chain->commits[9].attributes.confidence = 0.25f;
+    return chain;
+}
+
+static int same_block(const fossil_ai_jellyfish_block_t *a, const fossil_ai_jellyfish_block_t *b) {
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+// Copy the first @p keep bytes of @p from into @p to
+static void copy_prefix(const char *from, const char *to, long keep) {
+    FILE *in = fopen(from, "rb");
+    FILE *out = fopen(to, "wb");
+    for (long i = 0; in && out && i < keep; i++) {
+        int c = fgetc(in);
+        if (c == EOF) break;
+        fputc(c, out);
+    }
+    if (in) fclose(in);
+    if (out) fclose(out);
+}
+
+// Define the test suite and add test cases
+FOSSIL_TEST_SUITE(c_zchain_suite);
+
+// Setup function for the test suite
+FOSSIL_SETUP(c_zchain_suite) {
+    // Setup code here
+}
+
+// Teardown function for the test suite
+FOSSIL_TEARDOWN(c_zchain_suite) {
+    remove(ZCHAIN_TEST_PATH);
+    remove(ZCHAIN_TEST_TORN);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// A compressed chain must decode to the exact commits it was
+// written from, in any read order, and refuse a torn file.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_zchain_round_trip_across_keyframes) {
+    fossil_ai_jellyfish_chain_t *chain = zchain_sample();
+    fossil_ai_jellyfish_chain_t *loaded = (fossil_ai_jellyfish_chain_t *)calloc(1, sizeof(*loaded));
+    ASSUME_ITS_TRUE(chain != NULL && loaded != NULL);
+    ASSUME_ITS_TRUE(chain->count > FISH_ZCHAIN_KEYFRAME);
+
+    ASSUME_ITS_EQUAL_I32(0, fish_zchain_save(chain, ZCHAIN_TEST_PATH));
+    ASSUME_ITS_TRUE(fish_zchain_probe(ZCHAIN_TEST_PATH));
+    ASSUME_ITS_EQUAL_I32(0, fish_chain_load(loaded, ZCHAIN_TEST_PATH));
+    ASSUME_ITS_EQUAL_I32((int)chain->count, (int)loaded->count);
+    for (size_t i = 0; i < chain->count && i < loaded->count; i++)
+        ASSUME_ITS_TRUE(same_block(&chain->commits[i], &loaded->commits[i]));
+
+    free(chain);
+    free(loaded);
+}
+
+FOSSIL_TEST_CASE(c_test_zchain_read_out_of_order) {
+    fossil_ai_jellyfish_chain_t *chain = zchain_sample();
+    fossil_ai_jellyfish_block_t block;
+    fish_zchain_t z;
+    ASSUME_ITS_TRUE(chain != NULL);
+    ASSUME_ITS_EQUAL_I32(0, fish_zchain_save(chain, ZCHAIN_TEST_PATH));
+    ASSUME_ITS_EQUAL_I32(0, fish_zchain_open(&z, ZCHAIN_TEST_PATH, NULL));
+    ASSUME_ITS_EQUAL_I32((int)chain->count, (int)z.count);
+
+    // backwards, across intervals, repeated, and back to a keyframe
+    const uint64_t last = chain->count - 1;
+    const uint64_t order[] = {
+        last, 0, FISH_ZCHAIN_KEYFRAME + 1, FISH_ZCHAIN_KEYFRAME, FISH_ZCHAIN_KEYFRAME,
+        FISH_ZCHAIN_KEYFRAME - 1, 9, last - 1, 1
+    };
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        ASSUME_ITS_EQUAL_I32(0, fish_zchain_read(&z, order[i], &block));
+        ASSUME_ITS_TRUE(same_block(&chain->commits[order[i]], &block));
+    }
+    ASSUME_ITS_EQUAL_I32(-1, fish_zchain_read(&z, chain->count, &block));
+
+    fish_zchain_close(&z);
+    free(chain);
+}
+
+FOSSIL_TEST_CASE(c_test_zchain_rejects_truncated) {
+    fossil_ai_jellyfish_chain_t *chain = zchain_sample();
+    fossil_ai_jellyfish_chain_t *loaded = (fossil_ai_jellyfish_chain_t *)calloc(1, sizeof(*loaded));
+    fish_zchain_t z;
+    ASSUME_ITS_TRUE(chain != NULL && loaded != NULL);
+    ASSUME_ITS_EQUAL_I32(0, fish_zchain_save(chain, ZCHAIN_TEST_PATH));
+
+    // cut inside the trailer, inside the directory, and inside the blocks
+    long size = (long)fish_file_size(ZCHAIN_TEST_PATH);
+    const long keep[] = { size - 1, size - 20, size / 2 };
+    for (size_t i = 0; i < sizeof(keep) / sizeof(keep[0]); i++) {
+        copy_prefix(ZCHAIN_TEST_PATH, ZCHAIN_TEST_TORN, keep[i]);
+        ASSUME_ITS_EQUAL_I32(-1, fish_zchain_open(&z, ZCHAIN_TEST_TORN, NULL));
+        ASSUME_ITS_TRUE(fish_chain_load(loaded, ZCHAIN_TEST_TORN) != 0);
+    }
+
+    free(chain);
+    free(loaded);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_GROUP(c_zchain_tests) {
+    FOSSIL_TEST_ADD(c_zchain_suite, c_test_zchain_round_trip_across_keyframes);
+    FOSSIL_TEST_ADD(c_zchain_suite, c_test_zchain_read_out_of_order);
+    FOSSIL_TEST_ADD(c_zchain_suite, c_test_zchain_rejects_truncated);
+
+    FOSSIL_TEST_REGISTER(c_zchain_suite);
+}